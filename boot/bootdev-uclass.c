@@ -11,6 +11,7 @@
 #include <bootflow.h>
 #include <bootmeth.h>
 #include <bootstd.h>
+#include <cyclic.h>
 #include <fs.h>
 #include <log.h>
 #include <malloc.h>
@@ -745,6 +746,13 @@ int bootdev_setup_iter(struct bootflow_iter *iter, const char *label,
 		log_debug("- bootdev_hunt_prio() ret %d\n", ret);
 		if (ret)
 			return log_msg_ret("pre", ret);
+
+		/* let slow hunters make progress while other bootdevs are used */
+		if (CONFIG_IS_ENABLED(BOOTSTD_HUNT_BACKGROUND) && !label) {
+			ret = bootdev_hunt_start();
+			if (ret)
+				return log_msg_ret("bg", ret);
+		}
 	}
 
 	/* Handle scanning a single device */
@@ -796,6 +804,113 @@ int bootdev_setup_iter(struct bootflow_iter *iter, const char *label,
 	return 0;
 }
 
+/* Interval between steps of hunters running in the background */
+#define BOOTDEV_HUNT_STEP_US	1000
+
+/* Stop running a hunter in the background */
+static void bootdev_hunt_stop(struct bootstd_priv *std, uint seq)
+{
+	std->hunters_active &= ~BIT(seq);
+	if (!std->hunters_active)
+		cyclic_unregister(&std->hunt_cyclic);
+}
+
+static void bootdev_hunt_cyclic(struct cyclic_info *c)
+{
+	struct bootstd_priv *std;
+	struct bootdev_hunter *start;
+	int n_ent, i;
+
+	std = container_of(c, struct bootstd_priv, hunt_cyclic);
+	start = ll_entry_start(struct bootdev_hunter, bootdev_hunter);
+	n_ent = ll_entry_count(struct bootdev_hunter, bootdev_hunter);
+	for (i = 0; i < n_ent; i++) {
+		struct bootdev_hunter *info = start + i;
+		int ret;
+
+		if (!(std->hunters_active & BIT(i)))
+			continue;
+		ret = info->step(info, false, true);
+		if (ret == -EAGAIN)
+			continue;
+		log_debug("Hunted with %s in background: %d\n",
+			  uclass_get_name(info->uclass), ret);
+
+		/* leave errors to be reported when the hunter is next used */
+		if (!ret || ret == -ENOENT)
+			std->hunters_used |= BIT(i);
+		bootdev_hunt_stop(std, i);
+	}
+}
+
+int bootdev_hunt_start(void)
+{
+	struct bootdev_hunter *start;
+	struct bootstd_priv *std;
+	int n_ent, i, ret;
+
+	ret = bootstd_get_priv(&std);
+	if (ret)
+		return log_msg_ret("std", ret);
+
+	start = ll_entry_start(struct bootdev_hunter, bootdev_hunter);
+	n_ent = ll_entry_count(struct bootdev_hunter, bootdev_hunter);
+	for (i = 0; i < n_ent; i++) {
+		struct bootdev_hunter *info = start + i;
+
+		if (!info->step ||
+		    (std->hunters_used | std->hunters_active) & BIT(i))
+			continue;
+		log_debug("Hunting with %s in background\n",
+			  uclass_get_name(info->uclass));
+		if (!std->hunters_active)
+			cyclic_register(&std->hunt_cyclic, bootdev_hunt_cyclic,
+					BOOTDEV_HUNT_STEP_US, "bootdev_hunt");
+		std->hunters_active |= BIT(i);
+	}
+
+	return 0;
+}
+
+void bootdev_hunt_stop_all(void)
+{
+	struct bootstd_priv *std;
+
+	if (bootstd_get_priv(&std) || !std->hunters_active)
+		return;
+	log_debug("Stopping background hunters %x\n", std->hunters_active);
+	std->hunters_active = 0;
+	cyclic_unregister(&std->hunt_cyclic);
+}
+
+/**
+ * bootdev_hunt_steps() - Run a hunter's steps until it is finished
+ *
+ * If the hunter is running in the background, this carries on from where it
+ * got to. Other hunters are left running in the background.
+ *
+ * @std: bootstd private info
+ * @info: Hunter to run
+ * @seq: Position of the hunter in the linker list
+ * @show: true to show information from the hunter
+ * Return: result of the hunter's step() method
+ */
+static int bootdev_hunt_steps(struct bootstd_priv *std,
+			      struct bootdev_hunter *info, uint seq, bool show)
+{
+	int ret;
+
+	if (std->hunters_active & BIT(seq))
+		bootdev_hunt_stop(std, seq);
+	do {
+		ret = info->step(info, show, false);
+		if (ret == -EAGAIN)
+			schedule();
+	} while (ret == -EAGAIN);
+
+	return ret;
+}
+
 static int bootdev_hunt_drv(struct bootdev_hunter *info, uint seq, bool show)
 {
 	const char *name = uclass_get_name(info->uclass);
@@ -811,8 +926,11 @@ static int bootdev_hunt_drv(struct bootdev_hunter *info, uint seq, bool show)
 			printf("Hunting with: %s\n",
 			       uclass_get_name(info->uclass));
 		log_debug("Hunting with: %s\n", name);
-		if (info->hunt) {
-			ret = info->hunt(info, show);
+		if (info->step || info->hunt) {
+			if (info->step)
+				ret = bootdev_hunt_steps(std, info, seq, show);
+			else
+				ret = info->hunt(info, show);
 			log_debug("  - hunt result %d\n", ret);
 			if (ret && ret != -ENOENT)
 				return ret;
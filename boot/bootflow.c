@@ -11,9 +11,12 @@
 #include <bootmeth.h>
 #include <bootstd.h>
 #include <dm.h>
+#include <env.h>
 #include <env_internal.h>
 #include <malloc.h>
+#include <part.h>
 #include <serial.h>
+#include <u-boot/crc.h>
 #include <dm/device-internal.h>
 #include <dm/uclass-internal.h>
 
@@ -355,6 +358,14 @@ static int bootflow_check(struct bootflow_iter *iter, struct bootflow *bflow)
 	dev = iter->dev;
 	ret = bootdev_get_bootflow(dev, iter, bflow);
 
+	/* Skip the bootflow already provided by the bootflow cache */
+	if (IS_ENABLED(CONFIG_BOOTSTD_CACHE) && !ret &&
+	    dev == iter->cached_dev && iter->part == iter->cached_part &&
+	    iter->method == iter->cached_method) {
+		bootflow_free(bflow);
+		ret = -EALREADY;
+	}
+
 	/* If we got a valid bootflow, return it */
 	if (!ret) {
 		log_debug("Bootdev '%s' part %d method '%s': Found bootflow\n",
@@ -377,21 +388,256 @@ static int bootflow_check(struct bootflow_iter *iter, struct bootflow *bflow)
 	return log_msg_ret("check", ret);
 }
 
-int bootflow_scan_first(struct udevice *dev, const char *label,
-			struct bootflow_iter *iter, int flags,
-			struct bootflow *bflow)
+/*
+ * The bootflow cache records the bootflow which was last booted, in the
+ * environment, as:
+ *
+ *	<label> <part> <bootmeth> <fname> <size> <crc32> <uuid> <order>
+ *
+ * where <label> is the media device, e.g. "mmc1", <part>, <size> and <crc32>
+ * are in hex, <uuid> is the partition UUID, or "-" if there is none, and
+ * <order> is the CRC32 of the bootdev order, in hex
+ */
+#define BOOTFLOW_CACHE_VAR	"bootflow_cache"
+#define BOOTFLOW_CACHE_FIELDS	8
+
+/**
+ * bootflow_cache_uuid() - Get the UUID of the partition holding a bootflow
+ *
+ * @blk: Block device
+ * @part: Partition number
+ * @info: Used to hold the partition information
+ * Return: UUID, or "-" if there is none
+ */
+static const char *bootflow_cache_uuid(struct udevice *blk, int part,
+				       struct disk_partition *info)
 {
-	int ret;
+	const char *uuid = NULL;
 
-	if (dev || label)
-		flags |= BOOTFLOWIF_SKIP_GLOBAL;
-	bootflow_iter_init(iter, flags);
+	if (IS_ENABLED(CONFIG_PARTITION_UUIDS) && part &&
+	    !part_get_info(dev_get_uclass_plat(blk), part, info))
+		uuid = disk_partition_uuid(info);
+
+	return uuid && *uuid ? uuid : "-";
+}
+
+/* Get the CRC32 of a bootflow's file, which is normally small, e.g. a script */
+static u32 bootflow_cache_crc(struct bootflow *bflow)
+{
+	return crc32(0, (uchar *)bflow->buf, bflow->buf ? bflow->size : 0);
+}
+
+/**
+ * bootflow_cache_order() - Get a checksum of the bootdev order
+ *
+ * A different bootdev might come first if the order has changed since the
+ * bootflow was cached, so the cache is not used then. This does not use
+ * bootstd_get_bootdev_order(), since that replaces the list which a scan in
+ * progress may be using
+ *
+ * Return: CRC32 of the boot_targets variable if set, else of the bootdev order
+ *	in the devicetree, 0 if there is none
+ */
+static u32 bootflow_cache_order(void)
+{
+	const char *targets = env_get("boot_targets");
+	const char *const *label;
+	struct bootstd_priv *std;
+	u32 crc = 0;
+
+	if (targets && *targets)
+		return crc32(0, (uchar *)targets, strlen(targets));
+	if (!bootstd_get_priv(&std)) {
+		for (label = std->bootdev_order; label && *label; label++)
+			crc = crc32(crc, (uchar *)*label, strlen(*label) + 1);
+	}
+
+	return crc;
+}
+
+/**
+ * bootflow_cache_key() - Get the cache record for a bootflow
+ *
+ * Only bootflows on block devices can be cached, since other bootdevs must be
+ * set up (e.g. with DHCP) before their bootflows can be found anyway
+ *
+ * @bflow: Bootflow to check
+ * @buf: Returns the record
+ * @size: Size of @buf
+ * Return: 0 if OK, -EOPNOTSUPP if the bootflow cannot be cached, -ENOSPC if
+ *	the record is too large
+ */
+static int bootflow_cache_key(struct bootflow *bflow, char *buf, int size)
+{
+	struct disk_partition info;
+	struct udevice *media;
+	enum uclass_id id;
+	int len;
+
+	if (!bflow->dev || !bflow->blk || !bflow->fname)
+		return -EOPNOTSUPP;
+	media = dev_get_parent(bflow->dev);
+	id = device_get_uclass_id(media);
+	len = snprintf(buf, size, "%s%d %x %s %s %x %x %s %x",
+		       id == UCLASS_MASS_STORAGE ? "usb" : uclass_get_name(id),
+		       dev_seq(media), bflow->part, bflow->method->name,
+		       bflow->fname, bflow->size, bootflow_cache_crc(bflow),
+		       bootflow_cache_uuid(bflow->blk, bflow->part, &info),
+		       bootflow_cache_order());
+	if (len >= size)
+		return -ENOSPC;
+
+	return 0;
+}
+
+/**
+ * bootflow_cache_update() - Record the bootflow which is being booted
+ *
+ * The environment is only saved if the record changes, so booting the same
+ * bootflow each time does not write to the environment
+ *
+ * @bflow: Bootflow being booted
+ */
+static void bootflow_cache_update(struct bootflow *bflow)
+{
+	const char *old = env_get(BOOTFLOW_CACHE_VAR);
+	char buf[256];
+
+	/* Don't leave a stale record if this bootflow cannot be cached */
+	if (bootflow_cache_key(bflow, buf, sizeof(buf)))
+		*buf = '\0';
+	if (!strcmp(old ? old : "", buf))
+		return;
+	log_debug("Updating bootflow cache: '%s'\n", buf);
+	env_set(BOOTFLOW_CACHE_VAR, *buf ? buf : NULL);
+	if (IS_ENABLED(CONFIG_BOOTSTD_CACHE_SAVE))
+		env_save();
+}
+
+/**
+ * bootflow_cache_find() - Find the bootflow which was last booted
+ *
+ * This avoids hunting and scanning all bootdevs: only the cached bootdev's
+ * uclass is hunted, if BOOTFLOWIF_HUNT is set, and only the cached partition
+ * and bootmeth are checked. The bootflow is used only if the bootdev order,
+ * its partition UUID and the size and CRC32 of its file match those recorded
+ *
+ * @iter: Iterator to set up
+ * @flags: Flags for iterator (enum bootflow_iter_flags_t)
+ * @bflow: Returns the bootflow if found
+ * Return: 0 if found, -ve if there is no cache record or it does not match
+ */
+static int bootflow_cache_find(struct bootflow_iter *iter, int flags,
+			       struct bootflow *bflow)
+{
+	char *field[BOOTFLOW_CACHE_FIELDS];
+	struct disk_partition info;
+	struct udevice *dev, *blk;
+	int method_flags, part;
+	const char *val;
+	char *str, *s;
+	int ret, i;
+	bool ok;
+
+	val = env_get(BOOTFLOW_CACHE_VAR);
+	if (!val)
+		return -ENOENT;
+	str = strdup(val);
+	if (!str)
+		return log_msg_ret("cst", -ENOMEM);
+	for (i = 0, s = str; i < BOOTFLOW_CACHE_FIELDS && s; i++)
+		field[i] = strsep(&s, " ");
+	if (i != BOOTFLOW_CACHE_FIELDS) {
+		ret = log_msg_ret("cfl", -EINVAL);
+		goto err_str;
+	}
+	if (hextoul(field[7], NULL) != bootflow_cache_order()) {
+		ret = log_msg_ret("cor", -ESTALE);
+		goto err_str;
+	}
+	part = hextoul(field[1], NULL);
+
+	bootflow_iter_init(iter, flags | BOOTFLOWIF_SINGLE_PARTITION);
+	ret = bootmeth_setup_iter_order(iter,
+					!(flags & BOOTFLOWIF_SKIP_GLOBAL));
+	if (ret)
+		goto err_str;
+	iter->doing_global = false;
+	for (i = 0; i < iter->num_methods; i++) {
+		if (!strcmp(field[2], iter->method_order[i]->name))
+			break;
+	}
+	if (i == iter->num_methods) {
+		ret = log_msg_ret("cmt", -ENOENT);
+		goto err_iter;
+	}
+	iter->cur_method = i;
+	iter->method = iter->method_order[i];
+
+	if (flags & BOOTFLOWIF_HUNT)
+		ret = bootdev_hunt_and_find_by_label(field[0], &dev,
+						     &method_flags);
+	else
+		ret = bootdev_find_by_label(field[0], &dev, &method_flags);
+	if (!ret)
+		ret = device_probe(dev);
+	if (!ret)
+		ret = bootdev_get_sibling_blk(dev, &blk);
+	if (ret) {
+		ret = log_msg_ret("cdv", ret);
+		goto err_iter;
+	}
+
+	/* Check the partition before reading anything from it */
+	if (strcmp(field[6], bootflow_cache_uuid(blk, part, &info))) {
+		ret = log_msg_ret("cuu", -ESTALE);
+		goto err_iter;
+	}
+
+	bootflow_iter_set_dev(iter, dev, method_flags);
+	iter->part = part;
+	ret = bootflow_check(iter, bflow);
+	ok = !ret && bflow->fname && !strcmp(field[3], bflow->fname) &&
+		hextoul(field[4], NULL) == (ulong)bflow->size &&
+		hextoul(field[5], NULL) == bootflow_cache_crc(bflow);
+	if (!ok) {
+		bootflow_free(bflow);
+		ret = log_msg_ret("cmm", -ESTALE);
+		goto err_iter;
+	}
+	free(str);
+	log_debug("Using cached bootflow '%s'\n", bflow->name);
+	iter->flags |= BOOTFLOWIF_CACHED;
+
+	return 0;
+
+err_iter:
+	bootflow_iter_uninit(iter);
+err_str:
+	free(str);
+
+	return ret;
+}
+
+/**
+ * bootflow_scan_setup() - Set up an iterator and find the first bootflow
+ *
+ * @iter: Iterator, which must have been inited by bootflow_iter_init()
+ * @label: Label to control the scan, NULL to work through all devices
+ * @bflow: Place to put the bootflow if found
+ * Return: 0 if found, -ENODEV if no device, other -ve on other error
+ */
+static int bootflow_scan_setup(struct bootflow_iter *iter, const char *label,
+			       struct bootflow *bflow)
+{
+	int ret;
 
 	/*
 	 * Set up the ordering of bootmeths. This sets iter->doing_global and
 	 * iter->first_glob_method if we are starting with the global bootmeths
 	 */
-	ret = bootmeth_setup_iter_order(iter, !(flags & BOOTFLOWIF_SKIP_GLOBAL));
+	ret = bootmeth_setup_iter_order(iter,
+					!(iter->flags & BOOTFLOWIF_SKIP_GLOBAL));
 	if (ret)
 		return log_msg_ret("obmeth", -ENODEV);
 
@@ -425,10 +671,55 @@ int bootflow_scan_first(struct udevice *dev, const char *label,
 	return 0;
 }
 
+int bootflow_scan_first(struct udevice *dev, const char *label,
+			struct bootflow_iter *iter, int flags,
+			struct bootflow *bflow)
+{
+	if (dev || label)
+		flags |= BOOTFLOWIF_SKIP_GLOBAL;
+	else if (IS_ENABLED(CONFIG_BOOTSTD_CACHE) &&
+		 (flags & (BOOTFLOWIF_CACHE | BOOTFLOWIF_ALL)) ==
+		 BOOTFLOWIF_CACHE && !bootflow_cache_find(iter, flags, bflow))
+		return 0;
+	bootflow_iter_init(iter, flags);
+
+	return bootflow_scan_setup(iter, label, bflow);
+}
+
+/**
+ * bootflow_scan_uncached() - Start a full scan after using the bootflow cache
+ *
+ * The cached bootflow has already been returned, so it is skipped if the scan
+ * finds it again
+ *
+ * @iter: Iterator, as set up by bootflow_cache_find()
+ * @bflow: Place to put the bootflow if found
+ * Return: 0 if found, -ENODEV if no device, other -ve on other error
+ */
+static int bootflow_scan_uncached(struct bootflow_iter *iter,
+				  struct bootflow *bflow)
+{
+	struct udevice *dev = iter->dev, *method = iter->method;
+	int part = iter->part;
+
+	bootflow_iter_uninit(iter);
+	bootflow_iter_init(iter, iter->flags &
+			   ~(BOOTFLOWIF_CACHED | BOOTFLOWIF_SINGLE_PARTITION));
+	iter->cached_dev = dev;
+	iter->cached_part = part;
+	iter->cached_method = method;
+
+	return bootflow_scan_setup(iter, NULL, bflow);
+}
+
 int bootflow_scan_next(struct bootflow_iter *iter, struct bootflow *bflow)
 {
 	int ret;
 
+	if (IS_ENABLED(CONFIG_BOOTSTD_CACHE) &&
+	    (iter->flags & BOOTFLOWIF_CACHED))
+		return bootflow_scan_uncached(iter, bflow);
+
 	do {
 		ret = iter_incr(iter);
 		log_debug("iter_incr: ret=%d\n", ret);
@@ -507,6 +798,8 @@ int bootflow_boot(struct bootflow *bflow)
 	if (bflow->state != BOOTFLOWST_READY)
 		return log_msg_ret("load", -EPROTO);
 
+	if (CONFIG_IS_ENABLED(BOOTSTD_HUNT_BACKGROUND))
+		bootdev_hunt_stop_all();
 	ret = bootmeth_boot(bflow->method, bflow);
 	if (ret)
 		return log_msg_ret("boot", ret);
@@ -528,6 +821,8 @@ int bootflow_run_boot(struct bootflow_iter *iter, struct bootflow *bflow)
 	if (IS_ENABLED(CONFIG_OF_HAS_PRIOR_STAGE) &&
 	    (bflow->flags & BOOTFLOWF_USE_PRIOR_FDT))
 		printf("Using prior-stage device tree\n");
+	if (IS_ENABLED(CONFIG_BOOTSTD_CACHE))
+		bootflow_cache_update(bflow);
 	ret = bootflow_boot(bflow);
 	if (!IS_ENABLED(CONFIG_BOOTSTD_FULL)) {
 		printf("Boot failed (err=%d)\n", ret);
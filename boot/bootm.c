@@ -10,6 +10,7 @@
 #include <cli.h>
 #include <command.h>
 #include <cpu_func.h>
+#include <dma.h>
 #include <env.h>
 #include <errno.h>
 #include <fdt_support.h>
@@ -203,6 +204,17 @@ static int boot_get_kernel(const char *addr_fit, struct bootm_headers *images,
 		images->fit_uname_os = fit_uname_kernel;
 		images->fit_uname_cfg = fit_uname_config;
 		images->fit_noffset_os = os_noffset;
+		if (CONFIG_IS_ENABLED(FIT_VERBOSE) && fit_uname_config) {
+			struct fit_plan plan;
+			int cfg_noffset;
+
+			cfg_noffset = fit_conf_get_node(images->fit_hdr_os,
+							fit_uname_config);
+			if (cfg_noffset >= 0 &&
+			    !fit_plan_config(images->fit_hdr_os, cfg_noffset,
+					     &plan))
+				fit_plan_print(&plan);
+		}
 		break;
 #endif
 #ifdef CONFIG_ANDROID_BOOT_IMAGE
@@ -241,6 +253,7 @@ static int boot_get_kernel(const char *addr_fit, struct bootm_headers *images,
 
 static int bootm_start(void)
 {
+	free(images.align_buf);
 	memset((void *)&images, 0, sizeof(images));
 	images.verify = env_get_yesno("verify");
 
@@ -577,7 +590,7 @@ static int handle_decomp_error(int comp_type, size_t uncomp_size,
 	if (ret == -ENOSYS)
 		return BOOTM_ERR_UNIMPLEMENTED;
 
-	if (uncomp_size >= buf_size)
+	if (uncomp_size >= buf_size || ret == -ENOSPC)
 		printf("Image too large: increase CONFIG_SYS_BOOTM_LEN\n");
 	else
 		printf("%s: uncompress error %d\n", name, ret);
@@ -632,9 +645,16 @@ static int bootm_load_os(struct bootm_headers *images, int boot_progress)
 
 	load_buf = map_sysmem(load, 0);
 	image_buf = map_sysmem(os.image_start, image_len);
-	err = image_decomp(os.comp, load, os.image_start, os.type,
-			   load_buf, image_buf, image_len,
-			   CONFIG_SYS_BOOTM_LEN, &load_end);
+	if (CONFIG_IS_ENABLED(FIT_CHUNKED) && images->fit_hdr_os)
+		err = fit_image_decomp(images->fit_hdr_os,
+				       images->fit_noffset_os, os.comp, load,
+				       os.image_start, os.type, load_buf,
+				       image_buf, image_len,
+				       CONFIG_SYS_BOOTM_LEN, &load_end);
+	else
+		err = image_decomp(os.comp, load, os.image_start, os.type,
+				   load_buf, image_buf, image_len,
+				   CONFIG_SYS_BOOTM_LEN, &load_end);
 	if (err) {
 		err = handle_decomp_error(os.comp, load_end - load,
 					  CONFIG_SYS_BOOTM_LEN, err);
@@ -643,6 +663,8 @@ static int bootm_load_os(struct bootm_headers *images, int boot_progress)
 	}
 	/* We need the decompressed image size in the next steps */
 	images->os.image_len = load_end - load;
+	if (os.comp == IH_COMP_NONE && load != image_start)
+		images->bytes_moved += image_len;
 
 	flush_cache(flush_start, ALIGN(load_end, ARCH_DMA_MINALIGN) - flush_start);
 
@@ -687,7 +709,10 @@ static int bootm_load_os(struct bootm_headers *images, int boot_progress)
 			printf("Moving Image from 0x%lx to 0x%lx, end=0x%lx\n",
 			       load, relocated_addr,
 			       relocated_addr + image_size);
-			memmove((void *)relocated_addr, load_buf, image_size);
+			if (dma_memcpy_offload((void *)relocated_addr, load_buf,
+					       image_size))
+				memmove((void *)relocated_addr, load_buf,
+					image_size);
 		}
 
 		images->ep = relocated_addr;
@@ -68,6 +68,8 @@ static int bootstd_remove(struct udevice *dev)
 	free(priv->prefixes);
 	free(priv->bootdev_order);
 	bootstd_clear_glob_(priv);
+	if (priv->hunters_active)
+		cyclic_unregister(&priv->hunt_cyclic);
 
 	return 0;
 }
@@ -1080,6 +1080,185 @@ int fit_image_get_data_and_size(const void *fit, int noffset,
 	return ret;
 }
 
+int fit_image_get_blocks(const void *fit, int noffset, size_t size,
+			 ulong *block_sizep, const fdt32_t **offsetsp)
+{
+	const fdt32_t *offsets, *val;
+	int count, len, i;
+
+	if (!CONFIG_IS_ENABLED(FIT_CHUNKED))
+		return 0;
+
+	offsets = fdt_getprop(fit, noffset, FIT_COMP_BLOCK_OFFSETS_PROP, &len);
+	if (!offsets)
+		return 0;
+
+	val = fdt_getprop(fit, noffset, FIT_COMP_BLOCK_SIZE_PROP, &i);
+	if (!val || i != sizeof(*val) || !fdt32_to_cpu(*val)) {
+		debug("Missing or invalid '%s' property\n",
+		      FIT_COMP_BLOCK_SIZE_PROP);
+		return -EINVAL;
+	}
+
+	/* The offsets must start at 0, increase and end with the data */
+	count = len / sizeof(*offsets) - 1;
+	if (count < 1 || fdt32_to_cpu(offsets[0]) ||
+	    fdt32_to_cpu(offsets[count]) != size) {
+		debug("Invalid '%s' property\n", FIT_COMP_BLOCK_OFFSETS_PROP);
+		return -EINVAL;
+	}
+	for (i = 0; i < count; i++) {
+		if (fdt32_to_cpu(offsets[i + 1]) <= fdt32_to_cpu(offsets[i])) {
+			debug("Block %d is empty\n", i);
+			return -EINVAL;
+		}
+	}
+	*block_sizep = fdt32_to_cpu(*val);
+	*offsetsp = offsets;
+
+	return count;
+}
+
+/**
+ * fit_decomp_block() - decompress a block of a sub-image
+ *
+ * @comp: compression type (IH_COMP_...)
+ * @data: sub-image data
+ * @offsets: block offsets, from fit_image_get_blocks()
+ * @block: block number
+ * @dst: destination
+ * @space: space available at @dst
+ * @lenp: returns the number of bytes written to @dst
+ * Return: 0 if OK, -ENOSYS if @comp is not supported, -EIO on error
+ */
+static int fit_decomp_block(int comp, const void *data,
+			    const fdt32_t *offsets, int block, void *dst,
+			    ulong space, ulong *lenp)
+{
+	ulong start = fdt32_to_cpu(offsets[block]);
+	int ret;
+
+	*lenp = fdt32_to_cpu(offsets[block + 1]) - start;
+	ret = image_decomp_buf(comp, dst, space, (void *)data + start, lenp);
+	if (ret && ret != -ENOSYS) {
+		debug("Cannot decompress block %d: %d\n", block, ret);
+		return -EIO;
+	}
+
+	return ret;
+}
+
+int fit_image_decomp(const void *fit, int noffset, int comp, ulong load,
+		     ulong image_start, int type, void *load_buf,
+		     void *image_buf, ulong image_len, uint unc_len,
+		     ulong *load_end)
+{
+	ulong block_size, space, len;
+	const fdt32_t *offsets;
+	int count, i, ret;
+
+	count = fit_image_get_blocks(fit, noffset, image_len, &block_size,
+				     &offsets);
+	if (count < 0)
+		return count;
+	if (!count || comp == IH_COMP_NONE)
+		return image_decomp(comp, load, image_start, type, load_buf,
+				    image_buf, image_len, unc_len, load_end);
+
+	printf("   Uncompressing %s to %lx (%d blocks)\n",
+	       genimg_get_type_name(type), load, count);
+	*load_end = load;
+	for (i = 0; i < count; i++) {
+		space = unc_len - (*load_end - load);
+		if (space > block_size)
+			space = block_size;
+		ret = fit_decomp_block(comp, image_buf, offsets, i, load_buf,
+				       space, &len);
+		if (ret)
+			return ret;
+
+		/* Only the last block may be short */
+		if (i < count - 1 && len != block_size) {
+			debug("Block %d has %lx bytes\n", i, len);
+			return -EINVAL;
+		}
+		load_buf += len;
+		*load_end += len;
+	}
+
+	return 0;
+}
+
+int fit_image_read_range(const void *fit, int noffset, ulong offset,
+			 ulong len, void *dst)
+{
+	ulong block_size, start, want, done, out_len;
+	const fdt32_t *offsets;
+	const void *data;
+	void *buf = NULL;
+	int count, first, last, i, ret;
+	uint8_t comp;
+	size_t size;
+
+	if (fit_image_get_data_and_size(fit, noffset, &data, &size))
+		return -ENOENT;
+	if (fdt_subnode_offset(fit, noffset, FIT_CIPHER_NODENAME) >= 0)
+		return -EACCES;
+
+	if (fit_image_get_comp(fit, noffset, &comp) || comp == IH_COMP_NONE) {
+		if (offset > size || len > size - offset)
+			return -ERANGE;
+		memcpy(dst, data + offset, len);
+		return 0;
+	}
+
+	count = fit_image_get_blocks(fit, noffset, size, &block_size,
+				     &offsets);
+	if (count <= 0)
+		return count ? count : -EPROTONOSUPPORT;
+	if (!len)
+		return 0;
+	first = offset / block_size;
+	last = (offset + len - 1) / block_size;
+	if (last >= count)
+		return -ERANGE;
+
+	done = 0;
+	for (i = first; i <= last; i++) {
+		start = i == first ? offset % block_size : 0;
+		want = block_size - start;
+		if (want > len - done)
+			want = len - done;
+
+		/* Use a bounce buffer unless the whole block is wanted */
+		if (!start && want == block_size) {
+			ret = fit_decomp_block(comp, data, offsets, i,
+					       dst + done, block_size,
+					       &out_len);
+		} else {
+			if (!buf) {
+				buf = malloc(block_size);
+				if (!buf)
+					return -ENOMEM;
+			}
+			ret = fit_decomp_block(comp, data, offsets, i, buf,
+					       block_size, &out_len);
+			if (!ret && out_len >= start + want)
+				memcpy(dst + done, buf + start, want);
+		}
+		if (!ret && out_len < start + want)
+			ret = -ERANGE;
+		if (ret) {
+			free(buf);
+			return ret;
+		}
+		done += want;
+	}
+	free(buf);
+
+	return last - first + 1;
+}
+
 /**
  * fit_image_hash_get_algo - get hash algorithm name
  * @fit: pointer to the FIT format image header
@@ -1249,34 +1428,16 @@ int fit_set_timestamp(void *fit, int noffset, time_t timestamp)
 int calculate_hash(const void *data, int data_len, const char *name,
 			uint8_t *value, int *value_len)
 {
-#if !defined(USE_HOSTCC) && defined(CONFIG_DM_HASH)
-	int rc;
-	enum HASH_ALGO hash_algo;
-	struct udevice *dev;
-
-	rc = uclass_get_device(UCLASS_HASH, 0, &dev);
-	if (rc) {
-		debug("failed to get hash device, rc=%d\n", rc);
-		return -1;
-	}
-
-	hash_algo = hash_algo_lookup_by_name(name);
-	if (hash_algo == HASH_ALGO_INVALID) {
-		debug("Unsupported hash algorithm\n");
-		return -1;
-	};
-
-	rc = hash_digest_wd(dev, hash_algo, data, data_len, value, CHUNKSZ);
-	if (rc) {
-		debug("failed to get hash value, rc=%d\n", rc);
-		return -1;
-	}
-
-	*value_len = hash_algo_digest_size(hash_algo);
-#else
 	struct hash_algo *algo;
 	int ret;
 
+#if !defined(USE_HOSTCC) && defined(CONFIG_DM_HASH)
+	/* Use a hash device if there is one, else hash in software */
+	if (!hash_offload(name, data, data_len, value, CHUNKSZ)) {
+		*value_len = hash_algo_digest_size(hash_algo_lookup_by_name(name));
+		return 0;
+	}
+#endif
 	ret = hash_lookup_algo(name, &algo);
 	if (ret < 0) {
 		debug("Unsupported hash alogrithm\n");
@@ -1285,7 +1446,6 @@ int calculate_hash(const void *data, int data_len, const char *name,
 
 	algo->hash_func_ws(data, data_len, value, algo->chunk_size);
 	*value_len = algo->digest_size;
-#endif
 
 	return 0;
 }
@@ -2047,6 +2207,208 @@ static const char *fit_get_image_type_property(int type)
 	return "unknown";
 }
 
+/* Alignment an image needs to be used in place, FDTs must be 8-byte aligned */
+static ulong fit_image_align(int image_type)
+{
+	return image_type == IH_TYPE_FLATDT ? 8 : 1;
+}
+
+/**
+ * fit_plan_action() - decide how fit_image_load() loads an image
+ *
+ * @image_type: image type requested from fit_image_load() (IH_TYPE_...)
+ * @comp: compression type of the image (IH_COMP_...)
+ * @data: address of the image data
+ * @load: load address, @data if there is none
+ * @has_load: true if the image must go to @load
+ * Return: action to take
+ */
+static enum fit_plan_action fit_plan_action(int image_type, int comp,
+					    ulong data, ulong load,
+					    bool has_load)
+{
+	/* Kernel images get decompressed later in bootm_load_os() */
+	if (comp != IH_COMP_NONE && image_type != IH_TYPE_KERNEL &&
+	    image_type != IH_TYPE_KERNEL_NOLOAD &&
+	    image_type != IH_TYPE_RAMDISK)
+		return load == data ? FIT_PLAN_DECOMP_ALLOC : FIT_PLAN_DECOMP;
+	if (load != data)
+		return FIT_PLAN_COPY;
+	if (!has_load && (data & (fit_image_align(image_type) - 1)))
+		return FIT_PLAN_COPY_ALIGN;
+
+	return FIT_PLAN_IN_PLACE;
+}
+
+int fit_plan_image(const void *fit, int noffset, int image_type,
+		   enum fit_load_op load_op, struct fit_plan_entry *entry)
+{
+	bool has_load = false;
+	const void *buf;
+	uint8_t comp;
+	size_t size;
+	ulong load;
+
+	if (fit_image_get_data_and_size(fit, noffset, &buf, &size))
+		return -ENOENT;
+	entry->data = map_to_sysmem((void *)buf);
+	entry->size = size;
+
+	load = entry->data;
+	if (load_op != FIT_LOAD_IGNORED) {
+		if (!fit_image_get_load(fit, noffset, &load)) {
+			has_load = load_op != FIT_LOAD_OPTIONAL_NON_ZERO ||
+				load;
+			if (!has_load)
+				load = entry->data;
+		} else if (load_op == FIT_LOAD_REQUIRED) {
+			return -EBADF;
+		}
+	}
+
+	comp = IH_COMP_NONE;
+	fit_image_get_comp(fit, noffset, &comp);
+	entry->action = fit_plan_action(image_type, comp, entry->data, load,
+					has_load);
+	switch (entry->action) {
+	case FIT_PLAN_DECOMP_ALLOC:
+	case FIT_PLAN_COPY_ALIGN:
+		entry->load = 0;
+		break;
+	default:
+		entry->load = load;
+		break;
+	}
+
+	return 0;
+}
+
+/**
+ * fit_plan_kernel() - work out how bootm_load_os() loads a kernel
+ *
+ * @fit: FIT holding the kernel
+ * @noffset: kernel node offset
+ * @entry: returns the plan for the kernel
+ * Return: 0 if OK, -ve on error
+ */
+static int fit_plan_kernel(const void *fit, int noffset,
+			   struct fit_plan_entry *entry)
+{
+	uint8_t comp, type;
+	ulong load;
+	int ret;
+
+	ret = fit_plan_image(fit, noffset, IH_TYPE_KERNEL, FIT_LOAD_IGNORED,
+			     entry);
+	if (ret)
+		return ret;
+
+	/* A 'noload' kernel runs where it is, unless it is compressed */
+	comp = IH_COMP_NONE;
+	fit_image_get_comp(fit, noffset, &comp);
+	if (!fit_image_get_type(fit, noffset, &type) &&
+	    type == IH_TYPE_KERNEL_NOLOAD) {
+		if (comp != IH_COMP_NONE) {
+			entry->action = FIT_PLAN_DECOMP_ALLOC;
+			entry->load = 0;
+		}
+		return 0;
+	}
+
+	if (fit_image_get_load(fit, noffset, &load))
+		return -EBADF;
+
+	entry->load = load;
+	if (comp != IH_COMP_NONE)
+		entry->action = FIT_PLAN_DECOMP;
+	else if (load != entry->data)
+		entry->action = FIT_PLAN_COPY;
+
+	return 0;
+}
+
+int fit_plan_config(const void *fit, int cfg_noffset, struct fit_plan *plan)
+{
+	static const struct {
+		const char *prop;
+		int type;
+		enum fit_load_op load_op;
+	} props[] = {
+		{ FIT_KERNEL_PROP, IH_TYPE_KERNEL, FIT_LOAD_IGNORED },
+		{ FIT_FDT_PROP, IH_TYPE_FLATDT, FIT_LOAD_OPTIONAL },
+		{ FIT_RAMDISK_PROP, IH_TYPE_RAMDISK,
+		  FIT_LOAD_OPTIONAL_NON_ZERO },
+		{ FIT_LOADABLE_PROP, IH_TYPE_LOADABLE,
+		  FIT_LOAD_OPTIONAL_NON_ZERO },
+	};
+	struct fit_plan_entry *entry;
+	enum fit_load_op load_op;
+	const char *uname;
+	int i, j, noffset, ret;
+
+	memset(plan, '\0', sizeof(*plan));
+	for (i = 0; i < ARRAY_SIZE(props); i++) {
+		for (j = 0;
+		     (uname = fdt_stringlist_get(fit, cfg_noffset, props[i].prop,
+						 j, NULL));
+		     j++) {
+			if (plan->count == FIT_PLAN_MAX_IMAGES)
+				return -E2BIG;
+			noffset = fit_image_get_node(fit, uname);
+			if (noffset < 0)
+				return -ENOENT;
+
+			entry = &plan->entry[plan->count++];
+			entry->prop = props[i].prop;
+			entry->uname = uname;
+			/* FDTs after the first are overlays, used in place */
+			load_op = j && props[i].type == IH_TYPE_FLATDT ?
+				FIT_LOAD_IGNORED : props[i].load_op;
+			if (props[i].type == IH_TYPE_KERNEL)
+				ret = fit_plan_kernel(fit, noffset, entry);
+			else
+				ret = fit_plan_image(fit, noffset,
+						     props[i].type, load_op,
+						     entry);
+			if (ret)
+				return ret;
+			if (entry->action == FIT_PLAN_COPY ||
+			    entry->action == FIT_PLAN_COPY_ALIGN)
+				plan->bytes_moved += entry->size;
+		}
+	}
+
+	return 0;
+}
+
+void fit_plan_print(const struct fit_plan *plan)
+{
+	static const char *const action_name[] = {
+		[FIT_PLAN_IN_PLACE]	= "in place",
+		[FIT_PLAN_DECOMP]	= "decompress",
+		[FIT_PLAN_DECOMP_ALLOC]	= "decompress",
+		[FIT_PLAN_COPY]		= "copy",
+		[FIT_PLAN_COPY_ALIGN]	= "copy/align",
+	};
+	const struct fit_plan_entry *entry;
+	int i;
+
+	printf("   Load plan:\n");
+	for (i = 0; i < plan->count; i++) {
+		entry = &plan->entry[i];
+		printf("     %-10s %-16s %-10s %8lx bytes at %08lx", entry->prop,
+		       entry->uname, action_name[entry->action], entry->size,
+		       entry->data);
+		if (entry->action == FIT_PLAN_IN_PLACE)
+			printf("\n");
+		else if (entry->load)
+			printf(" -> %08lx\n", entry->load);
+		else
+			printf(" -> allocated\n");
+	}
+	printf("   Bytes to move: %lx\n", plan->bytes_moved);
+}
+
 int fit_image_load(struct bootm_headers *images, ulong addr,
 		   const char **fit_unamep, const char **fit_uname_configp,
 		   int arch, int ph_type, int bootstage_id,
@@ -2063,6 +2425,7 @@ int fit_image_load(struct bootm_headers *images, ulong addr,
 	size_t size;
 	int type_ok, os_ok;
 	ulong load, load_end, data, len;
+	bool has_load;
 	uint8_t os, comp;
 	const char *prop_name;
 	int ret;
@@ -2224,6 +2587,7 @@ int fit_image_load(struct bootm_headers *images, ulong addr,
 
 	data = map_to_sysmem(buf);
 	load = data;
+	has_load = false;
 	if (load_op == FIT_LOAD_IGNORED) {
 		/* Don't load */
 	} else if (fit_image_get_load(fit, noffset, &load)) {
@@ -2238,13 +2602,14 @@ int fit_image_load(struct bootm_headers *images, ulong addr,
 
 		/*
 		 * move image data to the load address,
-		 * make sure we don't overwrite initial image
+		 * make sure we don't overwrite initial image, unless the data
+		 * is already there
 		 */
 		image_start = addr;
 		image_end = addr + fit_get_size(fit);
 
 		load_end = load + len;
-		if (image_type != IH_TYPE_KERNEL &&
+		if (image_type != IH_TYPE_KERNEL && load != data &&
 		    load < image_end && load_end > image_start) {
 			printf("Error: %s overwritten\n", prop_name);
 			return -EXDEV;
@@ -2252,35 +2617,56 @@ int fit_image_load(struct bootm_headers *images, ulong addr,
 
 		printf("   Loading %s from 0x%08lx to 0x%08lx\n",
 		       prop_name, data, load);
+		has_load = true;
 	} else {
 		load = data;	/* No load address specified */
 	}
 
 	comp = IH_COMP_NONE;
+	fit_image_get_comp(fit, noffset, &comp);
 	loadbuf = buf;
-	/* Kernel images get decompressed later in bootm_load_os(). */
-	if (!fit_image_get_comp(fit, noffset, &comp) &&
-	    comp != IH_COMP_NONE &&
-	    !(image_type == IH_TYPE_KERNEL ||
-	      image_type == IH_TYPE_KERNEL_NOLOAD ||
-	      image_type == IH_TYPE_RAMDISK)) {
+	switch (fit_plan_action(image_type, comp, data, load, has_load)) {
+	case FIT_PLAN_DECOMP:
+	case FIT_PLAN_DECOMP_ALLOC: {
 		ulong max_decomp_len = len * 20;
+
 		if (load == data) {
 			loadbuf = malloc(max_decomp_len);
 			load = map_to_sysmem(loadbuf);
 		} else {
 			loadbuf = map_sysmem(load, max_decomp_len);
 		}
-		if (image_decomp(comp, load, data, image_type,
-				loadbuf, buf, len, max_decomp_len, &load_end)) {
+		if (fit_image_decomp(fit, noffset, comp, load, data, image_type,
+				     loadbuf, buf, len, max_decomp_len,
+				     &load_end)) {
 			printf("Error decompressing %s\n", prop_name);
 
 			return -ENOEXEC;
 		}
 		len = load_end - load;
-	} else if (load != data) {
+		break;
+	}
+	case FIT_PLAN_COPY:
 		loadbuf = map_sysmem(load, len);
+		memmove_wd(loadbuf, buf, len, CHUNKSZ);
+		if (images)
+			images->bytes_moved += len;
+		break;
+	case FIT_PLAN_COPY_ALIGN:
+		/* The copy is kept until the next bootm_start() frees it */
+		if (!images)
+			break;
+		loadbuf = malloc(len);
+		if (!loadbuf)
+			return -ENOMEM;
 		memcpy(loadbuf, buf, len);
+		free(images->align_buf);
+		images->align_buf = loadbuf;
+		load = map_to_sysmem(loadbuf);
+		images->bytes_moved += len;
+		break;
+	case FIT_PLAN_IN_PLACE:
+		break;
 	}
 
 	if (image_type == IH_TYPE_RAMDISK && comp != IH_COMP_NONE)
@@ -36,7 +36,8 @@ int bootstd_prog_boot(void)
 
 	printf("Programmatic boot starting\n");
 	show_bootmeths();
-	flags = BOOTFLOWIF_HUNT | BOOTFLOWIF_SHOW | BOOTFLOWIF_SKIP_GLOBAL;
+	flags = BOOTFLOWIF_HUNT | BOOTFLOWIF_SHOW | BOOTFLOWIF_SKIP_GLOBAL |
+		BOOTFLOWIF_CACHE;
 
 	bootstd_clear_glob();
 	for (i = 0, ret = bootflow_scan_first(NULL, NULL, &iter, flags, &bflow);
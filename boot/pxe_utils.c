@@ -17,6 +17,7 @@
 #include <fdt_support.h>
 #include <video.h>
 #include <linux/libfdt.h>
+#include <linux/sizes.h>
 #include <linux/string.h>
 #include <linux/ctype.h>
 #include <errno.h>
@@ -34,6 +35,9 @@
 
 #define MAX_TFTP_PATH_LEN 512
 
+/* Size of each block of memory used to hold the parsed menu */
+#define PXE_ARENA_BLOCK_SIZE	SZ_4K
+
 int pxe_get_file_size(ulong *sizep)
 {
 	const char *val;
@@ -223,49 +227,15 @@ static int get_relfile_envaddr(struct pxe_context *ctx, const char *file_path,
 /**
  * label_create() - crate a new PXE label
  *
- * Allocates memory for and initializes a pxe_label. This uses malloc, so the
- * result must be free()'d to reclaim the memory.
+ * Allocates memory for and initializes a pxe_label, in the menu's arena, so it
+ * is freed along with the menu
  *
+ * @cfg: Menu which the label is for
  * Returns a pointer to the label, or NULL if out of memory
  */
-static struct pxe_label *label_create(void)
+static struct pxe_label *label_create(struct pxe_menu *cfg)
 {
-	struct pxe_label *label;
-
-	label = malloc(sizeof(struct pxe_label));
-	if (!label)
-		return NULL;
-
-	memset(label, 0, sizeof(struct pxe_label));
-
-	return label;
-}
-
-/**
- * label_destroy() - free the memory used by a pxe_label
- *
- * This frees @label itself as well as memory used by its name,
- * kernel, config, append, initrd, fdt, fdtdir and fdtoverlay members, if
- * they're non-NULL.
- *
- * So - be sure to only use dynamically allocated memory for the members of
- * the pxe_label struct, unless you want to clean it up first. These are
- * currently only created by the pxe file parsing code.
- *
- * @label: Label to free
- */
-static void label_destroy(struct pxe_label *label)
-{
-	free(label->name);
-	free(label->kernel_label);
-	free(label->kernel);
-	free(label->config);
-	free(label->append);
-	free(label->initrd);
-	free(label->fdt);
-	free(label->fdtdir);
-	free(label->fdtoverlays);
-	free(label);
+	return arena_zalloc(&cfg->arena, sizeof(struct pxe_label));
 }
 
 /**
@@ -846,9 +816,9 @@ enum lex_state {
  * The location of *p is updated to point to the first character after the end
  * of the token - the ending delimiter.
  *
- * Memory for t->val is allocated using malloc and must be free()'d to reclaim
- * it.
+ * Memory for t->val is allocated from @ar
  *
+ * @ar: Arena to allocate from
  * @p: Points to a pointer to the current position in the input being processed.
  *	Updated to point at the first character after the current token
  * @t: Pointers to a token to fill in
@@ -856,7 +826,8 @@ enum lex_state {
  * @lower: true to convert the string to lower case when storing
  * Returns the new value of t->val, on success, NULL if out of memory
  */
-static char *get_string(char **p, struct token *t, char delim, int lower)
+static char *get_string(struct arena *ar, char **p, struct token *t,
+			char delim, int lower)
 {
 	char *b, *e;
 	size_t len, i;
@@ -881,7 +852,7 @@ static char *get_string(char **p, struct token *t, char delim, int lower)
 	 * Allocate memory to hold the string, and copy it in, converting
 	 * characters to lowercase if lower is != 0.
 	 */
-	t->val = malloc(len + 1);
+	t->val = arena_alloc(ar, len + 1);
 	if (!t->val)
 		return NULL;
 
@@ -925,10 +896,12 @@ static void get_keyword(struct token *t)
  * We have to keep track of which state we're in to know if we're looking to get
  * a string literal or a keyword.
  *
+ * @ar: Arena to allocate the token value from
  * @p: Points to a pointer to the current position in the input being processed.
  *	Updated to point at the first character after the current token
  */
-static void get_token(char **p, struct token *t, enum lex_state state)
+static void get_token(struct arena *ar, char **p, struct token *t,
+		      enum lex_state state)
 {
 	char *c = *p;
 
@@ -954,7 +927,7 @@ static void get_token(char **p, struct token *t, enum lex_state state)
 		t->type = T_EOF;
 		c++;
 	} else if (state == L_SLITERAL) {
-		get_string(&c, t, '\n', 0);
+		get_string(ar, &c, t, '\n', 0);
 	} else if (state == L_KEYWORD) {
 		/*
 		 * when we expect a keyword, we first get the next string
@@ -963,7 +936,7 @@ static void get_token(char **p, struct token *t, enum lex_state state)
 		 * converted to a keyword token of the appropriate type, and
 		 * if not, it remains a string token.
 		 */
-		get_string(&c, t, ' ', 1);
+		get_string(ar, &c, t, ' ', 1);
 		get_keyword(t);
 	}
 
@@ -995,12 +968,12 @@ static void eol_or_eof(char **c)
  * Parse a string literal and store a pointer it at *dst. String literals
  * terminate at the end of the line.
  */
-static int parse_sliteral(char **c, char **dst)
+static int parse_sliteral(struct arena *ar, char **c, char **dst)
 {
 	struct token t;
 	char *s = *c;
 
-	get_token(c, &t, L_SLITERAL);
+	get_token(ar, c, &t, L_SLITERAL);
 
 	if (t.type != T_STRING) {
 		printf("Expected string literal: %.*s\n", (int)(*c - s), s);
@@ -1015,12 +988,12 @@ static int parse_sliteral(char **c, char **dst)
 /*
  * Parse a base 10 (unsigned) integer and store it at *dst.
  */
-static int parse_integer(char **c, int *dst)
+static int parse_integer(struct arena *ar, char **c, int *dst)
 {
 	struct token t;
 	char *s = *c;
 
-	get_token(c, &t, L_SLITERAL);
+	get_token(ar, c, &t, L_SLITERAL);
 	if (t.type != T_STRING) {
 		printf("Expected string: %.*s\n", (int)(*c - s), s);
 		return -EINVAL;
@@ -1028,8 +1001,6 @@ static int parse_integer(char **c, int *dst)
 
 	*dst = simple_strtol(t.val, NULL, 10);
 
-	free(t.val);
-
 	return 1;
 }
 
@@ -1053,7 +1024,7 @@ static int handle_include(struct pxe_context *ctx, char **c, unsigned long base,
 	char *buf;
 	int ret;
 
-	err = parse_sliteral(c, &include_path);
+	err = parse_sliteral(&cfg->arena, c, &include_path);
 	if (err < 0) {
 		printf("Expected include path: %.*s\n", (int)(*c - s), s);
 		return err;
@@ -1089,11 +1060,11 @@ static int parse_menu(struct pxe_context *ctx, char **c, struct pxe_menu *cfg,
 	char *s = *c;
 	int err = 0;
 
-	get_token(c, &t, L_KEYWORD);
+	get_token(&cfg->arena, c, &t, L_KEYWORD);
 
 	switch (t.type) {
 	case T_TITLE:
-		err = parse_sliteral(c, &cfg->title);
+		err = parse_sliteral(&cfg->arena, c, &cfg->title);
 
 		break;
 
@@ -1102,7 +1073,7 @@ static int parse_menu(struct pxe_context *ctx, char **c, struct pxe_menu *cfg,
 		break;
 
 	case T_BACKGROUND:
-		err = parse_sliteral(c, &cfg->bmp);
+		err = parse_sliteral(&cfg->arena, c, &cfg->bmp);
 		break;
 
 	default:
@@ -1128,19 +1099,20 @@ static int parse_label_menu(char **c, struct pxe_menu *cfg,
 
 	s = *c;
 
-	get_token(c, &t, L_KEYWORD);
+	get_token(&cfg->arena, c, &t, L_KEYWORD);
 
 	switch (t.type) {
 	case T_DEFAULT:
 		if (!cfg->default_label)
-			cfg->default_label = strdup(label->name);
+			cfg->default_label = arena_strdup(&cfg->arena,
+							  label->name);
 
 		if (!cfg->default_label)
 			return -ENOMEM;
 
 		break;
 	case T_LABEL:
-		parse_sliteral(c, &label->menu);
+		parse_sliteral(&cfg->arena, c, &label->menu);
 		break;
 	default:
 		printf("Ignoring malformed menu command: %.*s\n",
@@ -1156,17 +1128,18 @@ static int parse_label_menu(char **c, struct pxe_menu *cfg,
  * Handles parsing a 'kernel' label.
  * expecting "filename" or "<fit_filename>#cfg"
  */
-static int parse_label_kernel(char **c, struct pxe_label *label)
+static int parse_label_kernel(struct arena *ar, char **c,
+			      struct pxe_label *label)
 {
 	char *s;
 	int err;
 
-	err = parse_sliteral(c, &label->kernel);
+	err = parse_sliteral(ar, c, &label->kernel);
 	if (err < 0)
 		return err;
 
 	/* copy the kernel label to compare with FDT / INITRD when FIT is used */
-	label->kernel_label = strdup(label->kernel);
+	label->kernel_label = arena_strdup(ar, label->kernel);
 	if (!label->kernel_label)
 		return -ENOMEM;
 
@@ -1174,7 +1147,7 @@ static int parse_label_kernel(char **c, struct pxe_label *label)
 	if (!s)
 		return 1;
 
-	label->config = strdup(s);
+	label->config = arena_strdup(ar, s);
 	if (!label->config)
 		return -ENOMEM;
 
@@ -1193,20 +1166,20 @@ static int parse_label_kernel(char **c, struct pxe_label *label)
  */
 static int parse_label(char **c, struct pxe_menu *cfg)
 {
+	struct arena *ar = &cfg->arena;
 	struct token t;
 	int len;
 	char *s = *c;
 	struct pxe_label *label;
 	int err;
 
-	label = label_create();
+	label = label_create(cfg);
 	if (!label)
 		return -ENOMEM;
 
-	err = parse_sliteral(c, &label->name);
+	err = parse_sliteral(ar, c, &label->name);
 	if (err < 0) {
 		printf("Expected label name: %.*s\n", (int)(*c - s), s);
-		label_destroy(label);
 		return -EINVAL;
 	}
 
@@ -1214,7 +1187,7 @@ static int parse_label(char **c, struct pxe_menu *cfg)
 
 	while (1) {
 		s = *c;
-		get_token(c, &t, L_KEYWORD);
+		get_token(ar, c, &t, L_KEYWORD);
 
 		err = 0;
 		switch (t.type) {
@@ -1224,11 +1197,11 @@ static int parse_label(char **c, struct pxe_menu *cfg)
 
 		case T_KERNEL:
 		case T_LINUX:
-			err = parse_label_kernel(c, label);
+			err = parse_label_kernel(ar, c, label);
 			break;
 
 		case T_APPEND:
-			err = parse_sliteral(c, &label->append);
+			err = parse_sliteral(ar, c, &label->append);
 			if (label->initrd)
 				break;
 			s = strstr(label->append, "initrd=");
@@ -1236,39 +1209,37 @@ static int parse_label(char **c, struct pxe_menu *cfg)
 				break;
 			s += 7;
 			len = (int)(strchr(s, ' ') - s);
-			label->initrd = malloc(len + 1);
-			strncpy(label->initrd, s, len);
-			label->initrd[len] = '\0';
+			label->initrd = arena_strndup(ar, s, len);
 
 			break;
 
 		case T_INITRD:
 			if (!label->initrd)
-				err = parse_sliteral(c, &label->initrd);
+				err = parse_sliteral(ar, c, &label->initrd);
 			break;
 
 		case T_FDT:
 			if (!label->fdt)
-				err = parse_sliteral(c, &label->fdt);
+				err = parse_sliteral(ar, c, &label->fdt);
 			break;
 
 		case T_FDTDIR:
 			if (!label->fdtdir)
-				err = parse_sliteral(c, &label->fdtdir);
+				err = parse_sliteral(ar, c, &label->fdtdir);
 			break;
 
 		case T_FDTOVERLAYS:
 			if (!label->fdtoverlays)
-				err = parse_sliteral(c, &label->fdtoverlays);
+				err = parse_sliteral(ar, c, &label->fdtoverlays);
 			break;
 
 		case T_LOCALBOOT:
 			label->localboot = 1;
-			err = parse_integer(c, &label->localboot_val);
+			err = parse_integer(ar, c, &label->localboot_val);
 			break;
 
 		case T_IPAPPEND:
-			err = parse_integer(c, &label->ipappend);
+			err = parse_integer(ar, c, &label->ipappend);
 			break;
 
 		case T_KASLRSEED:
@@ -1324,7 +1295,7 @@ static int parse_pxefile_top(struct pxe_context *ctx, char *p, unsigned long bas
 	while (1) {
 		s = p;
 
-		get_token(&p, &t, L_KEYWORD);
+		get_token(&cfg->arena, &p, &t, L_KEYWORD);
 
 		err = 0;
 		switch (t.type) {
@@ -1336,7 +1307,7 @@ static int parse_pxefile_top(struct pxe_context *ctx, char *p, unsigned long bas
 			break;
 
 		case T_TIMEOUT:
-			err = parse_integer(&p, &cfg->timeout);
+			err = parse_integer(&cfg->arena, &p, &cfg->timeout);
 			break;
 
 		case T_LABEL:
@@ -1345,14 +1316,10 @@ static int parse_pxefile_top(struct pxe_context *ctx, char *p, unsigned long bas
 
 		case T_DEFAULT:
 		case T_ONTIMEOUT:
-			err = parse_sliteral(&p, &label_name);
-
-			if (label_name) {
-				if (cfg->default_label)
-					free(cfg->default_label);
+			err = parse_sliteral(&cfg->arena, &p, &label_name);
 
+			if (label_name)
 				cfg->default_label = label_name;
-			}
 
 			break;
 
@@ -1363,7 +1330,7 @@ static int parse_pxefile_top(struct pxe_context *ctx, char *p, unsigned long bas
 			break;
 
 		case T_PROMPT:
-			err = parse_integer(&p, &cfg->prompt);
+			err = parse_integer(&cfg->arena, &p, &cfg->prompt);
 			// Do not fail if prompt configuration is undefined
 			if (err <  0)
 				eol_or_eof(&p);
@@ -1390,18 +1357,7 @@ static int parse_pxefile_top(struct pxe_context *ctx, char *p, unsigned long bas
  */
 void destroy_pxe_menu(struct pxe_menu *cfg)
 {
-	struct list_head *pos, *n;
-	struct pxe_label *label;
-
-	free(cfg->title);
-	free(cfg->default_label);
-
-	list_for_each_safe(pos, n, &cfg->labels) {
-		label = list_entry(pos, struct pxe_label, list);
-
-		label_destroy(label);
-	}
-
+	arena_uninit(&cfg->arena);
 	free(cfg);
 }
 
@@ -1418,6 +1374,7 @@ struct pxe_menu *parse_pxefile(struct pxe_context *ctx, unsigned long menucfg)
 	memset(cfg, 0, sizeof(struct pxe_menu));
 
 	INIT_LIST_HEAD(&cfg->labels);
+	arena_init(&cfg->arena, PXE_ARENA_BLOCK_SIZE);
 
 	buf = map_sysmem(menucfg, 0);
 	r = parse_pxefile_top(ctx, buf, menucfg, cfg, 1);
@@ -1426,6 +1383,9 @@ struct pxe_menu *parse_pxefile(struct pxe_context *ctx, unsigned long menucfg)
 		destroy_pxe_menu(cfg);
 		return NULL;
 	}
+	log_debug("menu: %lu allocations, %lu bytes in %lu blocks\n",
+		  cfg->arena.stats.allocs, cfg->arena.stats.used,
+		  cfg->arena.stats.blocks);
 
 	return cfg;
 }
@@ -112,11 +112,14 @@ static int do_bootdev_hunt(struct cmd_tbl *cmdtp, int flag, int argc,
 	struct bootstd_priv *priv;
 	const char *spec = NULL;
 	bool list = false;
+	bool bg = false;
 	int ret = 0;
 
 	if (argc >= 2) {
 		if (!strcmp(argv[1], "-l"))
 			list = true;
+		else if (!strcmp(argv[1], "-b"))
+			bg = true;
 		else
 			spec = argv[1];
 	}
@@ -126,6 +129,17 @@ static int do_bootdev_hunt(struct cmd_tbl *cmdtp, int flag, int argc,
 		return ret;
 	if (list) {
 		bootdev_list_hunters(priv);
+	} else if (bg) {
+		if (!CONFIG_IS_ENABLED(BOOTSTD_HUNT_BACKGROUND)) {
+			printf("Not available (enable CONFIG_BOOTSTD_HUNT_BACKGROUND)\n");
+			return CMD_RET_FAILURE;
+		}
+		ret = bootdev_hunt_start();
+		if (ret) {
+			printf("Failed (err=%dE)\n", ret);
+
+			return CMD_RET_FAILURE;
+		}
 	} else {
 		ret = bootdev_hunt(spec, true);
 		if (ret) {
@@ -139,10 +153,10 @@ static int do_bootdev_hunt(struct cmd_tbl *cmdtp, int flag, int argc,
 }
 
 U_BOOT_LONGHELP(bootdev,
-	"list [-p]         - list all available bootdevs (-p to probe)\n"
-	"bootdev hunt [-l|<spec>]  - use hunt drivers to find bootdevs\n"
-	"bootdev select <bd>       - select a bootdev by name | label | seq\n"
-	"bootdev info [-p]         - show information about a bootdev (-p to probe)");
+	"list [-p]            - list all available bootdevs (-p to probe)\n"
+	"bootdev hunt [-l|-b|<spec>]  - use hunt drivers to find bootdevs\n"
+	"bootdev select <bd>          - select a bootdev by name | label | seq\n"
+	"bootdev info [-p]            - show information about a bootdev (-p to probe)");
 
 U_BOOT_CMD_WITH_SUBCMDS(bootdev, "Boot devices", bootdev_help_text,
 	U_BOOT_SUBCMD_MKENT(list, 2, 1, do_bootdev_list),
@@ -182,6 +182,8 @@ static int do_bootflow_scan(struct cmd_tbl *cmdtp, int flag, int argc,
 		flags |= BOOTFLOWIF_SKIP_GLOBAL;
 	if (!no_hunter)
 		flags |= BOOTFLOWIF_HUNT;
+	if (boot && !menu)
+		flags |= BOOTFLOWIF_CACHE;
 
 	/*
 	 * If we have a device, just scan for bootflows attached to that device
@@ -10,8 +10,11 @@
  */
 
 #include <command.h>
+#include <dm.h>
 #include <hash.h>
 #include <linux/ctype.h>
+#include <linux/math64.h>
+#include <u-boot/hash.h>
 
 #if IS_ENABLED(CONFIG_HASH_VERIFY)
 #define HARGS 6
@@ -19,12 +22,37 @@
 #define HARGS 5
 #endif
 
+/* Show how much data each hash device has hashed, and how fast */
+static int hash_show_stats(void)
+{
+	struct hash_dev_priv *uc_priv;
+	struct udevice *dev;
+	ulong rate;
+
+	printf("Device                Bytes    Time (ms)       KiB/s\n");
+	uclass_foreach_dev_probe(UCLASS_HASH, dev) {
+		uc_priv = dev_get_uclass_priv(dev);
+		rate = 0;
+		if (uc_priv->time_us)
+			rate = div64_u64(uc_priv->bytes * 1000000,
+					 uc_priv->time_us) >> 10;
+		printf("%-16s %10llu %12llu %11lu\n", dev->name, uc_priv->bytes,
+		       div_u64(uc_priv->time_us, 1000), rate);
+	}
+
+	return 0;
+}
+
 static int do_hash(struct cmd_tbl *cmdtp, int flag, int argc,
 		   char *const argv[])
 {
 	char *s;
 	int flags = HASH_FLAG_ENV;
 
+	if (IS_ENABLED(CONFIG_DM_HASH) && argc == 2 &&
+	    !strcmp(argv[1], "stats"))
+		return hash_show_stats();
+
 	if (argc < (HARGS - 1))
 		return CMD_RET_USAGE;
 
@@ -53,4 +81,8 @@ U_BOOT_CMD(
 		"    - verify message digest of memory area to immediate value, \n"
 		"      env var or *address"
 #endif
+#if IS_ENABLED(CONFIG_DM_HASH)
+	"\nhash stats\n"
+		"    - show the throughput of each hash device"
+#endif
 );
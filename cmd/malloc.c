@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Show how memory allocated by malloc() is being used
+ */
+
+#include <command.h>
+#include <malloc.h>
+#include <sort.h>
+#include <vsprintf.h>
+#include <asm/global_data.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+static int do_malloc_info(struct cmd_tbl *cmdtp, int flag, int argc,
+			  char *const argv[])
+{
+	struct malloc_usage usage;
+
+	malloc_get_usage(&usage);
+	printf("in use  : %lu bytes\n", usage.in_use);
+	printf("peak    : %lu bytes\n", usage.peak);
+	printf("allocs  : %lu\n", usage.allocs);
+
+	return 0;
+}
+
+/* Put the callers with the most memory in use first */
+static int h_cmp_site(const void *v1, const void *v2)
+{
+	const struct malloc_site *s1 = v1, *s2 = v2;
+
+	if (s1->live != s2->live)
+		return s1->live < s2->live ? 1 : -1;
+	if (s1->peak != s2->peak)
+		return s1->peak < s2->peak ? 1 : -1;
+
+	return s1->count < s2->count ? 1 : s1->count > s2->count ? -1 : 0;
+}
+
+static int do_malloc_dump(struct cmd_tbl *cmdtp, int flag, int argc,
+			  char *const argv[])
+{
+	const struct malloc_site *sites;
+	struct malloc_site *sorted;
+	uint count, i, shown, max;
+
+	if (!IS_ENABLED(CONFIG_SYS_MALLOC_SITES)) {
+		printf("Not available (enable CONFIG_SYS_MALLOC_SITES)\n");
+		return CMD_RET_FAILURE;
+	}
+	max = argc > 1 ? dectoul(argv[1], NULL) : UINT_MAX;
+
+	/* Sort a copy, since allocations may happen while printing */
+	sites = malloc_get_sites(&count);
+	sorted = malloc(count * sizeof(*sorted));
+	if (!sorted) {
+		printf("Out of memory\n");
+		return CMD_RET_FAILURE;
+	}
+	memcpy(sorted, sites, count * sizeof(*sorted));
+	qsort(sorted, count, sizeof(*sorted), h_cmp_site);
+
+	printf("%-16s %8s %10s %10s\n", "Caller", "Count", "Live", "Peak");
+	for (i = 0, shown = 0; i < count && shown < max; i++) {
+		struct malloc_site *site = &sorted[i];
+
+		if (!site->count)
+			continue;
+		if (site->caller)
+			printf("%-16lx", site->caller - gd->reloc_off);
+		else
+			printf("%-16s", "(other)");
+		printf(" %8lu %10lu %10lu\n", site->count, site->live,
+		       site->peak);
+		shown++;
+	}
+	free(sorted);
+
+	return 0;
+}
+
+U_BOOT_LONGHELP(malloc,
+	"info - show the amount of memory allocated\n"
+	"malloc dump [<n>] - show the callers with the most memory in use");
+
+U_BOOT_CMD_WITH_SUBCMDS(malloc, "Show malloc() usage", malloc_help_text,
+	U_BOOT_SUBCMD_MKENT(info, 1, 1, do_malloc_info),
+	U_BOOT_SUBCMD_MKENT(dump, 2, 1, do_malloc_dump));
@@ -16,6 +16,7 @@
 #include <command.h>
 #include <console.h>
 #include <display_options.h>
+#include <dma.h>
 #ifdef CONFIG_MTD_NOR_FLASH
 #include <flash.h>
 #endif
@@ -359,7 +360,8 @@ static int do_mem_cp(struct cmd_tbl *cmdtp, int flag, int argc,
 	}
 #endif
 
-	memmove(dst, src, count * size);
+	if (dma_memcpy_offload(dst, src, count * size))
+		memmove(dst, src, count * size);
 
 	unmap_sysmem(src);
 	unmap_sysmem(dst);
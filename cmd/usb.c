@@ -560,21 +560,74 @@ static int do_usbboot(struct cmd_tbl *cmdtp, int flag, int argc,
 }
 #endif /* CONFIG_USB_STORAGE */
 
+static void usb_scan_storage(void)
+{
+	/* Driver model will probe the devices as they are found */
+# ifdef CONFIG_USB_STORAGE
+	/* try to recognize storage devices immediately */
+	usb_stor_curr_dev = usb_stor_scan(1);
+# endif
+}
+
 static void do_usb_start(void)
 {
 	bootstage_mark_name(BOOTSTAGE_ID_USB_START, "usb_start");
 
 	if (usb_init() < 0)
 		return;
+	usb_scan_storage();
+}
 
-	/* Driver model will probe the devices as they are found */
-# ifdef CONFIG_USB_STORAGE
-	/* try to recognize storage devices immediately */
-	usb_stor_curr_dev = usb_stor_scan(1);
-# endif
+/* Finish a scan started with 'usb start -b', if there is one */
+static void do_usb_finish(void)
+{
+	if (!usb_scan_busy() || usb_scan_wait() < 0)
+		return;
+	usb_scan_storage();
 }
 
 #ifdef CONFIG_DM_USB
+/* Find the device attached to a hub port, or NULL if none */
+static struct udevice *usb_port_device(struct udevice *hub, int port)
+{
+	struct udevice *child;
+
+	device_foreach_child(child, hub) {
+		struct usb_device *udev = dev_get_parent_priv(child);
+
+		if (device_active(child) && udev && udev->portnr == port)
+			return child;
+	}
+
+	return NULL;
+}
+
+/* Show how long it took to scan each port of each hub */
+static void usb_show_ports(void)
+{
+	struct udevice *hub, *dev;
+	struct uclass *uc;
+	int port;
+
+	if (uclass_get(UCLASS_USB_HUB, &uc))
+		return;
+
+	printf("%-20s %4s %9s  %s\n", "Hub", "Port", "Time (ms)", "Device");
+	uclass_foreach_dev(hub, uc) {
+		struct usb_hub_device *hubd;
+
+		if (!device_active(hub))
+			continue;
+		hubd = dev_get_uclass_priv(hub);
+		for (port = 1; port <= hubd->desc.bNbrPorts; port++) {
+			dev = usb_port_device(hub, port);
+			printf("%-20s %4d %9lu  %s\n", hub->name, port,
+			       hubd->scan_time[port - 1],
+			       dev ? dev->name : "-");
+		}
+	}
+}
+
 static void usb_show_info(struct usb_device *udev)
 {
 	struct udevice *child;
@@ -608,8 +661,17 @@ static int do_usb(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 		return CMD_RET_USAGE;
 
 	if (strncmp(argv[1], "start", 5) == 0) {
-		if (usb_started)
+		if (usb_started) {
+			do_usb_finish();
 			return 0; /* Already started */
+		}
+		if (CONFIG_IS_ENABLED(USB_ASYNC_SCAN) && argc > 2 &&
+		    !strcmp(argv[2], "-b")) {
+			printf("starting USB in background...\n");
+			bootstage_mark_name(BOOTSTAGE_ID_USB_START, "usb_start");
+			usb_init_start();
+			return 0;
+		}
 		printf("starting USB...\n");
 		do_usb_start();
 		return 0;
@@ -632,6 +694,7 @@ static int do_usb(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 		printf("USB is stopped. Please issue 'usb start' first.\n");
 		return 1;
 	}
+	do_usb_finish();
 	if (strncmp(argv[1], "tree", 4) == 0) {
 		puts("USB device tree:\n");
 		usb_show_tree();
@@ -683,6 +746,12 @@ static int do_usb(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 		i = dectoul(argv[3], NULL);
 		return usb_test(udev, i, argv[4]);
 	}
+#ifdef CONFIG_DM_USB
+	if (strncmp(argv[1], "ports", 5) == 0) {
+		usb_show_ports();
+		return 0;
+	}
+#endif
 #ifdef CONFIG_USB_STORAGE
 	if (strncmp(argv[1], "stor", 4) == 0)
 		return usb_stor_info();
@@ -697,10 +766,16 @@ U_BOOT_CMD(
 	usb,	5,	1,	do_usb,
 	"USB sub-system",
 	"start - start (scan) USB controller\n"
+#if CONFIG_IS_ENABLED(USB_ASYNC_SCAN)
+	"usb start -b - start USB, scanning for devices in the background\n"
+#endif
 	"usb reset - reset (rescan) USB controller\n"
 	"usb stop [f] - stop USB [f]=force stop\n"
 	"usb tree - show USB device tree\n"
 	"usb info [dev] - show available USB devices\n"
+#ifdef CONFIG_DM_USB
+	"usb ports - show the time taken to scan each hub port\n"
+#endif
 	"usb test [dev] [port] [mode] - set USB 2.0 test mode\n"
 	"    (specify port 0 to indicate the device's upstream port)\n"
 	"    Available modes: J, K, S[E0_NAK], P[acket], F[orce_Enable]\n"
@@ -54,6 +54,10 @@ do_imgextract(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 
 	verify = env_get_yesno("verify");
 
+	/* An offset must come with a size, and both need FIT_CHUNKED */
+	if (argc == 5 || (argc > 5 && !CONFIG_IS_ENABLED(FIT_CHUNKED)))
+		return CMD_RET_USAGE;
+
 	if (argc > 1) {
 		addr = hextoul(argv[1], NULL);
 	}
@@ -67,7 +71,7 @@ do_imgextract(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 		dest = hextoul(argv[3], NULL);
 	}
 
-	switch (genimg_get_format((void *)addr)) {
+	switch (genimg_get_format(map_sysmem(addr, 0))) {
 #if defined(CONFIG_LEGACY_IMAGE_FORMAT)
 	case IMAGE_FORMAT_LEGACY:
 
@@ -131,7 +135,7 @@ do_imgextract(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 		printf("## Copying '%s' subimage from FIT image "
 			"at %08lx ...\n", uname, addr);
 
-		fit_hdr = (const void *)addr;
+		fit_hdr = map_sysmem(addr, 0);
 		if (fit_check_format(fit_hdr, IMAGE_SIZE_INVAL)) {
 			puts("Bad FIT image format\n");
 			return 1;
@@ -160,6 +164,28 @@ do_imgextract(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 			}
 		}
 
+		/* extract part of the subimage, decompressing only that */
+		if (CONFIG_IS_ENABLED(FIT_CHUNKED) && argc > 5) {
+			ulong offset = hextoul(argv[4], NULL);
+			int ret;
+
+			len = hextoul(argv[5], NULL);
+			printf("   Extracting %lx bytes at %lx ... ", len,
+			       offset);
+			ret = fit_image_read_range(fit_hdr, noffset, offset,
+						   len, map_sysmem(dest, len));
+			if (ret < 0) {
+				printf("error %d\n", ret);
+				return 1;
+			}
+			printf("OK, %d blocks decompressed\n", ret);
+			flush_cache(dest, ALIGN(len, ARCH_DMA_MINALIGN));
+			env_set_hex("fileaddr", dest);
+			env_set_hex("filesize", len);
+
+			return 0;
+		}
+
 		/* get subimage/external data address and length */
 		if (fit_image_get_data_and_size(fit_hdr, noffset,
 					       &fit_data, &fit_len)) {
@@ -281,10 +307,15 @@ U_BOOT_LONGHELP(imgextract,
 	"\n"
 	"addr uname [dest]\n"
 	"    - extract <uname> subimage from FIT image at <addr> and copy to <dest>"
+#if CONFIG_IS_ENABLED(FIT_CHUNKED)
+	"\n"
+	"addr uname dest offset size\n"
+	"    - extract <size> bytes at <offset> in <uname> subimage to <dest>"
+#endif
 #endif
 	);
 
 U_BOOT_CMD(
-	imxtract, 4, 1, do_imgextract,
+	imxtract, 6, 1, do_imgextract,
 	"extract a part of a multi-image", imgextract_help_text
 );
@@ -41,7 +41,7 @@ void cyclic_register(struct cyclic_info *cyclic, cyclic_func_t func,
 
 void cyclic_unregister(struct cyclic_info *cyclic)
 {
-	hlist_del(&cyclic->list);
+	hlist_del_init(&cyclic->list);
 }
 
 void cyclic_run(void)
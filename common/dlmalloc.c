@@ -37,6 +37,8 @@ DECLARE_GLOBAL_DATA_PTR;
  #undef MALLOC_ZERO
 static inline void MALLOC_ZERO(void *p, size_t sz) { memset(p, 0, sz); }
 static inline void MALLOC_COPY(void *dest, const void *src, size_t sz) { memcpy(dest, src, sz); }
+#elif CONFIG_IS_ENABLED(SYS_MALLOC_STATS)
+ #define STATIC_IF_MCHECK static
 #else
  #define STATIC_IF_MCHECK
  #define mALLOc_impl mALLOc
@@ -2240,6 +2242,298 @@ void mcheck_check_all(void) { mcheck_pedantic_check(); }
 
 enum mcheck_status mprobe(void *__ptr) { return mcheck_mprobe(__ptr); }
 // mcheck API }
+#elif CONFIG_IS_ENABLED(SYS_MALLOC_STATS)
+
+static struct malloc_usage malloc_usage;
+
+/* Check if the dlmalloc() heap is in use, rather than malloc_simple() */
+static bool malloc_is_full(void)
+{
+#if CONFIG_IS_ENABLED(SYS_MALLOC_F)
+	return gd->flags & GD_FLG_FULL_MALLOC_INIT;
+#else
+	return true;
+#endif
+}
+
+static void malloc_stats_add(Void_t *mem)
+{
+	if (!mem || !malloc_is_full())
+		return;
+	malloc_usage.in_use += malloc_usable_size(mem);
+	malloc_usage.allocs++;
+	if (malloc_usage.in_use > malloc_usage.peak)
+		malloc_usage.peak = malloc_usage.in_use;
+}
+
+static void malloc_stats_sub(Void_t *mem)
+{
+	if (malloc_is_full())
+		malloc_usage.in_use -= malloc_usable_size(mem);
+}
+
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SITES)
+
+/* Number of callers to track. The first slot collects any that do not fit */
+#define MALLOC_SITE_COUNT	256
+
+/**
+ * struct malloc_site_hdr - Header placed before each allocation
+ *
+ * @site: Index of the caller in malloc_sites[]
+ * @skip: Number of bytes before the header, to align the memory
+ * @size: Number of bytes requested by the caller
+ */
+struct malloc_site_hdr {
+	u32 site;
+	u32 skip;
+	ulong size;
+};
+
+#define MALLOC_SITE_HDR_SIZE \
+	ALIGN(sizeof(struct malloc_site_hdr), MALLOC_ALIGNMENT)
+
+static struct malloc_site malloc_sites[MALLOC_SITE_COUNT];
+static uint malloc_site_count = 1;
+
+/* Find the slot for a caller, using open addressing */
+static uint malloc_site_find(ulong caller)
+{
+	uint idx = (caller >> 2) % (MALLOC_SITE_COUNT - 1) + 1;
+	struct malloc_site *site;
+
+	while (1) {
+		site = &malloc_sites[idx];
+		if (site->caller == caller)
+			return idx;
+		if (!site->caller)
+			break;
+		if (++idx == MALLOC_SITE_COUNT)
+			idx = 1;
+	}
+
+	/* Keep a free slot, so that the search always ends */
+	if (malloc_site_count == MALLOC_SITE_COUNT - 1)
+		return 0;
+	malloc_site_count++;
+	site->caller = caller;
+
+	return idx;
+}
+
+/* Fill in the header for a new block and return the memory for the caller */
+static void *malloc_site_add(void *blk, size_t skip, size_t bytes,
+			     ulong caller)
+{
+	struct malloc_site_hdr *hdr = blk + skip;
+	struct malloc_site *site;
+
+	hdr->site = malloc_site_find(caller);
+	hdr->skip = skip;
+	hdr->size = bytes;
+	site = &malloc_sites[hdr->site];
+	site->count++;
+	site->live += bytes;
+	if (site->live > site->peak)
+		site->peak = site->live;
+
+	return (void *)hdr + MALLOC_SITE_HDR_SIZE;
+}
+
+/* Drop a block from its caller's total and return the start of the block */
+static void *malloc_site_remove(void *mem)
+{
+	struct malloc_site_hdr *hdr = mem - MALLOC_SITE_HDR_SIZE;
+
+	malloc_sites[hdr->site].live -= hdr->size;
+
+	return (void *)hdr - hdr->skip;
+}
+
+static void *malloc_site_alloc(size_t bytes, ulong caller)
+{
+	void *blk;
+
+	if (bytes > CONFIG_SYS_MALLOC_LEN)
+		return NULL;
+	blk = mALLOc_impl(bytes + MALLOC_SITE_HDR_SIZE);
+	if (!blk)
+		return NULL;
+	malloc_stats_add(blk);
+
+	return malloc_site_add(blk, 0, bytes, caller);
+}
+
+const struct malloc_site *malloc_get_sites(uint *countp)
+{
+	*countp = MALLOC_SITE_COUNT;
+
+	return malloc_sites;
+}
+
+#define malloc_caller()	((ulong)__builtin_return_address(0))
+
+/* Blocks from before relocation are outside the pool and have no header */
+static bool malloc_site_has_hdr(const void *mem)
+{
+	return (ulong)mem >= mem_malloc_start && (ulong)mem < mem_malloc_end;
+}
+
+Void_t *mALLOc(size_t bytes)
+{
+	if (!malloc_is_full())
+		return mALLOc_impl(bytes);
+
+	return malloc_site_alloc(bytes, malloc_caller());
+}
+
+void fREe(Void_t *mem)
+{
+	void *blk;
+
+	if (!mem || !malloc_is_full() || !malloc_site_has_hdr(mem)) {
+		fREe_impl(mem);
+		return;
+	}
+	blk = malloc_site_remove(mem);
+	malloc_stats_sub(blk);
+	fREe_impl(blk);
+}
+
+Void_t *rEALLOc(Void_t *oldmem, size_t bytes)
+{
+	ulong caller = malloc_caller();
+	struct malloc_site_hdr *hdr;
+	void *blk, *p;
+	size_t old_size;
+
+	if (!malloc_is_full())
+		return rEALLOc_impl(oldmem, bytes);
+	if (!oldmem)
+		return malloc_site_alloc(bytes, caller);
+	if (!malloc_site_has_hdr(oldmem))
+		return rEALLOc_impl(oldmem, bytes);
+
+	/* Aligned blocks cannot be resized in place, so copy them */
+	hdr = oldmem - MALLOC_SITE_HDR_SIZE;
+	if (hdr->skip) {
+		p = malloc_site_alloc(bytes, caller);
+		if (p) {
+			memcpy(p, oldmem, min((size_t)hdr->size, bytes));
+			fREe(oldmem);
+		}
+		return p;
+	}
+
+	if (bytes > CONFIG_SYS_MALLOC_LEN)
+		return NULL;
+	blk = hdr;
+	old_size = malloc_usable_size(blk);
+	p = rEALLOc_impl(blk, bytes + MALLOC_SITE_HDR_SIZE);
+	if (!p)
+		return NULL;
+	malloc_usage.in_use -= old_size;
+	malloc_stats_add(p);
+	hdr = p;
+	malloc_sites[hdr->site].live -= hdr->size;
+
+	return malloc_site_add(p, 0, bytes, caller);
+}
+
+Void_t *mEMALIGn(size_t alignment, size_t bytes)
+{
+	size_t skip;
+	void *blk;
+
+	if (!malloc_is_full())
+		return mEMALIGn_impl(alignment, bytes);
+	if (alignment <= MALLOC_ALIGNMENT)
+		return malloc_site_alloc(bytes, malloc_caller());
+
+	/* Put the header just before the aligned memory */
+	skip = ALIGN(MALLOC_SITE_HDR_SIZE, alignment) - MALLOC_SITE_HDR_SIZE;
+	if (bytes > CONFIG_SYS_MALLOC_LEN)
+		return NULL;
+	blk = mEMALIGn_impl(alignment, skip + MALLOC_SITE_HDR_SIZE + bytes);
+	if (!blk)
+		return NULL;
+	malloc_stats_add(blk);
+
+	return malloc_site_add(blk, skip, bytes, malloc_caller());
+}
+
+Void_t *cALLOc(size_t n, size_t elem_size)
+{
+	size_t bytes;
+	void *p;
+
+	if (!malloc_is_full())
+		return cALLOc_impl(n, elem_size);
+	if (elem_size && n > CONFIG_SYS_MALLOC_LEN / elem_size)
+		return NULL;
+	bytes = n * elem_size;
+	p = malloc_site_alloc(bytes, malloc_caller());
+	if (p)
+		memset(p, '\0', bytes);
+
+	return p;
+}
+
+#else /* !SYS_MALLOC_SITES */
+
+Void_t *mALLOc(size_t bytes)
+{
+	void *p = mALLOc_impl(bytes);
+
+	malloc_stats_add(p);
+	return p;
+}
+
+void fREe(Void_t *mem)
+{
+	malloc_stats_sub(mem);
+	fREe_impl(mem);
+}
+
+Void_t *rEALLOc(Void_t *oldmem, size_t bytes)
+{
+	size_t old_size = malloc_is_full() ? malloc_usable_size(oldmem) : 0;
+	void *p = rEALLOc_impl(oldmem, bytes);
+
+	/* On failure the old block is untouched, unless it was freed */
+	if (p || !bytes)
+		malloc_usage.in_use -= old_size;
+	malloc_stats_add(p);
+	return p;
+}
+
+Void_t *mEMALIGn(size_t alignment, size_t bytes)
+{
+	void *p = mEMALIGn_impl(alignment, bytes);
+
+	malloc_stats_add(p);
+	return p;
+}
+
+Void_t *cALLOc(size_t n, size_t elem_size)
+{
+	void *p = cALLOc_impl(n, elem_size);
+
+	malloc_stats_add(p);
+	return p;
+}
+
+#endif /* SYS_MALLOC_SITES */
+
+void malloc_get_usage(struct malloc_usage *usage)
+{
+	*usage = malloc_usage;
+}
+
+void malloc_reset_peak(void)
+{
+	malloc_usage.peak = malloc_usage.in_use;
+}
 #endif
 
 /*
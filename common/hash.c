@@ -20,6 +20,7 @@
 #include <asm/global_data.h>
 #include <asm/io.h>
 #include <linux/errno.h>
+#include <u-boot/hash.h>
 #else
 #include "mkimage.h"
 #include <linux/compiler_attributes.h>
@@ -561,7 +562,8 @@ int hash_command(const char *algo_name, int flags, struct cmd_tbl *cmdtp,
 			return CMD_RET_FAILURE;
 
 		buf = map_sysmem(addr, len);
-		algo->hash_func_ws(buf, len, output, algo->chunk_size);
+		if (hash_offload(algo->name, buf, len, output, algo->chunk_size))
+			algo->hash_func_ws(buf, len, output, algo->chunk_size);
 		unmap_sysmem(buf);
 
 		/* Try to avoid code bloat when verify is not needed */
@@ -4,6 +4,8 @@
  * Written by Simon Glass <sjg@chromium.org>
  */
 
+#include <bootstage.h>
+#include <dma.h>
 #include <errno.h>
 #include <fpga.h>
 #include <gzip.h>
@@ -188,36 +190,66 @@ static int get_aligned_image_size(struct spl_load_info *info, int data_size,
 }
 
 /**
- * load_simple_fit(): load the image described in a certain FIT node
+ * struct spl_fit_load - An image which is being loaded from a FIT
+ *
+ * Loading happens in two steps: spl_fit_prepare() works out where the data
+ * comes from and goes to, then spl_fit_finish() reads it, if not already
+ * done, and checks, decompresses and copies it. In between, the read can be
+ * started with spl_fit_submit(), so that it runs in the background.
+ *
+ * @node: Offset of the image node in the FIT
+ * @load_addr: Address to load the image to
+ * @comp: Compression used by the image (IH_COMP_...)
+ * @offset: Offset of the (aligned) data to read from the device
+ * @size: Number of bytes to read from the device
+ * @buf: Buffer to read into, or NULL if the data is embedded in the FIT
+ * @src: Image data, once read, or NULL to skip the image
+ * @length: Length of the image data in bytes
+ * @pending: true if a read of @buf has been submitted but not waited for
+ * @done: true if @buf holds the data
+ */
+struct spl_fit_load {
+	int node;
+	ulong load_addr;
+	uint8_t comp;
+	ulong offset;
+	ulong size;
+	void *buf;
+	void *src;
+	size_t length;
+	bool pending;
+	bool done;
+};
+
+/**
+ * spl_fit_prepare() - Work out how to load an image from a FIT
+ *
  * @info:	points to information about the device to load data from
- * @sector:	the start sector of the FIT image on the device
+ * @fit_offset:	offset of the FIT image on the device
  * @ctx:	points to the FIT context structure
- * @node:	offset of the DT node describing the image to load (relative
- *		to @fit)
- * @image_info:	will be filled with information about the loaded image
- *		If the FIT node does not contain a "load" (address) property,
- *		the image gets loaded to the address pointed to by the
- *		load_addr member in this struct, if load_addr is not 0
+ * @node:	offset of the DT node describing the image to load
+ * @image_info:	provides the load address to use if the FIT node does not
+ *		contain a "load" property, if load_addr is not 0
+ * @staging:	address to read compressed data to
+ * @ld:		returns the information about the image
  *
  * Return:	0 on success or a negative error number.
  */
-static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
+static int spl_fit_prepare(struct spl_load_info *info, ulong fit_offset,
 			   const struct spl_fit_info *ctx, int node,
-			   struct spl_image_info *image_info)
+			   struct spl_image_info *image_info, ulong staging,
+			   struct spl_fit_load *ld)
 {
 	int offset;
-	size_t length;
 	int len;
-	ulong size;
-	ulong load_addr;
-	void *load_ptr;
-	void *src;
-	ulong overhead;
-	uint8_t image_comp = -1, type = -1;
 	const void *data;
 	const void *fit = ctx->fit;
 	bool external_data = false;
+	uint8_t type = -1;
 
+	memset(ld, '\0', sizeof(*ld));
+	ld->node = node;
+	ld->comp = -1;
 	if (IS_ENABLED(CONFIG_SPL_FPGA) ||
 	    (IS_ENABLED(CONFIG_SPL_OS_BOOT) && spl_decompression_enabled())) {
 		if (fit_image_get_type(fit, node, &type))
@@ -227,17 +259,17 @@ static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
 	}
 
 	if (spl_decompression_enabled()) {
-		fit_image_get_comp(fit, node, &image_comp);
-		debug("%s ", genimg_get_comp_name(image_comp));
+		fit_image_get_comp(fit, node, &ld->comp);
+		debug("%s ", genimg_get_comp_name(ld->comp));
 	}
 
-	if (fit_image_get_load(fit, node, &load_addr)) {
+	if (fit_image_get_load(fit, node, &ld->load_addr)) {
 		if (!image_info->load_addr) {
 			printf("Can't load %s: No load address and no buffer\n",
 			       fit_get_name(fit, node, NULL));
 			return -ENOBUFS;
 		}
-		load_addr = image_info->load_addr;
+		ld->load_addr = image_info->load_addr;
 	}
 
 	if (!fit_image_get_data_position(fit, node, &offset)) {
@@ -248,8 +280,6 @@ static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
 	}
 
 	if (external_data) {
-		void *src_ptr;
-
 		/* External data */
 		if (fit_image_get_data_size(fit, node, &len))
 			return -ENOENT;
@@ -258,39 +288,133 @@ static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
 		if (!len) {
 			log_warning("%s: Skip load '%s': image size is 0!\n",
 				    __func__, fit_get_name(fit, node, NULL));
+			ld->done = true;
 			return 0;
 		}
 
 		if (spl_decompression_enabled() &&
-		    (image_comp == IH_COMP_GZIP || image_comp == IH_COMP_LZMA))
-			src_ptr = map_sysmem(ALIGN(CONFIG_SYS_LOAD_ADDR, ARCH_DMA_MINALIGN), len);
+		    (ld->comp == IH_COMP_GZIP || ld->comp == IH_COMP_LZMA))
+			ld->buf = map_sysmem(ALIGN(staging, ARCH_DMA_MINALIGN), len);
 		else
-			src_ptr = map_sysmem(ALIGN(load_addr, ARCH_DMA_MINALIGN), len);
-		length = len;
-
-		overhead = get_aligned_image_overhead(info, offset);
-		size = get_aligned_image_size(info, length, offset);
-
-		if (info->read(info,
-			       fit_offset +
-			       get_aligned_image_offset(info, offset), size,
-			       src_ptr) < length)
-			return -EIO;
-
+			ld->buf = map_sysmem(ALIGN(ld->load_addr, ARCH_DMA_MINALIGN), len);
+		ld->length = len;
+		ld->offset = fit_offset + get_aligned_image_offset(info, offset);
+		ld->size = get_aligned_image_size(info, len, offset);
+		ld->src = ld->buf + get_aligned_image_overhead(info, offset);
 		debug("External data: dst=%p, offset=%x, size=%lx\n",
-		      src_ptr, offset, (unsigned long)length);
-		src = src_ptr + overhead;
+		      ld->buf, offset, (unsigned long)ld->length);
 	} else {
 		/* Embedded data */
-		if (fit_image_get_data(fit, node, &data, &length)) {
+		if (fit_image_get_data(fit, node, &data, &ld->length)) {
 			puts("Cannot get image data/size\n");
 			return -ENOENT;
 		}
-		debug("Embedded data: dst=%lx, size=%lx\n", load_addr,
-		      (unsigned long)length);
-		src = (void *)data;	/* cast away const */
+		debug("Embedded data: dst=%lx, size=%lx\n", ld->load_addr,
+		      (unsigned long)ld->length);
+		ld->src = (void *)data;	/* cast away const */
+		ld->done = true;
+	}
+
+	return 0;
+}
+
+/**
+ * spl_fit_submit() - Start reading an image in the background
+ *
+ * @info:	points to information about the device to load data from
+ * @ld:		image to read, as set up by spl_fit_prepare()
+ * Return:	0 if the read was started, -ve if it must be done by
+ *		spl_fit_finish() instead
+ */
+static int spl_fit_submit(struct spl_load_info *info, struct spl_fit_load *ld)
+{
+#if CONFIG_IS_ENABLED(LOAD_ASYNC)
+	int ret;
+
+	if (!info->read_submit || ld->done)
+		return -ENOSYS;
+	ret = info->read_submit(info, ld->offset, ld->size, ld->buf);
+	if (ret)
+		return ret;
+	ld->pending = true;
+
+	return 0;
+#else
+	return -ENOSYS;
+#endif
+}
+
+static ulong spl_fit_read_wait(struct spl_load_info *info)
+{
+#if CONFIG_IS_ENABLED(LOAD_ASYNC)
+	return info->read_wait(info);
+#else
+	return 0;
+#endif
+}
+
+/**
+ * spl_fit_read() - Make sure that the data for an image has been read
+ *
+ * This waits for a read started by spl_fit_submit(), if any, or reads the
+ * data.
+ *
+ * @info:	points to information about the device to load data from
+ * @ld:		image to read, as set up by spl_fit_prepare()
+ * Return:	0 on success or -EIO
+ */
+static int spl_fit_read(struct spl_load_info *info, struct spl_fit_load *ld)
+{
+	ulong count;
+
+	if (ld->done)
+		return 0;
+	bootstage_start(BOOTSTAGE_ID_ACCUM_FIT_READ, "spl_fit_read");
+	if (ld->pending) {
+		ld->pending = false;
+		count = spl_fit_read_wait(info);
+	} else {
+		count = info->read(info, ld->offset, ld->size, ld->buf);
 	}
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_FIT_READ);
+	if (count < ld->length)
+		return -EIO;
+	ld->done = true;
+
+	return 0;
+}
 
+/**
+ * spl_fit_finish() - Finish loading an image from a FIT
+ *
+ * @info:	points to information about the device to load data from
+ * @ctx:	points to the FIT context structure
+ * @ld:		image to load, as set up by spl_fit_prepare()
+ * @image_info:	will be filled with information about the loaded image
+ *
+ * Return:	0 on success or a negative error number.
+ */
+static int spl_fit_finish(struct spl_load_info *info,
+			  const struct spl_fit_info *ctx,
+			  struct spl_fit_load *ld,
+			  struct spl_image_info *image_info)
+{
+	const void *fit = ctx->fit;
+	int node = ld->node;
+	ulong load_addr = ld->load_addr;
+	size_t length = ld->length;
+	void *src = ld->src;
+	void *load_ptr;
+	ulong size;
+	int ret;
+
+	ret = spl_fit_read(info, ld);
+	if (ret)
+		return ret;
+	if (!src)
+		return 0;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_FIT_PROCESS, "spl_fit_process");
 	if (CONFIG_IS_ENABLED(FIT_SIGNATURE)) {
 		printf("## Checking hash(es) for Image %s ... ",
 		       fit_get_name(fit, node, NULL));
@@ -304,14 +428,14 @@ static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
 		board_fit_image_post_process(fit, node, &src, &length);
 
 	load_ptr = map_sysmem(load_addr, length);
-	if (IS_ENABLED(CONFIG_SPL_GZIP) && image_comp == IH_COMP_GZIP) {
+	if (IS_ENABLED(CONFIG_SPL_GZIP) && ld->comp == IH_COMP_GZIP) {
 		size = length;
 		if (gunzip(load_ptr, CONFIG_SYS_BOOTM_LEN, src, &size)) {
 			puts("Uncompressing error\n");
 			return -EIO;
 		}
 		length = size;
-	} else if (IS_ENABLED(CONFIG_SPL_LZMA) && image_comp == IH_COMP_LZMA) {
+	} else if (IS_ENABLED(CONFIG_SPL_LZMA) && ld->comp == IH_COMP_LZMA) {
 		size = CONFIG_SYS_BOOTM_LEN;
 		ulong loadEnd;
 
@@ -324,6 +448,7 @@ static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
 	} else {
 		memcpy(load_ptr, src, length);
 	}
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_FIT_PROCESS);
 
 	if (image_info) {
 		ulong entry_point;
@@ -342,6 +467,35 @@ static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
 	return 0;
 }
 
+/**
+ * load_simple_fit(): load the image described in a certain FIT node
+ * @info:	points to information about the device to load data from
+ * @sector:	the start sector of the FIT image on the device
+ * @ctx:	points to the FIT context structure
+ * @node:	offset of the DT node describing the image to load (relative
+ *		to @fit)
+ * @image_info:	will be filled with information about the loaded image
+ *		If the FIT node does not contain a "load" (address) property,
+ *		the image gets loaded to the address pointed to by the
+ *		load_addr member in this struct, if load_addr is not 0
+ *
+ * Return:	0 on success or a negative error number.
+ */
+static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
+			   const struct spl_fit_info *ctx, int node,
+			   struct spl_image_info *image_info)
+{
+	struct spl_fit_load ld;
+	int ret;
+
+	ret = spl_fit_prepare(info, fit_offset, ctx, node, image_info,
+			      CONFIG_SYS_LOAD_ADDR, &ld);
+	if (ret)
+		return ret;
+
+	return spl_fit_finish(info, ctx, &ld, image_info);
+}
+
 static bool os_takes_devicetree(uint8_t os)
 {
 	switch (os) {
@@ -712,10 +866,135 @@ static int spl_simple_fit_parse(struct spl_fit_info *ctx)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(LOAD_ASYNC)
+static struct dma_memcpy_tx spl_load_tx;
+
+int spl_load_dma_submit(void *buf, const void *src, ulong count)
+{
+	return dma_memcpy_submit(&spl_load_tx, buf, src, count);
+}
+
+ulong spl_load_dma_wait(struct spl_load_info *load)
+{
+	if (dma_memcpy_wait(&spl_load_tx))
+		return 0;
+
+	return spl_load_tx.len;
+}
+#endif
+
+/* Check if [@start, @end) overlaps the @size bytes at @base */
+static bool spl_fit_range_overlaps(ulong start, ulong end, ulong base,
+				   ulong size)
+{
+	return start < base + size && base < end;
+}
+
+/**
+ * spl_fit_overlaps() - Check if reading an image could clobber another
+ *
+ * Reading @next must not touch the FIT itself, which is needed until all
+ * images are loaded, the data of @cur, whether read into a buffer or
+ * embedded in the FIT, nor the memory which @cur is loaded to. Where the
+ * size of the latter is not known, because @cur is compressed or has a
+ * devicetree appended, CONFIG_SYS_BOOTM_LEN is assumed.
+ *
+ * @ctx:	points to the FIT context structure
+ * @cur:	image which is about to be processed
+ * @next:	image to read
+ * Return:	true if @next must not be read until @cur is processed
+ */
+static bool spl_fit_overlaps(const struct spl_fit_info *ctx,
+			     const struct spl_fit_load *cur,
+			     const struct spl_fit_load *next)
+{
+	ulong start = map_to_sysmem(next->buf), end = start + next->size;
+	ulong size = cur->length;
+	uint8_t os;
+
+	if (spl_fit_range_overlaps(start, end, map_to_sysmem(ctx->fit),
+				   fdt_totalsize(ctx->fit)))
+		return true;
+	if (cur->buf) {
+		if (spl_fit_range_overlaps(start, end,
+					   map_to_sysmem(cur->buf), cur->size))
+			return true;
+	} else if (cur->src) {
+		if (spl_fit_range_overlaps(start, end,
+					   map_to_sysmem(cur->src),
+					   cur->length))
+			return true;
+	}
+	if (cur->comp == IH_COMP_GZIP || cur->comp == IH_COMP_LZMA ||
+	    spl_fit_image_get_os(ctx->fit, cur->node, &os) ||
+	    os_takes_devicetree(os))
+		size = max_t(ulong, size, CONFIG_SYS_BOOTM_LEN);
+
+	return spl_fit_range_overlaps(start, end, cur->load_addr, size);
+}
+
+/**
+ * spl_fit_prefetch() - Start reading the next loadable in the background
+ *
+ * This finds the loadable after @cur and starts reading it, if the device
+ * can read in the background and the read cannot clobber @cur. The read of
+ * @cur is finished first, since only one read can be in progress.
+ *
+ * @info:	points to information about the device to load data from
+ * @offset:	offset of the FIT image on the device
+ * @ctx:	points to the FIT context structure
+ * @cur:	image which is about to be processed
+ * @index:	index of the first loadable to consider
+ * @firmware_node: node of the firmware image, which is skipped
+ * @next:	returns the image being read. Its node is -1 if there is none
+ */
+static void spl_fit_prefetch(struct spl_load_info *info, ulong offset,
+			     const struct spl_fit_info *ctx,
+			     struct spl_fit_load *cur, int index,
+			     int firmware_node, struct spl_fit_load *next)
+{
+	struct spl_image_info image_info = {};
+	ulong staging = CONFIG_SYS_LOAD_ADDR;
+	int node;
+
+	next->node = -1;
+	if (!spl_load_can_submit(info) || spl_fit_read(info, cur))
+		return;
+
+	do {
+		node = spl_fit_get_image_node(ctx, "loadables", index++);
+	} while (node >= 0 && node == firmware_node);
+	if (node < 0)
+		return;
+
+	/* Keep the compressed data of @cur, if it is in the staging area */
+	if (cur->buf &&
+	    map_to_sysmem(cur->buf) == ALIGN(staging, ARCH_DMA_MINALIGN))
+		staging = map_to_sysmem(cur->buf) + cur->size;
+
+	if (spl_fit_prepare(info, offset, ctx, node, &image_info, staging,
+			    next) ||
+	    next->done || spl_fit_overlaps(ctx, cur, next) ||
+	    spl_fit_submit(info, next)) {
+		next->node = -1;
+		return;
+	}
+	debug("Reading '%s' in the background\n",
+	      fit_get_name(ctx->fit, node, NULL));
+}
+
+/* Wait for a read started by spl_fit_prefetch(), if any */
+static void spl_fit_wait(struct spl_load_info *info, struct spl_fit_load *ld)
+{
+	if (ld->pending && spl_fit_read(info, ld))
+		ld->node = -1;
+}
+
 int spl_load_simple_fit(struct spl_image_info *spl_image,
 			struct spl_load_info *info, ulong offset, void *fit)
 {
 	struct spl_image_info image_info;
+	struct spl_fit_load cur, next;
 	struct spl_fit_info ctx;
 	int node = -1;
 	int ret;
@@ -766,10 +1045,21 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 		return -1;
 	}
 
-	/* Load the image and set up the spl_image structure */
-	ret = load_simple_fit(info, offset, &ctx, node, spl_image);
+	/*
+	 * Load the image and set up the spl_image structure. While the image
+	 * is processed, the first loadable can be read.
+	 */
+	firmware_node = node;
+	ret = spl_fit_prepare(info, offset, &ctx, node, spl_image,
+			      CONFIG_SYS_LOAD_ADDR, &cur);
 	if (ret)
 		return ret;
+	spl_fit_prefetch(info, offset, &ctx, &cur, index, firmware_node, &next);
+	ret = spl_fit_finish(info, &ctx, &cur, spl_image);
+	if (ret) {
+		spl_fit_wait(info, &next);
+		return ret;
+	}
 
 	/*
 	 * For backward compatibility, we treat the first node that is
@@ -785,12 +1075,12 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 	 * We allow this to fail, as the U-Boot image might embed its FDT.
 	 */
 	if (os_takes_devicetree(spl_image->os)) {
+		spl_fit_wait(info, &next);
 		ret = spl_fit_append_fdt(spl_image, info, offset, &ctx);
 		if (ret < 0 && spl_image->os != IH_OS_U_BOOT)
 			return ret;
 	}
 
-	firmware_node = node;
 	/* Now check if there are more images for us to load */
 	for (; ; index++) {
 		uint8_t os_type = IH_OS_INVALID;
@@ -807,9 +1097,23 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 		if (firmware_node == node)
 			continue;
 
+		/* Use the read started for the previous image, if any */
 		image_info.load_addr = 0;
-		ret = load_simple_fit(info, offset, &ctx, node, &image_info);
+		if (next.node == node) {
+			cur = next;
+			ret = 0;
+		} else {
+			ret = spl_fit_prepare(info, offset, &ctx, node,
+					      &image_info, CONFIG_SYS_LOAD_ADDR,
+					      &cur);
+		}
+		if (!ret) {
+			spl_fit_prefetch(info, offset, &ctx, &cur, index + 1,
+					 firmware_node, &next);
+			ret = spl_fit_finish(info, &ctx, &cur, &image_info);
+		}
 		if (ret < 0) {
+			spl_fit_wait(info, &next);
 			printf("%s: can't load image loadables index %d (ret = %d)\n",
 			       __func__, index, ret);
 			return ret;
@@ -822,6 +1126,7 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 			debug("Loadable is %s\n", genimg_get_os_name(os_type));
 
 		if (os_takes_devicetree(os_type)) {
+			spl_fit_wait(info, &next);
 			spl_fit_append_fdt(&image_info, info, offset, &ctx);
 			spl_image->fdt_addr = image_info.fdt_addr;
 		}
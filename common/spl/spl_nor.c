@@ -20,6 +20,12 @@ static ulong spl_nor_load_read(struct spl_load_info *load, ulong sector,
 	return count;
 }
 
+static int spl_nor_load_submit(struct spl_load_info *load, ulong sector,
+			       ulong count, void *buf)
+{
+	return spl_load_dma_submit(buf, map_sysmem(sector, count), count);
+}
+
 unsigned long __weak spl_nor_get_uboot_base(void)
 {
 	return CFG_SYS_UBOOT_BASE;
@@ -50,6 +56,9 @@ static int spl_nor_load_image(struct spl_image_info *spl_image,
 
 			debug("Found FIT\n");
 			spl_load_init(&load, spl_nor_load_read, NULL, 1);
+			if (CONFIG_IS_ENABLED(LOAD_ASYNC))
+				spl_set_async(&load, spl_nor_load_submit,
+					      spl_load_dma_wait);
 
 			ret = spl_load_simple_fit(spl_image, &load,
 						  CONFIG_SYS_OS_BASE,
@@ -93,6 +102,8 @@ static int spl_nor_load_image(struct spl_image_info *spl_image,
 	 * defined location in SDRAM
 	 */
 	spl_load_init(&load, spl_nor_load_read, NULL, 1);
+	if (CONFIG_IS_ENABLED(LOAD_ASYNC))
+		spl_set_async(&load, spl_nor_load_submit, spl_load_dma_wait);
 	return spl_load(spl_image, bootdev, &load, 0, spl_nor_get_uboot_base());
 }
 SPL_LOAD_IMAGE_METHOD("NOR", 0, BOOT_DEVICE_NOR, spl_nor_load_image);
@@ -16,14 +16,10 @@
 #include <spl.h>
 #include <linux/libfdt.h>
 
-static ulong spl_ram_load_read(struct spl_load_info *load, ulong sector,
-			       ulong count, void *buf)
+static ulong spl_ram_load_addr(ulong sector)
 {
 	ulong addr = 0;
 
-	debug("%s: sector %lx, count %lx, buf %lx\n",
-	      __func__, sector, count, (ulong)buf);
-
 	if (IS_ENABLED(CONFIG_SPL_LOAD_FIT)) {
 		addr = IF_ENABLED_INT(CONFIG_SPL_LOAD_FIT,
 				      CONFIG_SPL_LOAD_FIT_ADDRESS);
@@ -32,11 +28,27 @@ static ulong spl_ram_load_read(struct spl_load_info *load, ulong sector,
 	if (CONFIG_IS_ENABLED(IMAGE_PRE_LOAD))
 		addr += image_load_offset;
 
-	memcpy(buf, (void *)addr, count);
+	return addr;
+}
+
+static ulong spl_ram_load_read(struct spl_load_info *load, ulong sector,
+			       ulong count, void *buf)
+{
+	debug("%s: sector %lx, count %lx, buf %lx\n",
+	      __func__, sector, count, (ulong)buf);
+
+	memcpy(buf, (void *)spl_ram_load_addr(sector), count);
 
 	return count;
 }
 
+static int spl_ram_load_submit(struct spl_load_info *load, ulong sector,
+			       ulong count, void *buf)
+{
+	return spl_load_dma_submit(buf, (void *)spl_ram_load_addr(sector),
+				   count);
+}
+
 static int spl_ram_load_image(struct spl_image_info *spl_image,
 			      struct spl_boot_device *bootdev)
 {
@@ -70,6 +82,9 @@ static int spl_ram_load_image(struct spl_image_info *spl_image,
 
 		debug("Found FIT\n");
 		spl_load_init(&load, spl_ram_load_read, NULL, 1);
+		if (CONFIG_IS_ENABLED(LOAD_ASYNC))
+			spl_set_async(&load, spl_ram_load_submit,
+				      spl_load_dma_wait);
 		ret = spl_load_simple_fit(spl_image, &load, 0, header);
 	} else {
 		ulong u_boot_pos = spl_get_image_pos();
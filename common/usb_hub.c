@@ -55,6 +55,7 @@ struct usb_device_scan {
 	struct usb_device *dev;		/* USB hub device to scan */
 	struct usb_hub_device *hub;	/* USB hub struct */
 	int port;			/* USB port to scan */
+	ulong start;			/* Time when scanning started, in ms */
 	struct list_head list;
 };
 
@@ -438,6 +439,18 @@ int usb_hub_port_connect_change(struct usb_device *dev, int port)
 	return ret;
 }
 
+/* Remove a port from the scanning list, recording how long it took */
+static void usb_scan_port_done(struct usb_device_scan *usb_scan)
+{
+	ulong elapsed = get_timer(usb_scan->start);
+
+	debug("devnum=%d port=%d: scanned in %lu ms\n", usb_scan->dev->devnum,
+	      usb_scan->port + 1, elapsed);
+	usb_scan->hub->scan_time[usb_scan->port] = elapsed;
+	list_del(&usb_scan->list);
+	free(usb_scan);
+}
+
 static int usb_scan_port(struct usb_device_scan *usb_scan)
 {
 	ALLOC_CACHE_ALIGN_BUFFER(struct usb_port_status, portsts, 1);
@@ -466,8 +479,7 @@ static int usb_scan_port(struct usb_device_scan *usb_scan)
 			debug("devnum=%d port=%d: timeout\n",
 			      dev->devnum, i + 1);
 			/* Remove this device from scanning list */
-			list_del(&usb_scan->list);
-			free(usb_scan);
+			usb_scan_port_done(usb_scan);
 			return 0;
 		}
 		return 0;
@@ -490,8 +502,7 @@ static int usb_scan_port(struct usb_device_scan *usb_scan)
 			debug("devnum=%d port=%d: timeout\n",
 			      dev->devnum, i + 1);
 			/* Remove this device from scanning list */
-			list_del(&usb_scan->list);
-			free(usb_scan);
+			usb_scan_port_done(usb_scan);
 			return 0;
 		}
 		return 0;
@@ -560,8 +571,7 @@ static int usb_scan_port(struct usb_device_scan *usb_scan)
 	 * We're done with this device, so let's remove this device from
 	 * scanning list
 	 */
-	list_del(&usb_scan->list);
-	free(usb_scan);
+	usb_scan_port_done(usb_scan);
 
 	return 0;
 }
@@ -573,8 +583,11 @@ static int usb_device_list_scan(void)
 	static int running;
 	int ret = 0;
 
-	/* Only run this loop once for each controller */
-	if (running)
+	/*
+	 * Only run this loop once for each controller, and not at all if the
+	 * ports are being scanned in the background
+	 */
+	if (running || usb_scan_busy())
 		return 0;
 
 	running = 1;
@@ -605,6 +618,38 @@ out:
 	return ret;
 }
 
+#if CONFIG_IS_ENABLED(USB_ASYNC_SCAN)
+int usb_hub_scan_step(void)
+{
+	struct usb_device_scan *usb_scan;
+
+	if (list_empty(&usb_scan_list))
+		return 0;
+
+	/*
+	 * Scan one port each time, moving it to the end of the list so that
+	 * the others get a turn. Ports of hubs found while scanning are added
+	 * to the end of the list, so are picked up too.
+	 */
+	usb_scan = list_first_entry(&usb_scan_list, struct usb_device_scan,
+				    list);
+	list_move_tail(&usb_scan->list, &usb_scan_list);
+	usb_scan_port(usb_scan);
+
+	return list_empty(&usb_scan_list) ? 0 : -EAGAIN;
+}
+
+void usb_hub_scan_stop(void)
+{
+	struct usb_device_scan *usb_scan, *tmp;
+
+	list_for_each_entry_safe(usb_scan, tmp, &usb_scan_list, list) {
+		list_del(&usb_scan->list);
+		free(usb_scan);
+	}
+}
+#endif
+
 static struct usb_hub_device *usb_get_hub_device(struct usb_device *dev)
 {
 	struct usb_hub_device *hub;
@@ -873,6 +918,7 @@ static int usb_hub_configure(struct usb_device *dev)
 		usb_scan->dev = dev;
 		usb_scan->hub = hub;
 		usb_scan->port = i;
+		usb_scan->start = get_timer(0);
 		list_add_tail(&usb_scan->list, &usb_scan_list);
 	}
 
@@ -949,6 +995,22 @@ static int usb_hub_post_probe(struct udevice *dev)
 	return usb_hub_scan(dev);
 }
 
+static int usb_hub_pre_remove(struct udevice *dev)
+{
+	struct usb_device *udev = dev_get_parent_priv(dev);
+	struct usb_device_scan *usb_scan, *tmp;
+
+	/* Drop any ports of this hub which are still waiting to be scanned */
+	list_for_each_entry_safe(usb_scan, tmp, &usb_scan_list, list) {
+		if (usb_scan->dev == udev) {
+			list_del(&usb_scan->list);
+			free(usb_scan);
+		}
+	}
+
+	return 0;
+}
+
 static const struct udevice_id usb_hub_ids[] = {
 	{ .compatible = "usb-hub" },
 	{ }
@@ -966,6 +1028,7 @@ UCLASS_DRIVER(usb_hub) = {
 	.name		= "usb_hub",
 	.post_bind	= dm_scan_fdt_dev,
 	.post_probe	= usb_hub_post_probe,
+	.pre_remove	= usb_hub_pre_remove,
 	.child_pre_probe	= usb_child_pre_probe,
 	.per_child_auto	= sizeof(struct usb_device),
 	.per_child_plat_auto	= sizeof(struct usb_dev_plat),
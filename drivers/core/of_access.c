@@ -38,6 +38,11 @@ static LIST_HEAD(aliases_lookup);
 /* "/aliaes" node */
 static struct device_node *of_aliases;
 
+/* phandle -> node table of the tree at of_phandle_root */
+static struct device_node *of_phandle_root;
+static struct device_node **of_phandle_table;
+static phandle of_phandle_max;
+
 /* "/chosen" node */
 static struct device_node *of_chosen;
 
@@ -131,6 +136,27 @@ struct property *of_find_property(const struct device_node *np,
 	if (!np)
 		return NULL;
 
+#if IS_ENABLED(CONFIG_OF_LIVE_PROP_HASH)
+	if (np->prop_hash) {
+		const struct of_prop_hash *ph = np->prop_hash;
+		u32 hash = of_prop_name_hash(name);
+		uint i;
+
+		pp = NULL;
+		for (i = hash & ph->mask; ph->slot[i].pp;
+		     i = (i + 1) & ph->mask) {
+			if (ph->slot[i].hash == hash &&
+			    !strcmp(ph->slot[i].pp->name, name)) {
+				pp = ph->slot[i].pp;
+				break;
+			}
+		}
+		if (lenp)
+			*lenp = pp ? pp->length : -FDT_ERR_NOTFOUND;
+
+		return pp;
+	}
+#endif
 	for (pp = np->properties; pp; pp = pp->next) {
 		if (strcmp(pp->name, name) == 0) {
 			if (lenp)
@@ -453,6 +479,11 @@ struct device_node *of_find_node_by_phandle(struct device_node *root,
 	if (!handle)
 		return NULL;
 
+	/* fall back to a search for phandles not in the table */
+	if (of_phandle_table && (root ? root : gd->of_root) == of_phandle_root &&
+	    handle <= of_phandle_max && of_phandle_table[handle])
+		return of_phandle_table[handle];
+
 	for_each_of_allnodes_from(root, np)
 		if (np->phandle == handle)
 			break;
@@ -461,6 +492,53 @@ struct device_node *of_find_node_by_phandle(struct device_node *root,
 	return np;
 }
 
+int of_phandle_table_build(struct device_node *root)
+{
+	struct device_node *np;
+	phandle top = 0;
+	int count = 0;
+
+	of_phandle_table_free(NULL);
+
+	for_each_of_allnodes_from(root, np) {
+		top = max(top, np->phandle);
+		count++;
+	}
+	if (!top || top > count * 4 + 64) {
+		log_debug("No phandle table: max %x for %d nodes\n", top, count);
+		return 0;
+	}
+
+	of_phandle_table = calloc(top + 1, sizeof(*of_phandle_table));
+	if (!of_phandle_table)
+		return -ENOMEM;
+	for_each_of_allnodes_from(root, np) {
+		/* keep the first node found, as a search would */
+		if (np->phandle && !of_phandle_table[np->phandle])
+			of_phandle_table[np->phandle] = np;
+	}
+	/*
+	 * The walk above skips the root node, since a search from an explicit
+	 * root does too. Leave its phandle to the search.
+	 */
+	if (root->phandle <= top)
+		of_phandle_table[root->phandle] = NULL;
+	of_phandle_root = root;
+	of_phandle_max = top;
+
+	return 0;
+}
+
+void of_phandle_table_free(struct device_node *root)
+{
+	if (root && root != of_phandle_root)
+		return;
+	free(of_phandle_table);
+	of_phandle_table = NULL;
+	of_phandle_root = NULL;
+	of_phandle_max = 0;
+}
+
 /**
  * of_find_property_value_of_size() - find property of given size
  *
@@ -970,6 +1048,10 @@ int of_write_prop(struct device_node *np, const char *propname, int len,
 	new->length = len;
 	new->next = NULL;
 
+#if IS_ENABLED(CONFIG_OF_LIVE_PROP_HASH)
+	/* the table cannot grow, so search the list from now on */
+	np->prop_hash = NULL;
+#endif
 	if (pp_last)
 		pp_last->next = new;
 	else
@@ -1054,6 +1136,9 @@ int __of_remove_property(struct device_node *np, struct property *prop)
 
 	/* found the node */
 	*next = prop->next;
+#if IS_ENABLED(CONFIG_OF_LIVE_PROP_HASH)
+	np->prop_hash = NULL;
+#endif
 
 	return 0;
 }
@@ -1093,6 +1178,11 @@ int of_remove_node(struct device_node *to_remove)
 	else
 		parent->child = np->sibling;
 
+	/* the phandle table of this tree may point into the removed subtree */
+	for (np = parent; np->parent; np = np->parent)
+		;
+	of_phandle_table_free(np);
+
 	/*
 	 * don't free it, since if this is an unflattened tree, all the memory
 	 * was alloced in one block; this pointer will be somewhere in the
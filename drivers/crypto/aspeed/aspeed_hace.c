@@ -328,6 +328,7 @@ static int aspeed_hace_probe(struct udevice *dev)
 {
 	int rc;
 	struct aspeed_hace *hace = dev_get_priv(dev);
+	struct hash_dev_priv *uc_priv = dev_get_uclass_priv(dev);
 
 	rc = clk_get_by_index(dev, 0, &hace->clk);
 	if (rc < 0) {
@@ -342,6 +343,8 @@ static int aspeed_hace_probe(struct udevice *dev)
 	}
 
 	hace->base = devfdt_get_addr(dev);
+	uc_priv->algos = BIT(HASH_ALGO_SHA1) | BIT(HASH_ALGO_SHA256) |
+			 BIT(HASH_ALGO_SHA384) | BIT(HASH_ALGO_SHA512);
 
 	return rc;
 }
@@ -218,6 +218,7 @@ static int cptra_sha_digest(struct udevice *dev, enum HASH_ALGO algo,
 static int cptra_sha_probe(struct udevice *dev)
 {
 	struct cptra_sha *cs = dev_get_priv(dev);
+	struct hash_dev_priv *uc_priv = dev_get_uclass_priv(dev);
 
 	cs->regs = (void *)devfdt_get_addr(dev);
 	if (cs->regs == (void *)FDT_ADDR_T_NONE) {
@@ -225,6 +226,8 @@ static int cptra_sha_probe(struct udevice *dev)
 		return -ENODEV;
 	}
 
+	uc_priv->algos = BIT(HASH_ALGO_SHA384) | BIT(HASH_ALGO_SHA512);
+
 	return 0;
 }
 
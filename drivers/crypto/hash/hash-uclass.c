@@ -6,13 +6,19 @@
 
 #define LOG_CATEGORY UCLASS_HASH
 
+#include <cpu_func.h>
+#include <cyclic.h>
 #include <dm.h>
+#include <log.h>
+#include <time.h>
+#include <asm/cache.h>
 #include <asm/global_data.h>
 #include <u-boot/hash.h>
 #include <errno.h>
 #include <fdtdec.h>
 #include <malloc.h>
 #include <asm/io.h>
+#include <linux/bitops.h>
 #include <linux/list.h>
 
 struct hash_info {
@@ -114,7 +120,90 @@ int hash_finish(struct udevice *dev, void *ctx, void *obuf)
 	return ops->hash_finish(dev, ctx, obuf);
 }
 
+int hash_find_device(enum HASH_ALGO algo, struct udevice **devp)
+{
+	struct hash_dev_priv *uc_priv;
+	struct udevice *dev;
+
+	if (algo >= HASH_ALGO_NUM)
+		return -ENODEV;
+
+	uclass_foreach_dev_probe(UCLASS_HASH, dev) {
+		uc_priv = dev_get_uclass_priv(dev);
+		if (uc_priv->algos & BIT(algo)) {
+			*devp = dev;
+			return 0;
+		}
+	}
+
+	return -ENODEV;
+}
+
+int hash_digest_chunked(struct udevice *dev, enum HASH_ALGO algo,
+			const void *ibuf, ulong ilen, void *obuf,
+			uint chunk_sz)
+{
+	struct hash_dev_priv *uc_priv = dev_get_uclass_priv(dev);
+	const void *end = ibuf + ilen;
+	ulong start, addr;
+	void *ctx;
+	uint len;
+	int ret;
+
+	start = timer_get_us();
+	ret = hash_init(dev, algo, &ctx);
+	if (ret)
+		return ret;
+
+	for (; ibuf < end; ibuf += len) {
+		len = end - ibuf;
+		if (chunk_sz && len > chunk_sz)
+			len = chunk_sz;
+
+		/* The device may read the data by DMA */
+		addr = (ulong)ibuf;
+		flush_dcache_range(ALIGN_DOWN(addr, ARCH_DMA_MINALIGN),
+				   ALIGN(addr + len, ARCH_DMA_MINALIGN));
+		ret = hash_update(dev, ctx, ibuf, len);
+		if (ret) {
+			/* This frees the context */
+			hash_finish(dev, ctx, obuf);
+			return ret;
+		}
+		schedule();
+	}
+
+	ret = hash_finish(dev, ctx, obuf);
+	if (ret)
+		return ret;
+
+	uc_priv->bytes += ilen;
+	uc_priv->time_us += timer_get_us() - start;
+
+	return 0;
+}
+
+int hash_offload(const char *algo_name, const void *ibuf, ulong ilen,
+		 void *obuf, uint chunk_sz)
+{
+	enum HASH_ALGO algo = hash_algo_lookup_by_name(algo_name);
+	struct udevice *dev;
+	int ret;
+
+	ret = hash_find_device(algo, &dev);
+	if (ret)
+		return ret;
+
+	ret = hash_digest_chunked(dev, algo, ibuf, ilen, obuf, chunk_sz);
+	if (ret)
+		log_warning("%s: %s failed (err=%d)\n", dev->name, algo_name,
+			    ret);
+
+	return ret;
+}
+
 UCLASS_DRIVER(hash) = {
 	.id	= UCLASS_HASH,
 	.name	= "hash",
+	.per_device_auto	= sizeof(struct hash_dev_priv),
 };
@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Sandbox hash engine
+ *
+ * This behaves like a hash accelerator which only supports SHA1 and SHA256,
+ * so that offloading and the fallback to software hashing can be tested.
+ */
+
+#include <dm.h>
+#include <malloc.h>
+#include <u-boot/hash.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+#include <linux/bitops.h>
+
+struct sandbox_hash_ctx {
+	enum HASH_ALGO algo;
+	union {
+		sha1_context sha1;
+		sha256_context sha256;
+	};
+};
+
+static int sandbox_hash_init(struct udevice *dev, enum HASH_ALGO algo,
+			     void **ctxp)
+{
+	struct sandbox_hash_ctx *ctx;
+
+	if (algo != HASH_ALGO_SHA1 && algo != HASH_ALGO_SHA256)
+		return -EPROTONOSUPPORT;
+
+	ctx = malloc(sizeof(*ctx));
+	if (!ctx)
+		return -ENOMEM;
+
+	ctx->algo = algo;
+	if (algo == HASH_ALGO_SHA1)
+		sha1_starts(&ctx->sha1);
+	else
+		sha256_starts(&ctx->sha256);
+	*ctxp = ctx;
+
+	return 0;
+}
+
+static int sandbox_hash_update(struct udevice *dev, void *vctx,
+			       const void *ibuf, const uint32_t ilen)
+{
+	struct sandbox_hash_ctx *ctx = vctx;
+
+	if (ctx->algo == HASH_ALGO_SHA1)
+		sha1_update(&ctx->sha1, ibuf, ilen);
+	else
+		sha256_update(&ctx->sha256, ibuf, ilen);
+
+	return 0;
+}
+
+static int sandbox_hash_finish(struct udevice *dev, void *vctx, void *obuf)
+{
+	struct sandbox_hash_ctx *ctx = vctx;
+
+	if (ctx->algo == HASH_ALGO_SHA1)
+		sha1_finish(&ctx->sha1, obuf);
+	else
+		sha256_finish(&ctx->sha256, obuf);
+	free(ctx);
+
+	return 0;
+}
+
+static int sandbox_hash_probe(struct udevice *dev)
+{
+	struct hash_dev_priv *uc_priv = dev_get_uclass_priv(dev);
+
+	uc_priv->algos = BIT(HASH_ALGO_SHA1) | BIT(HASH_ALGO_SHA256);
+
+	return 0;
+}
+
+static const struct hash_ops sandbox_hash_ops = {
+	.hash_init = sandbox_hash_init,
+	.hash_update = sandbox_hash_update,
+	.hash_finish = sandbox_hash_finish,
+};
+
+static const struct udevice_id sandbox_hash_ids[] = {
+	{ .compatible = "sandbox,hash" },
+	{ }
+};
+
+U_BOOT_DRIVER(sandbox_hash) = {
+	.name = "sandbox_hash",
+	.id = UCLASS_HASH,
+	.of_match = sandbox_hash_ids,
+	.ops = &sandbox_hash_ops,
+	.probe = sandbox_hash_probe,
+};
@@ -6,6 +6,8 @@
  * author: Lukasz Majewski <l.majewski@samsung.com>
  */
 
+#include <cyclic.h>
+#include <div64.h>
 #include <env.h>
 #include <errno.h>
 #include <log.h>
@@ -14,6 +16,7 @@
 #include <fat.h>
 #include <dfu.h>
 #include <hash.h>
+#include <time.h>
 #include <linux/list.h>
 #include <linux/compiler.h>
 #include <linux/printk.h>
@@ -195,12 +198,56 @@ done:
 	return ret;
 }
 
+#define DFU_MAX_BUF_COUNT	8
+
 static unsigned char *dfu_buf;
 static unsigned long dfu_buf_size;
+static unsigned int dfu_buf_count;
 static enum dfu_device_type dfu_buf_device_type;
 
+/**
+ * struct dfu_write_queue - buffers waiting to be written to the medium
+ *
+ * With more than one buffer, a full buffer is queued and the next one is
+ * filled, while a cyclic function writes the queued buffers in order. If
+ * all buffers are full, dfu_write() waits for the oldest one.
+ *
+ * @dfu: Entity being written, NULL if the queue is not in use
+ * @head: Index of the oldest queued buffer
+ * @pending: Number of queued buffers
+ * @len: Number of bytes in each buffer
+ * @err: First error returned by the medium, reported by the next call
+ * @start_us: Start time of the transfer
+ * @busy_us: Time spent writing to the medium
+ * @stalls: Number of times dfu_write() had to wait for a free buffer
+ * @draining: A buffer is being written; the medium may call schedule()
+ *	while writing, so the cyclic function must not start another one
+ * @cyclic: Cyclic function writing queued buffers
+ */
+static struct dfu_write_queue {
+	struct dfu_entity *dfu;
+	unsigned int head;
+	unsigned int pending;
+	long len[DFU_MAX_BUF_COUNT];
+	int err;
+	ulong start_us;
+	ulong busy_us;
+	unsigned int stalls;
+	bool draining;
+	struct cyclic_info cyclic;
+} dfu_wq;
+
+static void dfu_write_queue_stop(void)
+{
+	if (dfu_wq.dfu)
+		cyclic_unregister(&dfu_wq.cyclic);
+	dfu_wq.dfu = NULL;
+	dfu_wq.pending = 0;
+}
+
 unsigned char *dfu_free_buf(void)
 {
+	dfu_write_queue_stop();
 	free(dfu_buf);
 	dfu_buf = NULL;
 	return dfu_buf;
@@ -213,6 +260,7 @@ unsigned long dfu_get_buf_size(void)
 
 unsigned char *dfu_get_buf(struct dfu_entity *dfu)
 {
+	ulong count;
 	char *s;
 
 	/* manage several entity with several contraint */
@@ -232,10 +280,19 @@ unsigned char *dfu_get_buf(struct dfu_entity *dfu)
 	if (dfu->max_buf_size && dfu_buf_size > dfu->max_buf_size)
 		dfu_buf_size = dfu->max_buf_size;
 
-	dfu_buf = memalign(CONFIG_SYS_CACHELINE_SIZE, dfu_buf_size);
+	/* Writing in the background needs the cyclic framework */
+	dfu_buf_count = 1;
+	if (CONFIG_IS_ENABLED(CYCLIC)) {
+		count = env_get_ulong("dfu_bufcnt", 0,
+				      CONFIG_DFU_WRITE_BUF_COUNT);
+		dfu_buf_count = clamp(count, 1UL, (ulong)DFU_MAX_BUF_COUNT);
+	}
+
+	dfu_buf = memalign(CONFIG_SYS_CACHELINE_SIZE,
+			   dfu_buf_size * dfu_buf_count);
 	if (dfu_buf == NULL)
 		printf("%s: Could not memalign 0x%lx bytes\n",
-		       __func__, dfu_buf_size);
+		       __func__, dfu_buf_size * dfu_buf_count);
 
 	dfu_buf_device_type = dfu->dev_type;
 	return dfu_buf;
@@ -258,27 +315,24 @@ static char *dfu_get_hash_algo(void)
 	return NULL;
 }
 
-static int dfu_write_buffer_drain(struct dfu_entity *dfu)
+static int dfu_write_buffer(struct dfu_entity *dfu, u8 *buf, long w_size)
 {
-	long w_size;
+	ulong start;
 	int ret;
 
-	/* flush size? */
-	w_size = dfu->i_buf - dfu->i_buf_start;
 	if (w_size == 0)
 		return 0;
 
 	if (dfu_hash_algo)
 		dfu_hash_algo->hash_update(dfu_hash_algo, &dfu->crc,
-					   dfu->i_buf_start, w_size, 0);
+					   buf, w_size, 0);
 
-	ret = dfu->write_medium(dfu, dfu->offset, dfu->i_buf_start, &w_size);
+	start = timer_get_us();
+	ret = dfu->write_medium(dfu, dfu->offset, buf, &w_size);
+	dfu_wq.busy_us += timer_get_us() - start;
 	if (ret)
 		debug("%s: Write error!\n", __func__);
 
-	/* point back */
-	dfu->i_buf = dfu->i_buf_start;
-
 	/* update offset */
 	dfu->offset += w_size;
 
@@ -287,8 +341,110 @@ static int dfu_write_buffer_drain(struct dfu_entity *dfu)
 	return ret;
 }
 
+/* Write the oldest queued buffer */
+static int dfu_write_queue_drain(void)
+{
+	unsigned int i = dfu_wq.head;
+	int ret;
+
+	dfu_wq.draining = true;
+	ret = dfu_write_buffer(dfu_wq.dfu, dfu_buf + i * dfu_buf_size,
+			       dfu_wq.len[i]);
+	dfu_wq.draining = false;
+	dfu_wq.head = (i + 1) % dfu_buf_count;
+	dfu_wq.pending--;
+	if (ret && !dfu_wq.err)
+		dfu_wq.err = ret;
+
+	return ret;
+}
+
+static void dfu_write_cyclic(struct cyclic_info *c)
+{
+	if (dfu_wq.pending && !dfu_wq.err && !dfu_wq.draining)
+		dfu_write_queue_drain();
+}
+
+/* Write all queued buffers */
+static int dfu_write_queue_wait(void)
+{
+	while (dfu_wq.pending && !dfu_wq.err)
+		dfu_write_queue_drain();
+
+	return dfu_wq.err;
+}
+
+static int dfu_write_buffer_drain(struct dfu_entity *dfu)
+{
+	unsigned int next;
+	long w_size;
+	int ret;
+
+	/* flush size? */
+	w_size = dfu->i_buf - dfu->i_buf_start;
+	if (w_size == 0)
+		return 0;
+
+	if (!dfu_wq.dfu) {
+		ret = dfu_write_buffer(dfu, dfu->i_buf_start, w_size);
+
+		/* point back */
+		dfu->i_buf = dfu->i_buf_start;
+
+		return ret;
+	}
+
+	/* Queue the buffer, waiting for the oldest one if all are in use */
+	if (dfu_wq.pending == dfu_buf_count - 1) {
+		dfu_wq.stalls++;
+		dfu_write_queue_drain();
+	}
+	if (dfu_wq.err)
+		return dfu_wq.err;
+
+	next = (dfu_wq.head + dfu_wq.pending) % dfu_buf_count;
+	dfu_wq.len[next] = w_size;
+	dfu_wq.pending++;
+
+	/* Continue in the next free buffer */
+	next = (next + 1) % dfu_buf_count;
+	dfu->i_buf_start = dfu_buf + next * dfu_buf_size;
+	dfu->i_buf_end = dfu->i_buf_start + dfu_buf_size;
+	dfu->i_buf = dfu->i_buf_start;
+
+	return 0;
+}
+
+static void dfu_write_queue_start(struct dfu_entity *dfu)
+{
+	dfu_wq.head = 0;
+	dfu_wq.pending = 0;
+	dfu_wq.err = 0;
+	dfu_wq.start_us = timer_get_us();
+	dfu_wq.busy_us = 0;
+	dfu_wq.stalls = 0;
+	dfu_wq.draining = false;
+	if (dfu_buf_count > 1) {
+		dfu_wq.dfu = dfu;
+		cyclic_register(&dfu_wq.cyclic, dfu_write_cyclic, 0,
+				"dfu_write");
+	}
+}
+
+static void dfu_write_queue_stats(struct dfu_entity *dfu)
+{
+	ulong total_us = max(timer_get_us() - dfu_wq.start_us, 1UL);
+
+	printf("\nDFU %s: %llu bytes in %lu ms (%llu KiB/s), medium busy %lu ms, waited for a free buffer %u times\n",
+	       dfu->name, dfu->offset, total_us / 1000,
+	       lldiv(dfu->offset * 1000000 / 1024, total_us),
+	       dfu_wq.busy_us / 1000, dfu_wq.stalls);
+}
+
 void dfu_transaction_cleanup(struct dfu_entity *dfu)
 {
+	dfu_write_queue_stop();
+
 	/* clear everything */
 	dfu->crc = 0;
 	dfu->offset = 0;
@@ -322,6 +478,8 @@ int dfu_transaction_initiate(struct dfu_entity *dfu, bool read)
 		if (ret < 0)
 			return ret;
 		debug("%s: %s %lld [B]\n", __func__, dfu->name, dfu->r_left);
+	} else {
+		dfu_write_queue_start(dfu);
 	}
 
 	dfu->inited = 1;
@@ -332,12 +490,22 @@ int dfu_transaction_initiate(struct dfu_entity *dfu, bool read)
 
 int dfu_flush(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 {
+	bool queued = dfu_wq.dfu;
 	int ret = 0;
 
-	ret = dfu_write_buffer_drain(dfu);
+	ret = dfu_write_queue_wait();
 	if (ret)
 		return ret;
 
+	ret = dfu_write_buffer(dfu, dfu->i_buf_start,
+			       dfu->i_buf - dfu->i_buf_start);
+	dfu->i_buf = dfu->i_buf_start;
+	if (ret)
+		return ret;
+
+	if (queued)
+		dfu_write_queue_stats(dfu);
+
 	if (dfu->flush_medium)
 		ret = dfu->flush_medium(dfu);
 
@@ -364,6 +532,14 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 	if (ret < 0)
 		return ret;
 
+	/* Report an error from writing a queued buffer */
+	if (dfu_wq.err) {
+		ret = dfu_wq.err;
+		dfu_transaction_cleanup(dfu);
+		dfu_error_callback(dfu, "DFU write error");
+		return ret;
+	}
+
 	if (dfu->i_blk_seq_num != blk_seq_num) {
 		printf("%s: Wrong sequence number! [%d] [%d]\n",
 		       __func__, dfu->i_blk_seq_num, blk_seq_num);
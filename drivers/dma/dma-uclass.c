@@ -12,6 +12,7 @@
 #define LOG_CATEGORY UCLASS_DMA
 
 #include <cpu_func.h>
+#include <cyclic.h>
 #include <dm.h>
 #include <log.h>
 #include <malloc.h>
@@ -260,6 +261,108 @@ int dma_memcpy(void *dst, void *src, size_t len)
 	return ret;
 }
 
+int dma_memcpy_submit(struct dma_memcpy_tx *tx, void *dst, const void *src,
+		      size_t len)
+{
+	const struct dma_ops *ops;
+	struct udevice *dev;
+	int ret;
+
+	/*
+	 * Mapping works on whole cache lines, so invalidating an unaligned
+	 * destination would discard data next to it
+	 */
+	if (!IS_ALIGNED((ulong)dst | (ulong)src | len, ARCH_DMA_MINALIGN))
+		return -EINVAL;
+
+	ret = dma_get_device(DMA_SUPPORTS_MEM_TO_MEM, &dev);
+	if (ret < 0)
+		return ret;
+
+	ops = device_get_ops(dev);
+	if (!ops->submit && !ops->transfer)
+		return -ENOSYS;
+
+	tx->dev = dev;
+	tx->len = len;
+	tx->cookie = 0;
+	tx->dst = dma_map_single(dst, len, DMA_FROM_DEVICE);
+	tx->src = dma_map_single((void *)src, len, DMA_TO_DEVICE);
+
+	if (ops->submit) {
+		ret = ops->submit(dev, DMA_MEM_TO_MEM, tx->dst, tx->src, len,
+				  &tx->cookie);
+		if (!ret) {
+			tx->status = -EINPROGRESS;
+			return 0;
+		}
+	} else {
+		ret = ops->transfer(dev, DMA_MEM_TO_MEM, tx->dst, tx->src, len);
+	}
+
+	dma_unmap_single(tx->dst, len, DMA_FROM_DEVICE);
+	dma_unmap_single(tx->src, len, DMA_TO_DEVICE);
+	tx->status = ret;
+
+	/* A synchronous copy is complete already, report errors when polled */
+	return ops->submit ? ret : 0;
+}
+
+int dma_memcpy_poll(struct dma_memcpy_tx *tx)
+{
+	const struct dma_ops *ops;
+
+	if (tx->status != -EINPROGRESS)
+		return tx->status;
+
+	ops = device_get_ops(tx->dev);
+	tx->status = ops->poll ? ops->poll(tx->dev, tx->cookie) : -ENOSYS;
+	if (tx->status == -EINPROGRESS)
+		return tx->status;
+
+	/* Invalidate the destination so that the CPU sees the copied data */
+	dma_unmap_single(tx->dst, tx->len, DMA_FROM_DEVICE);
+	dma_unmap_single(tx->src, tx->len, DMA_TO_DEVICE);
+
+	return tx->status;
+}
+
+int dma_memcpy_wait(struct dma_memcpy_tx *tx)
+{
+	int ret;
+
+	while ((ret = dma_memcpy_poll(tx)) == -EINPROGRESS)
+		schedule();
+
+	return ret;
+}
+
+#if CONFIG_IS_ENABLED(DMA_MEMCPY_OFFLOAD)
+int dma_memcpy_offload(void *dst, const void *src, size_t len)
+{
+	struct dma_memcpy_tx tx;
+	int ret;
+
+	if (len < CONFIG_DMA_MEMCPY_OFFLOAD_MIN)
+		return -EINVAL;
+	if (dst < src + len && src < dst + len)
+		return -EINVAL;
+	/* Flushing the source must not touch data outside it either */
+	if (!IS_ALIGNED((ulong)dst | (ulong)src | len, ARCH_DMA_MINALIGN))
+		return -EINVAL;
+
+	ret = dma_memcpy_submit(&tx, dst, src, len);
+	if (ret)
+		return ret;
+	ret = dma_memcpy_wait(&tx);
+	if (ret)
+		log_warning("DMA copy of %zx bytes failed (err=%d)\n", len,
+			    ret);
+
+	return ret;
+}
+#endif
+
 UCLASS_DRIVER(dma) = {
 	.id		= UCLASS_DMA,
 	.name		= "dma",
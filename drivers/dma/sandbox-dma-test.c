@@ -15,9 +15,12 @@
 #include <dt-structs.h>
 #include <errno.h>
 #include <linux/printk.h>
+#include <linux/sizes.h>
 
 #define SANDBOX_DMA_CH_CNT 3
 #define SANDBOX_DMA_BUF_SIZE 1024
+#define SANDBOX_DMA_DESC_CNT 4
+#define SANDBOX_DMA_CHUNK SZ_64K
 
 struct sandbox_dma_chan {
 	struct sandbox_dma_dev *ud;
@@ -28,6 +31,14 @@ struct sandbox_dma_chan {
 	bool enabled;
 };
 
+/* A queued memory-to-memory transfer */
+struct sandbox_dma_desc {
+	dma_addr_t dst;
+	dma_addr_t src;
+	size_t len;
+	size_t done;
+};
+
 struct sandbox_dma_dev {
 	struct device *dev;
 	u32 ch_count;
@@ -36,6 +47,9 @@ struct sandbox_dma_dev {
 	uchar	*buf_rx;
 	size_t	data_len;
 	u32	meta;
+	struct sandbox_dma_desc desc[SANDBOX_DMA_DESC_CNT];
+	ulong	submitted;
+	ulong	completed;
 };
 
 static int sandbox_dma_transfer(struct udevice *dev, int direction,
@@ -46,6 +60,55 @@ static int sandbox_dma_transfer(struct udevice *dev, int direction,
 	return 0;
 }
 
+static int sandbox_dma_submit(struct udevice *dev, int direction,
+			      dma_addr_t dst, dma_addr_t src, size_t len,
+			      ulong *cookie)
+{
+	struct sandbox_dma_dev *ud = dev_get_priv(dev);
+	struct sandbox_dma_desc *desc;
+
+	if (direction != DMA_MEM_TO_MEM)
+		return -EINVAL;
+	if (ud->submitted - ud->completed == SANDBOX_DMA_DESC_CNT)
+		return -EBUSY;
+
+	desc = &ud->desc[ud->submitted % SANDBOX_DMA_DESC_CNT];
+	desc->dst = dst;
+	desc->src = src;
+	desc->len = len;
+	desc->done = 0;
+	*cookie = ++ud->submitted;
+
+	return 0;
+}
+
+/*
+ * The emulated engine only makes progress when polled, copying up to
+ * SANDBOX_DMA_CHUNK bytes of the oldest transfer each time. This lets tests
+ * see transfers in flight.
+ */
+static int sandbox_dma_poll(struct udevice *dev, ulong cookie)
+{
+	struct sandbox_dma_dev *ud = dev_get_priv(dev);
+	struct sandbox_dma_desc *desc;
+	size_t len;
+
+	if (!cookie || cookie > ud->submitted)
+		return -EINVAL;
+	if (cookie <= ud->completed)
+		return 0;
+
+	desc = &ud->desc[ud->completed % SANDBOX_DMA_DESC_CNT];
+	len = min_t(size_t, desc->len - desc->done, SANDBOX_DMA_CHUNK);
+	memcpy((void *)desc->dst + desc->done, (void *)desc->src + desc->done,
+	       len);
+	desc->done += len;
+	if (desc->done == desc->len)
+		ud->completed++;
+
+	return cookie <= ud->completed ? 0 : -EINPROGRESS;
+}
+
 static int sandbox_dma_of_xlate(struct dma *dma,
 				struct ofnode_phandle_args *args)
 {
@@ -229,6 +292,8 @@ static int sandbox_dma_prepare_rcv_buf(struct dma *dma, void *dst, size_t size)
 
 static const struct dma_ops sandbox_dma_ops = {
 	.transfer	= sandbox_dma_transfer,
+	.submit		= sandbox_dma_submit,
+	.poll		= sandbox_dma_poll,
 	.of_xlate	= sandbox_dma_of_xlate,
 	.request	= sandbox_dma_request,
 	.rfree		= sandbox_dma_rfree,
@@ -10,6 +10,7 @@
 #include <fastboot-internal.h>
 #include <fb_mmc.h>
 #include <fb_nand.h>
+#include <image-sparse.h>
 #include <part.h>
 #include <stdlib.h>
 #include <vsprintf.h>
@@ -30,6 +31,38 @@ static u32 fastboot_bytes_received;
  */
 static u32 fastboot_bytes_expected;
 
+/**
+ * enum fb_stream_state - state of a streamed flash
+ *
+ * @FB_STREAM_IDLE: downloads are held in the download buffer
+ * @FB_STREAM_ARMED: the next download is written while it is received
+ * @FB_STREAM_ACTIVE: the current download is being written
+ * @FB_STREAM_DONE: the download has been written, "flash" reports the result
+ */
+enum fb_stream_state {
+	FB_STREAM_IDLE,
+	FB_STREAM_ARMED,
+	FB_STREAM_ACTIVE,
+	FB_STREAM_DONE,
+};
+
+/**
+ * fb_stream - sparse image written to flash while it is downloaded
+ *
+ * @state: Current state
+ * @part: Partition given to the "oem stream" command
+ * @storage: Storage of @part
+ * @sparse: Sparse image parser, using the download buffer for staging
+ * @response: Result reported by the "flash" command
+ */
+static struct {
+	enum fb_stream_state state;
+	char part[FASTBOOT_COMMAND_LEN];
+	struct sparse_storage storage;
+	struct sparse_stream sparse;
+	char response[FASTBOOT_RESPONSE_LEN];
+} fb_stream;
+
 static void okay(char *, char *);
 static void getvar(char *, char *);
 static void download(char *, char *);
@@ -43,6 +76,7 @@ static void oem_partconf(char *, char *);
 static void oem_bootbus(char *, char *);
 static void oem_console(char *, char *);
 static void oem_board(char *, char *);
+static void oem_stream(char *, char *);
 static void run_ucmd(char *, char *);
 static void run_acmd(char *, char *);
 
@@ -118,6 +152,10 @@ static const struct {
 		.command = "oem board",
 		.dispatch = CONFIG_IS_ENABLED(FASTBOOT_OEM_BOARD, (oem_board), (NULL))
 	},
+	[FASTBOOT_COMMAND_OEM_STREAM] = {
+		.command = "oem stream",
+		.dispatch = CONFIG_IS_ENABLED(FASTBOOT_STREAM_FLASH, (oem_stream), (NULL))
+	},
 	[FASTBOOT_COMMAND_UCMD] = {
 		.command = "UCmd",
 		.dispatch = CONFIG_IS_ENABLED(FASTBOOT_UUU_SUPPORT, (run_ucmd), (NULL))
@@ -226,6 +264,7 @@ static void getvar(char *cmd_parameter, char *response)
  */
 static void download(char *cmd_parameter, char *response)
 {
+	bool stream = false;
 	char *tmp;
 
 	if (!cmd_parameter) {
@@ -238,13 +277,31 @@ static void download(char *cmd_parameter, char *response)
 		fastboot_fail("Expected nonzero image size", response);
 		return;
 	}
+
+	if (CONFIG_IS_ENABLED(FASTBOOT_STREAM_FLASH)) {
+		stream = fb_stream.state == FB_STREAM_ARMED;
+		fb_stream.state = FB_STREAM_IDLE;
+		if (stream && sparse_stream_init(&fb_stream.sparse,
+						 &fb_stream.storage,
+						 fastboot_buf_addr,
+						 fastboot_buf_size)) {
+			fastboot_fail("Download buffer too small", response);
+			return;
+		}
+	}
+
 	/*
 	 * Nothing to download yet. Response is of the form:
 	 * [DATA|FAIL]$cmd_parameter
 	 *
 	 * where cmd_parameter is an 8 digit hexadecimal number
 	 */
-	if (fastboot_bytes_expected > fastboot_buf_size) {
+	if (stream) {
+		printf("Starting download of %d bytes to '%s'\n",
+		       fastboot_bytes_expected, fb_stream.part);
+		fb_stream.state = FB_STREAM_ACTIVE;
+		fastboot_response("DATA", response, "%s", cmd_parameter);
+	} else if (fastboot_bytes_expected > fastboot_buf_size) {
 		fastboot_fail(cmd_parameter, response);
 	} else {
 		printf("Starting download of %d bytes\n",
@@ -274,6 +331,10 @@ u32 fastboot_data_remaining(void)
  * response. fastboot_bytes_received is updated to indicate the number
  * of bytes that have been transferred.
  *
+ * When the download is streamed, the data is passed to the sparse image
+ * parser instead, which writes it to flash. Errors are recorded and reported
+ * by the "flash" command, so that the transfer itself always completes.
+ *
  * On completion sets image_size and ${filesize} to the total size of the
  * downloaded image.
  */
@@ -291,9 +352,16 @@ void fastboot_data_download(const void *fastboot_data,
 			      response);
 		return;
 	}
-	/* Download data to fastboot_buf_addr */
-	memcpy(fastboot_buf_addr + fastboot_bytes_received,
-	       fastboot_data, fastboot_data_len);
+	if (CONFIG_IS_ENABLED(FASTBOOT_STREAM_FLASH) &&
+	    fb_stream.state == FB_STREAM_ACTIVE) {
+		/* Write to flash, staging data in fastboot_buf_addr */
+		sparse_stream_write(&fb_stream.sparse, fastboot_data,
+				    fastboot_data_len, fb_stream.response);
+	} else {
+		/* Download data to fastboot_buf_addr */
+		memcpy(fastboot_buf_addr + fastboot_bytes_received,
+		       fastboot_data, fastboot_data_len);
+	}
 
 	pre_dot_num = fastboot_bytes_received / BYTES_PER_DOT;
 	fastboot_bytes_received += fastboot_data_len;
@@ -321,6 +389,16 @@ void fastboot_data_complete(char *response)
 	printf("\ndownloading of %d bytes finished\n", fastboot_bytes_received);
 	image_size = fastboot_bytes_received;
 	env_set_hex("filesize", image_size);
+
+	if (CONFIG_IS_ENABLED(FASTBOOT_STREAM_FLASH) &&
+	    fb_stream.state == FB_STREAM_ACTIVE) {
+		if (!sparse_stream_finish(&fb_stream.sparse, fb_stream.part,
+					  fb_stream.response))
+			fastboot_okay(NULL, fb_stream.response);
+		fb_stream.state = FB_STREAM_DONE;
+		/* The download buffer only holds the tail of the image */
+		image_size = 0;
+	}
 	fastboot_bytes_expected = 0;
 	fastboot_bytes_received = 0;
 }
@@ -333,9 +411,24 @@ void fastboot_data_complete(char *response)
  *
  * Writes the previously downloaded image to the partition indicated by
  * cmd_parameter. Writes to response.
+ *
+ * If the image has already been written by a streamed download, only report
+ * the result of that.
  */
 static void __maybe_unused flash(char *cmd_parameter, char *response)
 {
+	if (CONFIG_IS_ENABLED(FASTBOOT_STREAM_FLASH) &&
+	    fb_stream.state == FB_STREAM_DONE) {
+		fb_stream.state = FB_STREAM_IDLE;
+		if (!cmd_parameter || strcmp(cmd_parameter, fb_stream.part))
+			fastboot_fail("Image was streamed to another partition",
+				      response);
+		else
+			strlcpy(response, fb_stream.response,
+				FASTBOOT_RESPONSE_LEN);
+		return;
+	}
+
 	if (IS_ENABLED(CONFIG_FASTBOOT_FLASH_MMC))
 		fastboot_mmc_flash_write(cmd_parameter, fastboot_buf_addr,
 					 image_size, response);
@@ -572,3 +665,38 @@ static void __maybe_unused oem_board(char *cmd_parameter, char *response)
 {
 	fastboot_oem_board(cmd_parameter, (void *)fastboot_buf_addr, image_size, response);
 }
+
+/**
+ * oem_stream() - Write the next download to a partition while receiving it
+ *
+ * @cmd_parameter: Pointer to partition name
+ * @response: Pointer to fastboot response buffer
+ *
+ * The next download must be a sparse image. It may be larger than the
+ * download buffer, which is only used for staging. The following "flash"
+ * command reports the result.
+ */
+static void __maybe_unused oem_stream(char *cmd_parameter, char *response)
+{
+	int ret = -ENODEV;
+
+	fb_stream.state = FB_STREAM_IDLE;
+	if (!cmd_parameter || !*cmd_parameter) {
+		fastboot_fail("Expected partition name", response);
+		return;
+	}
+
+	/* Stream to one device only, so that an MMC error is not lost */
+	if (IS_ENABLED(CONFIG_FASTBOOT_FLASH_MMC))
+		ret = fastboot_mmc_sparse_storage(cmd_parameter,
+						  &fb_stream.storage, response);
+	else if (IS_ENABLED(CONFIG_FASTBOOT_FLASH_NAND))
+		ret = fastboot_nand_sparse_storage(cmd_parameter,
+						   &fb_stream.storage, response);
+	if (ret)
+		return;
+
+	strlcpy(fb_stream.part, cmd_parameter, sizeof(fb_stream.part));
+	fb_stream.state = FB_STREAM_ARMED;
+	fastboot_okay(NULL, response);
+}
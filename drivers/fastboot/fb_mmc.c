@@ -498,6 +498,77 @@ static struct blk_desc *fastboot_mmc_get_dev(char *response)
 	return ret;
 }
 
+/**
+ * fb_mmc_lookup() - Look up the partition to write a regular image to
+ *
+ * @cmd: Named partition
+ * @dev_desc: Pointer to returned blk_desc pointer
+ * @info: Pointer to returned struct disk_partition
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 or partition number on success, negative on error
+ */
+static int fb_mmc_lookup(const char *cmd, struct blk_desc **dev_desc,
+			 struct disk_partition *info, char *response)
+{
+#if IS_ENABLED(CONFIG_FASTBOOT_MMC_USER_SUPPORT)
+	if (strcmp(cmd, CONFIG_FASTBOOT_MMC_USER_NAME) == 0) {
+		*dev_desc = fastboot_mmc_get_dev(response);
+		if (!*dev_desc)
+			return -ENODEV;
+
+		strlcpy((char *)&info->name, cmd, sizeof(info->name));
+		info->size	= (*dev_desc)->lba;
+		info->blksz	= (*dev_desc)->blksz;
+		return 0;
+	}
+#endif
+
+	return fastboot_mmc_get_part_info(cmd, dev_desc, info, response);
+}
+
+static void fb_mmc_sparse_init(struct sparse_storage *sparse,
+			       struct fb_mmc_sparse *sparse_priv,
+			       struct blk_desc *dev_desc,
+			       struct disk_partition *info)
+{
+	sparse_priv->dev_desc = dev_desc;
+
+	sparse->blksz = info->blksz;
+	sparse->start = info->start;
+	sparse->size = info->size;
+	sparse->write = fb_mmc_sparse_write;
+	sparse->reserve = fb_mmc_sparse_reserve;
+	sparse->mssg = fastboot_fail;
+	sparse->priv = sparse_priv;
+}
+
+/**
+ * fastboot_mmc_sparse_storage() - Prepare eMMC for a streamed sparse image
+ *
+ * @cmd: Named partition to write image to
+ * @sparse: Pointer to returned sparse storage
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 on success, negative on error
+ */
+int fastboot_mmc_sparse_storage(const char *cmd, struct sparse_storage *sparse,
+				char *response)
+{
+	/* The storage outlives the command, so its private data must too */
+	static struct fb_mmc_sparse sparse_priv;
+	struct disk_partition info = {0};
+	struct blk_desc *dev_desc;
+	int ret;
+
+	ret = fb_mmc_lookup(cmd, &dev_desc, &info, response);
+	if (ret < 0)
+		return ret;
+
+	fb_mmc_sparse_init(sparse, &sparse_priv, dev_desc, &info);
+	printf("Streaming sparse image to offset " LBAFU "\n", sparse->start);
+
+	return 0;
+}
+
 /**
  * fastboot_mmc_flash_write() - Write image to eMMC for fastboot
  *
@@ -592,20 +663,7 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
 	}
 #endif
 
-#if IS_ENABLED(CONFIG_FASTBOOT_MMC_USER_SUPPORT)
-	if (strcmp(cmd, CONFIG_FASTBOOT_MMC_USER_NAME) == 0) {
-		dev_desc = fastboot_mmc_get_dev(response);
-		if (!dev_desc)
-			return;
-
-		strlcpy((char *)&info.name, cmd, sizeof(info.name));
-		info.size	= dev_desc->lba;
-		info.blksz	= dev_desc->blksz;
-	}
-#endif
-
-	if (!info.name[0] &&
-	    fastboot_mmc_get_part_info(cmd, &dev_desc, &info, response) < 0)
+	if (fb_mmc_lookup(cmd, &dev_desc, &info, response) < 0)
 		return;
 
 	if (is_sparse_image(download_buffer)) {
@@ -613,19 +671,11 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
 		struct sparse_storage sparse;
 		int err;
 
-		sparse_priv.dev_desc = dev_desc;
-
-		sparse.blksz = info.blksz;
-		sparse.start = info.start;
-		sparse.size = info.size;
-		sparse.write = fb_mmc_sparse_write;
-		sparse.reserve = fb_mmc_sparse_reserve;
-		sparse.mssg = fastboot_fail;
+		fb_mmc_sparse_init(&sparse, &sparse_priv, dev_desc, &info);
 
 		printf("Flashing sparse image at offset " LBAFU "\n",
 		       sparse.start);
 
-		sparse.priv = &sparse_priv;
 		err = write_sparse_image(&sparse, cmd, download_buffer,
 					 response);
 		if (!err)
@@ -146,6 +146,22 @@ static lbaint_t fb_nand_sparse_reserve(struct sparse_storage *info,
 	return blkcnt + bad_blocks;
 }
 
+static void fb_nand_sparse_init(struct sparse_storage *sparse,
+				struct fb_nand_sparse *sparse_priv,
+				struct mtd_info *mtd, struct part_info *part)
+{
+	sparse_priv->mtd = mtd;
+	sparse_priv->part = part;
+
+	sparse->blksz = mtd->writesize;
+	sparse->start = part->offset / sparse->blksz;
+	sparse->size = part->size / sparse->blksz;
+	sparse->write = fb_nand_sparse_write;
+	sparse->reserve = fb_nand_sparse_reserve;
+	sparse->mssg = fastboot_fail;
+	sparse->priv = sparse_priv;
+}
+
 /**
  * fastboot_nand_get_part_info() - Lookup NAND partion by name
  *
@@ -161,6 +177,42 @@ int fastboot_nand_get_part_info(const char *part_name,
 	return fb_nand_lookup(part_name, &mtd, part_info, response);
 }
 
+/**
+ * fastboot_nand_sparse_storage() - Prepare NAND for a streamed sparse image
+ *
+ * @cmd: Named device to write image to
+ * @sparse: Pointer to returned sparse storage
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 on success, negative on error
+ */
+int fastboot_nand_sparse_storage(const char *cmd, struct sparse_storage *sparse,
+				 char *response)
+{
+	/* The storage outlives the command, so its private data must too */
+	static struct fb_nand_sparse sparse_priv;
+	struct part_info *part;
+	struct mtd_info *mtd = NULL;
+	int ret;
+
+	ret = fb_nand_lookup(cmd, &mtd, &part, response);
+	if (ret) {
+		pr_err("invalid NAND device");
+		fastboot_fail("invalid NAND device", response);
+		return ret;
+	}
+
+	ret = board_fastboot_write_partition_setup(part->name);
+	if (ret) {
+		fastboot_fail("partition setup failed", response);
+		return ret;
+	}
+
+	fb_nand_sparse_init(sparse, &sparse_priv, mtd, part);
+	printf("Streaming sparse image to offset " LBAFU "\n", sparse->start);
+
+	return 0;
+}
+
 /**
  * fastboot_nand_flash_write() - Write image to NAND for fastboot
  *
@@ -191,20 +243,11 @@ void fastboot_nand_flash_write(const char *cmd, void *download_buffer,
 		struct fb_nand_sparse sparse_priv;
 		struct sparse_storage sparse;
 
-		sparse_priv.mtd = mtd;
-		sparse_priv.part = part;
-
-		sparse.blksz = mtd->writesize;
-		sparse.start = part->offset / sparse.blksz;
-		sparse.size = part->size / sparse.blksz;
-		sparse.write = fb_nand_sparse_write;
-		sparse.reserve = fb_nand_sparse_reserve;
-		sparse.mssg = fastboot_fail;
+		fb_nand_sparse_init(&sparse, &sparse_priv, mtd, part);
 
 		printf("Flashing sparse image at offset " LBAFU "\n",
 		       sparse.start);
 
-		sparse.priv = &sparse_priv;
 		ret = write_sparse_image(&sparse, cmd, download_buffer,
 					 response);
 		if (!ret)
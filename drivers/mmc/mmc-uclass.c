@@ -368,7 +368,9 @@ void mmc_do_preinit(void)
 
 		m->user_speed_mode = MMC_MODES_END;  /* Initialising user set speed mode */
 
-		if (m->preinit)
+		if (CONFIG_IS_ENABLED(MMC_ASYNC_INIT))
+			mmc_async_init(m);
+		else if (m->preinit)
 			mmc_start_init(m);
 	}
 }
@@ -538,9 +540,20 @@ U_BOOT_DRIVER(mmc_blk) = {
 };
 #endif /* CONFIG_BLK */
 
+static int mmc_pre_remove(struct udevice *dev)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+
+	if (CONFIG_IS_ENABLED(MMC_ASYNC_INIT) && mmc)
+		mmc_async_cancel(mmc);
+
+	return 0;
+}
+
 UCLASS_DRIVER(mmc) = {
 	.id		= UCLASS_MMC,
 	.name		= "mmc",
 	.flags		= DM_UC_FLAG_SEQ_ALIAS,
+	.pre_remove	= mmc_pre_remove,
 	.per_device_auto	= sizeof(struct mmc_uclass_priv),
 };
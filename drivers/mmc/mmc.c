@@ -9,6 +9,7 @@
 
 #include <config.h>
 #include <blk.h>
+#include <bootstage.h>
 #include <command.h>
 #include <dm.h>
 #include <log.h>
@@ -766,6 +767,10 @@ static int mmc_send_op_cond(struct mmc *mmc)
 		if (mmc->ocr & OCR_BUSY)
 			break;
 
+		/* let the card power up while U-Boot does other things */
+		if (i && mmc_async_pending(mmc))
+			break;
+
 		if (get_timer(start) > timeout)
 			return -ETIMEDOUT;
 		udelay(100);
@@ -3039,6 +3044,102 @@ static int mmc_complete_init(struct mmc *mmc)
 	return err;
 }
 
+#if CONFIG_IS_ENABLED(MMC_ASYNC_INIT)
+/* Interval between steps of background initialisation */
+#define MMC_ASYNC_STEP_US	1000
+
+void mmc_async_cancel(struct mmc *mmc)
+{
+	if (!mmc_async_pending(mmc))
+		return;
+	cyclic_unregister(&mmc->async_cyclic);
+	mmc->async_state = MMC_ASYNC_IDLE;
+}
+
+/**
+ * mmc_async_poll_op_cond() - Check once whether an eMMC card is ready
+ *
+ * @mmc: MMC device
+ * Return: 0 if ready, -EAGAIN if still powering up, -ETIMEDOUT if it took too
+ *	long, other -ve on error
+ */
+static int mmc_async_poll_op_cond(struct mmc *mmc)
+{
+	int err;
+
+	err = mmc_send_op_cond_iter(mmc, 1);
+	if (err)
+		return err;
+	if (mmc->ocr & OCR_BUSY)
+		return 0;
+	if (get_timer(mmc->async_start) > 1000)
+		return -ETIMEDOUT;
+
+	return -EAGAIN;
+}
+
+static void mmc_async_step(struct cyclic_info *c)
+{
+	struct mmc *mmc = container_of(c, struct mmc, async_cyclic);
+	int err;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_MMC_ASYNC, "mmc_async");
+	switch (mmc->async_state) {
+	case MMC_ASYNC_IDLE:
+		break;
+	case MMC_ASYNC_START:
+		/* leave mmc_init() to report a missing card, if it is used */
+		if (!IS_ENABLED(CONFIG_MMC_BROKEN_CD) && !mmc_getcd(mmc)) {
+			mmc_async_cancel(mmc);
+			break;
+		}
+		mmc->async_start = get_timer(0);
+		err = mmc_start_init(mmc);
+		if (err) {
+			mmc_async_cancel(mmc);
+			break;
+		}
+		mmc->async_state = mmc->op_cond_pending ? MMC_ASYNC_OP_COND :
+			MMC_ASYNC_STARTUP;
+		break;
+	case MMC_ASYNC_OP_COND:
+		err = mmc_async_poll_op_cond(mmc);
+		if (err == -EAGAIN)
+			break;
+		/*
+		 * on error, forget the power-up so that mmc_init() starts
+		 * again from scratch and reports any failure
+		 */
+		if (err) {
+			mmc_async_cancel(mmc);
+			mmc->op_cond_pending = 0;
+			mmc->init_in_progress = 0;
+		} else {
+			mmc->async_state = MMC_ASYNC_STARTUP;
+		}
+		break;
+	case MMC_ASYNC_STARTUP:
+		mmc_async_cancel(mmc);
+		err = mmc_init(mmc);
+		log_debug("%s: init %d, time %lu\n", mmc->cfg->name, err,
+			  get_timer(mmc->async_start));
+		if (!err)
+			bootstage_mark_name(BOOTSTAGE_ID_ALLOC, mmc->cfg->name);
+		break;
+	}
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_MMC_ASYNC);
+}
+
+void mmc_async_init(struct mmc *mmc)
+{
+	if (mmc->has_init || mmc->init_in_progress || mmc_async_pending(mmc))
+		return;
+	mmc->async_state = MMC_ASYNC_START;
+	cyclic_register(&mmc->async_cyclic, mmc_async_step, MMC_ASYNC_STEP_US,
+			mmc->cfg->name);
+}
+#endif
+
 static void __maybe_unused mmc_cyclic_cd_poll(struct cyclic_info *c)
 {
 	struct mmc *m = CONFIG_IS_ENABLED(CYCLIC, (container_of(c, struct mmc, cyclic)), (NULL));
@@ -3057,6 +3158,7 @@ int mmc_init(struct mmc *mmc)
 {
 	int err = 0;
 	__maybe_unused ulong start;
+	bool waiting;
 #if CONFIG_IS_ENABLED(DM_MMC)
 	struct mmc_uclass_priv *upriv = dev_get_uclass_priv(mmc->dev);
 
@@ -3067,6 +3169,13 @@ int mmc_init(struct mmc *mmc)
 
 	start = get_timer(0);
 
+	/* finish any background initialisation now */
+	waiting = mmc_async_pending(mmc);
+	if (waiting) {
+		mmc_async_cancel(mmc);
+		bootstage_start(BOOTSTAGE_ID_ACCUM_MMC_WAIT, "mmc_async_wait");
+	}
+
 	if (!mmc->init_in_progress)
 		err = mmc_start_init(mmc);
 
@@ -3074,6 +3183,8 @@ int mmc_init(struct mmc *mmc)
 		err = mmc_complete_init(mmc);
 	if (err)
 		pr_info("%s: %d, time %lu\n", __func__, err, get_timer(start));
+	if (waiting)
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_MMC_WAIT);
 
 	if (CONFIG_IS_ENABLED(CYCLIC, (!mmc->cyclic.func), (NULL))) {
 		/* Register cyclic function for card detect polling */
@@ -100,6 +100,16 @@ int mmc_get_next_devnum(void);
  */
 void mmc_do_preinit(void);
 
+/**
+ * mmc_async_cancel() - Stop initialising a device in the background
+ *
+ * Any steps which have already been done are kept, so mmc_init() carries on
+ * from where the background initialisation stopped.
+ *
+ * @mmc: MMC device
+ */
+void mmc_async_cancel(struct mmc *mmc);
+
 /**
  * mmc_list_init() - Set up the list of MMC devices
  */
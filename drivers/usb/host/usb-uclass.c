@@ -9,6 +9,7 @@
 #define LOG_CATEGORY UCLASS_USB
 
 #include <bootdev.h>
+#include <cyclic.h>
 #include <dm.h>
 #include <errno.h>
 #include <log.h>
@@ -20,8 +21,40 @@
 
 static bool asynch_allowed;
 
+/* Interval between steps of a background scan */
+#define USB_SCAN_STEP_US	1000
+
+/**
+ * enum usb_scan_state - State of a scan started by usb_init_start()
+ *
+ * @USB_SCAN_IDLE: No scan in progress
+ * @USB_SCAN_PRIMARY: Scanning the ports of the primary controllers
+ * @USB_SCAN_COMPANION: Scanning the ports of the companion controllers
+ * @USB_SCAN_DONE: All ports scanned, waiting for usb_scan_wait()
+ */
+enum usb_scan_state {
+	USB_SCAN_IDLE,
+	USB_SCAN_PRIMARY,
+	USB_SCAN_COMPANION,
+	USB_SCAN_DONE,
+};
+
+/**
+ * struct usb_uclass_priv - Information about the USB uclass
+ *
+ * @companion_device_count: Number of devices handed over to companion
+ *	controllers
+ * @scan_state: State of the background scan
+ * @scan_cyclic: Cyclic function which runs the background scan
+ * @controllers: Number of controllers available for the background scan
+ */
 struct usb_uclass_priv {
 	int companion_device_count;
+#if CONFIG_IS_ENABLED(USB_ASYNC_SCAN)
+	enum usb_scan_state scan_state;
+	struct cyclic_info scan_cyclic;
+	int controllers;
+#endif
 };
 
 int usb_lock_async(struct usb_device *udev, int lock)
@@ -187,6 +220,9 @@ int usb_stop(void)
 
 	uc_priv = uclass_get_priv(uc);
 
+	/* Drop any ports still waiting to be scanned */
+	usb_scan_cancel();
+
 	uclass_foreach_dev(bus, uc) {
 		ret = device_remove(bus, DM_REMOVE_NORMAL);
 		if (ret && !err)
@@ -221,25 +257,58 @@ int usb_stop(void)
 	return err;
 }
 
+/* Show the result of scanning a bus */
+static void usb_show_scan(struct udevice *bus, int ret)
+{
+	struct usb_bus_priv *priv = dev_get_uclass_priv(bus);
+
+	if (ret)
+		printf("failed, error %d\n", ret);
+	else if (priv->next_addr == 0)
+		printf("No USB Device found\n");
+	else
+		printf("%d USB Device(s) found\n", priv->next_addr);
+}
+
 static void usb_scan_bus(struct udevice *bus, bool recurse)
 {
-	struct usb_bus_priv *priv;
 	struct udevice *dev;
 	int ret;
 
-	priv = dev_get_uclass_priv(bus);
-
 	assert(recurse);	/* TODO: Support non-recusive */
 
 	printf("scanning bus %s for devices... ", bus->name);
 	debug("\n");
 	ret = usb_scan_device(bus, 0, USB_SPEED_FULL, &dev);
-	if (ret)
-		printf("failed, error %d\n", ret);
-	else if (priv->next_addr == 0)
-		printf("No USB Device found\n");
-	else
-		printf("%d USB Device(s) found\n", priv->next_addr);
+	usb_show_scan(bus, ret);
+}
+
+/**
+ * usb_scan_buses() - Scan the primary or companion controllers
+ *
+ * @uc: USB uclass
+ * @companion: true to scan the companion controllers, false for the others
+ * @defer: true to probe the root hubs and leave their ports to be scanned
+ *	later by usb_hub_scan_step(), false to scan all the devices now
+ */
+static void usb_scan_buses(struct uclass *uc, bool companion, bool defer)
+{
+	struct usb_bus_priv *priv;
+	struct udevice *bus, *dev;
+
+	uclass_foreach_dev(bus, uc) {
+		if (!device_active(bus))
+			continue;
+
+		priv = dev_get_uclass_priv(bus);
+		if (priv->companion != companion)
+			continue;
+		if (!defer) {
+			usb_scan_bus(bus, true);
+			continue;
+		}
+		priv->scan_err = usb_scan_device(bus, 0, USB_SPEED_FULL, &dev);
+	}
 }
 
 static void remove_inactive_children(struct uclass *uc, struct udevice *bus)
@@ -287,26 +356,24 @@ static int usb_probe_companion(struct udevice *bus)
 	return 0;
 }
 
-int usb_init(void)
+/**
+ * usb_probe_buses() - Probe the USB controllers
+ *
+ * @uc: USB uclass
+ * @defer: true if the buses are being scanned in the background, so that the
+ *	bus name is only shown if there is an error
+ * Return: number of controllers which are available
+ */
+static int usb_probe_buses(struct uclass *uc, bool defer)
 {
 	int controllers_initialized = 0;
-	struct usb_uclass_priv *uc_priv;
-	struct usb_bus_priv *priv;
 	struct udevice *bus;
-	struct uclass *uc;
 	int ret;
 
-	asynch_allowed = 1;
-
-	ret = uclass_get(UCLASS_USB, &uc);
-	if (ret)
-		return ret;
-
-	uc_priv = uclass_get_priv(uc);
-
 	uclass_foreach_dev(bus, uc) {
 		/* init low_level USB */
-		printf("Bus %s: ", bus->name);
+		if (!defer)
+			printf("Bus %s: ", bus->name);
 
 		/*
 		 * For Sandbox, we need scan the device tree each time when we
@@ -321,12 +388,16 @@ int usb_init(void)
 		    IS_ENABLED(CONFIG_USB_ONBOARD_HUB)) {
 			ret = dm_scan_fdt_dev(bus);
 			if (ret) {
+				if (defer)
+					printf("Bus %s: ", bus->name);
 				printf("USB device scan from fdt failed (%d)", ret);
 				continue;
 			}
 		}
 
 		ret = device_probe(bus);
+		if (ret && defer)
+			printf("Bus %s: ", bus->name);
 		if (ret == -ENODEV) {	/* No such device. */
 			puts("Port not available.\n");
 			controllers_initialized++;
@@ -346,51 +417,201 @@ int usb_init(void)
 		usb_started = true;
 	}
 
+	return controllers_initialized;
+}
+
+/* Tidy up after scanning the buses */
+static int usb_scan_done(struct uclass *uc, int controllers_initialized)
+{
+	struct udevice *bus = NULL;
+	int ret;
+
+	debug("scan end\n");
+
+	/* Remove any devices that were not found on this scan */
+	remove_inactive_children(uc, bus);
+
+	ret = uclass_get(UCLASS_USB_HUB, &uc);
+	if (ret)
+		return ret;
+	remove_inactive_children(uc, bus);
+
+	/* if we were not able to find at least one working bus, bail out */
+	if (controllers_initialized == 0)
+		printf("No USB controllers found\n");
+
+	return usb_started ? 0 : -ENOENT;
+}
+
+int usb_init(void)
+{
+	int controllers_initialized;
+	struct usb_uclass_priv *uc_priv;
+	struct uclass *uc;
+	int ret;
+
+	/* A background scan already covers every bus, so just finish it */
+	if (usb_scan_busy())
+		return usb_scan_wait();
+
+	asynch_allowed = 1;
+
+	ret = uclass_get(UCLASS_USB, &uc);
+	if (ret)
+		return ret;
+
+	uc_priv = uclass_get_priv(uc);
+
+	controllers_initialized = usb_probe_buses(uc, false);
+
 	/*
 	 * lowlevel init done, now scan the bus for devices i.e. search HUBs
 	 * and configure them, first scan primary controllers.
 	 */
-	uclass_foreach_dev(bus, uc) {
-		if (!device_active(bus))
-			continue;
-
-		priv = dev_get_uclass_priv(bus);
-		if (!priv->companion)
-			usb_scan_bus(bus, true);
-	}
+	usb_scan_buses(uc, false, false);
 
 	/*
 	 * Now that the primary controllers have been scanned and have handed
 	 * over any devices they do not understand to their companions, scan
 	 * the companions if necessary.
 	 */
-	if (uc_priv->companion_device_count) {
-		uclass_foreach_dev(bus, uc) {
-			if (!device_active(bus))
-				continue;
+	if (uc_priv->companion_device_count)
+		usb_scan_buses(uc, true, false);
 
-			priv = dev_get_uclass_priv(bus);
-			if (priv->companion)
-				usb_scan_bus(bus, true);
-		}
+	return usb_scan_done(uc, controllers_initialized);
+}
+
+#if CONFIG_IS_ENABLED(USB_ASYNC_SCAN)
+static void usb_scan_cyclic(struct cyclic_info *c)
+{
+	struct usb_uclass_priv *uc_priv;
+	struct uclass *uc;
+
+	uc_priv = container_of(c, struct usb_uclass_priv, scan_cyclic);
+	if (usb_hub_scan_step())
+		return;
+
+	/* Companions are scanned once the primary controllers are done */
+	if (uc_priv->scan_state == USB_SCAN_PRIMARY &&
+	    uc_priv->companion_device_count &&
+	    !uclass_get(UCLASS_USB, &uc)) {
+		uc_priv->scan_state = USB_SCAN_COMPANION;
+		usb_scan_buses(uc, true, true);
+		return;
 	}
+	log_debug("USB ports scanned\n");
+	uc_priv->scan_state = USB_SCAN_DONE;
+	cyclic_unregister(c);
+}
 
-	debug("scan end\n");
+int usb_init_start(void)
+{
+	struct usb_uclass_priv *uc_priv;
+	struct uclass *uc;
+	int ret;
 
-	/* Remove any devices that were not found on this scan */
-	remove_inactive_children(uc, bus);
+	ret = uclass_get(UCLASS_USB, &uc);
+	if (ret)
+		return ret;
 
-	ret = uclass_get(UCLASS_USB_HUB, &uc);
+	uc_priv = uclass_get_priv(uc);
+	if (uc_priv->scan_state != USB_SCAN_IDLE)
+		return -EALREADY;
+	asynch_allowed = 1;
+
+	/*
+	 * While a scan is in progress, hubs only add their ports to the list,
+	 * ready for the cyclic
+	 */
+	uc_priv->scan_state = USB_SCAN_PRIMARY;
+	uc_priv->controllers = usb_probe_buses(uc, true);
+	if (!usb_started) {
+		usb_hub_scan_stop();
+		uc_priv->scan_state = USB_SCAN_IDLE;
+		return usb_scan_done(uc, uc_priv->controllers);
+	}
+	usb_scan_buses(uc, false, true);
+	cyclic_register(&uc_priv->scan_cyclic, usb_scan_cyclic,
+			USB_SCAN_STEP_US, "usb_scan");
+
+	return 0;
+}
+
+bool usb_scan_busy(void)
+{
+	struct usb_uclass_priv *uc_priv;
+	struct uclass *uc;
+
+	if (uclass_get(UCLASS_USB, &uc))
+		return false;
+	uc_priv = uclass_get_priv(uc);
+
+	return uc_priv->scan_state != USB_SCAN_IDLE;
+}
+
+void usb_scan_cancel(void)
+{
+	struct usb_uclass_priv *uc_priv;
+	struct uclass *uc;
+
+	if (uclass_get(UCLASS_USB, &uc))
+		return;
+	uc_priv = uclass_get_priv(uc);
+
+	cyclic_unregister(&uc_priv->scan_cyclic);
+	usb_hub_scan_stop();
+	uc_priv->scan_state = USB_SCAN_IDLE;
+}
+
+static int usb_uclass_destroy(struct uclass *uc)
+{
+	struct usb_uclass_priv *uc_priv = uclass_get_priv(uc);
+
+	/* The hubs have gone, but the cyclic is still in the uclass priv */
+	cyclic_unregister(&uc_priv->scan_cyclic);
+
+	return 0;
+}
+
+int usb_scan_wait(void)
+{
+	struct usb_uclass_priv *uc_priv;
+	struct usb_bus_priv *priv;
+	struct udevice *bus;
+	struct uclass *uc;
+	int ret;
+
+	ret = uclass_get(UCLASS_USB, &uc);
 	if (ret)
 		return ret;
-	remove_inactive_children(uc, bus);
+	uc_priv = uclass_get_priv(uc);
+	if (uc_priv->scan_state == USB_SCAN_IDLE)
+		return 0;
 
-	/* if we were not able to find at least one working bus, bail out */
-	if (controllers_initialized == 0)
-		printf("No USB controllers found\n");
+	/*
+	 * Carry on from where the cyclic function got to. It must not run
+	 * while this is scanning, since the delays call schedule()
+	 */
+	cyclic_unregister(&uc_priv->scan_cyclic);
+	while (uc_priv->scan_state != USB_SCAN_DONE)
+		usb_scan_cyclic(&uc_priv->scan_cyclic);
+	usb_hub_scan_stop();
+	uc_priv->scan_state = USB_SCAN_IDLE;
 
-	return usb_started ? 0 : -ENOENT;
+	uclass_foreach_dev(bus, uc) {
+		if (!device_active(bus))
+			continue;
+		priv = dev_get_uclass_priv(bus);
+		if (priv->companion && !uc_priv->companion_device_count)
+			continue;
+		printf("Bus %s: scanning bus %s for devices... ", bus->name,
+		       bus->name);
+		usb_show_scan(bus, priv->scan_err);
+	}
+
+	return usb_scan_done(uc, uc_priv->controllers);
 }
+#endif /* USB_ASYNC_SCAN */
 
 int usb_setup_ehci_gadget(struct ehci_ctrl **ctlrp)
 {
@@ -856,6 +1077,9 @@ UCLASS_DRIVER(usb) = {
 	.name		= "usb",
 	.flags		= DM_UC_FLAG_SEQ_ALIAS,
 	.post_bind	= dm_scan_fdt_dev,
+#if CONFIG_IS_ENABLED(USB_ASYNC_SCAN)
+	.destroy	= usb_uclass_destroy,
+#endif
 	.priv_auto	= sizeof(struct usb_uclass_priv),
 	.per_child_auto	= sizeof(struct usb_device),
 	.per_device_auto	= sizeof(struct usb_bus_priv),
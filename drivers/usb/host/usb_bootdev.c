@@ -10,6 +10,9 @@
 #include <dm.h>
 #include <usb.h>
 
+/* true if usb_bootdev_step() has finished a hunt */
+static bool usb_bootdev_done;
+
 static int usb_bootdev_bind(struct udevice *dev)
 {
 	struct bootdev_uc_plat *ucp = dev_get_uclass_plat(dev);
@@ -27,6 +30,35 @@ static int usb_bootdev_hunt(struct bootdev_hunter *info, bool show)
 	return usb_init();
 }
 
+static int usb_bootdev_step(struct bootdev_hunter *info, bool show,
+			    bool background)
+{
+	int ret;
+
+	if (!usb_scan_busy()) {
+		/* A new hunt after a finished one must scan the buses again */
+		if (usb_started && usb_bootdev_done)
+			usb_stop();
+		if (!usb_started) {
+			ret = usb_init_start();
+			if (ret)
+				return ret;
+		}
+		usb_bootdev_done = false;
+	}
+
+	/*
+	 * When running in the background, leave the result to be collected in
+	 * the foreground, so that it is shown when the hunter is used
+	 */
+	if (background && usb_scan_busy())
+		return -EAGAIN;
+	ret = usb_scan_wait();
+	usb_bootdev_done = true;
+
+	return ret;
+}
+
 struct bootdev_ops usb_bootdev_ops = {
 };
 
@@ -47,5 +79,7 @@ BOOTDEV_HUNTER(usb_bootdev_hunter) = {
 	.prio		= BOOTDEVP_5_SCAN_SLOW,
 	.uclass		= UCLASS_USB,
 	.hunt		= usb_bootdev_hunt,
+	.step		= CONFIG_IS_ENABLED(USB_ASYNC_SCAN) ? usb_bootdev_step :
+			  NULL,
 	.drv		= DM_DRIVER_REF(usb_bootdev),
 };
@@ -35,6 +35,8 @@ static int console_set_row(struct udevice *dev, uint row, int clr)
 		fill_pixel_and_goto_next(&dst, clr, pbytes, pbytes);
 	end = dst;
 
+	video_damage(dev->parent, 0, fontdata->height * row, vid_priv->xsize,
+		     fontdata->height);
 	ret = vidconsole_sync_copy(dev, line, end);
 	if (ret)
 		return ret;
@@ -91,6 +93,7 @@ static int console_putc_xy(struct udevice *dev, uint x_frac, uint y, int cp)
 	if (ret)
 		return ret;
 
+	video_damage(dev->parent, x, y, fontdata->width, fontdata->height);
 	ret = vidconsole_sync_copy(dev, start, line);
 	if (ret)
 		return ret;
@@ -122,6 +125,8 @@ static int console_set_cursor_visible(struct udevice *dev, bool visible,
 	line = start;
 	draw_cursor_vertically(&line, vid_priv, vc_priv->y_charsize,
 			       NORMAL_DIRECTION);
+	video_damage(dev->parent, x + 1, y, VIDCONSOLE_CURSOR_WIDTH,
+		     vc_priv->y_charsize);
 
 	return 0;
 }
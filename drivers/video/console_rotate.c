@@ -32,6 +32,9 @@ static int console_set_row_1(struct udevice *dev, uint row, int clr)
 			fill_pixel_and_goto_next(&dst, clr, pbytes, pbytes);
 		line += vid_priv->line_length;
 	}
+	video_damage(dev->parent,
+		     vid_priv->xsize - (row + 1) * fontdata->height, 0,
+		     fontdata->height, vid_priv->ysize);
 	ret = vidconsole_sync_copy(dev, start, line);
 	if (ret)
 		return ret;
@@ -92,6 +95,9 @@ static int console_putc_xy_1(struct udevice *dev, uint x_frac, uint y, int cp)
 	if (ret)
 		return ret;
 
+	video_damage(dev->parent, vid_priv->xsize - y - fontdata->height,
+		     linenum - 1, fontdata->height, fontdata->width);
+
 	/* We draw backwards from 'start, so account for the first line */
 	ret = vidconsole_sync_copy(dev, start - vid_priv->line_length, line);
 	if (ret)
@@ -117,6 +123,9 @@ static int console_set_row_2(struct udevice *dev, uint row, int clr)
 	for (i = 0; i < pixels; i++)
 		fill_pixel_and_goto_next(&dst, clr, pbytes, pbytes);
 	end = dst;
+	video_damage(dev->parent, 0,
+		     vid_priv->ysize - (row + 1) * fontdata->height,
+		     vid_priv->xsize, fontdata->height);
 	ret = vidconsole_sync_copy(dev, start, end);
 	if (ret)
 		return ret;
@@ -170,6 +179,10 @@ static int console_putc_xy_2(struct udevice *dev, uint x_frac, uint y, int cp)
 	if (ret)
 		return ret;
 
+	video_damage(dev->parent, x - fontdata->width + 1,
+		     linenum - fontdata->height + 1, fontdata->width,
+		     fontdata->height);
+
 	/* Add 4 bytes to allow for the first pixel writen */
 	ret = vidconsole_sync_copy(dev, start + 4, line);
 	if (ret)
@@ -195,6 +208,8 @@ static int console_set_row_3(struct udevice *dev, uint row, int clr)
 			fill_pixel_and_goto_next(&dst, clr, pbytes, pbytes);
 		line += vid_priv->line_length;
 	}
+	video_damage(dev->parent, row * fontdata->height, 0, fontdata->height,
+		     vid_priv->ysize);
 	ret = vidconsole_sync_copy(dev, start, line);
 	if (ret)
 		return ret;
@@ -252,6 +267,8 @@ static int console_putc_xy_3(struct udevice *dev, uint x_frac, uint y, int cp)
 	ret = fill_char_horizontally(pfont, &line, vid_priv, fontdata, NORMAL_DIRECTION);
 	if (ret)
 		return ret;
+	video_damage(dev->parent, y, linenum - fontdata->width + 1,
+		     fontdata->height, fontdata->width);
 	/* Add a line to allow for the first pixels writen */
 	ret = vidconsole_sync_copy(dev, start + vid_priv->line_length, line);
 	if (ret)
@@ -10,6 +10,7 @@
 #include <spl.h>
 #include <video.h>
 #include <video_console.h>
+#include <linux/list.h>
 
 /* Functions needed by stb_truetype.h */
 static int tt_floor(double val)
@@ -127,6 +128,66 @@ struct pos_info {
  */
 #define POS_HISTORY_SIZE	(CONFIG_SYS_CBSIZE * 11 / 10)
 
+/* Number of hash buckets in each glyph cache (must be a power of two) */
+#define GLYPH_HASH_SIZE		64
+
+/* Maximum size of each glyph cache, including the cache structure */
+#ifdef CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE
+#define GLYPH_CACHE_SIZE	CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE_SIZE
+#else
+#define GLYPH_CACHE_SIZE	0
+#endif
+
+/**
+ * struct tt_glyph - A rendered character
+ *
+ * This holds the 8-bit alpha map of a character, as produced by the STB
+ * library. Each row is padded with zeroes to a multiple of four bytes, so
+ * that transparent areas can be skipped a word at a time.
+ *
+ * @node:	Entry in the glyph-cache hash table
+ * @lru:	Entry in the glyph-cache LRU list (most recently used first).
+ *		This is empty if the glyph is not in the cache
+ * @cp:		Unicode code point
+ * @shift:	Subpixel X offset used to render the glyph, in units of
+ *		1/VID_FRAC_DIV pixels
+ * @width:	Width of the image in pixels
+ * @height:	Height of the image in pixels
+ * @xoff:	X offset of the image from the cursor position
+ * @yoff:	Y offset of the image from the baseline
+ * @stride:	Number of bytes in each row of @bits
+ * @bits:	Alpha map, @stride * @height bytes
+ */
+struct tt_glyph {
+	struct hlist_node node;
+	struct list_head lru;
+	int cp;
+	int shift;
+	int width;
+	int height;
+	int xoff;
+	int yoff;
+	int stride;
+	u8 bits[];
+};
+
+/**
+ * struct tt_glyph_cache - Cache of rendered characters for one font / size
+ *
+ * @lru:	List of cached glyphs, most recently used first
+ * @hash:	Hash table of cached glyphs, indexed by code point and shift
+ * @size:	Total number of bytes used by the cached glyphs
+ * @hits:	Number of lookups which found the glyph in the cache
+ * @misses:	Number of lookups which had to render the glyph
+ */
+struct tt_glyph_cache {
+	struct list_head lru;
+	struct hlist_head hash[GLYPH_HASH_SIZE];
+	uint size;
+	uint hits;
+	uint misses;
+};
+
 /**
  * struct console_tt_metrics - Information about a font / size combination
  *
@@ -145,6 +206,7 @@ struct pos_info {
  * @scale:	Scale of the font. This is calculated from the pixel height
  *		of the font. It is used by the STB library to generate images
  *		of the correct size.
+ * @cache:	Cache of rendered glyphs, or NULL if not allocated yet
  */
 struct console_tt_metrics {
 	const char *font_name;
@@ -153,6 +215,7 @@ struct console_tt_metrics {
 	stbtt_fontinfo font;
 	int baseline;
 	double scale;
+	struct tt_glyph_cache *cache;
 };
 
 /**
@@ -187,6 +250,154 @@ struct console_tt_store {
 	struct pos_info cur;
 };
 
+static uint glyph_hash(int cp, int shift)
+{
+	return ((uint)cp * 0x9e3779b1 + shift) & (GLYPH_HASH_SIZE - 1);
+}
+
+/**
+ * render_glyph() - Render a character into a newly allocated glyph
+ *
+ * @met:	Font / size to use
+ * @cp:		Code point to render
+ * @x_shift:	Subpixel X offset in pixels
+ * @shift:	Cache key for @x_shift, in units of 1/VID_FRAC_DIV pixels
+ * Return: new glyph, or NULL if out of memory
+ */
+static struct tt_glyph *render_glyph(struct console_tt_metrics *met, int cp,
+				     float x_shift, int shift)
+{
+	int x0, y0, x1, y1, stride;
+	struct tt_glyph *glyph;
+
+	stbtt_GetCodepointBitmapBoxSubpixel(&met->font, cp, met->scale,
+					    met->scale, x_shift, 0, &x0, &y0,
+					    &x1, &y1);
+	stride = ALIGN(x1 - x0, sizeof(u32));
+	glyph = calloc(1, sizeof(*glyph) + stride * (y1 - y0));
+	if (!glyph)
+		return NULL;
+	INIT_LIST_HEAD(&glyph->lru);
+	glyph->cp = cp;
+	glyph->shift = shift;
+	glyph->width = x1 - x0;
+	glyph->height = y1 - y0;
+	glyph->xoff = x0;
+	glyph->yoff = y0;
+	glyph->stride = stride;
+	if (glyph->width && glyph->height)
+		stbtt_MakeCodepointBitmapSubpixel(&met->font, glyph->bits,
+						  glyph->width, glyph->height,
+						  stride, met->scale,
+						  met->scale, x_shift, 0, cp);
+
+	return glyph;
+}
+
+/**
+ * get_glyph() - Get the rendered image of a character
+ *
+ * This looks in the glyph cache first, rendering the character and adding it
+ * to the cache if needed. The least-recently used glyphs are dropped to keep
+ * the cache within CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE_SIZE bytes.
+ *
+ * Only offsets which are a whole number of 1/VID_FRAC_DIV pixels are cached.
+ * Others, which come from kerning, are rendered each time.
+ *
+ * @met:	Font / size to use
+ * @cp:		Code point to render
+ * @x_shift:	Subpixel X offset in pixels
+ * Return: glyph, or NULL if out of memory. Call put_glyph() when done
+ */
+static struct tt_glyph *get_glyph(struct console_tt_metrics *met, int cp,
+				  double x_shift)
+{
+	struct tt_glyph_cache *cache = met->cache;
+	double frac_shift = x_shift * VID_FRAC_DIV;
+	int shift = (int)frac_shift;
+	struct tt_glyph *glyph;
+	uint size, hash;
+	int i;
+
+	if (!IS_ENABLED(CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE) ||
+	    shift != frac_shift)
+		return render_glyph(met, cp, x_shift, shift);
+
+	if (!cache) {
+		cache = malloc(sizeof(*cache));
+		if (!cache)
+			return render_glyph(met, cp, x_shift, shift);
+		INIT_LIST_HEAD(&cache->lru);
+		for (i = 0; i < GLYPH_HASH_SIZE; i++)
+			INIT_HLIST_HEAD(&cache->hash[i]);
+		cache->size = sizeof(*cache);
+		cache->hits = 0;
+		cache->misses = 0;
+		met->cache = cache;
+	}
+
+	hash = glyph_hash(cp, shift);
+	hlist_for_each_entry(glyph, &cache->hash[hash], node) {
+		if (glyph->cp == cp && glyph->shift == shift) {
+			list_move(&glyph->lru, &cache->lru);
+			cache->hits++;
+			return glyph;
+		}
+	}
+	cache->misses++;
+
+	glyph = render_glyph(met, cp, x_shift, shift);
+	if (!glyph)
+		return NULL;
+	size = sizeof(*glyph) + glyph->stride * glyph->height;
+	if (sizeof(*cache) + size > GLYPH_CACHE_SIZE)
+		return glyph;
+
+	while (cache->size + size > GLYPH_CACHE_SIZE) {
+		struct tt_glyph *old;
+
+		old = list_last_entry(&cache->lru, struct tt_glyph, lru);
+		list_del(&old->lru);
+		hlist_del(&old->node);
+		cache->size -= sizeof(*old) + old->stride * old->height;
+		free(old);
+	}
+	list_add(&glyph->lru, &cache->lru);
+	hlist_add_head(&glyph->node, &cache->hash[hash]);
+	cache->size += size;
+
+	return glyph;
+}
+
+/* Release a glyph obtained from get_glyph() */
+static void put_glyph(struct tt_glyph *glyph)
+{
+	if (list_empty(&glyph->lru))
+		free(glyph);
+}
+
+/* Free a glyph cache and all the glyphs in it */
+static void free_glyph_cache(struct tt_glyph_cache *cache)
+{
+	struct tt_glyph *glyph, *tmp;
+
+	list_for_each_entry_safe(glyph, tmp, &cache->lru, lru)
+		free(glyph);
+	free(cache);
+}
+
+/*
+ * Check if the four pixels starting at @bits (pixel @i in the row) are all
+ * transparent, so that they can be skipped. Rows are word-aligned and padded
+ * to a whole number of words. Transparent pixels only leave the display
+ * unchanged when drawing a non-zero foreground over a zero background, so
+ * @skip must be false otherwise.
+ */
+static inline bool glyph_clear_word(bool skip, const u8 *bits, int i)
+{
+	return skip && !(i & 3) && !*(const u32 *)bits;
+}
+
 static int console_truetype_set_row(struct udevice *dev, uint row, int clr)
 {
 	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
@@ -229,6 +440,8 @@ static int console_truetype_set_row(struct udevice *dev, uint row, int clr)
 	default:
 		return -ENOSYS;
 	}
+	video_damage(dev->parent, 0, row * met->font_size, vid_priv->xsize,
+		     met->font_size);
 	ret = vidconsole_sync_copy(dev, line, end);
 	if (ret)
 		return ret;
@@ -274,8 +487,10 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 	double xpos, x_shift;
 	int lsb;
 	int width_frac, linenum;
+	struct tt_glyph *glyph;
 	struct pos_info *pos;
-	u8 *bits, *data;
+	bool skip;
+	u8 *bits;
 	int advance;
 	void *start, *end, *line;
 	int row, ret;
@@ -314,19 +529,23 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 	}
 
 	/*
-	 * Figure out how much past the start of a pixel we are, and pass this
-	 * information into the render, which will return a 8-bit-per-pixel
-	 * image of the character. For empty characters, like ' ', data will
-	 * return NULL;
+	 * Figure out how much past the start of a pixel we are, and use this
+	 * to obtain a 8-bit-per-pixel image of the character. Empty
+	 * characters, like ' ', have no image.
 	 */
-	data = stbtt_GetCodepointBitmapSubpixel(font, met->scale, met->scale,
-						x_shift, 0, cp, &width, &height,
-						&xoff, &yoff);
-	if (!data)
+	glyph = get_glyph(met, cp, x_shift);
+	if (!glyph)
+		return -ENOMEM;
+	width = glyph->width;
+	height = glyph->height;
+	xoff = glyph->xoff;
+	yoff = glyph->yoff;
+	if (!width || !height) {
+		put_glyph(glyph);
 		return width_frac;
+	}
 
 	/* Figure out where to write the character in the frame buffer */
-	bits = data;
 	start = vid_priv->fb + y * vid_priv->line_length +
 		VID_TO_PIXEL(x) * VNBYTES(vid_priv->bpix);
 	linenum = met->baseline + yoff;
@@ -337,9 +556,13 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 	/*
 	 * Write a row at a time, converting the 8bpp image into the colour
 	 * depth of the display. We only expect white-on-black or the reverse
-	 * so the code only handles this simple case.
+	 * so the code only handles this simple case. For white-on-black,
+	 * transparent pixels leave the display unchanged, so are skipped a
+	 * word at a time.
 	 */
+	skip = vid_priv->colour_fg && !vid_priv->colour_bg;
 	for (row = 0; row < height; row++) {
+		bits = glyph->bits + row * glyph->stride;
 		switch (vid_priv->bpix) {
 		case VIDEO_BPP8:
 			if (IS_ENABLED(CONFIG_VIDEO_BPP8)) {
@@ -350,6 +573,13 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 					int val = *bits;
 					int out;
 
+					if (glyph_clear_word(skip, bits, i)) {
+						i += 3;
+						dst += 4;
+						bits += 4;
+						continue;
+					}
+
 					if (vid_priv->colour_bg)
 						val = 255 - val;
 					out = val;
@@ -371,6 +601,13 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 					int val = *bits;
 					int out;
 
+					if (glyph_clear_word(skip, bits, i)) {
+						i += 3;
+						dst += 4;
+						bits += 4;
+						continue;
+					}
+
 					if (vid_priv->colour_bg)
 						val = 255 - val;
 					out = val >> 3 |
@@ -395,6 +632,13 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 					int val = *bits;
 					int out;
 
+					if (glyph_clear_word(skip, bits, i)) {
+						i += 3;
+						dst += 4;
+						bits += 4;
+						continue;
+					}
+
 					if (vid_priv->colour_bg)
 						val = 255 - val;
 					if (vid_priv->format == VIDEO_X2R10G10B10)
@@ -412,16 +656,18 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 			break;
 		}
 		default:
-			free(data);
+			put_glyph(glyph);
 			return -ENOSYS;
 		}
 
 		line += vid_priv->line_length;
 	}
+	video_damage(vid, VID_TO_PIXEL(x) + xoff,
+		     y + (linenum > 0 ? linenum : 0), width, height);
+	put_glyph(glyph);
 	ret = vidconsole_sync_copy(dev, start, line);
 	if (ret)
 		return ret;
-	free(data);
 
 	return width_frac;
 }
@@ -941,6 +1187,7 @@ static int truetype_set_cursor_visible(struct udevice *dev, bool visible,
 
 		line += vid_priv->line_length;
 	}
+	video_damage(vid, x + xoff, y, width, height);
 	ret = vidconsole_sync_copy(dev, start, line);
 	if (ret)
 		return ret;
@@ -990,6 +1237,23 @@ static int console_truetype_probe(struct udevice *dev)
 	return 0;
 }
 
+static int console_truetype_remove(struct udevice *dev)
+{
+	struct console_tt_priv *priv = dev_get_priv(dev);
+	int i;
+
+	for (i = 0; i < priv->num_metrics; i++) {
+		struct console_tt_metrics *met = &priv->metrics[i];
+
+		if (met->cache) {
+			free_glyph_cache(met->cache);
+			met->cache = NULL;
+		}
+	}
+
+	return 0;
+}
+
 struct vidconsole_ops console_truetype_ops = {
 	.putc_xy	= console_truetype_putc_xy,
 	.move_rows	= console_truetype_move_rows,
@@ -1011,5 +1275,6 @@ U_BOOT_DRIVER(vidconsole_truetype) = {
 	.id	= UCLASS_VIDEO_CONSOLE,
 	.ops	= &console_truetype_ops,
 	.probe	= console_truetype_probe,
+	.remove	= console_truetype_remove,
 	.priv_auto	= sizeof(struct console_tt_priv),
 };
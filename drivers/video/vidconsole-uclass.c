@@ -767,10 +767,30 @@ int vidconsole_sync_copy(struct udevice *dev, void *from, void *to)
 	return video_sync_copy(vid, from, to);
 }
 
+#endif
+
+#if defined(CONFIG_VIDEO_COPY) || defined(CONFIG_VIDEO_DAMAGE)
 int vidconsole_memmove(struct udevice *dev, void *dst, const void *src,
 		       int size)
 {
 	memmove(dst, src, size);
+	if (IS_ENABLED(CONFIG_VIDEO_DAMAGE)) {
+		struct udevice *vid = dev_get_parent(dev);
+		struct video_priv *vid_priv = dev_get_uclass_priv(vid);
+		int pbytes = VNBYTES(vid_priv->bpix);
+		int offset = dst - vid_priv->fb;
+		int ystart = offset / vid_priv->line_length;
+		int yend = (offset + size - 1) / vid_priv->line_length + 1;
+
+		/* Within a single line only part of the line has changed */
+		if (yend - ystart == 1)
+			video_damage(vid, offset % vid_priv->line_length /
+				     pbytes, ystart, size / pbytes, 1);
+		else
+			video_damage(vid, 0, ystart, vid_priv->xsize,
+				     yend - ystart);
+	}
+
 	return vidconsole_sync_copy(dev, dst, dst + size);
 }
 #endif
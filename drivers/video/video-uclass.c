@@ -210,6 +210,7 @@ int video_fill_part(struct udevice *dev, int xstart, int ystart, int xend,
 		}
 		line += priv->line_length;
 	}
+	video_damage(dev, xstart, ystart, pixels, yend - ystart);
 	ret = video_sync_copy(dev, start, line);
 	if (ret)
 		return ret;
@@ -258,6 +259,7 @@ int video_fill(struct udevice *dev, u32 colour)
 		memset(priv->fb, colour, priv->fb_size);
 		break;
 	}
+	video_damage(dev, 0, 0, priv->xsize, priv->ysize);
 	ret = video_sync_copy(dev, priv->fb, priv->fb + priv->fb_size);
 	if (ret)
 		return ret;
@@ -364,6 +366,150 @@ void video_set_default_colors(struct udevice *dev, bool invert)
 	priv->colour_bg = video_index_to_colour(priv, back);
 }
 
+#ifdef CONFIG_VIDEO_DAMAGE
+static bool video_bbox_touches(const struct video_bbox *a,
+			       const struct video_bbox *b)
+{
+	return a->x0 <= b->x1 && b->x0 <= a->x1 &&
+	       a->y0 <= b->y1 && b->y0 <= a->y1;
+}
+
+static void video_bbox_merge(struct video_bbox *dst,
+			     const struct video_bbox *src)
+{
+	dst->x0 = min(dst->x0, src->x0);
+	dst->y0 = min(dst->y0, src->y0);
+	dst->x1 = max(dst->x1, src->x1);
+	dst->y1 = max(dst->y1, src->y1);
+}
+
+static ulong video_bbox_area(const struct video_bbox *bbox)
+{
+	return (ulong)(bbox->x1 - bbox->x0) * (bbox->y1 - bbox->y0);
+}
+
+/* Copy a damaged rectangle to the copy frame buffer, if there is one */
+static void video_damage_copy(struct video_priv *priv,
+			      const struct video_bbox *bbox)
+{
+	int pbytes = VNBYTES(priv->bpix);
+	int offset, len, y;
+
+	if (!IS_ENABLED(CONFIG_VIDEO_COPY) || !priv->copy_fb)
+		return;
+
+	offset = bbox->y0 * priv->line_length + bbox->x0 * pbytes;
+	len = (bbox->x1 - bbox->x0) * pbytes;
+
+	/* Full-width rectangles can be copied in one go */
+	if (len == priv->xsize * pbytes) {
+		len = (bbox->y1 - bbox->y0) * priv->line_length;
+		memcpy(priv->copy_fb + offset, priv->fb + offset, len);
+		priv->damage.copy_bytes += len;
+		return;
+	}
+
+	for (y = bbox->y0; y < bbox->y1; y++) {
+		memcpy(priv->copy_fb + offset, priv->fb + offset, len);
+		offset += priv->line_length;
+	}
+	priv->damage.copy_bytes += len * (bbox->y1 - bbox->y0);
+}
+
+void video_damage(struct udevice *vid, int x, int y, int width, int height)
+{
+	struct video_priv *priv = dev_get_uclass_priv(vid);
+	struct video_damage *damage = &priv->damage;
+	struct video_bbox bbox, tmp;
+	ulong growth, best_growth;
+	int i, best;
+
+	bbox.x0 = max(x, 0);
+	bbox.y0 = max(y, 0);
+	bbox.x1 = min(x + width, (int)priv->xsize);
+	bbox.y1 = min(y + height, (int)priv->ysize);
+	if (bbox.x0 >= bbox.x1 || bbox.y0 >= bbox.y1)
+		return;
+
+	video_damage_copy(priv, &bbox);
+
+	/* Extend an existing rectangle if this one overlaps or abuts it */
+	for (i = 0; i < damage->count; i++) {
+		if (video_bbox_touches(&damage->rect[i], &bbox)) {
+			video_bbox_merge(&damage->rect[i], &bbox);
+			return;
+		}
+	}
+
+	if (damage->count < VIDEO_DAMAGE_RECTS) {
+		damage->rect[damage->count++] = bbox;
+		return;
+	}
+
+	/* Out of space, so grow whichever rectangle increases the least */
+	best = 0;
+	best_growth = ULONG_MAX;
+	for (i = 0; i < damage->count; i++) {
+		tmp = damage->rect[i];
+		video_bbox_merge(&tmp, &bbox);
+		growth = video_bbox_area(&tmp) -
+			video_bbox_area(&damage->rect[i]);
+		if (growth < best_growth) {
+			best_growth = growth;
+			best = i;
+		}
+	}
+	video_bbox_merge(&damage->rect[best], &bbox);
+}
+
+static void video_flush_range(struct video_priv *priv, ulong start, ulong end)
+{
+	start = ALIGN_DOWN(start, CONFIG_SYS_CACHELINE_SIZE);
+	end = ALIGN(end, CONFIG_SYS_CACHELINE_SIZE);
+#if defined(CONFIG_ARM) && !CONFIG_IS_ENABLED(SYS_DCACHE_OFF)
+	flush_dcache_range(start, end);
+#endif
+	priv->damage.flush_bytes += end - start;
+}
+
+/*
+ * Flush the damaged rectangles from the data cache. Narrow rectangles are
+ * flushed a line at a time, so the rest of each line is left alone.
+ */
+static void video_flush_damage(struct video_priv *priv)
+{
+	struct video_damage *damage = &priv->damage;
+	int pbytes = VNBYTES(priv->bpix);
+	int i, y;
+
+	if (damage->shared) {
+		video_flush_range(priv, (ulong)priv->fb,
+				  (ulong)priv->fb + priv->fb_size);
+		return;
+	}
+
+	for (i = 0; i < damage->count; i++) {
+		struct video_bbox *bbox = &damage->rect[i];
+		ulong line = (ulong)priv->fb + bbox->y0 * priv->line_length;
+
+		if (bbox->x1 - bbox->x0 == priv->xsize) {
+			video_flush_range(priv, line, (ulong)priv->fb +
+					  bbox->y1 * priv->line_length);
+			continue;
+		}
+		for (y = bbox->y0; y < bbox->y1; y++) {
+			video_flush_range(priv, line + bbox->x0 * pbytes,
+					  line + bbox->x1 * pbytes);
+			line += priv->line_length;
+		}
+	}
+}
+#else
+static inline void video_flush_damage(struct video_priv *priv)
+{
+}
+#endif
+
 /* Flush video activity to the caches */
 int video_sync(struct udevice *vid, bool force)
 {
@@ -386,15 +532,22 @@ int video_sync(struct udevice *vid, bool force)
 	 * architectures do not actually implement it. Is there a way to find
 	 * out whether it exists? For now, ARM is safe.
 	 */
+	if (IS_ENABLED(CONFIG_VIDEO_DAMAGE)) {
+		if (priv->flush_dcache)
+			video_flush_damage(priv);
+	} else {
 #if defined(CONFIG_ARM) && !CONFIG_IS_ENABLED(SYS_DCACHE_OFF)
-	if (priv->flush_dcache) {
-		flush_dcache_range((ulong)priv->fb,
-				   ALIGN((ulong)priv->fb + priv->fb_size,
-					 CONFIG_SYS_CACHELINE_SIZE));
+		if (priv->flush_dcache) {
+			flush_dcache_range((ulong)priv->fb,
+					   ALIGN((ulong)priv->fb + priv->fb_size,
+						 CONFIG_SYS_CACHELINE_SIZE));
+		}
+#endif
 	}
-#elif defined(CONFIG_VIDEO_SANDBOX_SDL)
+#if defined(CONFIG_VIDEO_SANDBOX_SDL)
 	sandbox_sdl_sync(priv->fb);
 #endif
+	priv->damage.count = 0;
 	priv->last_sync = get_timer(0);
 
 	return 0;
@@ -453,6 +606,10 @@ int video_sync_copy(struct udevice *dev, void *from, void *to)
 {
 	struct video_priv *priv = dev_get_uclass_priv(dev);
 
+	/* video_damage() keeps the copy up to date in this case */
+	if (IS_ENABLED(CONFIG_VIDEO_DAMAGE))
+		return 0;
+
 	if (priv->copy_fb) {
 		long offset, size;
 
@@ -504,7 +661,10 @@ int video_sync_copy_all(struct udevice *dev)
 {
 	struct video_priv *priv = dev_get_uclass_priv(dev);
 
-	video_sync_copy(dev, priv->fb, priv->fb + priv->fb_size);
+	if (IS_ENABLED(CONFIG_VIDEO_DAMAGE))
+		video_damage(dev, 0, 0, priv->xsize, priv->ysize);
+	else
+		video_sync_copy(dev, priv->fb, priv->fb + priv->fb_size);
 
 	return 0;
 }
@@ -0,0 +1,142 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Arena allocator, for many small allocations which are freed together
+ */
+
+#ifndef __ARENA_H
+#define __ARENA_H
+
+#include <linux/types.h>
+
+struct arena_block;
+
+/**
+ * struct arena_stats - Statistics for an arena
+ *
+ * @allocs: Number of allocations since the arena was set up
+ * @used: Number of bytes allocated since the last reset, including padding
+ * @peak: Highest value of @used since the arena was set up
+ * @blocks: Number of blocks allocated from the heap since the arena was set up
+ */
+struct arena_stats {
+	ulong allocs;
+	ulong used;
+	ulong peak;
+	ulong blocks;
+};
+
+/**
+ * struct arena - Region of memory which hands out memory in order
+ *
+ * An arena suits objects which are created one after the other and all
+ * freed at the same time, such as the contents of a parsed file. Allocation
+ * just moves a pointer along, so is fast and has little overhead, but memory
+ * cannot be freed, other than by resetting the whole arena.
+ *
+ * The memory comes from a buffer provided by the caller and/or from blocks
+ * allocated from the heap as needed.
+ *
+ * @head: Block which is currently being allocated from, which points to the
+ *	previous blocks. NULL if there is none
+ * @ptr: Next free byte in @head
+ * @end: End of @head
+ * @fixed: Block provided by the caller, which must not be freed, or NULL
+ * @block_size: Size of each block to allocate from the heap, or 0 if the arena
+ *	cannot grow
+ * @stats: Statistics for the arena
+ */
+struct arena {
+	struct arena_block *head;
+	char *ptr;
+	char *end;
+	struct arena_block *fixed;
+	ulong block_size;
+	struct arena_stats stats;
+};
+
+/**
+ * arena_init() - Set up an arena which allocates memory from the heap
+ *
+ * No memory is allocated until it is needed
+ *
+ * @ar: Arena to set up
+ * @block_size: Size of each block to allocate from the heap. Larger
+ *	allocations get a block of their own
+ */
+void arena_init(struct arena *ar, ulong block_size);
+
+/**
+ * arena_init_buf() - Set up an arena which uses the given buffer
+ *
+ * This allows an arena to be used without the heap, e.g. with a buffer on
+ * the stack
+ *
+ * @ar: Arena to set up
+ * @buf: Buffer to allocate from, which must remain valid until the arena is
+ *	uninited
+ * @size: Size of @buf in bytes
+ * @block_size: Size of each block to allocate from the heap when @buf is full,
+ *	or 0 to fail instead
+ */
+void arena_init_buf(struct arena *ar, void *buf, ulong size, ulong block_size);
+
+/**
+ * arena_alloc() - Allocate memory from an arena
+ *
+ * The memory is aligned for any type and is not cleared
+ *
+ * @ar: Arena to allocate from
+ * @size: Number of bytes to allocate
+ * Return: Pointer to the memory, or NULL if out of memory
+ */
+void *arena_alloc(struct arena *ar, ulong size);
+
+/**
+ * arena_zalloc() - Allocate zeroed memory from an arena
+ *
+ * @ar: Arena to allocate from
+ * @size: Number of bytes to allocate
+ * Return: Pointer to the memory, or NULL if out of memory
+ */
+void *arena_zalloc(struct arena *ar, ulong size);
+
+/**
+ * arena_strndup() - Copy part of a string into an arena
+ *
+ * @ar: Arena to allocate from
+ * @str: String to copy
+ * @len: Maximum number of characters to copy, not including the terminator
+ * Return: Pointer to the nul-terminated copy, or NULL if out of memory
+ */
+char *arena_strndup(struct arena *ar, const char *str, ulong len);
+
+/**
+ * arena_strdup() - Copy a string into an arena
+ *
+ * @ar: Arena to allocate from
+ * @str: String to copy
+ * Return: Pointer to the copy, or NULL if out of memory
+ */
+char *arena_strdup(struct arena *ar, const char *str);
+
+/**
+ * arena_reset() - Free everything allocated from an arena
+ *
+ * The first block is kept, so that the arena can be used again without
+ * going back to the heap. The statistics are kept, apart from @used.
+ *
+ * @ar: Arena to reset
+ */
+void arena_reset(struct arena *ar);
+
+/**
+ * arena_uninit() - Free an arena and all the blocks allocated for it
+ *
+ * The arena can be used again after this, as if it had been set up with
+ * arena_init(), with the same block size.
+ *
+ * @ar: Arena to free
+ */
+void arena_uninit(struct arena *ar);
+
+#endif
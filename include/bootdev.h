@@ -70,6 +70,18 @@ struct bootdev_hunter;
  */
 typedef int (*bootdev_hunter_func)(struct bootdev_hunter *info, bool show);
 
+/**
+ * bootdev_hunter_step_func - function to hunt for bootdevs a step at a time
+ *
+ * @info: Info structure describing this hunter
+ * @show: true to show information from the hunter
+ * @background: true if called from the background cyclic function, in which
+ *	case the hunter should not block waiting for hunting to finish
+ * Returns: -EAGAIN if hunting is not complete, else as bootdev_hunter_func
+ */
+typedef int (*bootdev_hunter_step_func)(struct bootdev_hunter *info, bool show,
+					bool background);
+
 /**
  * struct bootdev_hunter - information about how to hunt for bootdevs
  *
@@ -77,6 +89,11 @@ typedef int (*bootdev_hunter_func)(struct bootdev_hunter *info, bool show);
  * @uclass: Uclass ID for the media associated with this bootdev
  * @drv: bootdev driver for the things found by this hunter
  * @hunt: Function to call to hunt for bootdevs of this type (NULL if none)
+ * @step: Function to call to hunt a step at a time, so that hunting can happen
+ *	in the background (NULL if not supported). It returns -EAGAIN until
+ *	hunting is complete, then a result as for @hunt. The next call after
+ *	that starts a new hunt. It may block until hunting is complete unless
+ *	called in the background. If provided, this is used instead of @hunt
  *
  * Some bootdevs are not visible until other devices are enumerated. For
  * example, USB bootdevs only appear when the USB bus is enumerated.
@@ -93,6 +110,7 @@ struct bootdev_hunter {
 	enum uclass_id uclass;
 	struct driver *drv;
 	bootdev_hunter_func hunt;
+	bootdev_hunter_step_func step;
 };
 
 /* declare a new bootdev hunter */
@@ -321,6 +339,27 @@ int bootdev_hunt(const char *spec, bool show);
  */
 int bootdev_hunt_prio(enum bootdev_prio_t prio, bool show);
 
+/**
+ * bootdev_hunt_start() - Start hunting for bootdevs in the background
+ *
+ * This starts all unused hunters which have a step() method. A cyclic function
+ * advances each of them in turn, so that slow buses are enumerated while other
+ * work is done, e.g. scanning faster bootdevs. If a hunter is needed before it
+ * has finished, bootdev_hunt() and bootdev_hunt_prio() finish it as normal.
+ *
+ * Return: 0 if OK, -ve on error
+ */
+int bootdev_hunt_start(void);
+
+/**
+ * bootdev_hunt_stop_all() - Stop all hunters running in the background
+ *
+ * This is used before booting, so that nothing touches the hardware while the
+ * OS is being started. Stopped hunters are not marked as used, so a later
+ * bootdev_hunt() carries on from where they got to.
+ */
+void bootdev_hunt_stop_all(void);
+
 /**
  * bootdev_unhunt() - Mark a device as needing to be hunted again
  *
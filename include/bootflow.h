@@ -126,6 +126,9 @@ struct bootflow {
  * before using it
  * @BOOTFLOWIF_ALL: Return bootflows with errors as well
  * @BOOTFLOWIF_HUNT: Hunt for new bootdevs using the bootdrv hunters
+ * @BOOTFLOWIF_CACHE: Try the bootflow which was last booted first, if it is
+ * still valid (see CONFIG_BOOTSTD_CACHE). This only applies when scanning all
+ * bootdevs
  *
  * Internal flags:
  * @BOOTFLOWIF_SINGLE_DEV: (internal) Just scan one bootdev
@@ -136,12 +139,15 @@ struct bootflow {
  * with things like "mmc1")
  * @BOOTFLOWIF_SINGLE_PARTITION: (internal) Scan one partition in media device
  * (used with things like "mmc1:3")
+ * @BOOTFLOWIF_CACHED: (internal) The bootflow was found using the bootflow
+ * cache; the next scan starts again with the first bootdev
  */
 enum bootflow_iter_flags_t {
 	BOOTFLOWIF_FIXED		= 1 << 0,
 	BOOTFLOWIF_SHOW			= 1 << 1,
 	BOOTFLOWIF_ALL			= 1 << 2,
 	BOOTFLOWIF_HUNT			= 1 << 3,
+	BOOTFLOWIF_CACHE		= 1 << 4,
 
 	/*
 	 * flags used internally by standard boot - do not set these when
@@ -152,6 +158,7 @@ enum bootflow_iter_flags_t {
 	BOOTFLOWIF_SINGLE_UCLASS	= 1 << 18,
 	BOOTFLOWIF_SINGLE_MEDIA		= 1 << 19,
 	BOOTFLOWIF_SINGLE_PARTITION	= 1 << 20,
+	BOOTFLOWIF_CACHED		= 1 << 21,
 };
 
 /**
@@ -221,6 +228,10 @@ enum bootflow_meth_flags_t {
  *	happens before the normal ones)
  * @method_flags: flags controlling which methods should be used for this @dev
  * (enum bootflow_meth_flags_t)
+ * @cached_dev: Bootdev of the bootflow found using the bootflow cache, or NULL
+ *	if none. This bootflow is skipped if the full scan finds it again
+ * @cached_part: Partition of the bootflow found using the bootflow cache
+ * @cached_method: Bootmeth of the bootflow found using the bootflow cache
  */
 struct bootflow_iter {
 	int flags;
@@ -242,6 +253,9 @@ struct bootflow_iter {
 	struct udevice **method_order;
 	bool doing_global;
 	int method_flags;
+	struct udevice *cached_dev;
+	int cached_part;
+	struct udevice *cached_method;
 };
 
 /**
@@ -213,6 +213,10 @@ enum bootstage_id {
 	BOOTSTAGE_ID_ACCUM_FSP_M,
 	BOOTSTAGE_ID_ACCUM_FSP_S,
 	BOOTSTAGE_ID_ACCUM_MMAP_SPI,
+	BOOTSTAGE_ID_ACCUM_FIT_READ,
+	BOOTSTAGE_ID_ACCUM_FIT_PROCESS,
+	BOOTSTAGE_ID_ACCUM_MMC_ASYNC,
+	BOOTSTAGE_ID_ACCUM_MMC_WAIT,
 
 	/* a few spare for the user, from here */
 	BOOTSTAGE_ID_USER,
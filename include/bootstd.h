@@ -9,6 +9,7 @@
 #ifndef __bootstd_h
 #define __bootstd_h
 
+#include <cyclic.h>
 #include <dm/ofnode_decl.h>
 #include <linux/list.h>
 #include <linux/types.h>
@@ -37,6 +38,9 @@ struct udevice;
  * @theme: Node containing the theme information
  * @hunters_used: Bitmask of used hunters, indexed by their position in the
  * linker list. The bit is set if the hunter has been used already
+ * @hunters_active: Bitmask of hunters running in the background, indexed in
+ * the same way as @hunters_used
+ * @hunt_cyclic: Cyclic function which advances the hunters in @hunters_active
  */
 struct bootstd_priv {
 	const char **prefixes;
@@ -50,6 +54,8 @@ struct bootstd_priv {
 	struct udevice *vbe_bootmeth;
 	ofnode theme;
 	uint hunters_used;
+	uint hunters_active;
+	struct cyclic_info hunt_cyclic;
 };
 
 /**
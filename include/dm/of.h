@@ -49,6 +49,8 @@ struct property {
  * @parent: Pointer to parent node, or NULL if this is the root node
  * @child: Pointer to head of child node list, or NULL if no children
  * @sibling: Pointer to the next sibling node, or NULL if this is the last
+ * @prop_hash: Hash table of the properties, or NULL to search the list (only
+ *	present with CONFIG_OF_LIVE_PROP_HASH)
  */
 struct device_node {
 	const char *name;
@@ -60,8 +62,53 @@ struct device_node {
 	struct device_node *parent;
 	struct device_node *child;
 	struct device_node *sibling;
+#if IS_ENABLED(CONFIG_OF_LIVE_PROP_HASH)
+	struct of_prop_hash *prop_hash;
+#endif
+};
+
+/**
+ * struct of_prop_slot: Entry in a property hash table
+ *
+ * @hash: Hash of the property name, see of_prop_name_hash()
+ * @pp: Property, or NULL if the slot is empty
+ */
+struct of_prop_slot {
+	u32 hash;
+	struct property *pp;
 };
 
+/**
+ * struct of_prop_hash: Open-addressing hash table of a node's properties
+ *
+ * This is built by unflatten_device_tree() for nodes with many properties, so
+ * that of_find_property() does not need to compare the name of each one. Only
+ * the first property with a given name is entered, matching a list search.
+ *
+ * @mask: Number of slots minus one (the number of slots is a power of two)
+ * @slot: Hash slots, probed linearly
+ */
+struct of_prop_hash {
+	u32 mask;
+	struct of_prop_slot slot[];
+};
+
+/**
+ * of_prop_name_hash() - Calculate the hash of a property name
+ *
+ * @name: Property name
+ * Return: FNV-1a hash of @name
+ */
+static inline u32 of_prop_name_hash(const char *name)
+{
+	u32 hash = 2166136261U;
+
+	while (*name)
+		hash = (hash ^ (u8)*name++) * 16777619U;
+
+	return hash;
+}
+
 #define BAD_OF_ROOT	0xdead11e3
 
 #define OF_MAX_PHANDLE_ARGS 16
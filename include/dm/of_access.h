@@ -266,6 +266,28 @@ struct device_node *of_find_node_by_prop_value(struct device_node *from,
 struct device_node *of_find_node_by_phandle(struct device_node *root,
 					    phandle handle);
 
+/**
+ * of_phandle_table_build() - Build a table to look up phandles in a tree
+ *
+ * This creates an array indexed by phandle, which of_find_node_by_phandle()
+ * uses to avoid searching the tree. Only one tree has a table at a time, so
+ * this replaces any existing table. Nothing is built if the phandles in the
+ * tree are too sparse for an array to be worthwhile.
+ *
+ * @root:	root node of the tree
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+int of_phandle_table_build(struct device_node *root);
+
+/**
+ * of_phandle_table_free() - Drop the phandle table of a tree
+ *
+ * This must be called before the tree is freed.
+ *
+ * @root:	root node of the tree, or NULL to drop the table of any tree
+ */
+void of_phandle_table_free(struct device_node *root);
+
 /**
  * of_read_u8() - Find and read a 8-bit integer from a property
  *
@@ -134,6 +134,34 @@ struct dma_ops {
 	 */
 	int (*transfer)(struct udevice *dev, int direction, dma_addr_t dst,
 			dma_addr_t src, size_t len);
+	/**
+	 * submit() - Start a DMA transfer without waiting for it
+	 *
+	 * Transfers submitted to a device complete in the order in which
+	 * they were submitted. This is optional, dma_memcpy_submit() falls
+	 * back to transfer() without it.
+	 *
+	 * @dev: The DMA device
+	 * @direction: direction of data transfer (should be one from
+	 *   enum dma_direction)
+	 * @dst: The destination pointer.
+	 * @src: The source pointer.
+	 * @len: Length of the data to be copied (number of bytes).
+	 * @cookie: Returns a non-zero identifier of the transfer for poll()
+	 * @return zero on success, -EBUSY if no more transfers can be
+	 *   queued, or other -ve error code.
+	 */
+	int (*submit)(struct udevice *dev, int direction, dma_addr_t dst,
+		      dma_addr_t src, size_t len, ulong *cookie);
+	/**
+	 * poll() - Check the state of a submitted DMA transfer
+	 *
+	 * @dev: The DMA device
+	 * @cookie: Identifier returned by submit()
+	 * @return zero if the transfer is complete, -EINPROGRESS if it is
+	 *   still running, or other -ve error code if it failed.
+	 */
+	int (*poll)(struct udevice *dev, ulong cookie);
 };
 
 #endif /* _DMA_UCLASS_H */
@@ -307,6 +307,28 @@ int dma_send(struct dma *dma, void *src, size_t len, void *metadata);
 int dma_get_cfg(struct dma *dma, u32 cfg_id, void **cfg_data);
 #endif /* CONFIG_DMA_CHANNELS */
 
+/**
+ * struct dma_memcpy_tx - completion token of an asynchronous memory copy
+ *
+ * The token is filled in by dma_memcpy_submit() and must stay valid until
+ * dma_memcpy_poll() or dma_memcpy_wait() has reported completion.
+ *
+ * @dev: DMA device doing the copy
+ * @dst: destination mapped for the device
+ * @src: source mapped for the device
+ * @len: number of bytes being copied
+ * @cookie: driver-specific identifier of the transfer
+ * @status: -EINPROGRESS while the copy runs, then 0 or a -ve error code
+ */
+struct dma_memcpy_tx {
+	struct udevice *dev;
+	dma_addr_t dst;
+	dma_addr_t src;
+	size_t len;
+	ulong cookie;
+	int status;
+};
+
 #if CONFIG_IS_ENABLED(DMA)
 /*
  * dma_get_device - get a DMA device which supports transfer
@@ -331,6 +353,47 @@ int dma_get_device(u32 transfer_type, struct udevice **devp);
 	     transferred and on failure return error code.
  */
 int dma_memcpy(void *dst, void *src, size_t len);
+
+/**
+ * dma_memcpy_submit() - start copying memory with a DMA engine
+ *
+ * The caches are maintained here, so the caller must not touch either area
+ * until the copy has completed. @dst, @src and @len must be aligned to
+ * ARCH_DMA_MINALIGN, since data sharing a cache line with either area could
+ * be lost otherwise.
+ *
+ * A device without support for asynchronous copies does the whole copy
+ * here, in which case the token is already complete on return.
+ *
+ * @tx: completion token to fill in
+ * @dst: destination pointer
+ * @src: source pointer, must not overlap @dst
+ * @len: number of bytes to copy
+ * Return: 0 if the copy was started, -EINVAL if an area or the length is
+ *	not aligned, -EBUSY if the engine cannot take another transfer, other
+ *	-ve error code on failure
+ */
+int dma_memcpy_submit(struct dma_memcpy_tx *tx, void *dst, const void *src,
+		      size_t len);
+
+/**
+ * dma_memcpy_poll() - check whether an asynchronous copy has completed
+ *
+ * @tx: completion token filled in by dma_memcpy_submit()
+ * Return: 0 if the copy is complete and @dst may be read, -EINPROGRESS if
+ *	it is still running, other -ve error code if it failed
+ */
+int dma_memcpy_poll(struct dma_memcpy_tx *tx);
+
+/**
+ * dma_memcpy_wait() - wait for an asynchronous copy to complete
+ *
+ * Cyclic functions and the watchdog are serviced while waiting.
+ *
+ * @tx: completion token filled in by dma_memcpy_submit()
+ * Return: 0 if the copy is complete, -ve error code if it failed
+ */
+int dma_memcpy_wait(struct dma_memcpy_tx *tx);
 #else
 static inline int dma_get_device(u32 transfer_type, struct udevice **devp)
 {
@@ -341,5 +404,44 @@ static inline int dma_memcpy(void *dst, void *src, size_t len)
 {
 	return -ENOSYS;
 }
+
+static inline int dma_memcpy_submit(struct dma_memcpy_tx *tx, void *dst,
+				    const void *src, size_t len)
+{
+	return -ENOSYS;
+}
+
+static inline int dma_memcpy_poll(struct dma_memcpy_tx *tx)
+{
+	return -ENOSYS;
+}
+
+static inline int dma_memcpy_wait(struct dma_memcpy_tx *tx)
+{
+	return -ENOSYS;
+}
 #endif /* CONFIG_DMA */
+
+#if CONFIG_IS_ENABLED(DMA_MEMCPY_OFFLOAD)
+/**
+ * dma_memcpy_offload() - copy a large area with a DMA engine if possible
+ *
+ * This is meant for moving images around: the copy is only offloaded if it
+ * is at least CONFIG_DMA_MEMCPY_OFFLOAD_MIN bytes long, the areas do not
+ * overlap and the source, destination and length are aligned to
+ * ARCH_DMA_MINALIGN. Otherwise nothing is copied and the caller must fall back
+ * to memmove().
+ *
+ * @dst: destination pointer
+ * @src: source pointer
+ * @len: number of bytes to copy
+ * Return: 0 if the data was copied, -ve error code if not
+ */
+int dma_memcpy_offload(void *dst, const void *src, size_t len);
+#else
+static inline int dma_memcpy_offload(void *dst, const void *src, size_t len)
+{
+	return -ENOSYS;
+}
+#endif
 #endif	/* _DMA_H_ */
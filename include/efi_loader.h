@@ -274,6 +274,8 @@ extern const efi_guid_t efi_guid_host_dev;
 #endif
 /* GUID of the EFI_BLOCK_IO_PROTOCOL */
 extern const efi_guid_t efi_block_io_guid;
+/* GUID of the EFI_BLOCK_IO2_PROTOCOL */
+extern const efi_guid_t efi_block_io2_guid;
 extern const efi_guid_t efi_global_variable_guid;
 extern const efi_guid_t efi_guid_console_control;
 extern const efi_guid_t efi_guid_device_path;
@@ -363,12 +365,16 @@ struct efi_open_protocol_info_item {
  * @guid:		GUID of the protocol
  * @protocol_interface:	protocol interface
  * @open_infos:		link to the list of open protocol info items
+ * @handle:		handle on which the protocol is installed
+ * @guid_link:		link to the list of handlers with the same GUID
  */
 struct efi_handler {
 	struct list_head link;
 	const efi_guid_t guid;
 	void *protocol_interface;
 	struct list_head open_infos;
+	efi_handle_t handle;
+	struct list_head guid_link;
 };
 
 /**
@@ -396,6 +402,8 @@ enum efi_object_type {
  *		handle
  * @type:	image type if the handle relates to an image
  * @dev:	pointer to the DM device which is associated with this EFI handle
+ * @hash_link:	link into the hash table used to validate handles
+ * @seq:	creation sequence number, gives the position in efi_obj_list
  *
  * UEFI offers a flexible and expandable object model. The objects in the UEFI
  * API are devices, drivers, and loaded images. struct efi_object is our storage
@@ -414,6 +422,8 @@ struct efi_object {
 	struct list_head protocols;
 	enum efi_object_type type;
 	struct udevice *dev;
+	struct hlist_node hash_link;
+	ulong seq;
 };
 
 enum efi_image_auth_status {
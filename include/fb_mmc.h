@@ -8,6 +8,7 @@
 
 struct blk_desc;
 struct disk_partition;
+struct sparse_storage;
 
 /**
  * fastboot_mmc_get_part_info() - Lookup eMMC partion by name
@@ -32,6 +33,18 @@ int fastboot_mmc_get_part_info(const char *part_name,
  */
 void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
 			      u32 download_bytes, char *response);
+
+/**
+ * fastboot_mmc_sparse_storage() - Prepare eMMC for a streamed sparse image
+ *
+ * @cmd: Named partition to write image to
+ * @sparse: Pointer to returned sparse storage
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 on success, negative on error
+ */
+int fastboot_mmc_sparse_storage(const char *cmd, struct sparse_storage *sparse,
+				char *response);
+
 /**
  * fastboot_mmc_flash_erase() - Erase eMMC for fastboot
  *
@@ -9,6 +9,8 @@
 
 #include <jffs2/load_kernel.h>
 
+struct sparse_storage;
+
 /**
  * fastboot_nand_get_part_info() - Lookup NAND partion by name
  *
@@ -30,6 +32,17 @@ int fastboot_nand_get_part_info(const char *part_name,
 void fastboot_nand_flash_write(const char *cmd, void *download_buffer,
 			       u32 download_bytes, char *response);
 
+/**
+ * fastboot_nand_sparse_storage() - Prepare NAND for a streamed sparse image
+ *
+ * @cmd: Named device to write image to
+ * @sparse: Pointer to returned sparse storage
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 on success, negative on error
+ */
+int fastboot_nand_sparse_storage(const char *cmd, struct sparse_storage *sparse,
+				 char *response);
+
 /**
  * fastboot_nand_flash_erase() - Erase NAND for fastboot
  *
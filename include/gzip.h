@@ -34,6 +34,25 @@ int gzip_parse_header(const unsigned char *src, unsigned long len);
  */
 int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp);
 
+/**
+ * inflate_fast_buf() - Decompress a raw deflate stream held in memory
+ *
+ * This is the engine behind gunzip() and zunzip() with CONFIG_GZIP_FAST. It
+ * uses @dst as the window, so the whole output must fit in it.
+ *
+ * @dst: Destination for uncompressed data
+ * @dstlen: Size of destination buffer
+ * @src: Deflate stream
+ * @srclen: Length of data at @src, which may extend past the end of the stream
+ * @outlenp: Returns the number of bytes written to @dst
+ * @inlenp: Returns the number of bytes used from @src
+ * @crcp: If not NULL, the CRC32 of the output is accumulated into this
+ * Return: 0 if OK, -ENOSPC if @dst is too small, -EINVAL if the stream is
+ * corrupt or truncated, -ENOMEM if out of memory
+ */
+int inflate_fast_buf(void *dst, size_t dstlen, const void *src, size_t srclen,
+		     size_t *outlenp, size_t *inlenp, u32 *crcp);
+
 /**
  * zunzip() - Uncompress blocks compressed with zlib without headers
  *
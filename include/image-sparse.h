@@ -42,3 +42,102 @@ static inline int is_sparse_image(void *buf)
 
 int write_sparse_image(struct sparse_storage *info, const char *part_name,
 		       void *data, char *response);
+
+/**
+ * enum sparse_stream_state - what a streamed sparse image expects next
+ *
+ * @SPARSE_STREAM_HEADER: file header
+ * @SPARSE_STREAM_CHUNK: chunk header
+ * @SPARSE_STREAM_RAW: data of a CHUNK_TYPE_RAW chunk
+ * @SPARSE_STREAM_FILL: fill value of a CHUNK_TYPE_FILL chunk
+ * @SPARSE_STREAM_DONE: all chunks have been written, the rest is ignored
+ * @SPARSE_STREAM_ERROR: writing failed, the rest is ignored
+ */
+enum sparse_stream_state {
+	SPARSE_STREAM_HEADER,
+	SPARSE_STREAM_CHUNK,
+	SPARSE_STREAM_RAW,
+	SPARSE_STREAM_FILL,
+	SPARSE_STREAM_DONE,
+	SPARSE_STREAM_ERROR,
+};
+
+/**
+ * struct sparse_stream - sparse image which is written while it is received
+ *
+ * The image is passed in pieces of any size to sparse_stream_write(). Raw
+ * data is collected in a staging buffer which is written to storage each
+ * time it is full, so memory use is bounded by the staging buffer and not by
+ * the size of the image.
+ *
+ * @info: Storage to write to
+ * @buf: Staging buffer, aligned to ARCH_DMA_MINALIGN
+ * @buf_blks: Size of @buf in storage blocks
+ * @buf_used: Number of bytes in @buf
+ * @header: File header
+ * @chunk: Header of the current chunk
+ * @fill_val: Fill value of the current CHUNK_TYPE_FILL chunk
+ * @state: Current state
+ * @got: Number of bytes of @header, @chunk or @fill_val received
+ * @skip: Number of bytes to drop before continuing in @state
+ * @left: Number of data bytes left in the current chunk
+ * @chunks: Number of chunks processed
+ * @blk: Next storage block to write
+ * @total_blocks: Number of sparse blocks processed
+ * @bytes_written: Number of bytes written to storage
+ */
+struct sparse_stream {
+	struct sparse_storage	*info;
+	void			*buf;
+	lbaint_t		buf_blks;
+	size_t			buf_used;
+	sparse_header_t		header;
+	chunk_header_t		chunk;
+	u32			fill_val;
+	enum sparse_stream_state state;
+	size_t			got;
+	size_t			skip;
+	u64			left;
+	u32			chunks;
+	lbaint_t		blk;
+	u32			total_blocks;
+	u64			bytes_written;
+};
+
+/**
+ * sparse_stream_init() - prepare for writing a sparse image in pieces
+ *
+ * @ss: Stream state to initialise
+ * @info: Storage to write to
+ * @buf: Staging buffer
+ * @size: Size of @buf, at least one storage block after alignment
+ * Return: 0 on success, -ENOSPC if @buf is too small
+ */
+int sparse_stream_init(struct sparse_stream *ss, struct sparse_storage *info,
+		       void *buf, size_t size);
+
+/**
+ * sparse_stream_write() - process the next piece of a sparse image
+ *
+ * @ss: Stream state
+ * @data: Data received
+ * @len: Number of bytes at @data
+ * @response: Pointer to fastboot response buffer, passed to info->mssg()
+ * Return: 0 on success, -1 if the image is invalid or cannot be written
+ */
+int sparse_stream_write(struct sparse_stream *ss, const void *data,
+			size_t len, char *response);
+
+/**
+ * sparse_stream_finish() - complete writing a sparse image
+ *
+ * Check that the whole image has been received and that it described the
+ * expected number of blocks.
+ *
+ * @ss: Stream state
+ * @part_name: Name of the partition, for messages
+ * @response: Pointer to fastboot response buffer, passed to info->mssg()
+ * Return: 0 on success, -1 on error
+ */
+int sparse_stream_finish(struct sparse_stream *ss, const char *part_name,
+			 char *response);
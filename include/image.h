@@ -396,6 +396,8 @@ struct bootm_headers {
 #endif
 
 	int		verify;		/* env_get("verify")[0] != 'n' */
+	ulong		bytes_moved;	/* bytes copied while loading images */
+	void		*align_buf;	/* aligned copy of an image, or NULL */
 
 #define BOOTM_STATE_START	0x00000001
 #define BOOTM_STATE_FINDOS	0x00000002
@@ -753,6 +755,102 @@ int fit_image_load(struct bootm_headers *images, ulong addr,
 		   int arch, int image_ph_type, int bootstage_id,
 		   enum fit_load_op load_op, ulong *datap, ulong *lenp);
 
+/**
+ * enum fit_plan_action - how a FIT sub-image gets to where it is used
+ *
+ * @FIT_PLAN_IN_PLACE: used where it is in the FIT
+ * @FIT_PLAN_DECOMP: decompressed from the FIT to its load address
+ * @FIT_PLAN_DECOMP_ALLOC: decompressed from the FIT to an allocated buffer
+ * @FIT_PLAN_COPY: copied to its load address
+ * @FIT_PLAN_COPY_ALIGN: copied to an allocated buffer, since it is not
+ *	aligned as its type requires where it is in the FIT
+ */
+enum fit_plan_action {
+	FIT_PLAN_IN_PLACE,
+	FIT_PLAN_DECOMP,
+	FIT_PLAN_DECOMP_ALLOC,
+	FIT_PLAN_COPY,
+	FIT_PLAN_COPY_ALIGN,
+};
+
+/**
+ * struct fit_plan_entry - how a FIT sub-image is loaded
+ *
+ * @prop: configuration property which refers to the image, e.g. "fdt"
+ * @uname: name of the image node
+ * @action: how the image is loaded
+ * @data: address of the image data in the FIT
+ * @load: address the image is loaded to, the same as @data if it is used in
+ *	place, 0 if it goes to an allocated buffer
+ * @size: size of the image data in the FIT
+ */
+struct fit_plan_entry {
+	const char *prop;
+	const char *uname;
+	enum fit_plan_action action;
+	ulong data;
+	ulong load;
+	ulong size;
+};
+
+#define FIT_PLAN_MAX_IMAGES	16
+
+/**
+ * struct fit_plan - how the images of a FIT configuration are loaded
+ *
+ * @entry: one entry for each image
+ * @count: number of entries
+ * @bytes_moved: number of bytes which are copied, not counting decompression
+ */
+struct fit_plan {
+	struct fit_plan_entry entry[FIT_PLAN_MAX_IMAGES];
+	int count;
+	ulong bytes_moved;
+};
+
+/**
+ * fit_plan_image() - work out how fit_image_load() loads an image
+ *
+ * An image is used in place if it has no load address, or if it is already
+ * at its load address, provided that it is aligned as its type requires.
+ * Compressed images are decompressed straight from the FIT. Anything else is
+ * copied.
+ *
+ * @fit: FIT holding the image
+ * @noffset: image node offset
+ * @image_type: image type requested from fit_image_load() (IH_TYPE_...)
+ * @load_op: what to do with the load address
+ * @entry: returns the plan for the image. Only @action, @data, @load and
+ *	@size are set.
+ * Return: 0 if OK, -ENOENT if the image has no data, -EBADF if it has no
+ *	load address but @load_op requires one
+ */
+int fit_plan_image(const void *fit, int noffset, int image_type,
+		   enum fit_load_op load_op, struct fit_plan_entry *entry);
+
+/**
+ * fit_plan_config() - work out how bootm loads the images of a configuration
+ *
+ * This covers the kernel, FDT and overlays, ramdisk and loadables, so that
+ * the number of bytes moved while booting is known in advance. The plan is
+ * only for information: fit_image_load() makes the same decision for each
+ * image as it loads it.
+ *
+ * @fit: FIT to plan
+ * @cfg_noffset: configuration node offset
+ * @plan: returns the plan
+ * Return: 0 if OK, -E2BIG if there are too many images, other -ve value if an
+ *	image cannot be found or loaded
+ */
+int fit_plan_config(const void *fit, int cfg_noffset, struct fit_plan *plan);
+
+/**
+ * fit_plan_print() - print a load plan
+ *
+ * @plan: plan to print
+ */
+void fit_plan_print(const struct fit_plan *plan);
+
 /**
  * image_locate_script() - Locate the raw script in an image
  *
@@ -994,6 +1092,23 @@ static inline int image_check_target_arch(const struct legacy_img_hdr *hdr)
  */
 int image_decomp_type(const unsigned char *buf, ulong len);
 
+/**
+ * image_decomp_buf() - decompress a buffer
+ *
+ * This is the part of image_decomp() which does the work, without any
+ * messages. An uncompressed image is copied.
+ *
+ * @comp:	Compression algorithm that is used (IH_COMP_...)
+ * @load_buf:	Place to decompress to
+ * @unc_len:	Available space for decompression
+ * @image_buf:	Address to decompress from
+ * @lenp:	On entry, number of bytes in @image_buf to decompress. On exit,
+ *		number of bytes written to @load_buf
+ * Return: 0 if OK, -ENOSYS if @comp is not supported, other -ve on error
+ */
+int image_decomp_buf(int comp, void *load_buf, uint unc_len, void *image_buf,
+		     ulong *lenp);
+
 /**
  * image_decomp() - decompress an image
  *
@@ -1087,6 +1202,8 @@ int booti_setup(ulong image, ulong *relocated_addr, ulong *size,
 #define FIT_TYPE_PROP		"type"
 #define FIT_OS_PROP		"os"
 #define FIT_COMP_PROP		"compression"
+#define FIT_COMP_BLOCK_SIZE_PROP	"compression-block-size"
+#define FIT_COMP_BLOCK_OFFSETS_PROP	"compression-block-offsets"
 #define FIT_ENTRY_PROP		"entry"
 #define FIT_LOAD_PROP		"load"
 
@@ -1171,6 +1288,61 @@ int fit_image_get_data_size_unciphered(const void *fit, int noffset,
 int fit_image_get_data_and_size(const void *fit, int noffset,
 				const void **data, size_t *size);
 
+/**
+ * fit_image_get_blocks() - get the blocks of a sub-image compressed in blocks
+ *
+ * The data of such a sub-image is made of blocks which are compressed
+ * independently. Each block except the last decompresses to the number of
+ * bytes given by the 'compression-block-size' property. The
+ * 'compression-block-offsets' property holds the offset of each block in the
+ * data, followed by the size of the data.
+ *
+ * @fit: FIT to read from
+ * @noffset: sub-image node offset
+ * @size: size of the sub-image data
+ * @block_sizep: returns the uncompressed size of a block
+ * @offsetsp: returns the block offsets
+ * Return: number of blocks, 0 if the sub-image is not compressed in blocks,
+ *	-EINVAL if the properties are invalid
+ */
+int fit_image_get_blocks(const void *fit, int noffset, size_t size,
+			 ulong *block_sizep, const fdt32_t **offsetsp);
+
+/**
+ * fit_image_decomp() - decompress a sub-image
+ *
+ * This is image_decomp() for a sub-image of a FIT, which may be compressed in
+ * blocks. See fit_image_get_blocks().
+ *
+ * @fit: FIT holding the sub-image
+ * @noffset: sub-image node offset
+ * Other parameters and return value are as for image_decomp()
+ */
+int fit_image_decomp(const void *fit, int noffset, int comp, ulong load,
+		     ulong image_start, int type, void *load_buf,
+		     void *image_buf, ulong image_len, uint unc_len,
+		     ulong *load_end);
+
+/**
+ * fit_image_read_range() - read part of a sub-image, decompressing it
+ *
+ * For a sub-image compressed in blocks, only the blocks covering the range
+ * are decompressed. Compressed sub-images which are not made of blocks, as
+ * well as ciphered sub-images, are not supported.
+ *
+ * @fit: FIT holding the sub-image
+ * @noffset: sub-image node offset
+ * @offset: offset of the range in the uncompressed sub-image
+ * @len: length of the range
+ * @dst: place to put the data
+ * Return: number of blocks decompressed, 0 if the sub-image is not
+ *	compressed, -ERANGE if the range is outside the sub-image,
+ *	-EPROTONOSUPPORT if the sub-image is compressed but not in blocks,
+ *	-EACCES if it is ciphered, other -ve value on error
+ */
+int fit_image_read_range(const void *fit, int noffset, ulong offset,
+			 ulong len, void *dst);
+
 /**
  * fit_get_data_node() - Get verified image data for an image
  * @fit: Pointer to the FIT format image header
@@ -446,9 +446,58 @@ size_t zstd_get_frame_header(zstd_frame_header *params, const void *src,
 
 struct abuf;
 
+/**
+ * struct zstd_workspace - decompression context which can be reused
+ *
+ * Setting up a context needs a large allocation, so callers decompressing
+ * many buffers should keep one around.
+ *
+ * @buf: memory holding the context, NULL if not set up
+ * @dctx: decompression context inside @buf
+ */
+struct zstd_workspace {
+	void *buf;
+	zstd_dctx *dctx;
+};
+
+/**
+ * zstd_workspace_init() - set up a workspace, unless already done
+ *
+ * @ws: workspace, zeroed before the first call
+ * Return: 0 if OK, -ENOMEM if out of memory, -EPERM on other errors
+ */
+int zstd_workspace_init(struct zstd_workspace *ws);
+
+/**
+ * zstd_workspace_uninit() - free the memory of a workspace
+ *
+ * @ws: workspace to free
+ */
+void zstd_workspace_uninit(struct zstd_workspace *ws);
+
+/**
+ * zstd_decompress_ws() - Decompress Zstandard data with a given workspace
+ *
+ * All frames in @in are decompressed one after the other, skipping
+ * skippable frames. Anything following the last frame is ignored. If @in
+ * is in the seekable format, the frames are located using its seek table
+ * and the total size is checked against @out before decompressing.
+ *
+ * @ws: workspace set up by zstd_workspace_init()
+ * @in: Input buffer to decompress
+ * @out: Output buffer to hold the results (must be large enough)
+ * Return: size of the decompressed data, -ENOSPC if @out is too small,
+ *	other -ve value on error
+ */
+int zstd_decompress_ws(struct zstd_workspace *ws, struct abuf *in,
+		       struct abuf *out);
+
 /**
  * zstd_decompress() - Decompress Zstandard data
  *
+ * This is zstd_decompress_ws() with a workspace which is set up for this
+ * call and freed afterwards.
+ *
  * @in: Input buffer to decompress
  * @out: Output buffer to hold the results (must be large enough)
  * Return: size of the decompressed data, or -ve on error
@@ -879,6 +879,82 @@ void malloc_enable_testing(int max_allocs);
 /** malloc_disable_testing() - Put malloc() into normal mode */
 void malloc_disable_testing(void);
 
+/**
+ * struct malloc_usage - Memory allocated by malloc()
+ *
+ * @in_use: Number of bytes currently allocated
+ * @peak: Highest value of @in_use since the last malloc_reset_peak()
+ * @allocs: Number of successful allocations
+ */
+struct malloc_usage {
+	ulong in_use;
+	ulong peak;
+	ulong allocs;
+};
+
+#if CONFIG_IS_ENABLED(SYS_MALLOC_STATS)
+/**
+ * malloc_get_usage() - Get the amount of memory allocated by malloc()
+ *
+ * Sizes are those of the blocks handed out, as given by malloc_usable_size(),
+ * so include any rounding up. Allocations made before full malloc() is set up
+ * are not counted.
+ *
+ * This only works if SYS_MALLOC_STATS is enabled, otherwise all values are 0
+ *
+ * @usage: Returns the usage
+ */
+void malloc_get_usage(struct malloc_usage *usage);
+
+/** malloc_reset_peak() - Start tracking the peak usage from now */
+void malloc_reset_peak(void);
+#else
+static inline void malloc_get_usage(struct malloc_usage *usage)
+{
+	memset(usage, '\0', sizeof(*usage));
+}
+
+static inline void malloc_reset_peak(void) {}
+#endif
+
+/**
+ * struct malloc_site - Memory allocated by a particular caller of malloc()
+ *
+ * @caller: Address which malloc() returns to, or 0 for the slot which collects
+ *	callers that do not fit in the table
+ * @count: Number of allocations made by this caller
+ * @live: Number of bytes currently allocated by this caller, as requested
+ * @peak: Highest value of @live
+ */
+struct malloc_site {
+	ulong caller;
+	ulong count;
+	ulong live;
+	ulong peak;
+};
+
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SITES)
+/**
+ * malloc_get_sites() - Get the table of callers of malloc()
+ *
+ * Unused entries have @caller and @count set to 0. The first entry holds
+ * callers which could not be added to the table, once it is full.
+ *
+ * This only works if SYS_MALLOC_SITES is enabled, otherwise it returns NULL
+ *
+ * @countp: Returns the number of entries in the table
+ * Return: Table of callers
+ */
+const struct malloc_site *malloc_get_sites(uint *countp);
+#else
+static inline const struct malloc_site *malloc_get_sites(uint *countp)
+{
+	*countp = 0;
+
+	return NULL;
+}
+#endif
+
 #if CONFIG_IS_ENABLED(SYS_MALLOC_SIMPLE)
 #define malloc malloc_simple
 #define realloc realloc_simple
@@ -619,6 +619,22 @@ struct sd_ssr {
 	unsigned int erase_offset;	/* In milliseconds */
 };
 
+/**
+ * enum mmc_async_state - State of background initialisation of a device
+ *
+ * @MMC_ASYNC_IDLE: Not initialising in the background
+ * @MMC_ASYNC_START: Waiting to power up the card
+ * @MMC_ASYNC_OP_COND: Waiting for the card to report that it is ready
+ * @MMC_ASYNC_STARTUP: Waiting to read the card details and select the bus
+ *	mode
+ */
+enum mmc_async_state {
+	MMC_ASYNC_IDLE,
+	MMC_ASYNC_START,
+	MMC_ASYNC_OP_COND,
+	MMC_ASYNC_STARTUP,
+};
+
 enum bus_mode {
 	MMC_LEGACY,
 	MMC_HS,
@@ -760,6 +776,11 @@ struct mmc {
 	enum bus_mode user_speed_mode; /* input speed mode from user */
 
 	CONFIG_IS_ENABLED(CYCLIC, (struct cyclic_info cyclic));
+#if CONFIG_IS_ENABLED(MMC_ASYNC_INIT)
+	enum mmc_async_state async_state;
+	struct cyclic_info async_cyclic;
+	ulong async_start;	/* time when the card started powering up */
+#endif
 };
 
 #if CONFIG_IS_ENABLED(DM_MMC)
@@ -967,6 +988,35 @@ int mmc_start_init(struct mmc *mmc);
  */
 void mmc_set_preinit(struct mmc *mmc, int preinit);
 
+/**
+ * mmc_async_init() - Start initialising a device in the background
+ *
+ * This registers a cyclic function which powers up the card and reads its
+ * details a step at a time, so that this happens while U-Boot is doing other
+ * things. Calling mmc_init() finishes any remaining steps immediately.
+ *
+ * Nothing happens if the device is already initialised or being initialised.
+ *
+ * @mmc: MMC device to initialise
+ */
+void mmc_async_init(struct mmc *mmc);
+
+/**
+ * mmc_async_pending() - Check if a device is initialising in the background
+ *
+ * @mmc: MMC device to check
+ * Return: true if background initialisation has been started and has not
+ *	yet finished or been cancelled, false otherwise
+ */
+static inline bool mmc_async_pending(struct mmc *mmc)
+{
+#if CONFIG_IS_ENABLED(MMC_ASYNC_INIT)
+	return mmc->async_state != MMC_ASYNC_IDLE;
+#else
+	return false;
+#endif
+}
+
 #ifdef CONFIG_MMC_SPI
 #define mmc_host_is_spi(mmc)	((mmc)->cfg->host_caps & MMC_MODE_SPI)
 #else
@@ -3,6 +3,7 @@
 #ifndef __PXE_UTILS_H
 #define __PXE_UTILS_H
 
+#include <arena.h>
 #include <linux/list.h>
 
 /*
@@ -69,6 +70,8 @@ struct pxe_label {
  *          interrupted.  If 1, always prompt for a choice regardless of
  *          timeout.
  * labels - a list of labels defined for the menu.
+ * arena - holds the labels and all strings, which are freed together by
+ *         destroy_pxe_menu()
  */
 struct pxe_menu {
 	char *title;
@@ -77,6 +80,7 @@ struct pxe_menu {
 	int timeout;
 	int prompt;
 	struct list_head labels;
+	struct arena arena;
 };
 
 struct pxe_context;
@@ -298,12 +298,40 @@ struct spl_load_info;
 typedef ulong (*spl_load_reader)(struct spl_load_info *load, ulong sector,
 				 ulong count, void *buf);
 
+/**
+ * spl_load_submitter() - Start reading from device, without waiting
+ *
+ * Only one read can be in progress at a time. The caller must call the
+ * matching spl_load_waiter() before starting another read, with either
+ * function, and must not touch @buf until then.
+ *
+ * @load: Information about the load state
+ * @offset: Offset to read from in bytes, as for spl_load_reader()
+ * @count: Number of bytes to read, as for spl_load_reader()
+ * @buf: Buffer to read into
+ * @return 0 if the read was started, -ve on error, in which case the caller
+ *	should use the spl_load_reader() instead
+ */
+typedef int (*spl_load_submitter)(struct spl_load_info *load, ulong sector,
+				  ulong count, void *buf);
+
+/**
+ * spl_load_waiter() - Wait for a read started by spl_load_submitter()
+ *
+ * @load: Information about the load state
+ * @return number of bytes read, 0 on error
+ */
+typedef ulong (*spl_load_waiter)(struct spl_load_info *load);
+
 /**
  * Information required to load data from a device
  *
  * @read: Function to call to read from the device
  * @priv: Private data for the device
  * @bl_len: Block length for reading in bytes
+ * @read_submit: Function to call to start a read without waiting, or NULL if
+ *	the device cannot do this
+ * @read_wait: Function to call to wait for a read started by @read_submit
  */
 struct spl_load_info {
 	spl_load_reader read;
@@ -311,6 +339,10 @@ struct spl_load_info {
 #if IS_ENABLED(CONFIG_SPL_LOAD_BLOCK)
 	int bl_len;
 #endif
+#if CONFIG_IS_ENABLED(LOAD_ASYNC)
+	spl_load_submitter read_submit;
+	spl_load_waiter read_wait;
+#endif
 };
 
 static inline int spl_get_bl_len(struct spl_load_info *info)
@@ -332,8 +364,30 @@ static inline void spl_set_bl_len(struct spl_load_info *info, int bl_len)
 #endif
 }
 
+static inline void spl_set_async(struct spl_load_info *load,
+				 spl_load_submitter h_submit,
+				 spl_load_waiter h_wait)
+{
+#if CONFIG_IS_ENABLED(LOAD_ASYNC)
+	load->read_submit = h_submit;
+	load->read_wait = h_wait;
+#endif
+}
+
+static inline bool spl_load_can_submit(struct spl_load_info *load)
+{
+#if CONFIG_IS_ENABLED(LOAD_ASYNC)
+	return load->read_submit;
+#else
+	return false;
+#endif
+}
+
 /**
  * spl_load_init() - Set up a new spl_load_info structure
+ *
+ * Reads are synchronous. Use spl_set_async() afterwards if the device can
+ * read in the background.
  */
 static inline void spl_load_init(struct spl_load_info *load,
 				 spl_load_reader h_read, void *priv,
@@ -342,8 +396,35 @@ static inline void spl_load_init(struct spl_load_info *load,
 	load->read = h_read;
 	load->priv = priv;
 	spl_set_bl_len(load, bl_len);
+	spl_set_async(load, NULL, NULL);
 }
 
+/**
+ * spl_load_dma_submit() - Start copying from a memory-mapped device
+ *
+ * This is a helper for the spl_load_submitter() of devices which can be read
+ * like memory, such as NOR flash. It copies with a DMA engine, if there is
+ * one, so that the CPU can do other work in the meantime.
+ *
+ * @buf: Buffer to copy into
+ * @src: Data to copy
+ * @count: Number of bytes to copy
+ * Return: 0 if the copy was started, -EINVAL if @buf, @src or @count is not
+ *	aligned to ARCH_DMA_MINALIGN, other -ve value if there is no DMA engine
+ *	or it cannot do the copy
+ */
+int spl_load_dma_submit(void *buf, const void *src, ulong count);
+
+/**
+ * spl_load_dma_wait() - Wait for a copy started by spl_load_dma_submit()
+ *
+ * This can be used as the spl_load_waiter() of the device
+ *
+ * @load: Information about the load state
+ * Return: number of bytes copied, 0 on error
+ */
+ulong spl_load_dma_wait(struct spl_load_info *load);
+
 /*
  * We need to know the position of U-Boot in memory so we can jump to it. We
  * allow any U-Boot binary to be used (u-boot.bin, u-boot-nodtb.bin,
@@ -55,6 +55,21 @@ void crc16_ccitt_wd_buf(const uint8_t *in, uint len,
  */
 uint32_t crc32(uint32_t crc, const unsigned char *buf, uint len);
 
+/**
+ * crc32_runtime - Calculate the CRC32 for a block of data at EFI runtime
+ *
+ * This gives the same result as crc32() but only uses the bytewise table,
+ * which lives in the EFI runtime region, so it may be called from EFI runtime
+ * services after ExitBootServices().
+ *
+ * @crc: Input crc to chain from a previous calculution (use 0 to start a new
+ *	calculation)
+ * @buf: Bytes to checksum
+ * @len: Number of bytes to checksum
+ * Return: checksum value
+ */
+uint32_t crc32_runtime(uint32_t crc, const unsigned char *buf, uint len);
+
 /**
  * crc32_wd - Calculate the CRC32 for a block of data (watchdog version)
  *
@@ -98,6 +113,20 @@ void crc32_wd_buf(const uint8_t *input, uint ilen, uint8_t *output,
 
 /* lib/crc32c.c */
 
+/**
+ * crc32c() - Calculate the CRC32C (Castagnoli) of a block of data
+ *
+ * This uses the CRC32C instructions where available and otherwise a
+ * table-driven algorithm, see CONFIG_CRC32_SLICE_BY_8. No one's complement is
+ * applied, so callers pass ~0 to start and invert the result as required.
+ *
+ * @crc: Previous crc
+ * @data: Data bytes to checksum
+ * @len: Number of bytes to process
+ * Return: checksum value
+ */
+uint32_t crc32c(uint32_t crc, const void *data, size_t len);
+
 /**
  * crc32c_init() - Set up a the CRC32 table
  *
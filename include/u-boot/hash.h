@@ -5,6 +5,11 @@
 #ifndef _UBOOT_HASH_H
 #define _UBOOT_HASH_H
 
+#include <linux/errno.h>
+#include <linux/types.h>
+
+struct udevice;
+
 enum HASH_ALGO {
 	HASH_ALGO_CRC16_CCITT,
 	HASH_ALGO_CRC32,
@@ -19,6 +24,21 @@ enum HASH_ALGO {
 	HASH_ALGO_INVALID = 0xffffffff,
 };
 
+/**
+ * struct hash_dev_priv - information about a hash device used by the uclass
+ *
+ * @algos: algorithms the device can offload, as a mask of
+ *	BIT(HASH_ALGO_...), set by the driver when probed. Devices which leave
+ *	this zero, such as the software driver, are not used by hash_offload()
+ * @bytes: number of bytes hashed through hash_digest_chunked()
+ * @time_us: time spent in hash_digest_chunked(), in microseconds
+ */
+struct hash_dev_priv {
+	u32 algos;
+	u64 bytes;
+	u64 time_us;
+};
+
 /* general APIs for hash algo information */
 enum HASH_ALGO hash_algo_lookup_by_name(const char *name);
 ssize_t hash_algo_digest_size(enum HASH_ALGO algo);
@@ -35,6 +55,59 @@ int hash_init(struct udevice *dev, enum HASH_ALGO algo, void **ctxp);
 int hash_update(struct udevice *dev, void *ctx, const void *ibuf, const uint32_t ilen);
 int hash_finish(struct udevice *dev, void *ctx, void *obuf);
 
+/**
+ * hash_find_device() - find a device which can offload an algorithm
+ *
+ * @algo: hash algorithm
+ * @devp: returns the device
+ * Return: 0 if found, -ENODEV if no device offloads @algo
+ */
+int hash_find_device(enum HASH_ALGO algo, struct udevice **devp);
+
+/**
+ * hash_digest_chunked() - hash a buffer progressively, one chunk at a time
+ *
+ * Each chunk is flushed from the data cache just before it is passed to the
+ * device, and the watchdog is serviced after each chunk. The time taken is
+ * added to the statistics of the device.
+ *
+ * @dev: hash device
+ * @algo: hash algorithm
+ * @ibuf: data to hash
+ * @ilen: number of bytes to hash
+ * @obuf: returns the digest
+ * @chunk_sz: number of bytes to pass to the device at a time, 0 for all
+ * Return: 0 if OK, -ve error code on failure
+ */
+int hash_digest_chunked(struct udevice *dev, enum HASH_ALGO algo,
+			const void *ibuf, ulong ilen, void *obuf,
+			uint chunk_sz);
+
+#if IS_ENABLED(CONFIG_DM_HASH)
+/**
+ * hash_offload() - hash a buffer with a hash device, if there is one
+ *
+ * The digest has the same format as the one produced by the hash_algo
+ * table in common/hash.c, which is what callers fall back to if this fails.
+ *
+ * @algo_name: name of the algorithm, e.g. "sha256"
+ * @ibuf: data to hash
+ * @ilen: number of bytes to hash
+ * @obuf: returns the digest
+ * @chunk_sz: number of bytes to pass to the device at a time, 0 for all
+ * Return: 0 if OK, -ENODEV if no device offloads the algorithm, other -ve
+ *	error code on failure
+ */
+int hash_offload(const char *algo_name, const void *ibuf, ulong ilen,
+		 void *obuf, uint chunk_sz);
+#else
+static inline int hash_offload(const char *algo_name, const void *ibuf,
+			       ulong ilen, void *obuf, uint chunk_sz)
+{
+	return -ENODEV;
+}
+#endif
+
 /*
  * struct hash_ops - Driver model for Hash operations
  *
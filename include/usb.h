@@ -263,6 +263,65 @@ int usb_host_eth_scan(int mode);
  */
 int usb_init(void);
 
+#if CONFIG_IS_ENABLED(USB_ASYNC_SCAN)
+/**
+ * usb_init_start() - Start initialising the USB controllers in the background
+ *
+ * This probes the controllers and their root hubs, then returns. The hub ports
+ * are scanned by a cyclic function, so that other work can proceed while
+ * devices are enumerated. Use usb_scan_wait() to wait for this to finish.
+ *
+ * Return: 0 if OK, -EALREADY if a scan is already in progress, -ENOENT if
+ *	there are no USB controllers
+ */
+int usb_init_start(void);
+
+/**
+ * usb_scan_busy() - Check whether a background scan is still outstanding
+ *
+ * Return: true if a scan started by usb_init_start() has not yet been
+ *	finished by usb_scan_wait(), false otherwise
+ */
+bool usb_scan_busy(void);
+
+/**
+ * usb_scan_wait() - Wait for a scan started by usb_init_start() to finish
+ *
+ * This scans any remaining ports, tidies up and shows the number of devices
+ * found on each bus. It does nothing if there is no scan in progress.
+ *
+ * Return: 0 if OK (or nothing to do), -ENOENT if there are no USB controllers
+ */
+int usb_scan_wait(void);
+
+/**
+ * usb_scan_cancel() - Cancel a scan started by usb_init_start()
+ *
+ * This drops any ports which have not been scanned yet, without waiting for
+ * them. Devices which have already been found are left as they are.
+ */
+void usb_scan_cancel(void);
+#else
+static inline int usb_init_start(void)
+{
+	return -ENOSYS;
+}
+
+static inline bool usb_scan_busy(void)
+{
+	return false;
+}
+
+static inline int usb_scan_wait(void)
+{
+	return 0;
+}
+
+static inline void usb_scan_cancel(void)
+{
+}
+#endif
+
 int usb_stop(void); /* stop the USB Controller */
 int usb_detect_change(void); /* detect if a USB device has been (un)plugged */
 
@@ -598,6 +657,7 @@ struct usb_hub_device {
 	ulong connect_timeout;		/* Device connection timeout in ms */
 	ulong query_delay;		/* Device query delay in ms */
 	int overcurrent_count[USB_MAXCHILDREN];	/* Over-current counter */
+	ulong scan_time[USB_MAXCHILDREN];	/* Time to scan each port, ms */
 	int hub_depth;			/* USB 3.0 hub depth */
 	struct usb_tt tt;		/* Transaction Translator */
 };
@@ -658,11 +718,14 @@ struct usb_dev_plat {
  *		so this will be false.
  * @companion:  True if this is a companion controller to another USB
  *		controller
+ * @scan_err:	Error from scanning the root hub in the background, reported
+ *		once the scan has finished
  */
 struct usb_bus_priv {
 	int next_addr;
 	bool desc_before_addr;
 	bool companion;
+	int scan_err;
 };
 
 /**
@@ -843,6 +906,22 @@ bool usb_hub_is_root_hub(struct udevice *hub);
  */
 int usb_hub_scan(struct udevice *hub);
 
+/**
+ * usb_hub_scan_step() - Check the next port on the list of ports to scan
+ *
+ * A port is removed from the list when a device is found on it or it times
+ * out. This does not wait for the hub's power-on or connection delays, but
+ * enumerating a device which is found still blocks for its reset delays.
+ *
+ * Return: 0 if all ports have been scanned, -EAGAIN if some are not finished
+ */
+int usb_hub_scan_step(void);
+
+/**
+ * usb_hub_scan_stop() - Drop any ports still waiting to be scanned
+ */
+void usb_hub_scan_stop(void);
+
 /**
  * usb_scan_device() - Scan a device on a bus
  *
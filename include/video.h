@@ -73,6 +73,48 @@ enum video_format {
 	VIDEO_X2R10G10B10,
 };
 
+/**
+ * struct video_bbox - Rectangle within the display, in pixels
+ *
+ * @x0: X start position (inclusive)
+ * @y0: Y start position (inclusive)
+ * @x1: X end position (exclusive)
+ * @y1: Y end position (exclusive)
+ */
+struct video_bbox {
+	int x0;
+	int y0;
+	int x1;
+	int y1;
+};
+
+/* Maximum number of separate damaged rectangles tracked per device */
+#define VIDEO_DAMAGE_RECTS	4
+
+/**
+ * struct video_damage - Damage-tracking state for a video device
+ *
+ * This records which parts of the frame buffer have been written since the
+ * last video_sync(), so that only those need to be flushed. See
+ * CONFIG_VIDEO_DAMAGE
+ *
+ * @count:	Number of valid entries in @rect
+ * @rect:	Damaged rectangles (these may overlap)
+ * @copy_bytes:	Total number of bytes copied to the copy frame buffer
+ * @flush_bytes: Total number of bytes flushed from the data cache
+ * @shared:	true if other software can write to the frame buffer directly,
+ *		e.g. an EFI application using the GOP, so that its changes are
+ *		not recorded. Each video_sync() then flushes the whole frame
+ *		buffer
+ */
+struct video_damage {
+	bool shared;
+	int count;
+	struct video_bbox rect[VIDEO_DAMAGE_RECTS];
+	ulong copy_bytes;
+	ulong flush_bytes;
+};
+
 /**
  * struct video_priv - Device information used by the video uclass
  *
@@ -98,6 +140,7 @@ enum video_format {
  * @fg_col_idx:	Foreground color code (bit 3 = bold, bit 0-2 = color)
  * @bg_col_idx:	Background color code (bit 3 = bold, bit 0-2 = color)
  * @last_sync:	Monotonic time of last video sync
+ * @damage:	Regions changed since the last sync (CONFIG_VIDEO_DAMAGE)
  */
 struct video_priv {
 	/* Things set up by the driver: */
@@ -123,6 +166,7 @@ struct video_priv {
 	u8 fg_col_idx;
 	u8 bg_col_idx;
 	ulong last_sync;
+	struct video_damage damage;
 };
 
 /**
@@ -264,6 +308,30 @@ int video_fill_part(struct udevice *dev, int xstart, int ystart, int xend,
  */
 int video_sync(struct udevice *vid, bool force);
 
+#ifdef CONFIG_VIDEO_DAMAGE
+/**
+ * video_damage() - Notify the uclass that part of the frame buffer changed
+ *
+ * This records the rectangle so that the next video_sync() only flushes the
+ * regions which were actually written. If CONFIG_VIDEO_COPY is enabled, the
+ * rectangle is also copied to the copy frame buffer.
+ *
+ * The rectangle is clipped to the display, so callers need not do this.
+ *
+ * @vid:	Video device which was updated
+ * @x:		X position of the changed area, in pixels from the left
+ * @y:		Y position of the changed area, in pixels from the top
+ * @width:	Width of the changed area in pixels
+ * @height:	Height of the changed area in pixels
+ */
+void video_damage(struct udevice *vid, int x, int y, int width, int height);
+#else
+static inline void video_damage(struct udevice *vid, int x, int y, int width,
+				int height)
+{
+}
+#endif
+
 /**
  * video_sync_all() - Sync all devices' frame buffers with their hardware
  *
@@ -350,6 +418,9 @@ int video_default_font_height(struct udevice *dev);
  * This ensures that the copy framebuffer has the same data as the framebuffer
  * for a particular region. It should be called after the framebuffer is updated
  *
+ * If CONFIG_VIDEO_DAMAGE is enabled this does nothing, since video_damage()
+ * keeps the copy framebuffer up to date instead.
+ *
  * @from and @to can be in either order. The region between them is synced.
  *
  * @dev: Vidconsole device being updated
@@ -545,12 +545,20 @@ int vidconsole_get_font_size(struct udevice *dev, const char **name, uint *sizep
  *	frame buffer start
  */
 int vidconsole_sync_copy(struct udevice *dev, void *from, void *to);
+#else
+static inline int vidconsole_sync_copy(struct udevice *dev, void *from,
+				       void *to)
+{
+	return 0;
+}
+#endif
 
+#if defined(CONFIG_VIDEO_COPY) || defined(CONFIG_VIDEO_DAMAGE)
 /**
  * vidconsole_memmove() - Perform a memmove() within the frame buffer
  *
  * This handles a memmove(), e.g. for scrolling. It also updates the copy
- * framebuffer.
+ * framebuffer and records the damaged region.
  *
  * @dev: Vidconsole device being updated
  * @dst: Destination address within the framebuffer (->fb)
@@ -565,12 +573,6 @@ int vidconsole_memmove(struct udevice *dev, void *dst, const void *src,
 
 #include <string.h>
 
-static inline int vidconsole_sync_copy(struct udevice *dev, void *from,
-				       void *to)
-{
-	return 0;
-}
-
 static inline int vidconsole_memmove(struct udevice *dev, void *dst,
 				     const void *src, int size)
 {
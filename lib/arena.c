@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Arena allocator, for many small allocations which are freed together
+ */
+
+#include <arena.h>
+#include <malloc.h>
+#include <string.h>
+#include <linux/kernel.h>
+
+enum {
+	ARENA_ALIGN	= sizeof(u64),
+};
+
+/**
+ * struct arena_block - Header at the start of each block of an arena
+ *
+ * @prev: Previous block, or NULL if this is the first
+ * @size: Size of the block in bytes, including this header
+ */
+struct arena_block {
+	struct arena_block *prev;
+	ulong size;
+};
+
+#define ARENA_HDR_SIZE	ALIGN(sizeof(struct arena_block), ARENA_ALIGN)
+
+static void arena_use_block(struct arena *ar, struct arena_block *blk,
+			    ulong size)
+{
+	blk->prev = ar->head;
+	blk->size = size;
+	ar->head = blk;
+	ar->ptr = (char *)blk + ARENA_HDR_SIZE;
+	ar->end = (char *)blk + size;
+}
+
+void arena_init(struct arena *ar, ulong block_size)
+{
+	memset(ar, '\0', sizeof(*ar));
+	ar->block_size = block_size;
+}
+
+void arena_init_buf(struct arena *ar, void *buf, ulong size, ulong block_size)
+{
+	ulong ofs = ALIGN((ulong)buf, ARENA_ALIGN) - (ulong)buf;
+
+	arena_init(ar, block_size);
+	if (size < ofs + ARENA_HDR_SIZE)
+		return;
+	ar->fixed = buf + ofs;
+	arena_use_block(ar, ar->fixed, size - ofs);
+}
+
+/**
+ * arena_grow() - Add a new block to an arena
+ *
+ * @ar: Arena to grow
+ * @size: Number of bytes which the block must be able to hold
+ * Return: true if OK, false if out of memory or the arena cannot grow
+ */
+static bool arena_grow(struct arena *ar, ulong size)
+{
+	struct arena_block *blk;
+
+	if (!ar->block_size)
+		return false;
+	size = max(size + ARENA_HDR_SIZE, ar->block_size);
+	blk = malloc(size);
+	if (!blk)
+		return false;
+	arena_use_block(ar, blk, size);
+	ar->stats.blocks++;
+
+	return true;
+}
+
+void *arena_alloc(struct arena *ar, ulong size)
+{
+	char *ptr = PTR_ALIGN(ar->ptr, ARENA_ALIGN);
+
+	if (!ar->head || ptr > ar->end || size > ar->end - ptr) {
+		if (!arena_grow(ar, size))
+			return NULL;
+		ptr = ar->ptr;
+	}
+	ar->stats.used += ptr + size - ar->ptr;
+	ar->stats.peak = max(ar->stats.peak, ar->stats.used);
+	ar->stats.allocs++;
+	ar->ptr = ptr + size;
+
+	return ptr;
+}
+
+void *arena_zalloc(struct arena *ar, ulong size)
+{
+	void *ptr = arena_alloc(ar, size);
+
+	if (ptr)
+		memset(ptr, '\0', size);
+
+	return ptr;
+}
+
+char *arena_strndup(struct arena *ar, const char *str, ulong len)
+{
+	char *ptr;
+
+	len = strnlen(str, len);
+	ptr = arena_alloc(ar, len + 1);
+	if (!ptr)
+		return NULL;
+	memcpy(ptr, str, len);
+	ptr[len] = '\0';
+
+	return ptr;
+}
+
+char *arena_strdup(struct arena *ar, const char *str)
+{
+	return arena_strndup(ar, str, strlen(str));
+}
+
+/* Free the blocks of an arena, except the first if @keep, and return it */
+static struct arena_block *arena_free_blocks(struct arena *ar, bool keep)
+{
+	struct arena_block *blk, *prev;
+
+	for (blk = ar->head; blk; blk = prev) {
+		prev = blk->prev;
+		if (!prev && keep)
+			return blk;
+		if (blk != ar->fixed)
+			free(blk);
+	}
+
+	return NULL;
+}
+
+void arena_reset(struct arena *ar)
+{
+	struct arena_block *first;
+
+	first = arena_free_blocks(ar, true);
+	ar->head = NULL;
+	ar->stats.used = 0;
+	if (first)
+		arena_use_block(ar, first, first->size);
+}
+
+void arena_uninit(struct arena *ar)
+{
+	arena_free_blocks(ar, false);
+	arena_init(ar, ar->block_size);
+}
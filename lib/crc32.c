@@ -29,6 +29,19 @@
 
 #define tole(x) cpu_to_le32(x)
 
+/*
+ * Slicing-by-8 handles eight bytes per step with one lookup per byte in eight
+ * tables, which removes the serial dependency between the table lookups of
+ * the bytewise algorithm. The tables are built from crc_table on first use.
+ */
+#if !defined(CONFIG_ARM64_CRC32) && __BYTE_ORDER == __LITTLE_ENDIAN
+#ifdef USE_HOSTCC
+#define CRC32_SLICE	1
+#elif CONFIG_IS_ENABLED(CRC32_SLICE_BY_8)
+#define CRC32_SLICE	1
+#endif
+#endif
+
 #ifdef CONFIG_DYNAMIC_CRC_TABLE
 
 static int __efi_runtime_data crc_table_empty = 1;
@@ -168,6 +181,31 @@ const uint32_t * ZEXPORT get_crc_table()
 }
 #endif
 
+#ifdef CRC32_SLICE
+/*
+ * The slice tables are only used at boot time, so keep them out of the EFI
+ * runtime region; crc32_runtime() sticks to crc_table.
+ */
+static int crc_slice_empty = 1;
+static uint32_t crc_slice[8][256];
+
+static void make_crc_slice(void)
+{
+  uint32_t c;
+  int n, k;
+
+  for (n = 0; n < 256; n++) {
+    c = crc_table[n];
+    crc_slice[0][n] = c;
+    for (k = 1; k < 8; k++) {
+      c = crc_table[c & 255] ^ (c >> 8);
+      crc_slice[k][n] = c;
+    }
+  }
+  crc_slice_empty = 0;
+}
+#endif
+
 /* ========================================================================= */
 # if __BYTE_ORDER == __LITTLE_ENDIAN
 #  define DO_CRC(x) crc = tab[(crc ^ (x)) & 255] ^ (crc >> 8)
@@ -177,13 +215,19 @@ const uint32_t * ZEXPORT get_crc_table()
 
 /* ========================================================================= */
 
-/* No ones complement version. JFFS2 (and other things ?)
- * don't use ones compliment in their CRC calculations.
- */
-uint32_t __efi_runtime crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
+/* Bytewise version, which is all that is available at EFI runtime */
+static uint32_t __efi_runtime crc32_bytes(uint32_t crc, const Bytef *buf,
+					  uInt len)
 {
 #ifdef CONFIG_ARM64_CRC32
     crc = cpu_to_le32(crc);
+    /* U-Boot is built with -mstrict-align, so only use aligned words */
+    while (len && ((ulong)buf & 7)) {
+        crc = __builtin_aarch64_crc32b(crc, *buf++);
+        len--;
+    }
+    for (; len >= 8; len -= 8, buf += 8)
+        crc = __builtin_aarch64_crc32x(crc, *(const uint64_t *)buf);
     while (len--)
         crc = __builtin_aarch64_crc32b(crc, *buf++);
     return le32_to_cpu(crc);
@@ -229,11 +273,50 @@ uint32_t __efi_runtime crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
 }
 #undef DO_CRC
 
-uint32_t __efi_runtime crc32(uint32_t crc, const Bytef *p, uInt len)
+/* No ones complement version. JFFS2 (and other things ?)
+ * don't use ones compliment in their CRC calculations.
+ */
+uint32_t crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
+{
+#ifdef CRC32_SLICE
+    if (len >= 16) {
+	 uint32_t (*t)[256] = crc_slice;
+	 const uint32_t *b;
+	 uInt head = -(long)buf & 3;
+	 uint32_t hi;
+
+	 /* Align it */
+	 crc = crc32_bytes(crc, buf, head);
+	 buf += head;
+	 len -= head;
+	 if (crc_slice_empty)
+	      make_crc_slice();
+	 crc = cpu_to_le32(crc);
+	 for (b = (const uint32_t *)buf; len >= 8; len -= 8, b += 2) {
+	      crc ^= b[0];
+	      hi = b[1];
+	      crc = t[7][crc & 255] ^ t[6][(crc >> 8) & 255] ^
+		    t[5][(crc >> 16) & 255] ^ t[4][crc >> 24] ^
+		    t[3][hi & 255] ^ t[2][(hi >> 8) & 255] ^
+		    t[1][(hi >> 16) & 255] ^ t[0][hi >> 24];
+	 }
+	 crc = le32_to_cpu(crc);
+	 buf = (const Bytef *)b;
+    }
+#endif
+    return crc32_bytes(crc, buf, len);
+}
+
+uint32_t crc32(uint32_t crc, const Bytef *p, uInt len)
 {
      return crc32_no_comp(crc ^ 0xffffffffL, p, len) ^ 0xffffffffL;
 }
 
+uint32_t __efi_runtime crc32_runtime(uint32_t crc, const Bytef *p, uInt len)
+{
+     return crc32_bytes(crc ^ 0xffffffffL, p, len) ^ 0xffffffffL;
+}
+
 /*
  * Calculate the crc32 checksum triggering the watchdog every 'chunk_sz' bytes
  * of input.
@@ -11,6 +11,79 @@
  */
 
 #include <compiler.h>
+#include <u-boot/crc.h>
+
+/* Bit-reflected CRC32C (Castagnoli) polynomial */
+#define CRC32C_POLY	0x82f63b78
+
+#if !defined(CONFIG_ARM64_CRC32) && __BYTE_ORDER == __LITTLE_ENDIAN && \
+	CONFIG_IS_ENABLED(CRC32_SLICE_BY_8)
+#define CRC32C_SLICES	8
+#else
+#define CRC32C_SLICES	1
+#endif
+
+#ifndef CONFIG_ARM64_CRC32
+static uint32_t crc32c_tab[CRC32C_SLICES][256];
+static bool crc32c_tab_ready;
+
+static void crc32c_make_tab(void)
+{
+	uint32_t c;
+	int n, k;
+
+	crc32c_init(crc32c_tab[0], CRC32C_POLY);
+	for (n = 0; n < 256; n++) {
+		c = crc32c_tab[0][n];
+		for (k = 1; k < CRC32C_SLICES; k++) {
+			c = crc32c_tab[0][c & 255] ^ (c >> 8);
+			crc32c_tab[k][n] = c;
+		}
+	}
+	crc32c_tab_ready = true;
+}
+#endif
+
+uint32_t crc32c(uint32_t crc, const void *data, size_t len)
+{
+	const uint8_t *p = data;
+
+#ifdef CONFIG_ARM64_CRC32
+	/* U-Boot is built with -mstrict-align, so only use aligned words */
+	while (len && ((ulong)p & 7)) {
+		crc = __builtin_aarch64_crc32cb(crc, *p++);
+		len--;
+	}
+	for (; len >= 8; len -= 8, p += 8)
+		crc = __builtin_aarch64_crc32cx(crc, *(const uint64_t *)p);
+	while (len--)
+		crc = __builtin_aarch64_crc32cb(crc, *p++);
+#else
+	uint32_t (*t)[256] = crc32c_tab;
+
+	if (!crc32c_tab_ready)
+		crc32c_make_tab();
+#if CRC32C_SLICES == 8
+	while (len && ((ulong)p & 3)) {
+		crc = t[0][(crc ^ *p++) & 255] ^ (crc >> 8);
+		len--;
+	}
+	for (; len >= 8; len -= 8, p += 8) {
+		uint32_t hi = ((const uint32_t *)p)[1];
+
+		crc ^= *(const uint32_t *)p;
+		crc = t[7][crc & 255] ^ t[6][(crc >> 8) & 255] ^
+		      t[5][(crc >> 16) & 255] ^ t[4][crc >> 24] ^
+		      t[3][hi & 255] ^ t[2][(hi >> 8) & 255] ^
+		      t[1][(hi >> 16) & 255] ^ t[0][hi >> 24];
+	}
+#endif
+	while (len--)
+		crc = t[0][(crc ^ *p++) & 255] ^ (crc >> 8);
+#endif
+
+	return crc;
+}
 
 uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
 		    uint32_t *crc32c_table)
@@ -30,6 +30,33 @@ static efi_uintn_t efi_tpl = TPL_APPLICATION;
 /* This list contains all the EFI objects our payload has access to */
 LIST_HEAD(efi_obj_list);
 
+#define EFI_HANDLE_HASH_SIZE	64
+#define EFI_PROTOCOL_HASH_SIZE	32
+
+/**
+ * struct efi_protocol_index - handlers of one protocol GUID
+ *
+ * @node:	link into efi_protocol_hash
+ * @guid:	protocol GUID
+ * @handlers:	handlers installed for the GUID ordered like efi_obj_list
+ * @count:	number of handlers
+ */
+struct efi_protocol_index {
+	struct hlist_node node;
+	efi_guid_t guid;
+	struct list_head handlers;
+	efi_uintn_t count;
+};
+
+/* Hash table of all handles in efi_obj_list */
+static struct hlist_head efi_handle_hash[EFI_HANDLE_HASH_SIZE];
+
+/* Hash table mapping protocol GUIDs to the handles implementing them */
+static struct hlist_head efi_protocol_hash[EFI_PROTOCOL_HASH_SIZE];
+
+/* Sequence number of the next handle added to efi_obj_list */
+static ulong efi_handle_seq;
+
 /* List of all events */
 __efi_runtime_data LIST_HEAD(efi_events);
 
@@ -234,6 +261,7 @@ static efi_status_t efi_purge_handle(efi_handle_t handle)
 	}
 	/* The last protocol has been removed, delete the handle. */
 	list_del(&handle->link);
+	hlist_del(&handle->hash_link);
 	free(handle);
 
 	return EFI_SUCCESS;
@@ -534,6 +562,106 @@ static efi_status_t EFIAPI efi_free_pool_ext(void *buffer)
 	return EFI_EXIT(r);
 }
 
+/**
+ * efi_handle_hash_head() - get the hash bucket of a handle
+ *
+ * @handle:	handle
+ * Return:	hash bucket
+ */
+static struct hlist_head *efi_handle_hash_head(const efi_handle_t handle)
+{
+	ulong key = (uintptr_t)handle / sizeof(struct efi_object);
+
+	return &efi_handle_hash[(key ^ key >> 6) % EFI_HANDLE_HASH_SIZE];
+}
+
+/**
+ * efi_protocol_hash_head() - get the hash bucket of a protocol GUID
+ *
+ * @protocol:	protocol GUID
+ * Return:	hash bucket
+ */
+static struct hlist_head *efi_protocol_hash_head(const efi_guid_t *protocol)
+{
+	u32 hash = 0;
+	int i;
+
+	for (i = 0; i < sizeof(efi_guid_t); ++i)
+		hash = hash * 31 + protocol->b[i];
+
+	return &efi_protocol_hash[hash % EFI_PROTOCOL_HASH_SIZE];
+}
+
+/**
+ * efi_protocol_index_find() - find the handlers of a protocol GUID
+ *
+ * @protocol:	protocol GUID
+ * Return:	index entry or NULL if no handle implements the protocol
+ */
+static struct efi_protocol_index *
+efi_protocol_index_find(const efi_guid_t *protocol)
+{
+	struct efi_protocol_index *entry;
+
+	hlist_for_each_entry(entry, efi_protocol_hash_head(protocol), node) {
+		if (!guidcmp(&entry->guid, protocol))
+			return entry;
+	}
+
+	return NULL;
+}
+
+/**
+ * efi_protocol_index_add() - add a handler to the protocol index
+ *
+ * The handler is sorted in by the sequence number of its handle so that
+ * locating handles by protocol returns them in the order of efi_obj_list.
+ *
+ * @handler:	handler with the handle field set
+ * Return:	status code
+ */
+static efi_status_t efi_protocol_index_add(struct efi_handler *handler)
+{
+	struct efi_protocol_index *entry;
+	struct efi_handler *pos;
+
+	entry = efi_protocol_index_find(&handler->guid);
+	if (!entry) {
+		entry = calloc(1, sizeof(*entry));
+		if (!entry)
+			return EFI_OUT_OF_RESOURCES;
+		guidcpy(&entry->guid, &handler->guid);
+		INIT_LIST_HEAD(&entry->handlers);
+		hlist_add_head(&entry->node,
+			       efi_protocol_hash_head(&entry->guid));
+	}
+	list_for_each_entry_reverse(pos, &entry->handlers, guid_link) {
+		if (pos->handle->seq < handler->handle->seq)
+			break;
+	}
+	list_add(&handler->guid_link, &pos->guid_link);
+	++entry->count;
+
+	return EFI_SUCCESS;
+}
+
+/**
+ * efi_protocol_index_del() - remove a handler from the protocol index
+ *
+ * @handler:	handler
+ */
+static void efi_protocol_index_del(struct efi_handler *handler)
+{
+	struct efi_protocol_index *entry;
+
+	entry = efi_protocol_index_find(&handler->guid);
+	list_del(&handler->guid_link);
+	if (entry && !--entry->count) {
+		hlist_del(&entry->node);
+		free(entry);
+	}
+}
+
 /**
  * efi_add_handle() - add a new handle to the object list
  *
@@ -548,6 +676,8 @@ void efi_add_handle(efi_handle_t handle)
 		return;
 	INIT_LIST_HEAD(&handle->protocols);
 	list_add_tail(&handle->link, &efi_obj_list);
+	handle->seq = efi_handle_seq++;
+	hlist_add_head(&handle->hash_link, efi_handle_hash_head(handle));
 }
 
 /**
@@ -624,6 +754,7 @@ static efi_status_t efi_remove_protocol(const efi_handle_t handle,
 	if (handler->protocol_interface != protocol_interface)
 		return EFI_NOT_FOUND;
 	list_del(&handler->link);
+	efi_protocol_index_del(handler);
 	free(handler);
 	return EFI_SUCCESS;
 }
@@ -1113,7 +1244,7 @@ struct efi_object *efi_search_obj(const efi_handle_t handle)
 	if (!handle)
 		return NULL;
 
-	list_for_each_entry(efiobj, &efi_obj_list, link) {
+	hlist_for_each_entry(efiobj, efi_handle_hash_head(handle), hash_link) {
 		if (efiobj == handle)
 			return efiobj;
 	}
@@ -1183,7 +1314,13 @@ efi_status_t efi_add_protocol(const efi_handle_t handle,
 		return EFI_OUT_OF_RESOURCES;
 	memcpy((void *)&handler->guid, protocol, sizeof(efi_guid_t));
 	handler->protocol_interface = protocol_interface;
+	handler->handle = efiobj;
 	INIT_LIST_HEAD(&handler->open_infos);
+	ret = efi_protocol_index_add(handler);
+	if (ret != EFI_SUCCESS) {
+		free(handler);
+		return ret;
+	}
 	list_add_tail(&handler->link, &efiobj->protocols);
 
 	/* Notify registered events */
@@ -1194,6 +1331,7 @@ efi_status_t efi_add_protocol(const efi_handle_t handle,
 			notif = calloc(1, sizeof(*notif));
 			if (!notif) {
 				list_del(&handler->link);
+				efi_protocol_index_del(handler);
 				free(handler);
 				return EFI_OUT_OF_RESOURCES;
 			}
@@ -1578,6 +1716,8 @@ static efi_status_t efi_locate_handle(
 	efi_uintn_t size = 0;
 	struct efi_register_notify_event *event;
 	struct efi_protocol_notification *handle = NULL;
+	struct efi_protocol_index *entry = NULL;
+	struct efi_handler *handler;
 
 	/* Check parameters */
 	switch (search_type) {
@@ -1608,6 +1748,11 @@ static efi_status_t efi_locate_handle(
 					  link);
 		efiobj = handle->handle;
 		size += sizeof(void *);
+	} else if (search_type == BY_PROTOCOL) {
+		entry = efi_protocol_index_find(protocol);
+		if (!entry)
+			return EFI_NOT_FOUND;
+		size = entry->count * sizeof(void *);
 	} else {
 		list_for_each_entry(efiobj, &efi_obj_list, link) {
 			if (!efi_search(search_type, protocol, efiobj))
@@ -1635,6 +1780,9 @@ static efi_status_t efi_locate_handle(
 	if (search_type == BY_REGISTER_NOTIFY) {
 		*buffer = efiobj;
 		list_del(&handle->link);
+	} else if (search_type == BY_PROTOCOL) {
+		list_for_each_entry(handler, &entry->handlers, guid_link)
+			*buffer++ = handler->handle;
 	} else {
 		list_for_each_entry(efiobj, &efi_obj_list, link) {
 			if (!efi_search(search_type, protocol, efiobj))
@@ -2655,10 +2803,14 @@ static efi_status_t EFIAPI efi_locate_protocol(const efi_guid_t *protocol,
 		if (ret == EFI_SUCCESS)
 			goto found;
 	} else {
-		list_for_each_entry(efiobj, &efi_obj_list, link) {
-			ret = efi_search_protocol(efiobj, protocol, &handler);
-			if (ret == EFI_SUCCESS)
-				goto found;
+		struct efi_protocol_index *entry;
+
+		entry = efi_protocol_index_find(protocol);
+		if (entry) {
+			handler = list_first_entry(&entry->handlers,
+						   struct efi_handler,
+						   guid_link);
+			goto found;
 		}
 	}
 not_found:
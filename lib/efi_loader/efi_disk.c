@@ -24,6 +24,7 @@ struct efi_system_partition efi_system_partition = {
 };
 
 const efi_guid_t efi_block_io_guid = EFI_BLOCK_IO_PROTOCOL_GUID;
+const efi_guid_t efi_block_io2_guid = EFI_BLOCK_IO2_PROTOCOL_GUID;
 const efi_guid_t efi_system_partition_guid = PARTITION_SYSTEM_GUID;
 
 /**
@@ -31,6 +32,7 @@ const efi_guid_t efi_system_partition_guid = PARTITION_SYSTEM_GUID;
  *
  * @header:	EFI object header
  * @ops:	EFI disk I/O protocol interface
+ * @ops2:	EFI block I/O 2 protocol interface
  * @media:	block I/O media information
  * @dp:		device path to the block device
  * @volume:	simple file system protocol of the partition
@@ -38,6 +40,7 @@ const efi_guid_t efi_system_partition_guid = PARTITION_SYSTEM_GUID;
 struct efi_disk_obj {
 	struct efi_object header;
 	struct efi_block_io ops;
+	struct efi_block_io2 ops2;
 	struct efi_block_io_media media;
 	struct efi_device_path *dp;
 	struct efi_simple_file_system_protocol *volume;
@@ -97,6 +100,49 @@ enum efi_disk_direction {
 	EFI_DISK_WRITE,
 };
 
+/**
+ * efi_disk_check_request() - check the parameters of a block I/O request
+ *
+ * @media:		media of the block device
+ * @media_id:		id of the medium the request is meant for
+ * @lba:		starting logical block
+ * @buffer_size:	size of the buffer
+ * @buffer:		pointer to the buffer
+ * @direction:		read or write
+ * Return:		status code
+ */
+static efi_status_t efi_disk_check_request(struct efi_block_io_media *media,
+					   u32 media_id, u64 lba,
+					   efi_uintn_t buffer_size,
+					   void *buffer,
+					   enum efi_disk_direction direction)
+{
+	if (direction == EFI_DISK_WRITE && media->read_only)
+		return EFI_WRITE_PROTECTED;
+	/* TODO: check for media changes */
+	if (media_id != media->media_id)
+		return EFI_MEDIA_CHANGED;
+	if (!media->media_present)
+		return EFI_NO_MEDIA;
+	/* media->io_align is a power of 2 or 0 */
+	if (media->io_align &&
+	    (uintptr_t)buffer & (media->io_align - 1))
+		return EFI_INVALID_PARAMETER;
+	if (lba * media->block_size + buffer_size >
+	    (media->last_block + 1) * media->block_size)
+		return EFI_INVALID_PARAMETER;
+
+	return EFI_SUCCESS;
+}
+
+#ifdef CONFIG_EFI_BLOCK_IO2_PROTOCOL
+static void efi_disk_io2_drain(void);
+#else
+static inline void efi_disk_io2_drain(void)
+{
+}
+#endif
+
 static efi_status_t efi_disk_rw_blocks(struct efi_block_io *this,
 			u32 media_id, u64 lba, unsigned long buffer_size,
 			void *buffer, enum efi_disk_direction direction)
@@ -171,18 +217,10 @@ static efi_status_t EFIAPI efi_disk_read_blocks(struct efi_block_io *this,
 
 	if (!this)
 		return EFI_INVALID_PARAMETER;
-	/* TODO: check for media changes */
-	if (media_id != this->media->media_id)
-		return EFI_MEDIA_CHANGED;
-	if (!this->media->media_present)
-		return EFI_NO_MEDIA;
-	/* media->io_align is a power of 2 or 0 */
-	if (this->media->io_align &&
-	    (uintptr_t)buffer & (this->media->io_align - 1))
-		return EFI_INVALID_PARAMETER;
-	if (lba * this->media->block_size + buffer_size >
-	    (this->media->last_block + 1) * this->media->block_size)
-		return EFI_INVALID_PARAMETER;
+	r = efi_disk_check_request(this->media, media_id, lba, buffer_size,
+				   buffer, EFI_DISK_READ);
+	if (r != EFI_SUCCESS)
+		return r;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 	if (buffer_size > EFI_LOADER_BOUNCE_BUFFER_SIZE) {
@@ -202,6 +240,8 @@ static efi_status_t EFIAPI efi_disk_read_blocks(struct efi_block_io *this,
 	EFI_ENTRY("%p, %x, %llx, %zx, %p", this, media_id, lba,
 		  buffer_size, buffer);
 
+	/* Requests queued with EFI_BLOCK_IO2_PROTOCOL come first */
+	efi_disk_io2_drain();
 	r = efi_disk_rw_blocks(this, media_id, lba, buffer_size, real_buffer,
 			       EFI_DISK_READ);
 
@@ -237,20 +277,10 @@ static efi_status_t EFIAPI efi_disk_write_blocks(struct efi_block_io *this,
 
 	if (!this)
 		return EFI_INVALID_PARAMETER;
-	if (this->media->read_only)
-		return EFI_WRITE_PROTECTED;
-	/* TODO: check for media changes */
-	if (media_id != this->media->media_id)
-		return EFI_MEDIA_CHANGED;
-	if (!this->media->media_present)
-		return EFI_NO_MEDIA;
-	/* media->io_align is a power of 2 or 0 */
-	if (this->media->io_align &&
-	    (uintptr_t)buffer & (this->media->io_align - 1))
-		return EFI_INVALID_PARAMETER;
-	if (lba * this->media->block_size + buffer_size >
-	    (this->media->last_block + 1) * this->media->block_size)
-		return EFI_INVALID_PARAMETER;
+	r = efi_disk_check_request(this->media, media_id, lba, buffer_size,
+				   buffer, EFI_DISK_WRITE);
+	if (r != EFI_SUCCESS)
+		return r;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 	if (buffer_size > EFI_LOADER_BOUNCE_BUFFER_SIZE) {
@@ -270,6 +300,9 @@ static efi_status_t EFIAPI efi_disk_write_blocks(struct efi_block_io *this,
 	EFI_ENTRY("%p, %x, %llx, %zx, %p", this, media_id, lba,
 		  buffer_size, buffer);
 
+	/* Requests queued with EFI_BLOCK_IO2_PROTOCOL come first */
+	efi_disk_io2_drain();
+
 	/* Populate bounce buffer if necessary */
 	if (real_buffer != buffer)
 		memcpy(real_buffer, buffer, buffer_size);
@@ -286,7 +319,8 @@ static efi_status_t EFIAPI efi_disk_write_blocks(struct efi_block_io *this,
  * This function implements the FlushBlocks service of the
  * EFI_BLOCK_IO_PROTOCOL.
  *
- * As we always write synchronously nothing is done here.
+ * As we always write synchronously, this only executes any requests queued
+ * with the EFI_BLOCK_IO2_PROTOCOL.
  *
  * See the Unified Extensible Firmware Interface (UEFI) specification for
  * details.
@@ -297,6 +331,7 @@ static efi_status_t EFIAPI efi_disk_write_blocks(struct efi_block_io *this,
 static efi_status_t EFIAPI efi_disk_flush_blocks(struct efi_block_io *this)
 {
 	EFI_ENTRY("%p", this);
+	efi_disk_io2_drain();
 	return EFI_EXIT(EFI_SUCCESS);
 }
 
@@ -307,6 +342,400 @@ static const struct efi_block_io block_io_disk_template = {
 	.flush_blocks = &efi_disk_flush_blocks,
 };
 
+#ifdef CONFIG_EFI_BLOCK_IO2_PROTOCOL
+/**
+ * struct efi_disk_request - queued EFI_BLOCK_IO2_PROTOCOL request
+ *
+ * @link:		link to the list of queued requests
+ * @diskobj:		disk the request is meant for
+ * @token:		token to complete, its event is signaled on completion
+ * @media_id:		id of the medium
+ * @lba:		starting logical block
+ * @buffer_size:	size of the buffer, 0 for a flush request
+ * @buffer:		pointer to the buffer
+ * @direction:		read or write
+ */
+struct efi_disk_request {
+	struct list_head link;
+	struct efi_disk_obj *diskobj;
+	struct efi_block_io2_token *token;
+	u32 media_id;
+	u64 lba;
+	efi_uintn_t buffer_size;
+	void *buffer;
+	enum efi_disk_direction direction;
+};
+
+/* Queued EFI_BLOCK_IO2_PROTOCOL requests of all disks in submission order */
+static LIST_HEAD(efi_disk_requests);
+
+/* Timer event servicing the queued requests */
+static struct efi_event *efi_disk_io2_event;
+
+/* True while a queued transfer is executed */
+static bool efi_disk_io2_busy;
+
+/**
+ * efi_disk_io2_transfer() - execute a block I/O 2 transfer synchronously
+ *
+ * The transfer is passed to the EFI_BLOCK_IO_PROTOCOL implementation so that
+ * bounce buffering applies.
+ *
+ * @diskobj:		disk
+ * @media_id:		id of the medium
+ * @lba:		starting logical block
+ * @buffer_size:	size of the buffer
+ * @buffer:		pointer to the buffer
+ * @direction:		read or write
+ * Return:		status code
+ */
+static efi_status_t efi_disk_io2_transfer(struct efi_disk_obj *diskobj,
+					  u32 media_id, u64 lba,
+					  efi_uintn_t buffer_size, void *buffer,
+					  enum efi_disk_direction direction)
+{
+	if (!buffer_size)
+		return EFI_SUCCESS;
+	if (direction == EFI_DISK_READ)
+		return EFI_CALL(efi_disk_read_blocks(&diskobj->ops, media_id,
+						     lba, buffer_size, buffer));
+	return EFI_CALL(efi_disk_write_blocks(&diskobj->ops, media_id, lba,
+					      buffer_size, buffer));
+}
+
+/**
+ * efi_disk_io2_complete() - complete a queued request
+ *
+ * @req:	request, removed from the queue and freed
+ * @status:	transaction status
+ */
+static void efi_disk_io2_complete(struct efi_disk_request *req,
+				  efi_status_t status)
+{
+	list_del(&req->link);
+	req->token->transaction_status = status;
+	efi_signal_event(req->token->event);
+	free(req);
+}
+
+/**
+ * efi_disk_io2_can_merge() - check if a request continues the previous one
+ *
+ * @prev:	previous request
+ * @req:	request to check
+ * @size:	size of the merged requests up to and including @prev
+ * Return:	true if @req can be merged into the transfer of @prev
+ */
+static bool efi_disk_io2_can_merge(struct efi_disk_request *prev,
+				   struct efi_disk_request *req,
+				   efi_uintn_t size)
+{
+	u32 blksz = prev->diskobj->media.block_size;
+
+	return req->direction == EFI_DISK_READ &&
+	       prev->direction == EFI_DISK_READ &&
+	       req->diskobj == prev->diskobj &&
+	       req->media_id == prev->media_id &&
+	       req->buffer_size &&
+	       req->lba == prev->lba + prev->buffer_size / blksz &&
+	       size + req->buffer_size <= CONFIG_EFI_BLOCK_IO2_MERGE_SIZE;
+}
+
+/**
+ * efi_disk_io2_drain() - execute all queued requests
+ *
+ * Runs of queued reads of adjacent blocks are executed as a single transfer.
+ * If the buffers of the run are not adjacent in memory the data is read into
+ * a temporary buffer and copied.
+ *
+ * Each run is taken off the queue before it is executed. Completing a request
+ * may call back into the protocol, in which case the rest of the queue is
+ * drained there, still in submission order.
+ */
+static void efi_disk_io2_drain(void)
+{
+	/* Transfers check timers which may call us again */
+	if (efi_disk_io2_busy)
+		return;
+
+	while (!list_empty(&efi_disk_requests)) {
+		struct efi_disk_request *first, *last, *req, *next;
+		struct efi_disk_obj *diskobj;
+		efi_uintn_t size, offset;
+		bool contiguous = true;
+		efi_status_t ret;
+		LIST_HEAD(run);
+		void *buffer;
+
+		first = list_first_entry(&efi_disk_requests,
+					 struct efi_disk_request, link);
+		diskobj = first->diskobj;
+		last = first;
+		size = first->buffer_size;
+		req = first;
+		list_for_each_entry_continue(req, &efi_disk_requests, link) {
+			if (!efi_disk_io2_can_merge(last, req, size))
+				break;
+			if (req->buffer != last->buffer + last->buffer_size)
+				contiguous = false;
+			size += req->buffer_size;
+			last = req;
+		}
+
+		buffer = first->buffer;
+		if (!contiguous) {
+			buffer = memalign(diskobj->media.io_align ?: 1, size);
+			if (!buffer) {
+				last = first;
+				size = first->buffer_size;
+				buffer = first->buffer;
+			}
+		}
+		list_cut_position(&run, &efi_disk_requests, &last->link);
+
+		efi_disk_io2_busy = true;
+		ret = efi_disk_io2_transfer(diskobj, first->media_id,
+					    first->lba, size, buffer,
+					    first->direction);
+		efi_disk_io2_busy = false;
+
+		offset = 0;
+		list_for_each_entry_safe(req, next, &run, link) {
+			if (buffer != first->buffer && ret == EFI_SUCCESS)
+				memcpy(req->buffer, buffer + offset,
+				       req->buffer_size);
+			offset += req->buffer_size;
+			efi_disk_io2_complete(req, ret);
+		}
+		if (buffer != first->buffer)
+			free(buffer);
+	}
+
+	if (efi_disk_io2_event)
+		efi_set_timer(efi_disk_io2_event, EFI_TIMER_STOP, 0);
+}
+
+/**
+ * efi_disk_io2_notify() - service the queued block I/O 2 requests
+ *
+ * @event:	timer event
+ * @context:	not used
+ */
+static void EFIAPI efi_disk_io2_notify(struct efi_event *event, void *context)
+{
+	EFI_ENTRY("%p, %p", event, context);
+	efi_disk_io2_drain();
+	EFI_EXIT(EFI_SUCCESS);
+}
+
+/**
+ * efi_disk_io2_cancel() - abort the queued requests of a disk
+ *
+ * Each request is completed with EFI_ABORTED, so that callers waiting on its
+ * token are woken.
+ *
+ * @diskobj:	disk which is removed
+ */
+static void efi_disk_io2_cancel(struct efi_disk_obj *diskobj)
+{
+	struct efi_disk_request *req, *next;
+
+	list_for_each_entry_safe(req, next, &efi_disk_requests, link) {
+		if (req->diskobj == diskobj)
+			efi_disk_io2_complete(req, EFI_ABORTED);
+	}
+}
+
+/**
+ * efi_disk_io2_submit() - execute or queue a block I/O 2 request
+ *
+ * Without a token or token event the request is executed synchronously
+ * after all queued requests. Otherwise it is queued and completed from the
+ * EFI timer.
+ *
+ * @this:		pointer to the BLOCK_IO2_PROTOCOL
+ * @media_id:		id of the medium
+ * @lba:		starting logical block
+ * @token:		completion token
+ * @buffer_size:	size of the buffer
+ * @buffer:		pointer to the buffer
+ * @direction:		read or write
+ * Return:		status code
+ */
+static efi_status_t efi_disk_io2_submit(struct efi_block_io2 *this,
+					u32 media_id, u64 lba,
+					struct efi_block_io2_token *token,
+					efi_uintn_t buffer_size, void *buffer,
+					enum efi_disk_direction direction)
+{
+	struct efi_disk_obj *diskobj;
+	struct efi_disk_request *req;
+	efi_status_t ret;
+
+	if (!this || (buffer_size && !buffer))
+		return EFI_INVALID_PARAMETER;
+	diskobj = container_of(this, struct efi_disk_obj, ops2);
+	ret = efi_disk_check_request(this->media, media_id, lba, buffer_size,
+				     buffer, direction);
+	if (ret != EFI_SUCCESS)
+		return ret;
+	if (buffer_size & (this->media->block_size - 1))
+		return EFI_BAD_BUFFER_SIZE;
+
+	if (!token || !token->event) {
+		efi_disk_io2_drain();
+		return efi_disk_io2_transfer(diskobj, media_id, lba,
+					     buffer_size, buffer, direction);
+	}
+
+	if (!efi_disk_io2_event) {
+		ret = efi_create_event(EVT_TIMER | EVT_NOTIFY_SIGNAL,
+				       TPL_CALLBACK, efi_disk_io2_notify, NULL,
+				       NULL, &efi_disk_io2_event);
+		if (ret != EFI_SUCCESS)
+			return EFI_OUT_OF_RESOURCES;
+	}
+	req = calloc(1, sizeof(*req));
+	if (!req)
+		return EFI_OUT_OF_RESOURCES;
+	req->diskobj = diskobj;
+	req->token = token;
+	req->media_id = media_id;
+	req->lba = lba;
+	req->buffer_size = buffer_size;
+	req->buffer = buffer;
+	req->direction = direction;
+	list_add_tail(&req->link, &efi_disk_requests);
+
+	return efi_set_timer(efi_disk_io2_event, EFI_TIMER_PERIODIC, 0);
+}
+
+/**
+ * efi_disk_reset_ex() - reset block device
+ *
+ * This function implements the Reset service of the
+ * EFI_BLOCK_IO2_PROTOCOL.
+ *
+ * As U-Boot's block devices do not have a reset function simply return
+ * EFI_SUCCESS.
+ *
+ * See the Unified Extensible Firmware Interface (UEFI) specification for
+ * details.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @extended_verification:	extended verification
+ * Return:			status code
+ */
+static efi_status_t EFIAPI efi_disk_reset_ex(struct efi_block_io2 *this,
+					     bool extended_verification)
+{
+	EFI_ENTRY("%p, %x", this, extended_verification);
+	return EFI_EXIT(EFI_SUCCESS);
+}
+
+/**
+ * efi_disk_read_blocks_ex() - reads blocks from device
+ *
+ * This function implements the ReadBlocksEx service of the
+ * EFI_BLOCK_IO2_PROTOCOL.
+ *
+ * See the Unified Extensible Firmware Interface (UEFI) specification for
+ * details.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @media_id:			id of the medium to be read from
+ * @lba:			starting logical block for reading
+ * @token:			token for a non-blocking request
+ * @buffer_size:		size of the read buffer
+ * @buffer:			pointer to the destination buffer
+ * Return:			status code
+ */
+static efi_status_t EFIAPI efi_disk_read_blocks_ex(
+			struct efi_block_io2 *this, u32 media_id, u64 lba,
+			struct efi_block_io2_token *token,
+			efi_uintn_t buffer_size, void *buffer)
+{
+	EFI_ENTRY("%p, %x, %llx, %p, %zx, %p", this, media_id, lba, token,
+		  buffer_size, buffer);
+
+	return EFI_EXIT(efi_disk_io2_submit(this, media_id, lba, token,
+					    buffer_size, buffer,
+					    EFI_DISK_READ));
+}
+
+/**
+ * efi_disk_write_blocks_ex() - writes blocks to device
+ *
+ * This function implements the WriteBlocksEx service of the
+ * EFI_BLOCK_IO2_PROTOCOL.
+ *
+ * See the Unified Extensible Firmware Interface (UEFI) specification for
+ * details.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @media_id:			id of the medium to be written to
+ * @lba:			starting logical block for writing
+ * @token:			token for a non-blocking request
+ * @buffer_size:		size of the write buffer
+ * @buffer:			pointer to the source buffer
+ * Return:			status code
+ */
+static efi_status_t EFIAPI efi_disk_write_blocks_ex(
+			struct efi_block_io2 *this, u32 media_id, u64 lba,
+			struct efi_block_io2_token *token,
+			efi_uintn_t buffer_size, void *buffer)
+{
+	EFI_ENTRY("%p, %x, %llx, %p, %zx, %p", this, media_id, lba, token,
+		  buffer_size, buffer);
+
+	return EFI_EXIT(efi_disk_io2_submit(this, media_id, lba, token,
+					    buffer_size, buffer,
+					    EFI_DISK_WRITE));
+}
+
+/**
+ * efi_disk_flush_blocks_ex() - flushes modified data to the device
+ *
+ * This function implements the FlushBlocksEx service of the
+ * EFI_BLOCK_IO2_PROTOCOL.
+ *
+ * Writes are executed synchronously, so a flush completes when all
+ * previously queued requests have been executed.
+ *
+ * See the Unified Extensible Firmware Interface (UEFI) specification for
+ * details.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @token:			token for a non-blocking request
+ * Return:			status code
+ */
+static efi_status_t EFIAPI efi_disk_flush_blocks_ex(
+			struct efi_block_io2 *this,
+			struct efi_block_io2_token *token)
+{
+	efi_status_t ret;
+
+	EFI_ENTRY("%p, %p", this, token);
+
+	if (!this) {
+		ret = EFI_INVALID_PARAMETER;
+		goto out;
+	}
+	/* A flush is queued as empty read to pass on read-only media */
+	ret = efi_disk_io2_submit(this, this->media->media_id, 0, token, 0,
+				  NULL, EFI_DISK_READ);
+out:
+	return EFI_EXIT(ret);
+}
+
+static const struct efi_block_io2 block_io2_disk_template = {
+	.reset = &efi_disk_reset_ex,
+	.read_blocks_ex = &efi_disk_read_blocks_ex,
+	.write_blocks_ex = &efi_disk_write_blocks_ex,
+	.flush_blocks_ex = &efi_disk_flush_blocks_ex,
+};
+#endif /* CONFIG_EFI_BLOCK_IO2_PROTOCOL */
+
 /**
  * efi_fs_from_path() - retrieve simple file system protocol
  *
@@ -503,6 +932,14 @@ static efi_status_t efi_disk_add_dev(
 		if (ret != EFI_SUCCESS)
 			goto error;
 	}
+#ifdef CONFIG_EFI_BLOCK_IO2_PROTOCOL
+	diskobj->ops2 = block_io2_disk_template;
+	diskobj->ops2.media = &diskobj->media;
+	ret = efi_add_protocol(&diskobj->header, &efi_block_io2_guid,
+			       &diskobj->ops2);
+	if (ret != EFI_SUCCESS)
+		goto error;
+#endif
 	diskobj->ops = block_io_disk_template;
 
 	/* Fill in EFI IO Media info (for read/write callbacks) */
@@ -754,6 +1191,9 @@ int efi_disk_remove(void *ctx, struct event *event)
 	dp = diskobj->dp;
 	volume = diskobj->volume;
 
+#ifdef CONFIG_EFI_BLOCK_IO2_PROTOCOL
+	efi_disk_io2_cancel(diskobj);
+#endif
 	ret = efi_delete_handle(handle);
 	/* Do not delete DM device if there are still EFI drivers attached. */
 	if (ret != EFI_SUCCESS)
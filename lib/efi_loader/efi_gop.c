@@ -26,6 +26,7 @@ static const efi_guid_t efi_gop_guid = EFI_GRAPHICS_OUTPUT_PROTOCOL_GUID;
  * @mode:	graphical output mode
  * @bpix:	bits per pixel
  * @fb:		frame buffer
+ * @vdev:	video device
  */
 struct efi_gop_obj {
 	struct efi_object header;
@@ -35,6 +36,7 @@ struct efi_gop_obj {
 	/* Fields we only have access to during init */
 	u32 bpix;
 	void *fb;
+	struct udevice *vdev;
 };
 
 static efi_status_t EFIAPI gop_query_mode(struct efi_gop *this, u32 mode_number,
@@ -407,6 +409,7 @@ static efi_status_t EFIAPI gop_blt(struct efi_gop *this,
 				   efi_uintn_t dy, efi_uintn_t width,
 				   efi_uintn_t height, efi_uintn_t delta)
 {
+	struct efi_gop_obj *gopobj;
 	efi_status_t ret = EFI_INVALID_PARAMETER;
 	efi_uintn_t vid_bpp;
 
@@ -451,6 +454,16 @@ static efi_status_t EFIAPI gop_blt(struct efi_gop *this,
 	if (ret != EFI_SUCCESS)
 		return EFI_EXIT(ret);
 
+	/*
+	 * With CONFIG_VIDEO_COPY the GOP frame buffer is the hardware copy, so
+	 * there is nothing for the uclass to copy or flush
+	 */
+	if (!IS_ENABLED(CONFIG_VIDEO_COPY) &&
+	    operation != EFI_BLT_VIDEO_TO_BLT_BUFFER) {
+		gopobj = container_of(this, struct efi_gop_obj, ops);
+		video_damage(gopobj->vdev, dx, dy, width, height);
+	}
+
 	video_sync_all();
 
 	return EFI_EXIT(EFI_SUCCESS);
@@ -549,6 +562,15 @@ efi_status_t efi_gop_register(void)
 	gopobj->info.pixels_per_scanline = col;
 	gopobj->bpix = bpix;
 	gopobj->fb = map_sysmem(fb_base, fb_size);
+	gopobj->vdev = vdev;
+
+	/*
+	 * The application can write to the frame buffer without telling us,
+	 * so damage tracking cannot know what to flush. With CONFIG_VIDEO_COPY
+	 * it writes to the hardware frame buffer, which needs no flushing.
+	 */
+	if (!IS_ENABLED(CONFIG_VIDEO_COPY))
+		priv->damage.shared = true;
 
 	return EFI_SUCCESS;
 }
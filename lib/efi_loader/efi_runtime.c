@@ -215,8 +215,8 @@ void __efi_runtime efi_memcpy_runtime(void *dest, const void *src, size_t n)
 void __efi_runtime efi_update_table_header_crc32(struct efi_table_hdr *table)
 {
 	table->crc32 = 0;
-	table->crc32 = crc32(0, (const unsigned char *)table,
-			     table->headersize);
+	table->crc32 = crc32_runtime(0, (const unsigned char *)table,
+				     table->headersize);
 }
 
 /**
@@ -7,6 +7,7 @@
 
 #include <efi_loader.h>
 #include <efi_variable.h>
+#include <linux/log2.h>
 #include <u-boot/crc.h>
 
 /*
@@ -18,6 +19,24 @@
 static struct efi_var_file __efi_runtime_data *efi_var_buf;
 static struct efi_var_entry __efi_runtime_data *efi_current_var;
 
+/**
+ * struct efi_var_idx_slot - slot of the variable hash index
+ *
+ * The index is an open addressing hash table with linear probing. Offsets
+ * are relative to efi_var_buf so that the table survives
+ * SetVirtualAddressMap() without rewriting.
+ *
+ * @offset:	offset of the variable in efi_var_buf, 0 for an empty slot
+ * @hash:	hash of the variable's GUID and name
+ */
+struct efi_var_idx_slot {
+	u32 offset;
+	u32 hash;
+};
+
+static struct efi_var_idx_slot __efi_runtime_data *efi_var_idx;
+static u32 __efi_runtime_data efi_var_idx_mask;
+
 /**
  * efi_var_mem_compare() - compare GUID and name with a variable
  *
@@ -78,6 +97,138 @@ u32 __efi_runtime efi_var_entry_len(struct efi_var_entry *var)
 		     var->length + sizeof(*var), 8);
 }
 
+/**
+ * efi_var_idx_hash() - compute the index hash of a variable
+ *
+ * The FNV-1a hash is taken over the GUID and the name.
+ *
+ * @guid:	vendor GUID
+ * @name:	variable name
+ * Return:	hash value
+ */
+static u32 __efi_runtime efi_var_idx_hash(const efi_guid_t *guid,
+					  const u16 *name)
+{
+	const u8 *pos = (const u8 *)guid;
+	u32 hash = 2166136261U;
+	int i;
+
+	for (i = 0; i < sizeof(efi_guid_t); ++i)
+		hash = (hash ^ pos[i]) * 16777619U;
+	for (; *name; ++name)
+		hash = (hash ^ *name) * 16777619U;
+
+	return hash;
+}
+
+/**
+ * efi_var_idx_add() - add a variable to the hash index
+ *
+ * @var:	variable in efi_var_buf
+ */
+static void __efi_runtime efi_var_idx_add(struct efi_var_entry *var)
+{
+	u32 hash, i;
+
+	if (!efi_var_idx)
+		return;
+
+	hash = efi_var_idx_hash(&var->guid, var->name);
+	for (i = hash & efi_var_idx_mask; efi_var_idx[i].offset;
+	     i = (i + 1) & efi_var_idx_mask)
+		;
+	efi_var_idx[i].offset = (uintptr_t)var - (uintptr_t)efi_var_buf;
+	efi_var_idx[i].hash = hash;
+}
+
+/**
+ * efi_var_idx_del() - remove a variable from the hash index
+ *
+ * The slot is freed by shifting back the following entries of the probe
+ * sequence. Afterwards all offsets behind the removed variable are reduced
+ * by its length as efi_var_mem_del() closes the gap in efi_var_buf.
+ *
+ * @var:	variable in efi_var_buf
+ * @len:	length of the variable entry
+ */
+static void __efi_runtime efi_var_idx_del(struct efi_var_entry *var, u32 len)
+{
+	u32 offset, hash, i, j, k;
+
+	if (!efi_var_idx)
+		return;
+
+	offset = (uintptr_t)var - (uintptr_t)efi_var_buf;
+	hash = efi_var_idx_hash(&var->guid, var->name);
+	for (i = hash & efi_var_idx_mask; efi_var_idx[i].offset != offset;
+	     i = (i + 1) & efi_var_idx_mask) {
+		if (!efi_var_idx[i].offset)
+			return;
+	}
+
+	for (j = (i + 1) & efi_var_idx_mask; efi_var_idx[j].offset;
+	     j = (j + 1) & efi_var_idx_mask) {
+		k = efi_var_idx[j].hash & efi_var_idx_mask;
+		/* Keep entries whose home slot lies cyclically in (i, j] */
+		if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+			continue;
+		efi_var_idx[i] = efi_var_idx[j];
+		i = j;
+	}
+	efi_var_idx[i].offset = 0;
+
+	for (i = 0; i <= efi_var_idx_mask; ++i) {
+		if (efi_var_idx[i].offset > offset)
+			efi_var_idx[i].offset -= len;
+	}
+}
+
+/**
+ * efi_var_idx_rebuild() - rebuild the hash index from efi_var_buf
+ */
+static void efi_var_idx_rebuild(void)
+{
+	struct efi_var_entry *var, *last;
+
+	if (!efi_var_idx)
+		return;
+
+	memset(efi_var_idx, 0, (efi_var_idx_mask + 1) * sizeof(*efi_var_idx));
+	last = (struct efi_var_entry *)
+	       ((uintptr_t)efi_var_buf + efi_var_buf->length);
+	for (var = efi_var_buf->var; var < last;
+	     var = (void *)var + efi_var_entry_len(var))
+		efi_var_idx_add(var);
+}
+
+/**
+ * efi_var_idx_find() - look up a variable in the hash index
+ *
+ * @guid:	GUID of the variable
+ * @name:	name of the variable
+ * @next:	on exit pointer to the variable following the match
+ * Return:	matching variable or NULL
+ */
+static struct efi_var_entry __efi_runtime
+*efi_var_idx_find(const efi_guid_t *guid, const u16 *name,
+		  struct efi_var_entry **next)
+{
+	struct efi_var_entry *var;
+	u32 hash, i;
+
+	hash = efi_var_idx_hash(guid, name);
+	for (i = hash & efi_var_idx_mask; efi_var_idx[i].offset;
+	     i = (i + 1) & efi_var_idx_mask) {
+		if (efi_var_idx[i].hash != hash)
+			continue;
+		var = (void *)efi_var_buf + efi_var_idx[i].offset;
+		if (efi_var_mem_compare(var, guid, name, next))
+			return var;
+	}
+
+	return NULL;
+}
+
 struct efi_var_entry __efi_runtime
 *efi_var_mem_find(const efi_guid_t *guid, const u16 *name,
 		  struct efi_var_entry **next)
@@ -102,6 +253,13 @@ struct efi_var_entry __efi_runtime
 		return efi_current_var;
 	}
 
+	if (efi_var_idx) {
+		var = efi_var_idx_find(guid, name, next);
+		if (next && (!var || *next >= last))
+			*next = NULL;
+		return var;
+	}
+
 	var = efi_var_buf->var;
 	if (var < last) {
 		for (; var;) {
@@ -142,13 +300,14 @@ void __efi_runtime efi_var_mem_del(struct efi_var_entry *var)
 	++data;
 	next = (struct efi_var_entry *)
 	       ALIGN((uintptr_t)data + var->length, 8);
+	efi_var_idx_del(var, (uintptr_t)next - (uintptr_t)var);
 	efi_var_buf->length -= (uintptr_t)next - (uintptr_t)var;
 
 	/* efi_memcpy_runtime() can be used because next >= var. */
 	efi_memcpy_runtime(var, next, (uintptr_t)last - (uintptr_t)next);
-	efi_var_buf->crc32 = crc32(0, (u8 *)efi_var_buf->var,
-				   efi_var_buf->length -
-				   sizeof(struct efi_var_file));
+	efi_var_buf->crc32 = crc32_runtime(0, (u8 *)efi_var_buf->var,
+					   efi_var_buf->length -
+					   sizeof(struct efi_var_file));
 }
 
 efi_status_t __efi_runtime efi_var_mem_ins(
@@ -180,13 +339,14 @@ efi_status_t __efi_runtime efi_var_mem_ins(
 			   sizeof(u16) * var_name_len);
 	efi_memcpy_runtime(data, data1, size1);
 	efi_memcpy_runtime((u8 *)data + size1, data2, size2);
+	efi_var_idx_add(var);
 
 	var = (struct efi_var_entry *)
 	      ALIGN((uintptr_t)data + var->length, 8);
 	efi_var_buf->length = (uintptr_t)var - (uintptr_t)efi_var_buf;
-	efi_var_buf->crc32 = crc32(0, (u8 *)efi_var_buf->var,
-				   efi_var_buf->length -
-				   sizeof(struct efi_var_file));
+	efi_var_buf->crc32 = crc32_runtime(0, (u8 *)efi_var_buf->var,
+					   efi_var_buf->length -
+					   sizeof(struct efi_var_file));
 
 	return EFI_SUCCESS;
 }
@@ -211,12 +371,15 @@ static void EFIAPI __efi_runtime
 efi_var_mem_notify_virtual_address_map(struct efi_event *event, void *context)
 {
 	efi_convert_pointer(0, (void **)&efi_var_buf);
+	if (efi_var_idx)
+		efi_convert_pointer(0, (void **)&efi_var_idx);
 	efi_current_var = NULL;
 }
 
 efi_status_t efi_var_mem_init(void)
 {
 	u64 memory;
+	size_t size;
 	efi_status_t ret;
 	struct efi_event *event;
 
@@ -232,6 +395,19 @@ efi_status_t efi_var_mem_init(void)
 	efi_var_buf->length = (uintptr_t)efi_var_buf->var -
 			      (uintptr_t)efi_var_buf;
 
+	if (IS_ENABLED(CONFIG_EFI_VAR_HASH_INDEX)) {
+		/* Each variable entry takes at least 40 bytes */
+		efi_var_idx_mask = roundup_pow_of_two(EFI_VAR_BUF_SIZE / 32) - 1;
+		size = (efi_var_idx_mask + 1) * sizeof(*efi_var_idx);
+		ret = efi_allocate_pages(EFI_ALLOCATE_ANY_PAGES,
+					 EFI_RUNTIME_SERVICES_DATA,
+					 efi_size_in_pages(size), &memory);
+		if (ret != EFI_SUCCESS)
+			return ret;
+		efi_var_idx = (struct efi_var_idx_slot *)(uintptr_t)memory;
+		memset(efi_var_idx, 0, size);
+	}
+
 	ret = efi_create_event(EVT_SIGNAL_VIRTUAL_ADDRESS_CHANGE, TPL_CALLBACK,
 			       efi_var_mem_notify_virtual_address_map, NULL,
 			       NULL, &event);
@@ -292,8 +468,8 @@ efi_var_collect_mem(struct efi_var_file *buf, efi_uintn_t *lenp, u32 mask)
 		*lenp = hdr.length;
 		return EFI_BUFFER_TOO_SMALL;
 	}
-	hdr.crc32 = crc32(0, (u8 *)buf->var,
-			  hdr.length - sizeof(struct efi_var_file));
+	hdr.crc32 = crc32_runtime(0, (u8 *)buf->var,
+				  hdr.length - sizeof(struct efi_var_file));
 
 	efi_memcpy_runtime(buf, &hdr, sizeof(hdr));
 	*lenp = hdr.length;
@@ -396,4 +572,6 @@ skip:
 void efi_var_buf_update(struct efi_var_file *var_buf)
 {
 	memcpy(efi_var_buf, var_buf, EFI_VAR_BUF_SIZE);
+	efi_current_var = NULL;
+	efi_var_idx_rebuild();
 }
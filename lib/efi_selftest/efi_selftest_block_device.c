@@ -13,6 +13,8 @@
  * A known file is read from the file system and verified.
  * The same block is read via the EFI_BLOCK_IO_PROTOCOL and compared to the file
  * contents.
+ * Non-blocking reads via the EFI_BLOCK_IO2_PROTOCOL are compared to a blocking
+ * read via the EFI_BLOCK_IO_PROTOCOL.
  */
 
 #include <efi_selftest.h>
@@ -28,6 +30,7 @@
 static struct efi_boot_services *boottime;
 
 static const efi_guid_t block_io_protocol_guid = EFI_BLOCK_IO_PROTOCOL_GUID;
+static const efi_guid_t block_io2_protocol_guid = EFI_BLOCK_IO2_PROTOCOL_GUID;
 static const efi_guid_t guid_device_path = EFI_DEVICE_PATH_PROTOCOL_GUID;
 static const efi_guid_t guid_simple_file_system_protocol =
 					EFI_SIMPLE_FILE_SYSTEM_PROTOCOL_GUID;
@@ -291,6 +294,147 @@ static efi_uintn_t dp_size(struct efi_device_path *dp)
 	return (char *)pos - (char *)dp;
 }
 
+/*
+ * Notification function of the block IO 2 token events, nothing to do.
+ *
+ * @event	notified event
+ * @context	not used
+ */
+static void EFIAPI notify(struct efi_event *event, void *context)
+{
+}
+
+/*
+ * Test the EFI_BLOCK_IO2_PROTOCOL of a partition.
+ *
+ * Four single block reads are queued with tokens. The second and third buffer
+ * are adjacent, the others are not. The result is compared to a blocking read
+ * of all four blocks. Then a blocking read must see the data of a write which
+ * was queued before it.
+ *
+ * @handle:	partition handle
+ * @block_io:	block IO protocol of the partition
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int test_block_io2(efi_handle_t handle, struct efi_block_io *block_io)
+{
+	struct efi_block_io2 *block_io2;
+	struct efi_block_io2_token token[4];
+	struct efi_event *event[4];
+	u8 expected[4 << LB_BLOCK_SIZE] __aligned(1 << LB_BLOCK_SIZE);
+	u8 buf[6 << LB_BLOCK_SIZE] __aligned(1 << LB_BLOCK_SIZE);
+	const unsigned int offset[4] = {0, 2, 3, 5};
+	u32 media_id = block_io->media->media_id;
+	efi_uintn_t index;
+	efi_status_t ret;
+	int i;
+
+	ret = boottime->open_protocol(handle, &block_io2_protocol_guid,
+				      (void **)&block_io2, NULL, NULL,
+				      EFI_OPEN_PROTOCOL_GET_PROTOCOL);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("Failed to open block IO 2 protocol\n");
+		return EFI_ST_FAILURE;
+	}
+	ret = block_io->read_blocks(block_io, media_id, 0x20,
+				    sizeof(expected), expected);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("ReadBlocks failed\n");
+		return EFI_ST_FAILURE;
+	}
+
+	/* Blocking request */
+	boottime->set_mem(buf, sizeof(buf), 0);
+	ret = block_io2->read_blocks_ex(block_io2, media_id, 0x20, NULL,
+					sizeof(expected), buf);
+	if (ret != EFI_SUCCESS || memcmp(buf, expected, sizeof(expected))) {
+		efi_st_error("Blocking ReadBlocksEx failed\n");
+		return EFI_ST_FAILURE;
+	}
+
+	/* Non-blocking requests */
+	boottime->set_mem(buf, sizeof(buf), 0);
+	for (i = 0; i < 4; ++i) {
+		ret = boottime->create_event(EVT_NOTIFY_WAIT, TPL_CALLBACK,
+					     notify, NULL, &event[i]);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("Could not create event\n");
+			return EFI_ST_FAILURE;
+		}
+		token[i].event = event[i];
+		token[i].transaction_status = EFI_NOT_READY;
+		ret = block_io2->read_blocks_ex(
+				block_io2, media_id, 0x20 + i, &token[i],
+				1 << LB_BLOCK_SIZE,
+				buf + (offset[i] << LB_BLOCK_SIZE));
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("ReadBlocksEx failed\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+	for (i = 0; i < 4; ++i) {
+		ret = boottime->wait_for_event(1, &event[i], &index);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("WaitForEvent failed\n");
+			return EFI_ST_FAILURE;
+		}
+		if (token[i].transaction_status != EFI_SUCCESS) {
+			efi_st_error("Request %d failed\n", i);
+			return EFI_ST_FAILURE;
+		}
+		if (memcmp(buf + (offset[i] << LB_BLOCK_SIZE),
+			   expected + (i << LB_BLOCK_SIZE),
+			   1 << LB_BLOCK_SIZE)) {
+			efi_st_error("Request %d read wrong data\n", i);
+			return EFI_ST_FAILURE;
+		}
+		boottime->close_event(event[i]);
+	}
+
+	/* A blocking request is executed after the queued ones */
+	for (i = 0; i < 1 << LB_BLOCK_SIZE; ++i)
+		buf[i] = ~expected[i];
+	ret = boottime->create_event(EVT_NOTIFY_WAIT, TPL_CALLBACK, notify,
+				     NULL, &event[0]);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("Could not create event\n");
+		return EFI_ST_FAILURE;
+	}
+	token[0].event = event[0];
+	token[0].transaction_status = EFI_NOT_READY;
+	ret = block_io2->write_blocks_ex(block_io2, media_id, 0x20, &token[0],
+					 1 << LB_BLOCK_SIZE, buf);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("WriteBlocksEx failed\n");
+		return EFI_ST_FAILURE;
+	}
+	ret = block_io->read_blocks(block_io, media_id, 0x20,
+				    1 << LB_BLOCK_SIZE,
+				    buf + (1 << LB_BLOCK_SIZE));
+	if (ret != EFI_SUCCESS ||
+	    token[0].transaction_status != EFI_SUCCESS ||
+	    memcmp(buf + (1 << LB_BLOCK_SIZE), buf, 1 << LB_BLOCK_SIZE)) {
+		efi_st_error("ReadBlocks overtook a queued request\n");
+		return EFI_ST_FAILURE;
+	}
+	boottime->close_event(event[0]);
+	ret = block_io->write_blocks(block_io, media_id, 0x20,
+				     1 << LB_BLOCK_SIZE, expected);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("WriteBlocks failed\n");
+		return EFI_ST_FAILURE;
+	}
+
+	/* Flush */
+	ret = block_io2->flush_blocks_ex(block_io2, NULL);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("FlushBlocksEx failed\n");
+		return EFI_ST_FAILURE;
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
 /*
  * Execute unit test.
  *
@@ -476,6 +620,12 @@ static int execute(void)
 		return EFI_ST_FAILURE;
 	}
 
+#ifdef CONFIG_EFI_BLOCK_IO2_PROTOCOL
+	if (test_block_io2(handle_partition, block_io_protocol) !=
+	    EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+#endif
+
 #ifdef CONFIG_FAT_WRITE
 	/* Write file */
 	ret = root->open(root, &file, u"u-boot.txt", EFI_FILE_MODE_READ |
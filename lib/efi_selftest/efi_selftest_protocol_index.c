@@ -0,0 +1,216 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * efi_selftest_protocol_index
+ *
+ * This unit test installs protocols on a large number of handles and checks
+ * that LocateHandleBuffer() and LocateProtocol() find the right handles in
+ * the order in which the handles were created. Finally the throughput of
+ * LocateHandleBuffer() is measured.
+ */
+
+#include <efi_selftest.h>
+
+#define EFI_ST_NUM_HANDLES 300
+/* Benchmark duration in units of 100 ns */
+#define EFI_ST_BENCH_TIME 10000000
+
+static struct efi_boot_services *boottime;
+static efi_guid_t guid_all =
+	EFI_GUID(0x0d3b8d7e, 0x2f5c, 0x4a1e,
+		 0x9b, 0x6a, 0x57, 0x1e, 0xc3, 0x84, 0x20, 0xf9);
+static efi_guid_t guid_some =
+	EFI_GUID(0x5c0e3f7a, 0x83d4, 0x4c9b,
+		 0xa2, 0x17, 0x6e, 0x4b, 0x90, 0xd1, 0x3a, 0x58);
+static efi_handle_t handles[EFI_ST_NUM_HANDLES];
+
+/**
+ * check_handles() - check the handles implementing guid_some
+ *
+ * @step:	every step-th handle is expected to implement the protocol
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int check_handles(unsigned int step)
+{
+	efi_handle_t *buffer;
+	efi_uintn_t count;
+	efi_status_t ret;
+	void *interface;
+	unsigned int i;
+
+	ret = boottime->locate_handle_buffer(BY_PROTOCOL, &guid_some, NULL,
+					     &count, &buffer);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("LocateHandleBuffer failed\n");
+		return EFI_ST_FAILURE;
+	}
+	if (count != (EFI_ST_NUM_HANDLES + step - 1) / step) {
+		efi_st_error("LocateHandleBuffer returned %u handles\n",
+			     (unsigned int)count);
+		return EFI_ST_FAILURE;
+	}
+	for (i = 0; i < count; ++i) {
+		if (buffer[i] != handles[i * step]) {
+			efi_st_error("Handles are not in creation order\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+	ret = boottime->free_pool(buffer);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("FreePool failed\n");
+		return EFI_ST_FAILURE;
+	}
+	ret = boottime->locate_protocol(&guid_some, NULL, &interface);
+	if (ret != EFI_SUCCESS || interface != &handles[0]) {
+		efi_st_error("LocateProtocol failed\n");
+		return EFI_ST_FAILURE;
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
+/*
+ * Setup unit test.
+ *
+ * Create the handles and install guid_all on each of them.
+ *
+ * @handle:	handle of the loaded image
+ * @systable:	system table
+ */
+static int setup(const efi_handle_t img_handle,
+		 const struct efi_system_table *systable)
+{
+	efi_status_t ret;
+	unsigned int i;
+
+	boottime = systable->boottime;
+
+	for (i = 0; i < EFI_ST_NUM_HANDLES; ++i) {
+		handles[i] = NULL;
+		ret = boottime->install_protocol_interface(&handles[i],
+							   &guid_all,
+							   EFI_NATIVE_INTERFACE,
+							   NULL);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("InstallProtocolInterface failed\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
+/*
+ * Tear down unit test.
+ *
+ * Uninstalling the last protocol deletes the handles.
+ */
+static int teardown(void)
+{
+	int ret = EFI_ST_SUCCESS;
+	unsigned int i;
+
+	for (i = 0; i < EFI_ST_NUM_HANDLES; ++i) {
+		if (!handles[i])
+			continue;
+		boottime->uninstall_protocol_interface(handles[i], &guid_some,
+						       &handles[i]);
+		if (boottime->uninstall_protocol_interface(
+				handles[i], &guid_all, NULL) != EFI_SUCCESS) {
+			efi_st_error("UninstallProtocolInterface failed\n");
+			ret = EFI_ST_FAILURE;
+		}
+		handles[i] = NULL;
+	}
+
+	return ret;
+}
+
+/*
+ * Execute unit test.
+ */
+static int execute(void)
+{
+	struct efi_event *event;
+	efi_handle_t *buffer;
+	efi_uintn_t count;
+	efi_status_t ret;
+	unsigned int i;
+	u64 calls;
+
+	/* Install in reverse order, the result must follow creation order */
+	for (i = EFI_ST_NUM_HANDLES; i--;) {
+		if (i % 3)
+			continue;
+		ret = boottime->install_protocol_interface(&handles[i],
+							   &guid_some,
+							   EFI_NATIVE_INTERFACE,
+							   &handles[i]);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("InstallProtocolInterface failed\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+	if (check_handles(3) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+
+	for (i = 3; i < EFI_ST_NUM_HANDLES; i += 6) {
+		ret = boottime->uninstall_protocol_interface(handles[i],
+							     &guid_some,
+							     &handles[i]);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("UninstallProtocolInterface failed\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+	if (check_handles(6) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+
+	ret = boottime->locate_handle_buffer(BY_PROTOCOL, &guid_all, NULL,
+					     &count, &buffer);
+	if (ret != EFI_SUCCESS || count != EFI_ST_NUM_HANDLES) {
+		efi_st_error("LocateHandleBuffer failed\n");
+		return EFI_ST_FAILURE;
+	}
+	boottime->free_pool(buffer);
+
+	/* Measure the LocateHandleBuffer() throughput */
+	ret = boottime->create_event(EVT_TIMER, TPL_CALLBACK, NULL, NULL,
+				     &event);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("Could not create event\n");
+		return EFI_ST_FAILURE;
+	}
+	ret = boottime->set_timer(event, EFI_TIMER_RELATIVE,
+				  EFI_ST_BENCH_TIME);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("Could not set timer\n");
+		return EFI_ST_FAILURE;
+	}
+	calls = 0;
+	do {
+		for (i = 0; i < 16; ++i, ++calls) {
+			ret = boottime->locate_handle_buffer(BY_PROTOCOL,
+							     &guid_some, NULL,
+							     &count, &buffer);
+			if (ret != EFI_SUCCESS) {
+				efi_st_error("LocateHandleBuffer failed\n");
+				return EFI_ST_FAILURE;
+			}
+			boottime->free_pool(buffer);
+		}
+	} while (boottime->check_event(event) == EFI_NOT_READY);
+	boottime->close_event(event);
+	efi_st_printf("LocateHandleBuffer: %u calls/s, %u of %u handles\n",
+		      (unsigned int)calls, (unsigned int)count,
+		      EFI_ST_NUM_HANDLES);
+
+	return EFI_ST_SUCCESS;
+}
+
+EFI_UNIT_TEST(protocol_index) = {
+	.name = "protocol index",
+	.phase = EFI_EXECUTE_BEFORE_BOOTTIME_EXIT,
+	.setup = setup,
+	.execute = execute,
+	.teardown = teardown,
+};
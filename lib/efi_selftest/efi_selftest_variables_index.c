@@ -0,0 +1,263 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * efi_selftest_variables_index
+ *
+ * This unit test stresses the lookup of variables in a well filled store:
+ * many variables are created, every second one is deleted and the rest is
+ * read back and enumerated. Finally the GetVariable() throughput is
+ * measured.
+ */
+
+#include <efi_selftest.h>
+
+#define EFI_ST_NUM_VARS 256
+#define EFI_ST_MAX_VARNAME_SIZE 80
+/* Benchmark duration in units of 100 ns */
+#define EFI_ST_BENCH_TIME 10000000
+
+static struct efi_boot_services *boottime;
+static struct efi_runtime_services *runtime;
+static const efi_guid_t guid_vendor[] = {
+	EFI_GUID(0x1b5dbcc7, 0x3cf6, 0x4dc8,
+		 0x9e, 0x0b, 0x8a, 0x47, 0x11, 0x39, 0x6e, 0x25),
+	EFI_GUID(0x8e5b3b60, 0x6a0d, 0x4c52,
+		 0xa1, 0x5c, 0x2d, 0xf0, 0x7e, 0x9b, 0x44, 0x13),
+};
+
+/**
+ * var_name() - generate the name of a test variable
+ *
+ * @buf:	buffer for the name
+ * @i:		number of the variable
+ */
+static void var_name(u16 *buf, unsigned int i)
+{
+	static const char prefix[] = "efi_st_idx";
+	int j;
+
+	for (j = 0; prefix[j]; ++j)
+		buf[j] = prefix[j];
+	buf[j++] = '0' + i / 100;
+	buf[j++] = '0' + (i / 10) % 10;
+	buf[j++] = '0' + i % 10;
+	buf[j] = 0;
+}
+
+/**
+ * var_guid() - get the vendor GUID of a test variable
+ *
+ * @i:		number of the variable
+ * Return:	vendor GUID
+ */
+static const efi_guid_t *var_guid(unsigned int i)
+{
+	return &guid_vendor[i & 1];
+}
+
+/**
+ * var_check() - check if a variable can be read and has the expected value
+ *
+ * @i:		number of the variable
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int var_check(unsigned int i)
+{
+	u16 name[EFI_ST_MAX_VARNAME_SIZE];
+	efi_uintn_t len = sizeof(u32);
+	efi_status_t ret;
+	u32 data;
+
+	var_name(name, i);
+	ret = runtime->get_variable(name, var_guid(i), NULL, &len, &data);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("GetVariable failed for %ps\n", name);
+		return EFI_ST_FAILURE;
+	}
+	if (len != sizeof(u32) || data != i) {
+		efi_st_error("GetVariable returned wrong value for %ps\n",
+			     name);
+		return EFI_ST_FAILURE;
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
+/*
+ * Setup unit test.
+ *
+ * @handle	handle of the loaded image
+ * @systable	system table
+ */
+static int setup(const efi_handle_t img_handle,
+		 const struct efi_system_table *systable)
+{
+	boottime = systable->boottime;
+	runtime = systable->runtime;
+
+	return EFI_ST_SUCCESS;
+}
+
+/*
+ * Tear down unit test.
+ *
+ * Delete the remaining test variables.
+ */
+static int teardown(void)
+{
+	u16 name[EFI_ST_MAX_VARNAME_SIZE];
+	unsigned int i;
+
+	for (i = 0; i < EFI_ST_NUM_VARS; ++i) {
+		var_name(name, i);
+		runtime->set_variable(name, var_guid(i), 0, 0, NULL);
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
+/*
+ * Execute unit test.
+ */
+static int execute(void)
+{
+	u16 name[EFI_ST_MAX_VARNAME_SIZE];
+	struct efi_event *event;
+	efi_status_t ret;
+	efi_uintn_t len;
+	efi_guid_t guid;
+	unsigned int i, count;
+	u64 calls;
+	u32 data;
+
+	for (i = 0; i < EFI_ST_NUM_VARS; ++i) {
+		var_name(name, i);
+		ret = runtime->set_variable(name, var_guid(i),
+					    EFI_VARIABLE_BOOTSERVICE_ACCESS,
+					    sizeof(i), &i);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("SetVariable failed for %ps\n", name);
+			return EFI_ST_FAILURE;
+		}
+	}
+	for (i = 0; i < EFI_ST_NUM_VARS; ++i) {
+		if (var_check(i) != EFI_ST_SUCCESS)
+			return EFI_ST_FAILURE;
+	}
+
+	/* The name must match in full, the GUID must match too */
+	var_name(name, 1);
+	len = sizeof(data);
+	ret = runtime->get_variable(name, &guid_vendor[0], NULL, &len, &data);
+	if (ret != EFI_NOT_FOUND) {
+		efi_st_error("GetVariable found variable with wrong GUID\n");
+		return EFI_ST_FAILURE;
+	}
+	name[10] = 0;
+	ret = runtime->get_variable(name, &guid_vendor[0], NULL, &len, &data);
+	if (ret != EFI_NOT_FOUND) {
+		efi_st_error("GetVariable matched prefix of variable name\n");
+		return EFI_ST_FAILURE;
+	}
+
+	/* Deleting moves all following variables in the store */
+	for (i = 0; i < EFI_ST_NUM_VARS; i += 2) {
+		var_name(name, i);
+		ret = runtime->set_variable(name, var_guid(i), 0, 0, NULL);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("Deleting %ps failed\n", name);
+			return EFI_ST_FAILURE;
+		}
+	}
+	/* Overwriting re-appends the variable at the end of the store */
+	for (i = 1; i < EFI_ST_NUM_VARS; i += 4) {
+		var_name(name, i);
+		ret = runtime->set_variable(name, var_guid(i),
+					    EFI_VARIABLE_BOOTSERVICE_ACCESS,
+					    sizeof(i), &i);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("SetVariable failed for %ps\n", name);
+			return EFI_ST_FAILURE;
+		}
+	}
+	for (i = 0; i < EFI_ST_NUM_VARS; ++i) {
+		if (i & 1) {
+			if (var_check(i) != EFI_ST_SUCCESS)
+				return EFI_ST_FAILURE;
+			continue;
+		}
+		var_name(name, i);
+		len = sizeof(data);
+		ret = runtime->get_variable(name, var_guid(i), NULL, &len,
+					    &data);
+		if (ret != EFI_NOT_FOUND) {
+			efi_st_error("Variable %ps was not deleted\n", name);
+			return EFI_ST_FAILURE;
+		}
+	}
+
+	/* Enumerate the variables */
+	count = 0;
+	*name = 0;
+	for (;;) {
+		len = sizeof(name);
+		ret = runtime->get_next_variable_name(&len, name, &guid);
+		if (ret == EFI_NOT_FOUND)
+			break;
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("GetNextVariableName failed (%u)\n",
+				     (unsigned int)ret);
+			return EFI_ST_FAILURE;
+		}
+		if (!memcmp(&guid, &guid_vendor[0], sizeof(guid)) ||
+		    !memcmp(&guid, &guid_vendor[1], sizeof(guid)))
+			++count;
+	}
+	if (count != EFI_ST_NUM_VARS / 2) {
+		efi_st_error("GetNextVariableName found %u variables\n",
+			     count);
+		return EFI_ST_FAILURE;
+	}
+
+	/* Measure the GetVariable() throughput */
+	ret = boottime->create_event(EVT_TIMER, TPL_CALLBACK, NULL, NULL,
+				     &event);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("Could not create event\n");
+		return EFI_ST_FAILURE;
+	}
+	ret = boottime->set_timer(event, EFI_TIMER_RELATIVE,
+				  EFI_ST_BENCH_TIME);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("Could not set timer\n");
+		boottime->close_event(event);
+		return EFI_ST_FAILURE;
+	}
+	calls = 0;
+	do {
+		for (i = 1; i < EFI_ST_NUM_VARS; i += 2, ++calls) {
+			var_name(name, i);
+			len = sizeof(data);
+			ret = runtime->get_variable(name, var_guid(i), NULL,
+						    &len, &data);
+			if (ret != EFI_SUCCESS) {
+				efi_st_error("GetVariable failed for %ps\n",
+					     name);
+				boottime->close_event(event);
+				return EFI_ST_FAILURE;
+			}
+		}
+	} while (boottime->check_event(event) == EFI_NOT_READY);
+	boottime->close_event(event);
+	efi_st_printf("GetVariable: %u calls/s with %u variables\n",
+		      (unsigned int)calls, EFI_ST_NUM_VARS / 2);
+
+	return EFI_ST_SUCCESS;
+}
+
+EFI_UNIT_TEST(variables_index) = {
+	.name = "variables index",
+	.phase = EFI_EXECUTE_BEFORE_BOOTTIME_EXIT,
+	.setup = setup,
+	.execute = execute,
+	.teardown = teardown,
+};
@@ -14,6 +14,7 @@
 #include <memalign.h>
 #include <u-boot/crc.h>
 #include <watchdog.h>
+#include <asm/unaligned.h>
 #include <u-boot/zlib.h>
 
 #define HEADER0			'\x1f'
@@ -71,13 +72,50 @@ int gzip_parse_header(const unsigned char *src, unsigned long len)
 	return i;
 }
 
+/*
+ * Try the fast inflate engine. It gives up on a corrupt stream or a too-small
+ * output buffer, returning -EAGAIN so that zlib can report the error in the
+ * usual way. With @gzip the gzip trailer is checked, if present in the input.
+ */
+static int zunzip_fast(void *dst, int dstlen, unsigned char *src,
+		       unsigned long *lenp, int offset, bool gzip)
+{
+	size_t outlen, inlen;
+	u32 crc = 0, *crcp = NULL;
+	const u8 *trailer;
+
+	if (!CONFIG_IS_ENABLED(GZIP_FAST))
+		return -EAGAIN;
+	if (gzip && IS_ENABLED(CONFIG_GZIP_FAST_CRC))
+		crcp = &crc;
+	if (inflate_fast_buf(dst, (uint)dstlen, src + offset, *lenp - offset,
+			     &outlen, &inlen, crcp))
+		return -EAGAIN;
+	if (crcp && offset + inlen + 8 <= *lenp) {
+		trailer = src + offset + inlen;
+		if (get_unaligned_le32(trailer) != crc ||
+		    get_unaligned_le32(trailer + 4) != (u32)outlen) {
+			puts("Error: gunzip CRC mismatch\n");
+			return -EIO;
+		}
+	}
+	*lenp = outlen;
+
+	return 0;
+}
+
 int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
 {
 	int offset = gzip_parse_header(src, *lenp);
+	int ret;
 
 	if (offset < 0)
 		return offset;
 
+	ret = zunzip_fast(dst, dstlen, src, lenp, offset, true);
+	if (ret != -EAGAIN)
+		return ret ? -1 : 0;
+
 	return zunzip(dst, dstlen, src, lenp, 1, offset);
 }
 
@@ -281,6 +319,10 @@ int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
 	int err = 0;
 	int r;
 
+	r = zunzip_fast(dst, dstlen, src, lenp, offset, false);
+	if (r != -EAGAIN)
+		return r;
+
 	s.zalloc = gzalloc;
 	s.zfree = gzfree;
 
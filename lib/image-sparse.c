@@ -316,3 +316,298 @@ int write_sparse_image(struct sparse_storage *info,
 
 	return 0;
 }
+
+static int sparse_stream_fail(struct sparse_stream *ss, const char *msg,
+			      char *response)
+{
+	ss->info->mssg(msg, response);
+	ss->state = SPARSE_STREAM_ERROR;
+
+	return -1;
+}
+
+/* Write @blkcnt blocks from the staging buffer */
+static int sparse_stream_put(struct sparse_stream *ss, lbaint_t blkcnt,
+			     char *response)
+{
+	struct sparse_storage *info = ss->info;
+	lbaint_t blks;
+
+	/* blks might be > blkcnt due to NAND bad-blocks */
+	blks = info->write(info, ss->blk, blkcnt, ss->buf);
+	if (IS_ERR_VALUE(blks) || blks < blkcnt) {
+		printf("%s: Write failed, block #" LBAFU " [" LBAFU "]\n",
+		       __func__, ss->blk, blkcnt);
+		return sparse_stream_fail(ss, "flash write failure", response);
+	}
+	ss->blk += blks;
+	ss->bytes_written += (u64)blkcnt * info->blksz;
+
+	return 0;
+}
+
+/* Copy up to @size - ss->got bytes of a header or value to @dst */
+static size_t sparse_stream_collect(struct sparse_stream *ss, void *dst,
+				    size_t size, const u8 *data, size_t len)
+{
+	size_t n = min(size - ss->got, len);
+
+	memcpy(dst + ss->got, data, n);
+	ss->got += n;
+
+	return n;
+}
+
+static void sparse_stream_next_chunk(struct sparse_stream *ss)
+{
+	ss->got = 0;
+	if (++ss->chunks == le32_to_cpu(ss->header.total_chunks))
+		ss->state = SPARSE_STREAM_DONE;
+	else
+		ss->state = SPARSE_STREAM_CHUNK;
+}
+
+static int sparse_stream_header(struct sparse_stream *ss, char *response)
+{
+	sparse_header_t *header = &ss->header;
+	u32 blk_sz = le32_to_cpu(header->blk_sz);
+
+	if (!is_sparse_image(header) ||
+	    le16_to_cpu(header->file_hdr_sz) < sizeof(sparse_header_t) ||
+	    le16_to_cpu(header->chunk_hdr_sz) < sizeof(chunk_header_t))
+		return sparse_stream_fail(ss, "invalid sparse image header",
+					  response);
+
+	/*
+	 * Verify that the sparse block size is a multiple of our
+	 * storage backend block size
+	 */
+	if (!blk_sz || blk_sz % (u32)ss->info->blksz) {
+		printf("%s: Sparse image block size issue [%u]\n",
+		       __func__, blk_sz);
+		return sparse_stream_fail(ss, "sparse image block size issue",
+					  response);
+	}
+
+	puts("Flashing Sparse Image\n");
+
+	/* Skip the remaining bytes in a header that is longer than expected */
+	ss->skip = le16_to_cpu(header->file_hdr_sz) - sizeof(sparse_header_t);
+	ss->got = 0;
+	if (header->total_chunks)
+		ss->state = SPARSE_STREAM_CHUNK;
+	else
+		ss->state = SPARSE_STREAM_DONE;
+
+	return 0;
+}
+
+static int sparse_stream_chunk(struct sparse_stream *ss, char *response)
+{
+	struct sparse_storage *info = ss->info;
+	chunk_header_t *chunk = &ss->chunk;
+	u32 hdr_sz = le16_to_cpu(ss->header.chunk_hdr_sz);
+	u32 total_sz = le32_to_cpu(chunk->total_sz);
+	u32 chunk_sz = le32_to_cpu(chunk->chunk_sz);
+	u64 data_sz = (u64)le32_to_cpu(ss->header.blk_sz) * chunk_sz;
+	lbaint_t blkcnt = div_u64(data_sz, (u32)info->blksz);
+	u16 type = le16_to_cpu(chunk->chunk_type);
+
+	/* Skip the remaining bytes in a header that is longer than expected */
+	ss->skip = hdr_sz - sizeof(chunk_header_t);
+	ss->got = 0;
+
+	if ((type == CHUNK_TYPE_RAW || type == CHUNK_TYPE_FILL) &&
+	    ss->blk + blkcnt > info->start + info->size) {
+		printf("%s: Request would exceed partition size!\n", __func__);
+		return sparse_stream_fail(ss,
+					  "Request would exceed partition size!",
+					  response);
+	}
+
+	switch (type) {
+	case CHUNK_TYPE_RAW:
+		if (total_sz != hdr_sz + data_sz)
+			return sparse_stream_fail(ss,
+					"Bogus chunk size for chunk type Raw",
+					response);
+		ss->left = data_sz;
+		ss->total_blocks += chunk_sz;
+		if (data_sz)
+			ss->state = SPARSE_STREAM_RAW;
+		else
+			sparse_stream_next_chunk(ss);
+		break;
+
+	case CHUNK_TYPE_FILL:
+		if (total_sz != hdr_sz + sizeof(uint32_t))
+			return sparse_stream_fail(ss,
+					"Bogus chunk size for chunk type FILL",
+					response);
+		ss->left = data_sz;
+		ss->total_blocks += chunk_sz;
+		ss->state = SPARSE_STREAM_FILL;
+		break;
+
+	case CHUNK_TYPE_DONT_CARE:
+		ss->blk += info->reserve(info, ss->blk, blkcnt);
+		ss->total_blocks += chunk_sz;
+		sparse_stream_next_chunk(ss);
+		break;
+
+	case CHUNK_TYPE_CRC32:
+		if (total_sz != hdr_sz + sizeof(uint32_t))
+			return sparse_stream_fail(ss,
+					"Bogus chunk size for chunk type CRC32",
+					response);
+		ss->skip += sizeof(uint32_t);
+		ss->total_blocks += chunk_sz;
+		sparse_stream_next_chunk(ss);
+		break;
+
+	default:
+		printf("%s: Unknown chunk type: %x\n", __func__, type);
+		return sparse_stream_fail(ss, "Unknown chunk type", response);
+	}
+
+	return 0;
+}
+
+static int sparse_stream_fill(struct sparse_stream *ss, char *response)
+{
+	u32 blksz = ss->info->blksz;
+	lbaint_t blkcnt = div_u64(ss->left, blksz);
+	lbaint_t n = min(blkcnt, ss->buf_blks);
+	u32 *fill_buf = ss->buf;
+	size_t i;
+
+	for (i = 0; i < n * blksz / sizeof(u32); i++)
+		fill_buf[i] = ss->fill_val;
+
+	while (blkcnt) {
+		n = min(blkcnt, ss->buf_blks);
+		if (sparse_stream_put(ss, n, response))
+			return -1;
+		blkcnt -= n;
+	}
+	ss->left = 0;
+	sparse_stream_next_chunk(ss);
+
+	return 0;
+}
+
+static size_t sparse_stream_raw(struct sparse_stream *ss, const u8 *data,
+				size_t len, char *response)
+{
+	u32 blksz = ss->info->blksz;
+	size_t room = ss->buf_blks * blksz - ss->buf_used;
+	size_t n = min_t(u64, ss->left, min(len, room));
+
+	memcpy(ss->buf + ss->buf_used, data, n);
+	ss->buf_used += n;
+	ss->left -= n;
+
+	/* Raw data is a whole number of blocks, so buf_used is too */
+	if (ss->buf_used == ss->buf_blks * blksz || !ss->left) {
+		if (sparse_stream_put(ss, ss->buf_used / blksz, response))
+			return n;
+		ss->buf_used = 0;
+		if (!ss->left)
+			sparse_stream_next_chunk(ss);
+	}
+
+	return n;
+}
+
+int sparse_stream_init(struct sparse_stream *ss, struct sparse_storage *info,
+		       void *buf, size_t size)
+{
+	void *aligned = PTR_ALIGN(buf, ARCH_DMA_MINALIGN);
+
+	memset(ss, '\0', sizeof(*ss));
+	if (size < aligned - buf + info->blksz)
+		return -ENOSPC;
+
+	if (!info->mssg)
+		info->mssg = default_log;
+	ss->info = info;
+	ss->buf = aligned;
+	ss->buf_blks = (size - (aligned - buf)) / (u32)info->blksz;
+	ss->blk = info->start;
+	ss->state = SPARSE_STREAM_HEADER;
+
+	return 0;
+}
+
+int sparse_stream_write(struct sparse_stream *ss, const void *data,
+			size_t len, char *response)
+{
+	const u8 *p = data;
+	size_t n;
+
+	while (len && ss->state != SPARSE_STREAM_ERROR) {
+		if (ss->skip) {
+			n = min(ss->skip, len);
+			ss->skip -= n;
+			p += n;
+			len -= n;
+			continue;
+		}
+
+		switch (ss->state) {
+		case SPARSE_STREAM_HEADER:
+			n = sparse_stream_collect(ss, &ss->header,
+						  sizeof(ss->header), p, len);
+			if (ss->got == sizeof(ss->header))
+				sparse_stream_header(ss, response);
+			break;
+		case SPARSE_STREAM_CHUNK:
+			n = sparse_stream_collect(ss, &ss->chunk,
+						  sizeof(ss->chunk), p, len);
+			if (ss->got == sizeof(ss->chunk))
+				sparse_stream_chunk(ss, response);
+			break;
+		case SPARSE_STREAM_FILL:
+			n = sparse_stream_collect(ss, &ss->fill_val,
+						  sizeof(ss->fill_val), p, len);
+			if (ss->got == sizeof(ss->fill_val))
+				sparse_stream_fill(ss, response);
+			break;
+		case SPARSE_STREAM_RAW:
+			n = sparse_stream_raw(ss, p, len, response);
+			break;
+		default:
+			/* Anything after the last chunk is ignored */
+			n = len;
+			break;
+		}
+		p += n;
+		len -= n;
+	}
+
+	return ss->state == SPARSE_STREAM_ERROR ? -1 : 0;
+}
+
+int sparse_stream_finish(struct sparse_stream *ss, const char *part_name,
+			 char *response)
+{
+	if (ss->state == SPARSE_STREAM_ERROR)
+		return -1;
+
+	if (ss->state != SPARSE_STREAM_DONE || ss->skip) {
+		printf("%s: Sparse image is truncated\n", __func__);
+		return sparse_stream_fail(ss, "sparse image truncated",
+					  response);
+	}
+
+	debug("Wrote %d blocks, expected to write %d blocks\n",
+	      ss->total_blocks, le32_to_cpu(ss->header.total_blks));
+	printf("........ wrote %llu bytes to '%s'\n", ss->bytes_written,
+	       part_name);
+
+	if (ss->total_blocks != le32_to_cpu(ss->header.total_blks))
+		return sparse_stream_fail(ss, "sparse image write failure",
+					  response);
+
+	return 0;
+}
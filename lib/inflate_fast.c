@@ -0,0 +1,572 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * One-shot inflate for gunzip() and zunzip()
+ *
+ * The zlib inflate() is written for streaming: it keeps its own window, can
+ * stop after any bit and handles each symbol with a state machine. Here the
+ * whole input and output are in memory, which allows a much tighter loop:
+ *
+ * - a 64-bit bit buffer, refilled once per symbol with a single load, holds
+ *   enough bits for a literal/length code, a distance code and their extra
+ *   bits
+ * - the literal/length table is indexed by 11 bits and an entry can hold
+ *   two literals whose codes fit in those bits
+ * - the output buffer is the window, so matches are copied straight from it,
+ *   eight bytes at a time when they do not overlap
+ *
+ * Anything unusual ends the decode with an error code, so that the caller can
+ * hand the data to zlib to report the error in the usual way.
+ */
+
+#include <cyclic.h>
+#include <errno.h>
+#include <gzip.h>
+#include <malloc.h>
+#include <asm/unaligned.h>
+#include <linux/compiler.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <u-boot/crc.h>
+
+#define LITLEN_BITS	11
+#define DIST_BITS	10
+#define PRECODE_BITS	7
+#define LITLEN_SYMS	288
+#define DIST_SYMS	32
+#define PRECODE_SYMS	19
+#define MAX_CODE_LEN	15
+
+/*
+ * Every subtable holds at least one symbol and has at most
+ * 2^(MAX_CODE_LEN - bits) entries
+ */
+#define LITLEN_ENOUGH	((1 << LITLEN_BITS) + \
+			 (LITLEN_SYMS << (MAX_CODE_LEN - LITLEN_BITS)))
+#define DIST_ENOUGH	((1 << DIST_BITS) + \
+			 (DIST_SYMS << (MAX_CODE_LEN - DIST_BITS)))
+
+/* Longest match plus the overshoot of a match copy */
+#define OUT_MARGIN	(258 + 15)
+
+/*
+ * A table entry holds the number of bits to consume in bits 0-3, the type in
+ * bits 4-7, the number of extra bits (or subtable index bits) in bits 8-15 and
+ * the value in bits 16-31
+ */
+enum {
+	ENT_LIT,	/* value is a literal (or a code-length symbol) */
+	ENT_LIT2,	/* value is two literals, the first in bits 0-7 */
+	ENT_LEN,	/* value is the base match length */
+	ENT_DIST,	/* value is the base distance */
+	ENT_EOB,
+	ENT_SUB,	/* value is the index of the subtable */
+	ENT_INVALID,
+};
+
+#define ENT(bits, type, extra, val) \
+	((bits) | (type) << 4 | (extra) << 8 | (u32)(val) << 16)
+#define ENT_BITS(e)	((e) & 15)
+#define ENT_TYPE(e)	(((e) >> 4) & 15)
+#define ENT_EXTRA(e)	(((e) >> 8) & 255)
+#define ENT_VAL(e)	((e) >> 16)
+/* Number of literals in an entry, ENT_LIT and ENT_LIT2 must be 0 and 1 */
+#define ENT_NLITS(e)	(ENT_TYPE(e) + 1)
+#define ENT_IS_LIT(e)	(ENT_TYPE(e) <= ENT_LIT2)
+
+enum table_kind {
+	TAB_PRECODE,
+	TAB_LITLEN,
+	TAB_DIST,
+};
+
+static const u16 len_base[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+
+static const u8 len_extra[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+
+static const u16 dist_base[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289,
+	16385, 24577,
+};
+
+static const u8 dist_extra[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+
+static const u8 precode_order[PRECODE_SYMS] = {
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15,
+};
+
+/**
+ * struct inflate_tables - decode tables and scratch space
+ *
+ * @litlen:	literal/length table
+ * @dist:	distance table
+ * @precode:	code-length table of a dynamic block header
+ * @lens:	code lengths of the literal/length and distance codes
+ * @codes:	bit-reversed code of each symbol while building a table
+ * @subbits:	index bits of the subtable for each main-table prefix
+ */
+struct inflate_tables {
+	u32 litlen[LITLEN_ENOUGH];
+	u32 dist[DIST_ENOUGH];
+	u32 precode[1 << PRECODE_BITS];
+	u8 lens[LITLEN_SYMS + DIST_SYMS];
+	u16 codes[LITLEN_SYMS];
+	u8 subbits[1 << LITLEN_BITS];
+};
+
+static u32 sym_entry(enum table_kind kind, uint sym, uint bits)
+{
+	switch (kind) {
+	case TAB_LITLEN:
+		if (sym < 256)
+			return ENT(bits, ENT_LIT, 0, sym);
+		if (sym == 256)
+			return ENT(bits, ENT_EOB, 0, 0);
+		sym -= 257;
+		if (sym < ARRAY_SIZE(len_base))
+			return ENT(bits, ENT_LEN, len_extra[sym],
+				   len_base[sym]);
+		break;
+	case TAB_DIST:
+		if (sym < ARRAY_SIZE(dist_base))
+			return ENT(bits, ENT_DIST, dist_extra[sym],
+				   dist_base[sym]);
+		break;
+	case TAB_PRECODE:
+		return ENT(bits, ENT_LIT, 0, sym);
+	}
+
+	/* Symbols which may be coded but must not be used */
+	return ENT(bits, ENT_INVALID, 0, 0);
+}
+
+/**
+ * build_table() - build a decode table for a canonical Huffman code
+ *
+ * Codes of up to @tbits bits are replicated in the main table. Longer codes
+ * go into subtables, one for each main-table prefix, sized for the longest
+ * code with that prefix. For literal/length tables, entries for a literal
+ * whose code is short enough to be followed by a second literal within the
+ * main-table bits are then combined into a two-literal entry.
+ *
+ * @t:		tables, for scratch space
+ * @table:	table to fill
+ * @lens:	code length of each symbol, 0 if the symbol is not used
+ * @nsyms:	number of symbols
+ * @tbits:	number of bits indexing the main table
+ * @kind:	type of code, to decide the entry for each symbol
+ * Return:	0 if OK, -EINVAL if the code lengths are invalid
+ */
+static int build_table(struct inflate_tables *t, u32 *table, const u8 *lens,
+		       uint nsyms, uint tbits, enum table_kind kind)
+{
+	u16 count[MAX_CODE_LEN + 1] = {0}, next[MAX_CODE_LEN + 1];
+	uint mask = (1 << tbits) - 1;
+	uint sym, len, i, code, rev, pos, max = 0;
+	int left = 1;
+
+	for (sym = 0; sym < nsyms; sym++)
+		count[lens[sym]]++;
+	for (len = 1; len <= MAX_CODE_LEN; len++) {
+		left = (left << 1) - count[len];
+		if (left < 0)
+			return -EINVAL;
+		if (count[len])
+			max = len;
+	}
+	for (i = 0; i <= mask; i++)
+		table[i] = ENT(0, ENT_INVALID, 0, 0);
+	if (!max)
+		return 0;
+	/* As zlib, only allow an incomplete code if it has a single symbol */
+	if (left && (kind == TAB_PRECODE || max != 1))
+		return -EINVAL;
+
+	next[1] = 0;
+	for (len = 1; len < MAX_CODE_LEN; len++)
+		next[len + 1] = (next[len] + count[len]) << 1;
+
+	memset(t->subbits, '\0', mask + 1);
+	for (sym = 0; sym < nsyms; sym++) {
+		len = lens[sym];
+		if (!len)
+			continue;
+		code = next[len]++;
+		for (rev = 0, i = 0; i < len; i++, code >>= 1)
+			rev = rev << 1 | (code & 1);
+		t->codes[sym] = rev;
+		if (len > tbits)
+			t->subbits[rev & mask] = max(t->subbits[rev & mask],
+						     (u8)(len - tbits));
+	}
+
+	pos = mask + 1;
+	for (i = 0; i <= mask; i++) {
+		if (!t->subbits[i])
+			continue;
+		table[i] = ENT(tbits, ENT_SUB, t->subbits[i], pos);
+		for (code = 0; code < 1 << t->subbits[i]; code++)
+			table[pos++] = ENT(0, ENT_INVALID, 0, 0);
+	}
+
+	for (sym = 0; sym < nsyms; sym++) {
+		len = lens[sym];
+		if (!len)
+			continue;
+		rev = t->codes[sym];
+		if (len <= tbits) {
+			for (i = rev; i <= mask; i += 1 << len)
+				table[i] = sym_entry(kind, sym, len);
+		} else {
+			u32 sub = table[rev & mask];
+			u32 *st = table + ENT_VAL(sub);
+
+			len -= tbits;
+			for (i = rev >> tbits; i < 1 << ENT_EXTRA(sub);
+			     i += 1 << len)
+				st[i] = sym_entry(kind, sym, len);
+		}
+	}
+
+	/*
+	 * Pair up literals. The bits after a literal code of l bits are
+	 * (i >> l), so the second literal can be looked up in the main table
+	 * itself. Work downwards so that the entry looked up is not yet paired.
+	 */
+	if (kind == TAB_LITLEN) {
+		for (i = mask + 1; i--;) {
+			u32 e = table[i], e2;
+			uint l = ENT_BITS(e);
+
+			if (ENT_TYPE(e) != ENT_LIT || l >= tbits)
+				continue;
+			e2 = table[i >> l];
+			if (ENT_TYPE(e2) == ENT_LIT && ENT_BITS(e2) <= tbits - l)
+				table[i] = ENT(l + ENT_BITS(e2), ENT_LIT2, 0,
+					       ENT_VAL(e) | ENT_VAL(e2) << 8);
+		}
+	}
+
+	return 0;
+}
+
+static int build_fixed(struct inflate_tables *t)
+{
+	u8 *lens = t->lens;
+	int ret;
+
+	memset(lens, 8, 144);
+	memset(lens + 144, 9, 256 - 144);
+	memset(lens + 256, 7, 280 - 256);
+	memset(lens + 280, 8, LITLEN_SYMS - 280);
+	memset(lens + LITLEN_SYMS, 5, DIST_SYMS);
+	ret = build_table(t, t->litlen, lens, LITLEN_SYMS, LITLEN_BITS,
+			  TAB_LITLEN);
+	if (!ret)
+		ret = build_table(t, t->dist, lens + LITLEN_SYMS, DIST_SYMS,
+				  DIST_BITS, TAB_DIST);
+
+	return ret;
+}
+
+/* Bit-buffer helpers, which work on the local variables of inflate_fast_buf */
+#define BITMASK(n)	((1ULL << (n)) - 1)
+
+#define CONSUME(n) do {				\
+	bitbuf >>= (n);				\
+	bitcnt -= (n);				\
+} while (0)
+
+/*
+ * Fill the bit buffer to at least 56 bits. Near the end of the input, zero
+ * bytes are added instead; using any of these means the input is truncated.
+ */
+#define REFILL() do {						\
+	if (likely(in_end - in >= 8)) {				\
+		bitbuf |= get_unaligned_le64(in) << bitcnt;	\
+		in += (63 - bitcnt) >> 3;			\
+		bitcnt |= 56;					\
+	} else {						\
+		if (overrun && bitcnt < overrun * 8)		\
+			goto truncated;				\
+		for (; bitcnt < 56; bitcnt += 8) {		\
+			if (in < in_end)			\
+				bitbuf |= (u64)*in++ << bitcnt;	\
+			else					\
+				overrun++;			\
+		}						\
+	}							\
+} while (0)
+
+/* Look up a symbol, following a subtable entry if needed */
+#define DECODE(e, table, tbits) do {				\
+	(e) = (table)[bitbuf & BITMASK(tbits)];			\
+	if (ENT_TYPE(e) == ENT_SUB) {				\
+		CONSUME(tbits);					\
+		(e) = (table)[ENT_VAL(e) +			\
+			      (bitbuf & BITMASK(ENT_EXTRA(e)))];	\
+	}							\
+	CONSUME(ENT_BITS(e));					\
+} while (0)
+
+static int read_dynamic(struct inflate_tables *t, const u8 **inp,
+			const u8 *in_end, u64 *bitbufp, uint *bitcntp,
+			uint *overrunp)
+{
+	const u8 *in = *inp;
+	u64 bitbuf = *bitbufp;
+	uint bitcnt = *bitcntp, overrun = *overrunp;
+	uint nlit, ndist, nprecode, i, rep;
+	u8 prelens[PRECODE_SYMS] = {0};
+	u8 *lens = t->lens, val;
+	u32 e;
+
+	REFILL();
+	nlit = (bitbuf & 31) + 257;
+	ndist = ((bitbuf >> 5) & 31) + 1;
+	nprecode = ((bitbuf >> 10) & 15) + 4;
+	CONSUME(14);
+	if (nlit > 286 || ndist > 30)
+		return -EINVAL;
+
+	for (i = 0; i < nprecode; i++) {
+		REFILL();
+		prelens[precode_order[i]] = bitbuf & 7;
+		CONSUME(3);
+	}
+	if (build_table(t, t->precode, prelens, PRECODE_SYMS, PRECODE_BITS,
+			TAB_PRECODE))
+		return -EINVAL;
+
+	for (i = 0; i < nlit + ndist; i += rep) {
+		REFILL();
+		DECODE(e, t->precode, PRECODE_BITS);
+		if (ENT_TYPE(e) != ENT_LIT)
+			return -EINVAL;
+		switch (ENT_VAL(e)) {
+		case 16:
+			if (!i)
+				return -EINVAL;
+			val = lens[i - 1];
+			rep = 3 + (bitbuf & 3);
+			CONSUME(2);
+			break;
+		case 17:
+			val = 0;
+			rep = 3 + (bitbuf & 7);
+			CONSUME(3);
+			break;
+		case 18:
+			val = 0;
+			rep = 11 + (bitbuf & 127);
+			CONSUME(7);
+			break;
+		default:
+			val = ENT_VAL(e);
+			rep = 1;
+			break;
+		}
+		if (rep > nlit + ndist - i)
+			return -EINVAL;
+		memset(lens + i, val, rep);
+	}
+	if (!lens[256])
+		return -EINVAL;
+
+	*inp = in;
+	*bitbufp = bitbuf;
+	*bitcntp = bitcnt;
+	*overrunp = overrun;
+
+	/* The distance lengths must follow on from the literal/length ones */
+	if (build_table(t, t->litlen, lens, nlit, LITLEN_BITS, TAB_LITLEN) ||
+	    build_table(t, t->dist, lens + nlit, ndist, DIST_BITS, TAB_DIST))
+		return -EINVAL;
+
+	return 0;
+
+truncated:
+	return -EINVAL;
+}
+
+#define COPY8(d, s)	put_unaligned(get_unaligned((const u64 *)(s)), (u64 *)(d))
+
+/*
+ * Copy a match of @len bytes from @dist bytes back, with @len <= @room.
+ * Non-overlapping matches are copied in words, writing up to 15 bytes past
+ * the end of the match if @room allows.
+ */
+static inline void copy_match(u8 *out, uint dist, uint len, size_t room)
+{
+	const u8 *src = out - dist;
+	u8 *end = out + len;
+
+	if (likely(dist >= 8 && room >= len + 15)) {
+		COPY8(out, src);
+		COPY8(out + 8, src + 8);
+		for (out += 16, src += 16; out < end; out += 8, src += 8)
+			COPY8(out, src);
+	} else if (dist == 1 && room >= len + 7) {
+		u64 v = out[-1] * 0x0101010101010101ULL;
+
+		for (; out < end; out += 8)
+			put_unaligned(v, (u64 *)out);
+	} else {
+		while (out < end)
+			*out++ = *src++;
+	}
+}
+
+/* Decode tables, allocated on first use */
+static struct inflate_tables *tables;
+
+int inflate_fast_buf(void *dst, size_t dstlen, const void *src, size_t srclen,
+		     size_t *outlenp, size_t *inlenp, u32 *crcp)
+{
+	const u8 *in = src, *in_end;
+	u8 *out = dst, *out_end, *blk;
+	struct inflate_tables *t;
+	uint bitcnt = 0, overrun = 0, final, len, dist;
+	bool fixed = false;
+	u64 bitbuf = 0;
+	u32 e;
+
+	/* Callers may pass a huge length to mean 'no limit' */
+	in_end = in + min_t(size_t, srclen, (uintptr_t)-1 - (uintptr_t)in);
+	out_end = out + min_t(size_t, dstlen, (uintptr_t)-1 - (uintptr_t)out);
+
+	/*
+	 * The tables are rebuilt for each block, so keep them for the next
+	 * call rather than allocating them every time
+	 */
+	if (!tables) {
+		tables = malloc(sizeof(*tables));
+		if (!tables)
+			return -ENOMEM;
+	}
+	t = tables;
+
+	do {
+		/* Keep the watchdog and cyclic functions going, as zlib does */
+		schedule();
+		REFILL();
+		final = bitbuf & 1;
+		len = (bitbuf >> 1) & 3;
+		CONSUME(3);
+		blk = out;
+
+		if (len == 0) {
+			/* Stored block: return the whole bytes to the input */
+			CONSUME(bitcnt & 7);
+			if (bitcnt < overrun * 8)
+				goto truncated;
+			in -= (bitcnt >> 3) - overrun;
+			bitbuf = 0;
+			bitcnt = 0;
+			overrun = 0;
+			if (in_end - in < 4)
+				goto truncated;
+			len = get_unaligned_le16(in);
+			if (len != (u16)~get_unaligned_le16(in + 2))
+				goto corrupt;
+			in += 4;
+			if (len > in_end - in)
+				goto truncated;
+			if (len > out_end - out)
+				goto nospace;
+			memcpy(out, in, len);
+			in += len;
+			out += len;
+			goto block_done;
+		} else if (len == 1) {
+			if (!fixed && build_fixed(t))
+				goto corrupt;
+			fixed = true;
+		} else if (len == 2) {
+			fixed = false;
+			if (read_dynamic(t, &in, in_end, &bitbuf, &bitcnt,
+					 &overrun))
+				goto corrupt;
+		} else {
+			goto corrupt;
+		}
+
+		for (;;) {
+			REFILL();
+			DECODE(e, t->litlen, LITLEN_BITS);
+			if (likely(out_end - out >= OUT_MARGIN)) {
+				/*
+				 * After a literal there are still enough bits
+				 * for another literal/length code
+				 */
+				while (ENT_IS_LIT(e)) {
+					out[0] = ENT_VAL(e);
+					out[1] = ENT_VAL(e) >> 8;
+					out += ENT_NLITS(e);
+					if (bitcnt < MAX_CODE_LEN)
+						break;
+					DECODE(e, t->litlen, LITLEN_BITS);
+				}
+				if (ENT_IS_LIT(e))
+					continue;
+				REFILL();
+			} else if (ENT_TYPE(e) == ENT_LIT2) {
+				if (out_end - out < 2)
+					goto nospace;
+				out[0] = ENT_VAL(e);
+				out[1] = ENT_VAL(e) >> 8;
+				out += 2;
+				continue;
+			} else if (ENT_TYPE(e) == ENT_LIT) {
+				if (out == out_end)
+					goto nospace;
+				*out++ = ENT_VAL(e);
+				continue;
+			}
+			if (ENT_TYPE(e) == ENT_EOB)
+				break;
+			if (ENT_TYPE(e) != ENT_LEN)
+				goto corrupt;
+			len = ENT_VAL(e) + (bitbuf & BITMASK(ENT_EXTRA(e)));
+			CONSUME(ENT_EXTRA(e));
+
+			DECODE(e, t->dist, DIST_BITS);
+			if (ENT_TYPE(e) != ENT_DIST)
+				goto corrupt;
+			dist = ENT_VAL(e) + (bitbuf & BITMASK(ENT_EXTRA(e)));
+			CONSUME(ENT_EXTRA(e));
+			if (dist > out - (u8 *)dst)
+				goto corrupt;
+			if (len > out_end - out)
+				goto nospace;
+			copy_match(out, dist, len, out_end - out);
+			out += len;
+		}
+block_done:
+		/* Fold the CRC in while the block is still in the cache */
+		if (CONFIG_IS_ENABLED(CRC32) && crcp)
+			*crcp = crc32(*crcp, blk, out - blk);
+	} while (!final);
+
+	if (bitcnt < overrun * 8)
+		goto truncated;
+	*outlenp = out - (u8 *)dst;
+	*inlenp = in - (u8 *)src - ((bitcnt >> 3) - overrun);
+
+	return 0;
+
+nospace:
+	return -ENOSPC;
+truncated:
+corrupt:
+	return -EINVAL;
+}
@@ -17,10 +17,17 @@
 #include <malloc.h>
 #include <dm/of_access.h>
 #include <linux/err.h>
+#include <linux/log2.h>
 #include <linux/sizes.h>
+#include <asm/global_data.h>
+
+DECLARE_GLOBAL_DATA_PTR;
 
 enum {
 	BUF_STEP	= SZ_64K,
+
+	/* Minimum number of properties for a node to get a hash table */
+	PROP_HASH_MIN	= 8,
 };
 
 static void *unflatten_dt_alloc(void **mem, unsigned long size,
@@ -35,6 +42,64 @@ static void *unflatten_dt_alloc(void **mem, unsigned long size,
 	return res;
 }
 
+#if IS_ENABLED(CONFIG_OF_LIVE_PROP_HASH)
+/**
+ * unflatten_prop_hash() - Alloc and populate the property hash of a node
+ *
+ * Nodes with only a few properties are left without a table, since a list
+ * search is just as quick for them.
+ *
+ * @np: Node whose properties have been set up (ignored if @dryrun)
+ * @mem: Memory chunk to use for allocating the table
+ * @nprops: Number of properties in the node
+ * @dryrun: If true, only calculate the memory needed
+ * Return: updated @mem
+ */
+static void *unflatten_prop_hash(struct device_node *np, void *mem,
+				 int nprops, bool dryrun)
+{
+	struct of_prop_hash *ph;
+	struct property *pp;
+	uint slots;
+
+	if (nprops < PROP_HASH_MIN)
+		return mem;
+
+	slots = roundup_pow_of_two(nprops * 2);
+	ph = unflatten_dt_alloc(&mem, sizeof(*ph) + slots * sizeof(ph->slot[0]),
+				__alignof__(struct of_prop_hash));
+	if (dryrun)
+		return mem;
+
+	ph->mask = slots - 1;
+	for (pp = np->properties; pp; pp = pp->next) {
+		u32 hash = of_prop_name_hash(pp->name);
+		uint i;
+
+		for (i = hash & ph->mask; ph->slot[i].pp;
+		     i = (i + 1) & ph->mask) {
+			if (ph->slot[i].hash == hash &&
+			    !strcmp(ph->slot[i].pp->name, pp->name))
+				break;
+		}
+		/* keep the first property of a given name */
+		if (!ph->slot[i].pp) {
+			ph->slot[i].hash = hash;
+			ph->slot[i].pp = pp;
+		}
+	}
+	np->prop_hash = ph;
+
+	return mem;
+}
+#else
+static void *unflatten_prop_hash(struct device_node *np, void *mem,
+				 int nprops, bool dryrun)
+{
+	return mem;
+}
+#endif
+
 /**
  * unflatten_dt_node() - Alloc and populate a device_node from the flat tree
  * @blob: The parent device tree blob
@@ -62,6 +127,7 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 	int offset;
 	int has_name = 0;
 	int new_format = 0;
+	int nprops = 0;
 
 	pathp = fdt_get_name(blob, *poffset, &l);
 	if (!pathp)
@@ -154,6 +220,7 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 			has_name = 1;
 		pp = unflatten_dt_alloc(&mem, sizeof(struct property),
 					__alignof__(struct property));
+		nprops++;
 		if (!dryrun) {
 			/*
 			 * We accept flattened tree phandles either in
@@ -199,6 +266,7 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 		sz = (pa - ps) + 1;
 		pp = unflatten_dt_alloc(&mem, sizeof(struct property) + sz,
 					__alignof__(struct property));
+		nprops++;
 		if (!dryrun) {
 			pp->name = "name";
 			pp->length = sz;
@@ -211,8 +279,10 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 			      (char *)pp->value);
 		}
 	}
-	if (!dryrun) {
+	if (!dryrun)
 		*prev_pp = NULL;
+	mem = unflatten_prop_hash(np, mem, nprops, dryrun);
+	if (!dryrun) {
 		if (!has_name)
 			np->name = of_get_property(np, "name", NULL);
 		np->type = of_get_property(np, "device_type", NULL);
@@ -333,6 +403,15 @@ int of_live_build(const void *fdt_blob, struct device_node **rootp)
 		debug("Failed to scan live tree aliases: err=%d\n", ret);
 		return ret;
 	}
+	/* only the control tree is looked up often enough to need a table */
+	if (IS_ENABLED(CONFIG_OF_LIVE_PHANDLE_TABLE) &&
+	    rootp == gd_of_root_ptr()) {
+		ret = of_phandle_table_build(*rootp);
+		if (ret) {
+			debug("Failed to build phandle table: err=%d\n", ret);
+			return ret;
+		}
+	}
 	debug("%s: stop\n", __func__);
 
 	return ret;
@@ -340,6 +419,8 @@ int of_live_build(const void *fdt_blob, struct device_node **rootp)
 
 void of_live_free(struct device_node *root)
 {
+	if (IS_ENABLED(CONFIG_OF_LIVE_PHANDLE_TABLE))
+		of_phandle_table_free(root);
 	/* the tree is stored as a contiguous block of memory */
 	free(root);
 }
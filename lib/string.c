@@ -20,8 +20,47 @@
 #include <linux/types.h>
 #include <linux/string.h>
 #include <linux/ctype.h>
+#include <linux/kernel.h>
 #include <malloc.h>
 
+/*
+ * With CONFIG_STRING_WORD_AT_A_TIME the functions below handle a word at a
+ * time once their pointers are word-aligned. Aligned loads never cross a page
+ * boundary, so reading beyond the end of a string in this way is safe. Some
+ * architectures (e.g. arm64 with the MMU off) cannot do unaligned loads, so
+ * two pointers are only handled a word at a time if they have the same
+ * alignment.
+ */
+#define WORD_SIZE	sizeof(ulong)
+
+static inline bool word_aligned(const void *p)
+{
+	return !((ulong)p & (WORD_SIZE - 1));
+}
+
+static inline bool words_coaligned(const void *p, const void *q)
+{
+	return word_aligned((void *)((ulong)p ^ (ulong)q));
+}
+
+/* Return a word with the top bit of each zero byte of @v set */
+static inline ulong word_zero_bytes(ulong v)
+{
+	const ulong low7 = REPEAT_BYTE(0x7f);
+
+	return ~(((v & low7) + low7) | v | low7);
+}
+
+/* Return the memory-order index of the first byte flagged in @mask */
+static inline uint word_first_byte(ulong mask)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	return __builtin_ctzl(mask) / 8;
+#else
+	return __builtin_clzl(mask) / 8;
+#endif
+}
+
 /**
  * strncasecmp - Case insensitive, length-limited string comparison
  * @s1: One string
@@ -209,6 +248,21 @@ int strcmp(const char *cs, const char *ct)
 {
 	int ret;
 
+	if (CONFIG_IS_ENABLED(STRING_WORD_AT_A_TIME) &&
+	    words_coaligned(cs, ct)) {
+		for (; !word_aligned(cs); cs++, ct++) {
+			ret = (unsigned char)*cs - (unsigned char)*ct;
+			if (ret || !*ct)
+				return ret;
+		}
+		/* skip equal words, the loop below finds the end or mismatch */
+		while (*(const ulong *)cs == *(const ulong *)ct &&
+		       !word_zero_bytes(*(const ulong *)cs)) {
+			cs += WORD_SIZE;
+			ct += WORD_SIZE;
+		}
+	}
+
 	while (1) {
 		unsigned char a = *cs++;
 		unsigned char b = *ct++;
@@ -233,6 +287,23 @@ int strncmp(const char *cs, const char *ct, size_t count)
 {
 	int ret = 0;
 
+	if (CONFIG_IS_ENABLED(STRING_WORD_AT_A_TIME) &&
+	    words_coaligned(cs, ct)) {
+		for (; count && !word_aligned(cs); cs++, ct++, count--) {
+			ret = (unsigned char)*cs - (unsigned char)*ct;
+			if (ret || !*ct)
+				return ret;
+		}
+		/* skip equal words, the loop below finds the end or mismatch */
+		while (count >= WORD_SIZE &&
+		       *(const ulong *)cs == *(const ulong *)ct &&
+		       !word_zero_bytes(*(const ulong *)cs)) {
+			cs += WORD_SIZE;
+			ct += WORD_SIZE;
+			count -= WORD_SIZE;
+		}
+	}
+
 	while (count--) {
 		unsigned char a = *cs++;
 		unsigned char b = *ct++;
@@ -293,9 +364,22 @@ char * strrchr(const char * s, int c)
  */
 size_t strlen(const char * s)
 {
-	const char *sc;
+	const char *sc = s;
+
+	if (CONFIG_IS_ENABLED(STRING_WORD_AT_A_TIME)) {
+		const ulong *w;
+		ulong zero;
+
+		for (; !word_aligned(sc); ++sc) {
+			if (*sc == '\0')
+				return sc - s;
+		}
+		for (w = (const ulong *)sc; !(zero = word_zero_bytes(*w)); w++)
+			;
+		return (const char *)w + word_first_byte(zero) - s;
+	}
 
-	for (sc = s; *sc != '\0'; ++sc)
+	for (; *sc != '\0'; ++sc)
 		/* nothing */;
 	return sc - s;
 }
@@ -309,9 +393,22 @@ size_t strlen(const char * s)
  */
 size_t strnlen(const char * s, size_t count)
 {
-	const char *sc;
+	const char *sc = s;
+
+	if (CONFIG_IS_ENABLED(STRING_WORD_AT_A_TIME)) {
+		for (; count && !word_aligned(sc); ++sc, count--) {
+			if (*sc == '\0')
+				return sc - s;
+		}
+		for (; count >= WORD_SIZE; sc += WORD_SIZE, count -= WORD_SIZE) {
+			ulong zero = word_zero_bytes(*(const ulong *)sc);
+
+			if (zero)
+				return sc + word_first_byte(zero) - s;
+		}
+	}
 
-	for (sc = s; count-- && *sc != '\0'; ++sc)
+	for (; count-- && *sc != '\0'; ++sc)
 		/* nothing */;
 	return sc - s;
 }
@@ -610,10 +707,32 @@ __used void * memmove(void * dest,const void *src,size_t count)
 	 * No issue today because memcpy is doing a forward-copying in lib/string.c and for ARM32
 	 * architecture; no other arches use __HAVE_ARCH_MEMCPY without __HAVE_ARCH_MEMMOVE.
 	 */
-		memcpy(dest, src, count);
+		tmp = dest;
+		s = (char *)src;
+		/*
+		 * copy bytes forwards until the pointers are aligned, so that
+		 * memcpy() can copy the rest a word at a time
+		 */
+		if (CONFIG_IS_ENABLED(STRING_WORD_AT_A_TIME) &&
+		    words_coaligned(tmp, s)) {
+			for (; count && !word_aligned(tmp); count--)
+				*tmp++ = *s++;
+		}
+		memcpy(tmp, s, count);
 	} else {
 		tmp = (char *) dest + count;
 		s = (char *) src + count;
+		/* copy backwards, a word at a time if the alignment allows */
+		if (CONFIG_IS_ENABLED(STRING_WORD_AT_A_TIME) &&
+		    words_coaligned(tmp, s)) {
+			for (; count && !word_aligned(tmp); count--)
+				*--tmp = *--s;
+			for (; count >= WORD_SIZE; count -= WORD_SIZE) {
+				tmp -= WORD_SIZE;
+				s -= WORD_SIZE;
+				*(ulong *)tmp = *(ulong *)s;
+			}
+		}
 		while (count--)
 			*--tmp = *--s;
 		}
@@ -631,10 +750,26 @@ __used void * memmove(void * dest,const void *src,size_t count)
  */
 __used int memcmp(const void * cs,const void * ct,size_t count)
 {
-	const unsigned char *su1, *su2;
+	const unsigned char *su1 = cs, *su2 = ct;
 	int res = 0;
 
-	for( su1 = cs, su2 = ct; 0 < count; ++su1, ++su2, count--)
+	if (CONFIG_IS_ENABLED(STRING_WORD_AT_A_TIME) &&
+	    words_coaligned(su1, su2)) {
+		for (; count && !word_aligned(su1); ++su1, ++su2, count--) {
+			res = *su1 - *su2;
+			if (res)
+				return res;
+		}
+		/* skip equal words, the loop below finds the mismatch */
+		while (count >= WORD_SIZE &&
+		       *(const ulong *)su1 == *(const ulong *)su2) {
+			su1 += WORD_SIZE;
+			su2 += WORD_SIZE;
+			count -= WORD_SIZE;
+		}
+	}
+
+	for (; 0 < count; ++su1, ++su2, count--)
 		if ((res = *su1 - *su2) != 0)
 			break;
 	return res;
@@ -715,6 +850,23 @@ char * strstr(const char * s1,const char * s2)
 void *memchr(const void *s, int c, size_t n)
 {
 	const unsigned char *p = s;
+
+	if (CONFIG_IS_ENABLED(STRING_WORD_AT_A_TIME)) {
+		const ulong pattern = REPEAT_BYTE((unsigned char)c);
+
+		for (; n && !word_aligned(p); ++p, n--) {
+			if ((unsigned char)c == *p)
+				return (void *)p;
+		}
+		for (; n >= WORD_SIZE; p += WORD_SIZE, n -= WORD_SIZE) {
+			ulong match;
+
+			match = word_zero_bytes(*(const ulong *)p ^ pattern);
+			if (match)
+				return (void *)p + word_first_byte(match);
+		}
+	}
+
 	while (n-- != 0) {
 		if ((unsigned char)c == *p++) {
 			return (void *)(p-1);
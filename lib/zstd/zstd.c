@@ -6,56 +6,248 @@
 #define LOG_CATEGORY	LOGC_BOOT
 
 #include <abuf.h>
+#include <cyclic.h>
 #include <log.h>
 #include <malloc.h>
+#include <asm/unaligned.h>
+#include <linux/bitops.h>
 #include <linux/errno.h>
 #include <linux/zstd.h>
 
-int zstd_decompress(struct abuf *in, struct abuf *out)
+/* Seekable format, see contrib/seekable_format in the zstd sources */
+#define ZSTD_SEEK_TABLE_MAGIC	0x184d2a5e
+#define ZSTD_SEEKABLE_MAGIC	0x8f92eab1
+#define ZSTD_SEEK_FOOTER_SIZE	9
+#define ZSTD_SEEK_CHECKSUM	BIT(7)
+#define ZSTD_SEEK_RESERVED	0x7c
+
+/**
+ * struct zstd_seek_table - seek table of a seekable zstd archive
+ *
+ * @entries: first entry, each holding the compressed and decompressed size
+ *	of a frame, followed by a checksum if @entry_size is 12
+ * @count: number of entries
+ * @entry_size: size of each entry in bytes
+ * @frames_size: size of the frames covered by the table, i.e. the offset of
+ *	the skippable frame holding the table
+ */
+struct zstd_seek_table {
+	const u8 *entries;
+	uint count;
+	uint entry_size;
+	size_t frames_size;
+};
+
+int zstd_workspace_init(struct zstd_workspace *ws)
 {
-	zstd_dctx *ctx;
-	size_t wsize, len;
-	void *workspace;
-	int ret;
+	size_t wsize;
+
+	if (ws->dctx)
+		return 0;
 
 	wsize = zstd_dctx_workspace_bound();
-	workspace = malloc(wsize);
-	if (!workspace) {
+	ws->buf = malloc(wsize);
+	if (!ws->buf) {
 		debug("%s: cannot allocate workspace of size %zu\n", __func__,
-			wsize);
+		      wsize);
 		return -ENOMEM;
 	}
 
-	ctx = zstd_init_dctx(workspace, wsize);
-	if (!ctx) {
+	ws->dctx = zstd_init_dctx(ws->buf, wsize);
+	if (!ws->dctx) {
 		log_err("%s: zstd_init_dctx() failed\n", __func__);
-		ret = -EPERM;
-		goto do_free;
+		zstd_workspace_uninit(ws);
+		return -EPERM;
+	}
+
+	return 0;
+}
+
+void zstd_workspace_uninit(struct zstd_workspace *ws)
+{
+	free(ws->buf);
+	ws->buf = NULL;
+	ws->dctx = NULL;
+}
+
+/**
+ * zstd_find_seek_table() - find the seek table at the end of the input
+ *
+ * @src: compressed data
+ * @len: length of the compressed data
+ * @table: returns the seek table
+ * Return: 0 if found, -ENOENT if there is none, -EINVAL if it is corrupt
+ */
+static int zstd_find_seek_table(const u8 *src, size_t len,
+				struct zstd_seek_table *table)
+{
+	const u8 *footer;
+	size_t size;
+	u8 desc;
+
+	if (len < ZSTD_SKIPPABLEHEADERSIZE + ZSTD_SEEK_FOOTER_SIZE)
+		return -ENOENT;
+	footer = src + len - ZSTD_SEEK_FOOTER_SIZE;
+	if (get_unaligned_le32(footer + 5) != ZSTD_SEEKABLE_MAGIC)
+		return -ENOENT;
+
+	desc = footer[4];
+	if (desc & ZSTD_SEEK_RESERVED)
+		return -EINVAL;
+	table->count = get_unaligned_le32(footer);
+	table->entry_size = desc & ZSTD_SEEK_CHECKSUM ? 12 : 8;
+
+	/* The table is a skippable frame ending with the footer */
+	size = (size_t)table->count * table->entry_size + ZSTD_SEEK_FOOTER_SIZE;
+	if (size > len - ZSTD_SKIPPABLEHEADERSIZE)
+		return -EINVAL;
+	table->frames_size = len - ZSTD_SKIPPABLEHEADERSIZE - size;
+	table->entries = src + table->frames_size + ZSTD_SKIPPABLEHEADERSIZE;
+	if (get_unaligned_le32(src + table->frames_size) !=
+	    ZSTD_SEEK_TABLE_MAGIC ||
+	    get_unaligned_le32(src + table->frames_size + 4) != size)
+		return -EINVAL;
+
+	return 0;
+}
+
+/**
+ * zstd_decompress_frame() - decompress a single zstd or skippable frame
+ *
+ * @dctx: decompression context
+ * @src: frame to decompress
+ * @len: length of the frame
+ * @dst: destination for the decompressed data
+ * @avail: space available at @dst
+ * Return: number of bytes written to @dst, or -ve on error
+ */
+static long zstd_decompress_frame(zstd_dctx *dctx, const u8 *src, size_t len,
+				  u8 *dst, size_t avail)
+{
+	size_t ret;
+
+	if (len >= 4 && (get_unaligned_le32(src) & ZSTD_MAGIC_SKIPPABLE_MASK) ==
+	    ZSTD_MAGIC_SKIPPABLE_START)
+		return 0;
+
+	ret = zstd_decompress_dctx(dctx, dst, avail, src, len);
+	if (zstd_is_error(ret)) {
+		log_err("%s: failed to decompress: %d\n", __func__,
+			zstd_get_error_code(ret));
+		if (zstd_get_error_code(ret) == ZSTD_error_dstSize_tooSmall)
+			return -ENOSPC;
+		return -EINVAL;
+	}
+
+	return ret;
+}
+
+/* Decompress the frames listed in a seek table */
+static long zstd_decompress_seekable(zstd_dctx *dctx, const u8 *src,
+				     const struct zstd_seek_table *table,
+				     u8 *dst, size_t avail)
+{
+	size_t in_len, out_len, in_total = 0, out_total = 0;
+	const u8 *entry;
+	long ret;
+	uint i;
+
+	/* Check that the table describes the input and fits the output */
+	for (i = 0, entry = table->entries; i < table->count;
+	     i++, entry += table->entry_size) {
+		in_total += get_unaligned_le32(entry);
+		out_total += get_unaligned_le32(entry + 4);
+	}
+	if (in_total != table->frames_size) {
+		log_err("%s: seek table does not match the frames\n", __func__);
+		return -EINVAL;
+	}
+	if (out_total > avail)
+		return -ENOSPC;
+
+	out_total = 0;
+	for (i = 0, entry = table->entries; i < table->count;
+	     i++, entry += table->entry_size) {
+		in_len = get_unaligned_le32(entry);
+		out_len = get_unaligned_le32(entry + 4);
+		ret = zstd_decompress_frame(dctx, src, in_len, dst + out_total,
+					    out_len);
+		if (ret < 0)
+			return ret;
+		if (ret != out_len) {
+			log_err("%s: frame %u has %ld bytes, expected %zu\n",
+				__func__, i, ret, out_len);
+			return -EINVAL;
+		}
+		src += in_len;
+		out_total += out_len;
+		schedule();
+	}
+
+	return out_total;
+}
+
+int zstd_decompress_ws(struct zstd_workspace *ws, struct abuf *in,
+		       struct abuf *out)
+{
+	const u8 *src = abuf_data(in), *end = src + abuf_size(in);
+	struct zstd_seek_table table;
+	size_t len, total = 0;
+	u32 magic;
+	long ret;
+
+	ret = zstd_find_seek_table(src, abuf_size(in), &table);
+	if (!ret)
+		return zstd_decompress_seekable(ws->dctx, src, &table,
+						abuf_data(out), abuf_size(out));
+	if (ret != -ENOENT) {
+		log_err("%s: corrupt seek table\n", __func__);
+		return ret;
 	}
 
 	/*
-	 * Find out how large the frame actually is, there may be junk at
-	 * the end of the frame that zstd_decompress_dctx() can't handle.
+	 * Decompress the frames one by one. Anything after the last frame
+	 * which is not a frame is ignored, as zstd_decompress_dctx() cannot
+	 * handle junk at the end.
 	 */
-	len = zstd_find_frame_compressed_size(abuf_data(in), abuf_size(in));
-	if (zstd_is_error(len)) {
-		log_err("%s: failed to detect compressed size: %d\n", __func__,
-			zstd_get_error_code(len));
-		ret = -EINVAL;
-		goto do_free;
-	}
+	while (src < end) {
+		magic = end - src >= 4 ? get_unaligned_le32(src) : 0;
+		if (src != abuf_data(in) && magic != ZSTD_MAGICNUMBER &&
+		    (magic & ZSTD_MAGIC_SKIPPABLE_MASK) !=
+		    ZSTD_MAGIC_SKIPPABLE_START)
+			break;
 
-	len = zstd_decompress_dctx(ctx, abuf_data(out), abuf_size(out),
-				   abuf_data(in), len);
-	if (zstd_is_error(len)) {
-		log_err("%s: failed to decompress: %d\n", __func__,
-			zstd_get_error_code(len));
-		ret = -EINVAL;
-		goto do_free;
+		len = zstd_find_frame_compressed_size(src, end - src);
+		if (zstd_is_error(len)) {
+			log_err("%s: failed to detect compressed size: %d\n",
+				__func__, zstd_get_error_code(len));
+			return -EINVAL;
+		}
+
+		ret = zstd_decompress_frame(ws->dctx, src, len,
+					    abuf_data(out) + total,
+					    abuf_size(out) - total);
+		if (ret < 0)
+			return ret;
+		src += len;
+		total += ret;
+		schedule();
 	}
 
-	ret = len;
-do_free:
-	free(workspace);
+	return total;
+}
+
+int zstd_decompress(struct abuf *in, struct abuf *out)
+{
+	struct zstd_workspace ws = {};
+	int ret;
+
+	ret = zstd_workspace_init(&ws);
+	if (ret)
+		return ret;
+
+	ret = zstd_decompress_ws(&ws, in, out);
+	zstd_workspace_uninit(&ws);
+
 	return ret;
 }
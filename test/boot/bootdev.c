@@ -10,8 +10,13 @@
 #include <dm.h>
 #include <bootdev.h>
 #include <bootflow.h>
+#include <console.h>
+#include <cyclic.h>
 #include <mapmem.h>
 #include <os.h>
+#include <time.h>
+#include <usb.h>
+#include <dm/uclass-internal.h>
 #include <test/suites.h>
 #include <test/ut.h>
 #include "bootstd_common.h"
@@ -379,6 +384,238 @@ static int bootdev_test_hunter(struct unit_test_state *uts)
 }
 BOOTSTD_TEST(bootdev_test_hunter, UTF_DM | UTF_SCAN_FDT | UTF_CONSOLE);
 
+/* Number of steps before the slow hunter starts enumerating its bus */
+static int slow_hunt_left;
+
+/* Hunter step which simulates a bus which is slow to come up */
+static int slow_hunter_step(struct bootdev_hunter *info, bool show,
+			    bool background)
+{
+	if (slow_hunt_left > 0) {
+		slow_hunt_left--;
+		return -EAGAIN;
+	}
+
+	return info->hunt(info, show);
+}
+
+/* Run cyclic functions until a hunter stops running in the background */
+static void wait_for_hunter(struct bootstd_priv *std, uint seq)
+{
+	ulong start = get_timer(0);
+
+	while ((std->hunters_active & BIT(seq)) && get_timer(start) < 1000)
+		schedule();
+}
+
+static int check_hunt_background(struct unit_test_state *uts)
+{
+	struct bootflow_iter iter;
+	struct bootstd_priv *std;
+	struct bootflow bflow;
+	ulong start;
+
+	ut_assertok(bootstd_get_priv(&std));
+	ut_assertok(bootstd_test_drop_bootdev_order(uts));
+
+	/* USB is the only hunter which can run in the background */
+	slow_hunt_left = INT_MAX;
+	ut_assertok(run_command("bootdev hunt -b", 0));
+	ut_assert_console_end();
+	ut_asserteq(BIT(USB_HUNTER), std->hunters_active);
+	ut_asserteq(0, std->hunters_used);
+
+	/* Time passes, but the bus is not ready */
+	start = get_timer(0);
+	while (slow_hunt_left > INT_MAX - 3 && get_timer(start) < 1000)
+		schedule();
+	ut_assert(slow_hunt_left <= INT_MAX - 3);
+	ut_asserteq(BIT(USB_HUNTER), std->hunters_active);
+
+	/* A bootflow on MMC is found without waiting for USB */
+	ut_assertok(bootflow_scan_first(NULL, NULL, &iter, BOOTFLOWIF_HUNT,
+					&bflow));
+	ut_asserteq_str("mmc1.bootdev", bflow.dev->name);
+	ut_asserteq(BIT(MMC_HUNTER) | BIT(1), std->hunters_used);
+	ut_asserteq(BIT(USB_HUNTER), std->hunters_active);
+	bootflow_iter_uninit(&iter);
+	console_record_reset();
+
+	/* Once the bus is ready, the hunter finishes in the background */
+	slow_hunt_left = 0;
+	wait_for_hunter(std, USB_HUNTER);
+	ut_assert_nextline(
+		"Bus usb@1: scanning bus usb@1 for devices... 5 USB Device(s) found");
+	ut_assert_console_end();
+	ut_asserteq(0, std->hunters_active);
+	ut_asserteq(BIT(MMC_HUNTER) | BIT(1) | BIT(USB_HUNTER),
+		    std->hunters_used);
+
+	/* ...so it is not needed again */
+	ut_assertok(bootdev_hunt("usb1", false));
+	ut_assert_console_end();
+
+	return 0;
+}
+
+/* Check hunting for bootdevs in the background */
+static int bootdev_test_hunt_background(struct unit_test_state *uts)
+{
+	struct bootdev_hunter *usb = BOOTDEV_HUNTER_GET(usb_bootdev_hunter);
+	bootdev_hunter_step_func old_step = usb->step;
+	int ret;
+
+	bootstd_reset_usb();
+	test_set_skip_delays(true);
+	usb->step = slow_hunter_step;
+	ret = check_hunt_background(uts);
+	usb->step = old_step;
+
+	return ret;
+}
+BOOTSTD_TEST(bootdev_test_hunt_background, UTF_DM | UTF_SCAN_FDT |
+	     UTF_CONSOLE);
+
+static int check_hunt_background_wait(struct unit_test_state *uts)
+{
+	struct bootstd_priv *std;
+	ulong start;
+
+	ut_assertok(bootstd_get_priv(&std));
+
+	slow_hunt_left = INT_MAX;
+	ut_assertok(bootdev_hunt_start());
+	ut_asserteq(BIT(USB_HUNTER), std->hunters_active);
+
+	/* Hunting for USB takes over from the background */
+	slow_hunt_left = 10;
+	ut_assertok(bootdev_hunt("usb", false));
+	ut_assert_nextline(
+		"Bus usb@1: scanning bus usb@1 for devices... 5 USB Device(s) found");
+	ut_assert_console_end();
+	ut_asserteq(0, slow_hunt_left);
+	ut_asserteq(0, std->hunters_active);
+	ut_assert(std->hunters_used & BIT(USB_HUNTER));
+
+	/* Nothing is left running in the background */
+	slow_hunt_left = 10;
+	start = get_timer(0);
+	while (get_timer(start) < 5)
+		schedule();
+	ut_asserteq(10, slow_hunt_left);
+
+	return 0;
+}
+
+/* Check that a hunter running in the background is finished when needed */
+static int bootdev_test_hunt_background_wait(struct unit_test_state *uts)
+{
+	struct bootdev_hunter *usb = BOOTDEV_HUNTER_GET(usb_bootdev_hunter);
+	bootdev_hunter_step_func old_step = usb->step;
+	int ret;
+
+	bootstd_reset_usb();
+	test_set_skip_delays(true);
+	usb->step = slow_hunter_step;
+	ret = check_hunt_background_wait(uts);
+	usb->step = old_step;
+
+	return ret;
+}
+BOOTSTD_TEST(bootdev_test_hunt_background_wait, UTF_DM | UTF_SCAN_FDT |
+	     UTF_CONSOLE);
+
+static int check_hunt_background_stop(struct unit_test_state *uts)
+{
+	struct bootstd_priv *std;
+	ulong start;
+
+	ut_assertok(bootstd_get_priv(&std));
+
+	slow_hunt_left = 10;
+	ut_assertok(bootdev_hunt_start());
+	ut_asserteq(BIT(USB_HUNTER), std->hunters_active);
+
+	/* Stopping leaves the hunter unused and it makes no more progress */
+	bootdev_hunt_stop_all();
+	ut_asserteq(0, std->hunters_active);
+	ut_assert(!(std->hunters_used & BIT(USB_HUNTER)));
+	start = get_timer(0);
+	while (get_timer(start) < 5)
+		schedule();
+	ut_asserteq(10, slow_hunt_left);
+
+	/* It can still be used later */
+	ut_assertok(bootdev_hunt("usb", false));
+	ut_assert_nextline(
+		"Bus usb@1: scanning bus usb@1 for devices... 5 USB Device(s) found");
+	ut_assert_console_end();
+	ut_asserteq(0, slow_hunt_left);
+
+	return 0;
+}
+
+/* Check that hunters running in the background can be stopped, e.g. to boot */
+static int bootdev_test_hunt_background_stop(struct unit_test_state *uts)
+{
+	struct bootdev_hunter *usb = BOOTDEV_HUNTER_GET(usb_bootdev_hunter);
+	bootdev_hunter_step_func old_step = usb->step;
+	int ret;
+
+	bootstd_reset_usb();
+	test_set_skip_delays(true);
+	usb->step = slow_hunter_step;
+	ret = check_hunt_background_stop(uts);
+	usb->step = old_step;
+
+	return ret;
+}
+BOOTSTD_TEST(bootdev_test_hunt_background_stop, UTF_DM | UTF_SCAN_FDT |
+	     UTF_CONSOLE);
+
+/* Check that the USB hunter itself can enumerate its bus in the background */
+static int bootdev_test_hunt_background_usb(struct unit_test_state *uts)
+{
+	struct bootstd_priv *std;
+	struct udevice *dev;
+	ulong start;
+
+	if (!CONFIG_IS_ENABLED(USB_ASYNC_SCAN))
+		return -EAGAIN;
+
+	ut_assertok(bootstd_get_priv(&std));
+	bootstd_reset_usb();
+	test_set_skip_delays(true);
+	ut_assertok(bootdev_hunt_start());
+	ut_asserteq(BIT(USB_HUNTER), std->hunters_active);
+
+	/* The cyclic functions find the flash stick without any waiting */
+	start = get_timer(0);
+	dev = NULL;
+	while (!dev && get_timer(start) < 1000) {
+		schedule();
+		uclass_find_first_device(UCLASS_MASS_STORAGE, &dev);
+	}
+	ut_assertnonnull(dev);
+
+	/* The result is left for the foreground, so that it is shown */
+	ut_assert_console_end();
+	ut_asserteq(BIT(USB_HUNTER), std->hunters_active);
+	ut_assert(usb_scan_busy());
+
+	ut_assertok(bootdev_hunt("usb", false));
+	ut_assert_nextline(
+		"Bus usb@1: scanning bus usb@1 for devices... 5 USB Device(s) found");
+	ut_assert_console_end();
+	ut_asserteq(0, std->hunters_active);
+	ut_assert(std->hunters_used & BIT(USB_HUNTER));
+	ut_assert(!usb_scan_busy());
+
+	return 0;
+}
+BOOTSTD_TEST(bootdev_test_hunt_background_usb, UTF_DM | UTF_SCAN_FDT |
+	     UTF_CONSOLE);
+
 /* Check 'bootdev hunt' command */
 static int bootdev_test_cmd_hunt(struct unit_test_state *uts)
 {
@@ -13,7 +13,11 @@
 #include <cli.h>
 #include <dm.h>
 #include <efi_default_filename.h>
+#include <env.h>
 #include <expo.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <pxe_utils.h>
 #ifdef CONFIG_SANDBOX
 #include <asm/test.h>
 #endif
@@ -31,6 +35,9 @@ extern U_BOOT_DRIVER(bootmeth_android);
 extern U_BOOT_DRIVER(bootmeth_cros);
 extern U_BOOT_DRIVER(bootmeth_2script);
 
+/* Address to use for the extlinux file in bootflow_pxe_parse() */
+#define PXE_PARSE_ADDR	0x10000
+
 static int inject_response(struct unit_test_state *uts)
 {
 	/*
@@ -248,6 +255,8 @@ BOOTSTD_TEST(bootflow_cmd_info, UTF_DM | UTF_SCAN_FDT | UTF_CONSOLE);
 /* Check 'bootflow scan -b' to boot the first available bootdev */
 static int bootflow_scan_boot(struct unit_test_state *uts)
 {
+	/* Don't use or leave behind a record of the last bootflow booted */
+	ut_assertok(env_set("bootflow_cache", NULL));
 	ut_assertok(inject_response(uts));
 	ut_assertok(run_command("bootflow scan -b", 0));
 	ut_assert_nextline(
@@ -261,11 +270,73 @@ static int bootflow_scan_boot(struct unit_test_state *uts)
 	ut_assert_skip_to_line("sandbox: continuing, as we cannot run Linux");
 	ut_assert_nextline("Boot failed (err=-14)");
 	ut_assert_console_end();
+	ut_assertok(env_set("bootflow_cache", NULL));
 
 	return 0;
 }
 BOOTSTD_TEST(bootflow_scan_boot, UTF_DM | UTF_SCAN_FDT | UTF_CONSOLE);
 
+/* Check booting the last-booted bootflow using the bootflow cache */
+static int bootflow_scan_cache(struct unit_test_state *uts)
+{
+	struct bootflow_iter iter;
+	struct bootflow bflow;
+	char order[16], record[80];
+	const char *cache;
+
+	if (!IS_ENABLED(CONFIG_BOOTSTD_CACHE))
+		return -EAGAIN;
+	ut_assertok(env_set("bootflow_cache", NULL));
+	ut_assertok(inject_response(uts));
+	ut_assertok(run_command("bootflow scan -b", 0));
+	ut_assert_nextline(
+		"** Booting bootflow 'mmc1.bootdev.part_1' with extlinux");
+	ut_assert_skip_to_line("Boot failed (err=-14)");
+	ut_assert_console_end();
+
+	cache = env_get("bootflow_cache");
+	ut_assertnonnull(cache);
+	ut_asserteq_strn("mmc1 1 extlinux /extlinux/extlinux.conf ", cache);
+	strlcpy(order, strrchr(cache, ' ') + 1, sizeof(order));
+
+	/* The cached bootflow is found first, then the others are scanned */
+	ut_assertok(bootflow_scan_first(NULL, NULL, &iter, BOOTFLOWIF_CACHE,
+					&bflow));
+	ut_assert(iter.flags & BOOTFLOWIF_CACHED);
+	ut_asserteq_str("mmc1.bootdev.part_1", bflow.name);
+	ut_asserteq_str("extlinux", bflow.method->name);
+	bootflow_free(&bflow);
+
+	/* ...without finding it again */
+	ut_asserteq(-ENODEV, bootflow_scan_next(&iter, &bflow));
+	ut_assert(!(iter.flags & BOOTFLOWIF_CACHED));
+	bootflow_iter_uninit(&iter);
+
+	/* A change to the bootdev order causes a full scan */
+	ut_assertok(env_set("boot_targets", "mmc1 mmc2"));
+	ut_assertok(bootflow_scan_first(NULL, NULL, &iter, BOOTFLOWIF_CACHE,
+					&bflow));
+	ut_assert(!(iter.flags & BOOTFLOWIF_CACHED));
+	bootflow_free(&bflow);
+	bootflow_iter_uninit(&iter);
+	ut_assertok(env_set("boot_targets", NULL));
+
+	/* A record which does not match the file causes a full scan */
+	snprintf(record, sizeof(record),
+		 "mmc1 1 extlinux /extlinux/extlinux.conf 1 0 - %s", order);
+	ut_assertok(env_set("bootflow_cache", record));
+	ut_assertok(bootflow_scan_first(NULL, NULL, &iter, BOOTFLOWIF_CACHE,
+					&bflow));
+	ut_assert(!(iter.flags & BOOTFLOWIF_CACHED));
+	ut_asserteq_str("mmc1.bootdev.part_1", bflow.name);
+	bootflow_free(&bflow);
+	bootflow_iter_uninit(&iter);
+	ut_assertok(env_set("bootflow_cache", NULL));
+
+	return 0;
+}
+BOOTSTD_TEST(bootflow_scan_cache, UTF_DM | UTF_SCAN_FDT | UTF_CONSOLE);
+
 /* Check iterating through available bootflows */
 static int bootflow_iter(struct unit_test_state *uts)
 {
@@ -409,6 +480,7 @@ static int bootflow_iter_disable(struct unit_test_state *uts)
 	ut_assertok(bootstd_test_drop_bootdev_order(uts));
 
 	bootstd_clear_glob();
+	ut_assertok(env_set("bootflow_cache", NULL));
 	ut_assertok(inject_response(uts));
 	ut_assertok(run_command("bootflow scan -lbH", 0));
 
@@ -427,6 +499,7 @@ static int bootflow_iter_disable(struct unit_test_state *uts)
 	ut_asserteq(2, iter.num_methods);
 	for (i = 0; i < iter.num_methods; i++)
 		ut_assert(strcmp("sandbox", iter.method_order[i]->name));
+	ut_assertok(env_set("bootflow_cache", NULL));
 
 	return 0;
 }
@@ -1205,3 +1278,68 @@ static int bootflow_android(struct unit_test_state *uts)
 	return 0;
 }
 BOOTSTD_TEST(bootflow_android, UTF_CONSOLE);
+
+/* Check that parsing an extlinux file only uses the heap for a few blocks */
+static int bootflow_pxe_parse(struct unit_test_state *uts)
+{
+	static const char conf[] =
+		"menu title Boot Options.\n"
+		"timeout 20\n"
+		"default linux-5.3\n"
+		"\n"
+		"label linux-5.3\n"
+		"	kernel /vmlinuz-5.3\n"
+		"	append ro root=UUID=9732b35b console=ttyS0 initrd=/ird\n"
+		"	fdtdir /dtb-5.3\n"
+		"\n"
+		"label linux-5.2\n"
+		"	kernel /fit.itb#conf-1\n"
+		"	initrd /initramfs-5.2.img\n"
+		"	fdt /dtb-5.2/board.dtb\n";
+	struct malloc_usage before, after;
+	struct pxe_context ctx = {};
+	struct pxe_label *label;
+	struct pxe_menu *cfg;
+	ulong start;
+	char *buf;
+
+	if (!IS_ENABLED(CONFIG_PXE_UTILS))
+		return -EAGAIN;
+
+	buf = map_sysmem(PXE_PARSE_ADDR, sizeof(conf));
+	memcpy(buf, conf, sizeof(conf));
+
+	start = ut_check_free();
+	malloc_get_usage(&before);
+	cfg = parse_pxefile(&ctx, PXE_PARSE_ADDR);
+	ut_assertnonnull(cfg);
+	malloc_get_usage(&after);
+
+	ut_asserteq_str("Boot Options.", cfg->title);
+	ut_asserteq_str("linux-5.3", cfg->default_label);
+	ut_asserteq(20, cfg->timeout);
+	label = list_first_entry(&cfg->labels, struct pxe_label, list);
+	ut_asserteq_str("linux-5.3", label->name);
+	ut_asserteq_str("/vmlinuz-5.3", label->kernel);
+	ut_asserteq_str("/ird", label->initrd);
+	ut_asserteq_str("/dtb-5.3", label->fdtdir);
+	label = list_entry(label->list.next, struct pxe_label, list);
+	ut_asserteq_str("linux-5.2", label->name);
+	ut_asserteq_str("/fit.itb", label->kernel);
+	ut_asserteq_str("/fit.itb#conf-1", label->kernel_label);
+	ut_asserteq_str("#conf-1", label->config);
+	ut_asserteq_str("/initramfs-5.2.img", label->initrd);
+
+	/* the menu and one arena block, rather than one per string */
+	ut_asserteq(1, cfg->arena.stats.blocks);
+	ut_assert(cfg->arena.stats.allocs > 20);
+	if (CONFIG_IS_ENABLED(SYS_MALLOC_STATS))
+		ut_asserteq(2, after.allocs - before.allocs);
+
+	destroy_pxe_menu(cfg);
+	ut_assertok(ut_check_delta(start));
+	unmap_sysmem(buf);
+
+	return 0;
+}
+BOOTSTD_TEST(bootflow_pxe_parse, 0);
@@ -91,6 +91,7 @@ int bootstd_test_check_mmc_hunter(struct unit_test_state *uts)
 
 void bootstd_reset_usb(void)
 {
+	usb_scan_cancel();
 	usb_started = false;
 }
 
@@ -23,6 +23,7 @@
 enum {
 	MAX_HUNTER	= 9,
 	MMC_HUNTER	= 3,	/* ID of MMC hunter */
+	USB_HUNTER	= 8,	/* ID of USB hunter */
 };
 
 struct unit_test_state;
@@ -6,7 +6,11 @@
  */
 
 #include <bootm.h>
+#include <bootstage.h>
+#include <image.h>
+#include <mapmem.h>
 #include <asm/global_data.h>
+#include <linux/libfdt.h>
 #include <test/suites.h>
 #include <test/test.h>
 #include <test/ut.h>
@@ -238,6 +242,165 @@ static int bootm_test_subst_both(struct unit_test_state *uts)
 }
 BOOTM_TEST(bootm_test_subst_both, 0);
 
+#define PLAN_FIT_ADDR	0x100000
+#define PLAN_RD_ADDR	0x200000
+#define PLAN_RD_SIZE	0x400
+
+/* Add an image node whose data is outside the FIT, at @pos */
+static int plan_add_image(void *fit, const char *name, const char *type,
+			  uint pos, uint size, uint load)
+{
+	int ret;
+
+	ret = fdt_begin_node(fit, name);
+	ret |= fdt_property_string(fit, FIT_TYPE_PROP, type);
+	ret |= fdt_property_string(fit, FIT_ARCH_PROP, "sandbox");
+	ret |= fdt_property_string(fit, FIT_OS_PROP, "linux");
+	ret |= fdt_property_string(fit, FIT_COMP_PROP, "none");
+	ret |= fdt_property_u32(fit, FIT_DATA_POSITION_PROP, pos);
+	ret |= fdt_property_u32(fit, FIT_DATA_SIZE_PROP, size);
+	if (load)
+		ret |= fdt_property_u32(fit, FIT_LOAD_PROP, load);
+	ret |= fdt_end_node(fit);
+
+	return ret;
+}
+
+/**
+ * plan_make_fit() - create a FIT with images needing each kind of load
+ *
+ * - the kernel is already at its load address
+ * - the FDT has no load address but is misaligned, so must be copied
+ * - the ramdisk must be copied to its load address
+ * - the loadable is inside the FIT, at its load address
+ */
+static int plan_make_fit(struct unit_test_state *uts, void *fit,
+			 int *fdt_sizep)
+{
+	const int fdt_pos = 0x1004, kernel_pos = 0x1800, rd_pos = 0x2000;
+	u8 fdt[128];
+	int node;
+	void *ptr;
+
+	ut_assertok(fdt_create_empty_tree(fdt, sizeof(fdt)));
+	*fdt_sizep = fdt_totalsize(fdt);
+	memcpy(fit + fdt_pos, fdt, *fdt_sizep);
+	memset(fit + kernel_pos, 'k', 0x100);
+	memset(fit + rd_pos, 'r', PLAN_RD_SIZE);
+
+	ut_assertok(fdt_create(fit, fdt_pos));
+	ut_assertok(fdt_finish_reservemap(fit));
+	ut_assertok(fdt_begin_node(fit, ""));
+	ut_assertok(fdt_property_string(fit, FIT_DESC_PROP, "plan"));
+	ut_assertok(fdt_property_u32(fit, FIT_TIMESTAMP_PROP, 0));
+	ut_assertok(fdt_begin_node(fit, "images"));
+	ut_assertok(plan_add_image(fit, "kernel", "kernel", kernel_pos, 0x100,
+				   PLAN_FIT_ADDR + kernel_pos));
+	ut_assertok(plan_add_image(fit, "fdt", "flat_dt", fdt_pos, *fdt_sizep,
+				   0));
+	ut_assertok(plan_add_image(fit, "ramdisk", "ramdisk", rd_pos,
+				   PLAN_RD_SIZE, PLAN_RD_ADDR));
+	ut_assertok(fdt_begin_node(fit, "firmware"));
+	ut_assertok(fdt_property_string(fit, FIT_TYPE_PROP, "firmware"));
+	ut_assertok(fdt_property_string(fit, FIT_ARCH_PROP, "sandbox"));
+	ut_assertok(fdt_property_string(fit, FIT_COMP_PROP, "none"));
+	ut_assertok(fdt_property(fit, FIT_DATA_PROP, "firmware", 8));
+	ut_assertok(fdt_property_u32(fit, FIT_LOAD_PROP, 0));
+	ut_assertok(fdt_end_node(fit));
+	ut_assertok(fdt_end_node(fit));
+	ut_assertok(fdt_begin_node(fit, "configurations"));
+	ut_assertok(fdt_property_string(fit, FIT_DEFAULT_PROP, "conf"));
+	ut_assertok(fdt_begin_node(fit, "conf"));
+	ut_assertok(fdt_property_string(fit, FIT_KERNEL_PROP, "kernel"));
+	ut_assertok(fdt_property_string(fit, FIT_FDT_PROP, "fdt"));
+	ut_assertok(fdt_property_string(fit, FIT_RAMDISK_PROP, "ramdisk"));
+	ut_assertok(fdt_property_string(fit, FIT_LOADABLE_PROP, "firmware"));
+	ut_assertok(fdt_end_node(fit));
+	ut_assertok(fdt_end_node(fit));
+	ut_assertok(fdt_end_node(fit));
+	ut_assertok(fdt_finish(fit));
+
+	/* Put the loadable's load address where its data is */
+	node = fdt_path_offset(fit, "/images/firmware");
+	ut_assert(node >= 0);
+	ptr = (void *)fdt_getprop(fit, node, FIT_DATA_PROP, NULL);
+	ut_assertnonnull(ptr);
+	ut_assertok(fdt_setprop_inplace_u32(fit, node, FIT_LOAD_PROP,
+					    map_to_sysmem(ptr)));
+
+	return 0;
+}
+
+/* Test that images are only moved when needed, and as planned */
+static int bootm_test_load_plan(struct unit_test_state *uts)
+{
+	struct bootm_headers hdrs;
+	const char *uname;
+	struct fit_plan plan;
+	ulong data, len;
+	int fdt_size;
+	void *fit;
+
+	fit = map_sysmem(PLAN_FIT_ADDR, 0x3000);
+	ut_assertok(plan_make_fit(uts, fit, &fdt_size));
+
+	ut_assertok(fit_plan_config(fit, fit_conf_get_node(fit, "conf"),
+				    &plan));
+	ut_asserteq(4, plan.count);
+	ut_asserteq(FIT_PLAN_IN_PLACE, plan.entry[0].action);
+	ut_asserteq(FIT_PLAN_COPY_ALIGN, plan.entry[1].action);
+	ut_asserteq(FIT_PLAN_COPY, plan.entry[2].action);
+	ut_asserteq(PLAN_RD_ADDR, plan.entry[2].load);
+	ut_asserteq(FIT_PLAN_IN_PLACE, plan.entry[3].action);
+	ut_asserteq(fdt_size + PLAN_RD_SIZE, plan.bytes_moved);
+
+	console_record_reset_enable();
+	fit_plan_print(&plan);
+	ut_assert_nextline("   Load plan:");
+	ut_assert_nextline("     kernel     kernel           in place        100 bytes at 00101800");
+	ut_assert_nextline("     fdt        fdt              copy/align       %2x bytes at 00101004 -> allocated",
+			   fdt_size);
+	ut_assert_nextline("     ramdisk    ramdisk          copy            400 bytes at 00102000 -> 00200000");
+	ut_assert_nextlinen("     loadables  firmware         in place          8 bytes at ");
+	ut_assert_nextline("   Bytes to move: %lx", plan.bytes_moved);
+	ut_assert_console_end();
+
+	/* Load the images as bootm does, counting the bytes moved */
+	memset(&hdrs, '\0', sizeof(hdrs));
+	uname = "fdt";
+	ut_assert(fit_image_load(&hdrs, PLAN_FIT_ADDR, &uname, NULL,
+				 IH_ARCH_DEFAULT, IH_TYPE_FLATDT,
+				 BOOTSTAGE_ID_FIT_FDT_START, FIT_LOAD_OPTIONAL,
+				 &data, &len) >= 0);
+	ut_asserteq(0, data & 7);
+	ut_asserteq_ptr(hdrs.align_buf, map_sysmem(data, len));
+	ut_asserteq(fdt_size, len);
+	ut_asserteq(fdt_size, hdrs.bytes_moved);
+
+	uname = "ramdisk";
+	ut_assert(fit_image_load(&hdrs, PLAN_FIT_ADDR, &uname, NULL,
+				 IH_ARCH_DEFAULT, IH_TYPE_RAMDISK,
+				 BOOTSTAGE_ID_FIT_RD_START,
+				 FIT_LOAD_OPTIONAL_NON_ZERO, &data, &len) >= 0);
+	ut_asserteq(PLAN_RD_ADDR, data);
+	ut_asserteq('r', *(char *)map_sysmem(PLAN_RD_ADDR + PLAN_RD_SIZE - 1,
+					     1));
+
+	/* This used to fail, as the load address is inside the FIT */
+	uname = "firmware";
+	ut_assert(fit_image_load(&hdrs, PLAN_FIT_ADDR, &uname, NULL,
+				 IH_ARCH_DEFAULT, IH_TYPE_LOADABLE,
+				 BOOTSTAGE_ID_FIT_LOADABLE_START,
+				 FIT_LOAD_OPTIONAL_NON_ZERO, &data, &len) >= 0);
+	ut_asserteq(plan.entry[3].data, data);
+	ut_asserteq(plan.bytes_moved, hdrs.bytes_moved);
+	unmap_sysmem(fit);
+	free(hdrs.align_buf);
+
+	return 0;
+}
+BOOTM_TEST(bootm_test_load_plan, UTF_CONSOLE);
+
 int do_ut_bootm(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 {
 	struct unit_test *tests = UNIT_TEST_SUITE_START(bootm_test);
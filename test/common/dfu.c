@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for DFU write buffering
+ *
+ * A RAM entity is written in DFU-sized blocks, as the USB gadget does, and
+ * the destination is checked to see when each buffer reaches the medium.
+ */
+
+#include <cyclic.h>
+#include <dfu.h>
+#include <env.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <test/common.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <linux/sizes.h>
+#include <linux/stringify.h>
+
+#define DFU_TEST_BLK	SZ_4K
+#define DFU_TEST_BUF	0x4000
+#define DFU_TEST_SIZE	SZ_64K
+
+/**
+ * dfu_test_setup() - Create a RAM entity covering @dst
+ *
+ * @uts: Test state
+ * @dst: Destination buffer of DFU_TEST_SIZE bytes
+ * @bufcnt: Number of write buffers
+ * Return: 0 if OK, 1 on test failure
+ */
+static int dfu_test_setup(struct unit_test_state *uts, void *dst,
+			  const char *bufcnt)
+{
+	char alt_info[64];
+
+	/* Use the entity directly, dfu_alt_info may be set by the board */
+	snprintf(alt_info, sizeof(alt_info), "img ram %lx %x",
+		 (ulong)map_to_sysmem(dst), DFU_TEST_SIZE);
+	ut_assertok(env_set("dfu_bufsiz", __stringify(DFU_TEST_BUF)));
+	ut_assertok(env_set("dfu_bufcnt", bufcnt));
+	ut_assertok(dfu_config_entities(alt_info, "ram", "0"));
+	ut_assertnonnull(dfu_get_entity(0));
+
+	return 0;
+}
+
+static void dfu_test_cleanup(void)
+{
+	dfu_free_entities();
+	env_set("dfu_bufsiz", NULL);
+	env_set("dfu_bufcnt", NULL);
+}
+
+/* Write blocks [@from, @to) of @src */
+static int dfu_test_write(struct unit_test_state *uts, u8 *src, int from,
+			  int to)
+{
+	int i;
+
+	for (i = from; i < to; i++)
+		ut_assertok(dfu_write(dfu_get_entity(0),
+				      src + i * DFU_TEST_BLK, DFU_TEST_BLK, i));
+
+	return 0;
+}
+
+static int common_test_dfu_write_sync(struct unit_test_state *uts)
+{
+	u8 *src, *dst;
+	int i;
+
+	src = malloc(DFU_TEST_SIZE);
+	dst = calloc(1, DFU_TEST_SIZE);
+	ut_assertnonnull(src);
+	ut_assertnonnull(dst);
+	for (i = 0; i < DFU_TEST_SIZE; i++)
+		src[i] = i * 3 + (i >> 8);
+
+	ut_assertok(dfu_test_setup(uts, dst, "1"));
+
+	/* A full buffer is written straight away */
+	ut_assertok(dfu_test_write(uts, src, 0, 4));
+	ut_asserteq_mem(src, dst, DFU_TEST_BUF);
+	ut_assertok(dfu_test_write(uts, src, 4, 15));
+	ut_assertok(dfu_flush(dfu_get_entity(0), NULL, 0, 15));
+	ut_asserteq_mem(src, dst, 15 * DFU_TEST_BLK);
+
+	dfu_test_cleanup();
+	free(dst);
+	free(src);
+
+	return 0;
+}
+COMMON_TEST(common_test_dfu_write_sync, 0);
+
+static int common_test_dfu_write_queue(struct unit_test_state *uts)
+{
+	u8 *src, *dst, *zero;
+	int i;
+
+	if (!CONFIG_IS_ENABLED(CYCLIC))
+		return -EAGAIN;
+
+	src = malloc(DFU_TEST_SIZE);
+	dst = calloc(1, DFU_TEST_SIZE);
+	zero = calloc(1, DFU_TEST_SIZE);
+	ut_assertnonnull(src);
+	ut_assertnonnull(dst);
+	ut_assertnonnull(zero);
+	for (i = 0; i < DFU_TEST_SIZE; i++)
+		src[i] = i * 3 + (i >> 8);
+
+	ut_assertok(dfu_test_setup(uts, dst, "3"));
+
+	/* A full buffer is queued and written by the cyclic function */
+	ut_assertok(dfu_test_write(uts, src, 0, 4));
+	ut_asserteq_mem(zero, dst, DFU_TEST_BUF);
+	schedule();
+	ut_asserteq_mem(src, dst, DFU_TEST_BUF);
+
+	/*
+	 * Without the cyclic function running, two more buffers can be
+	 * queued and the fourth one has to wait for the oldest
+	 */
+	ut_assertok(dfu_test_write(uts, src, 4, 12));
+	ut_asserteq_mem(zero, dst + DFU_TEST_BUF, 2 * DFU_TEST_BUF);
+	ut_assertok(dfu_test_write(uts, src, 12, 16));
+	ut_asserteq_mem(src, dst, 2 * DFU_TEST_BUF);
+	ut_asserteq_mem(zero, dst + 2 * DFU_TEST_BUF, 2 * DFU_TEST_BUF);
+
+	/* Flushing writes everything, in order */
+	ut_assertok(dfu_flush(dfu_get_entity(0), NULL, 0, 16));
+	ut_asserteq_mem(src, dst, DFU_TEST_SIZE);
+
+	/* The cyclic function is gone after the transfer */
+	memset(dst, '\0', DFU_TEST_SIZE);
+	ut_assertok(dfu_test_write(uts, src, 0, 4));
+	dfu_test_cleanup();
+	schedule();
+	ut_asserteq_mem(zero, dst, DFU_TEST_SIZE);
+
+	free(zero);
+	free(dst);
+	free(src);
+
+	return 0;
+}
+COMMON_TEST(common_test_dfu_write_queue, 0);
+
+static int (*dfu_test_orig_write)(struct dfu_entity *dfu, u64 offset,
+				  void *buf, long *len);
+static int dfu_test_writes;
+
+/* Like the SF and NAND backends, call schedule() in the middle of a write */
+static int dfu_test_write_schedule(struct dfu_entity *dfu, u64 offset,
+				   void *buf, long *len)
+{
+	dfu_test_writes++;
+	schedule();
+
+	return dfu_test_orig_write(dfu, offset, buf, len);
+}
+
+static int common_test_dfu_write_reenter(struct unit_test_state *uts)
+{
+	struct dfu_entity *dfu;
+	u8 *src, *dst;
+	int i;
+
+	if (!CONFIG_IS_ENABLED(CYCLIC))
+		return -EAGAIN;
+
+	src = malloc(DFU_TEST_SIZE);
+	dst = calloc(1, DFU_TEST_SIZE);
+	ut_assertnonnull(src);
+	ut_assertnonnull(dst);
+	for (i = 0; i < DFU_TEST_SIZE; i++)
+		src[i] = i * 3 + (i >> 8);
+
+	ut_assertok(dfu_test_setup(uts, dst, "3"));
+	dfu = dfu_get_entity(0);
+	dfu_test_orig_write = dfu->write_medium;
+	dfu->write_medium = dfu_test_write_schedule;
+	dfu_test_writes = 0;
+
+	/*
+	 * The third buffer has to wait for the oldest one, which is written
+	 * in the foreground; the cyclic function must not write it again
+	 */
+	ut_assertok(dfu_test_write(uts, src, 0, 12));
+	ut_asserteq(1, dfu_test_writes);
+	ut_asserteq(DFU_TEST_BUF, dfu->offset);
+	ut_asserteq_mem(src, dst, DFU_TEST_BUF);
+
+	ut_assertok(dfu_test_write(uts, src, 12, 16));
+	ut_assertok(dfu_flush(dfu, NULL, 0, 16));
+	ut_asserteq(4, dfu_test_writes);
+	ut_asserteq_mem(src, dst, DFU_TEST_SIZE);
+
+	dfu_test_cleanup();
+	free(dst);
+	free(src);
+
+	return 0;
+}
+COMMON_TEST(common_test_dfu_write_reenter, 0);
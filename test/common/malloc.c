@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for tracking the callers of malloc()
+ */
+
+#include <command.h>
+#include <malloc.h>
+#include <asm/global_data.h>
+#include <linux/sizes.h>
+#include <test/common.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define SITE_COUNT	4
+
+static struct malloc_site before[256];
+
+static int save_sites(struct unit_test_state *uts)
+{
+	const struct malloc_site *sites;
+	uint count;
+
+	sites = malloc_get_sites(&count);
+	ut_assert(count <= ARRAY_SIZE(before));
+	memcpy(before, sites, count * sizeof(*sites));
+
+	return 0;
+}
+
+/* Find the only site whose allocation count changed since save_sites() */
+static int changed_site(void)
+{
+	const struct malloc_site *sites;
+	uint count, i;
+	int found = -1;
+
+	sites = malloc_get_sites(&count);
+	for (i = 1; i < count; i++) {
+		if (sites[i].count == before[i].count)
+			continue;
+		if (found != -1)
+			return -1;
+		found = i;
+	}
+
+	return found;
+}
+
+/* Get the change in live bytes for a site since save_sites() */
+static long live_change(int idx)
+{
+	uint count;
+
+	return malloc_get_sites(&count)[idx].live - before[idx].live;
+}
+
+static int common_test_malloc_sites(struct unit_test_state *uts)
+{
+	const struct malloc_site *sites;
+	void *ptr[SITE_COUNT];
+	int idx, other, i;
+	uint count;
+	ulong peak;
+
+	sites = malloc_get_sites(&count);
+	ut_assertok(save_sites(uts));
+	for (i = 0; i < SITE_COUNT; i++)
+		ptr[i] = malloc(1000);
+	idx = changed_site();
+	ut_assert(idx > 0);
+	ut_asserteq(SITE_COUNT, sites[idx].count - before[idx].count);
+	ut_asserteq(SITE_COUNT * 1000, live_change(idx));
+	peak = sites[idx].peak;
+	ut_assert(peak >= sites[idx].live);
+
+	/* Freeing memory reduces the live bytes but not the peak */
+	for (i = 1; i < SITE_COUNT; i++)
+		free(ptr[i]);
+	ut_asserteq(1000, live_change(idx));
+	ut_asserteq(peak, sites[idx].peak);
+
+	/* Growing a block moves it to the new caller */
+	ut_assertok(save_sites(uts));
+	ptr[0] = realloc(ptr[0], 3000);
+	ut_assertnonnull(ptr[0]);
+	other = changed_site();
+	ut_assert(other > 0);
+	ut_assert(other != idx);
+	ut_asserteq(3000, live_change(other));
+	ut_asserteq(-1000, live_change(idx));
+	free(ptr[0]);
+	ut_asserteq(0, live_change(other));
+
+	/* Aligned blocks are tracked too */
+	ut_assertok(save_sites(uts));
+	ptr[0] = memalign(SZ_4K, 100);
+	ut_assertnonnull(ptr[0]);
+	ut_assert(IS_ALIGNED((ulong)ptr[0], SZ_4K));
+	idx = changed_site();
+	ut_assert(idx > 0);
+	ut_asserteq(100, live_change(idx));
+	ptr[0] = realloc(ptr[0], 200);
+	ut_assertnonnull(ptr[0]);
+	ut_asserteq(0, live_change(idx));
+	free(ptr[0]);
+
+	return 0;
+}
+COMMON_TEST(common_test_malloc_sites, 0);
+
+static int common_test_malloc_dump(struct unit_test_state *uts)
+{
+	const struct malloc_site *site;
+	struct malloc_usage usage;
+	uint count;
+	void *ptr;
+	int idx;
+
+	/* A large block puts its caller at the top of the list */
+	ut_assertok(save_sites(uts));
+	ptr = malloc(SZ_4M);
+	ut_assertnonnull(ptr);
+	idx = changed_site();
+	ut_assert(idx > 0);
+	site = &malloc_get_sites(&count)[idx];
+
+	malloc_get_usage(&usage);
+	ut_assert(usage.in_use >= SZ_4M);
+
+	ut_assertok(run_command("malloc dump 1", 0));
+	ut_assert_nextline("Caller              Count       Live       Peak");
+	ut_assert_nextline("%-16lx %8lu %10lu %10lu", site->caller - gd->reloc_off,
+			   site->count, site->live, site->peak);
+	ut_assert_console_end();
+	free(ptr);
+
+	ut_assertok(run_command("malloc info", 0));
+	ut_assert_nextlinen("in use  : ");
+	ut_assert_nextlinen("peak    : ");
+	ut_assert_nextlinen("allocs  : ");
+	ut_assert_console_end();
+
+	return 0;
+}
+COMMON_TEST(common_test_malloc_dump, UTF_CONSOLE);
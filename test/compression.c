@@ -6,12 +6,16 @@
 #include <abuf.h>
 #include <bootm.h>
 #include <command.h>
+#include <div64.h>
+#include <env.h>
 #include <gzip.h>
 #include <image.h>
 #include <log.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <time.h>
 #include <asm/io.h>
+#include <asm/unaligned.h>
 
 #include <u-boot/lz4.h>
 #include <u-boot/zlib.h>
@@ -22,6 +26,7 @@
 #include <lzma/LzmaTools.h>
 
 #include <linux/lzo.h>
+#include <linux/sizes.h>
 #include <linux/zstd.h>
 #include <test/compression.h>
 #include <test/suites.h>
@@ -506,6 +511,423 @@ static int compression_test_zstd(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_zstd, 0);
 
+/* Write a zstd frame holding @data in a raw block, returning its size */
+static int zstd_test_raw_frame(u8 *dst, const char *data)
+{
+	int len = strlen(data);
+
+	put_unaligned_le32(ZSTD_MAGICNUMBER, dst);
+	dst[4] = 0x20;		/* single segment, 1-byte content size */
+	dst[5] = len;
+	put_unaligned_le32(1 | len << 3, dst + 6);	/* last raw block */
+	memcpy(dst + 9, data, len);
+
+	return 9 + len;
+}
+
+/* Write a skippable frame with @len bytes of content */
+static int zstd_test_skip_frame(u8 *dst, int len)
+{
+	put_unaligned_le32(ZSTD_MAGIC_SKIPPABLE_START | 3, dst);
+	put_unaligned_le32(len, dst + 4);
+	memset(dst + 8, 0xaa, len);
+
+	return 8 + len;
+}
+
+static int zstd_test_decomp(u8 *in, int in_size, u8 *out, int out_size)
+{
+	struct abuf in_buf, out_buf;
+
+	abuf_init_set(&in_buf, in, in_size);
+	abuf_init_set(&out_buf, out, out_size);
+
+	return zstd_decompress(&in_buf, &out_buf);
+}
+
+/* Archives made of several frames, with and without a seek table */
+static int compression_test_zstd_frames(struct unit_test_state *uts)
+{
+	const int plain_len = strlen(plain);
+	u8 in[TEST_BUFFER_SIZE], out[TEST_BUFFER_SIZE];
+	int pos, frame, skip, table;
+	u8 *entry;
+
+	memcpy(in, zstd_compressed, zstd_compressed_size);
+	pos = zstd_compressed_size;
+	skip = zstd_test_skip_frame(in + pos, 5);
+	pos += skip;
+	frame = zstd_test_raw_frame(in + pos, "tail");
+	pos += frame;
+
+	ut_asserteq(plain_len + 4, zstd_test_decomp(in, pos, out,
+						    sizeof(out)));
+	ut_asserteq_mem(plain, out, plain_len);
+	ut_asserteq_mem("tail", out + plain_len, 4);
+
+	/* Padding after the last frame is ignored */
+	memset(in + pos, '\0', 16);
+	ut_asserteq(plain_len + 4, zstd_test_decomp(in, pos + 16, out,
+						    sizeof(out)));
+
+	/* Output buffer too small for the last frame */
+	memset(out, '\0', sizeof(out));
+	ut_asserteq(-ENOSPC, zstd_test_decomp(in, pos, out, plain_len + 3));
+	ut_asserteq(0, out[plain_len + 3]);
+
+	/* Add a seek table with an entry for each frame */
+	table = pos;
+	put_unaligned_le32(ZSTD_MAGIC_SKIPPABLE_START | 0xe, in + pos);
+	put_unaligned_le32(3 * 8 + 9, in + pos + 4);
+	entry = in + pos + 8;
+	put_unaligned_le32(zstd_compressed_size, entry);
+	put_unaligned_le32(plain_len, entry + 4);
+	put_unaligned_le32(skip, entry + 8);
+	put_unaligned_le32(0, entry + 12);
+	put_unaligned_le32(frame, entry + 16);
+	put_unaligned_le32(4, entry + 20);
+	put_unaligned_le32(3, entry + 24);
+	entry[28] = 0;
+	put_unaligned_le32(0x8f92eab1, entry + 29);
+	pos = table + 8 + 3 * 8 + 9;
+
+	memset(out, '\0', sizeof(out));
+	ut_asserteq(plain_len + 4, zstd_test_decomp(in, pos, out,
+						    sizeof(out)));
+	ut_asserteq_mem(plain, out, plain_len);
+	ut_asserteq_mem("tail", out + plain_len, 4);
+
+	/* The table is checked against the output before decompressing */
+	memset(out, '\0', sizeof(out));
+	ut_asserteq(-ENOSPC, zstd_test_decomp(in, pos, out, plain_len + 3));
+	ut_asserteq(0, out[0]);
+
+	/* A table which does not match the frames is rejected */
+	put_unaligned_le32(frame + 1, entry + 16);
+	ut_asserteq(-EINVAL, zstd_test_decomp(in, pos, out, sizeof(out)));
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_zstd_frames, 0);
+
+#define FAST_TEST_SIZE	SZ_1M
+
+/* Deflate @in with raw zlib, so that the level and strategy can be chosen */
+static int deflate_raw(void *in, ulong in_size, void *out, ulong *out_size,
+		       int level, int strategy)
+{
+	z_stream s = {0};
+	int ret;
+
+	s.zalloc = gzalloc;
+	s.zfree = gzfree;
+	if (deflateInit2_(&s, level, Z_DEFLATED, -MAX_WBITS, 8, strategy,
+			  sizeof(s)) != Z_OK)
+		return -EIO;
+	s.next_in = in;
+	s.avail_in = in_size;
+	s.next_out = out;
+	s.avail_out = *out_size;
+	ret = deflate(&s, Z_FINISH);
+	*out_size = s.total_out;
+	deflateEnd(&s);
+
+	return ret == Z_STREAM_END ? 0 : -ENOSPC;
+}
+
+/* Inflate @in with the zlib inflate(), bypassing the fast engine */
+static int inflate_zlib(void *in, ulong in_size, void *out, ulong *out_size)
+{
+	z_stream s = {0};
+	int ret;
+
+	s.zalloc = gzalloc;
+	s.zfree = gzfree;
+	if (inflateInit2(&s, -MAX_WBITS) != Z_OK)
+		return -EIO;
+	s.next_in = in;
+	s.avail_in = in_size;
+	s.next_out = out;
+	s.avail_out = *out_size;
+	ret = inflate(&s, Z_FINISH);
+	*out_size = s.total_out;
+	inflateEnd(&s);
+
+	return ret == Z_STREAM_END ? 0 : -EIO;
+}
+
+/*
+ * Make data which compresses like a mix of text and binary: repeated words,
+ * long runs (for overlapping matches) and stretches of noise (for literals)
+ */
+static void fill_fast_test(u8 *buf, ulong size)
+{
+	static const char *const words[] = {
+		"inflate ", "deflate ", "u-boot ", "kernel ", "\n", "block ",
+		"symbol ", "window ", "match ", "literal ",
+	};
+	u32 x = 1;
+	ulong i = 0;
+	int n;
+
+	while (i < size) {
+		x = x * 1103515245 + 12345;
+		switch ((x >> 16) & 7) {
+		case 0:
+			for (n = (x >> 20) & 255; n-- && i < size;)
+				buf[i++] = (x >> 8) & 255;
+			break;
+		case 1:
+			for (n = (x >> 20) & 63; n-- && i < size;) {
+				x = x * 1103515245 + 12345;
+				buf[i++] = x >> 24;
+			}
+			break;
+		default:
+			for (const char *w = words[(x >> 20) % 10]; *w && i < size;)
+				buf[i++] = *w++;
+			break;
+		}
+	}
+}
+
+/**
+ * compression_test_gzip_fast() - check the fast inflate engine against zlib
+ *
+ * Streams with stored, fixed and dynamic blocks are decompressed with both
+ * engines, which must agree. Then a truncated stream, a too-small output
+ * buffer and a corrupted stream must be rejected without overrunning the
+ * output. Finally the throughput of both is printed.
+ */
+static int compression_test_gzip_fast(struct unit_test_state *uts)
+{
+	static const struct {
+		int level;
+		int strategy;
+	} modes[] = {
+		{ 0, Z_DEFAULT_STRATEGY },
+		{ 1, Z_DEFAULT_STRATEGY },
+		{ 6, Z_DEFAULT_STRATEGY },
+		{ 9, Z_DEFAULT_STRATEGY },
+		{ 6, Z_FIXED },
+		{ 6, Z_HUFFMAN_ONLY },
+		{ 6, Z_RLE },
+	};
+	const ulong comp_max = FAST_TEST_SIZE + FAST_TEST_SIZE / 16;
+	const int loops = 8;
+	ulong comp_size, ref_size, start, fast_us, zlib_us;
+	size_t out_size, in_size;
+	u8 *orig, *comp, *out, *ref;
+	u32 crc;
+	int i, ret;
+
+	if (!CONFIG_IS_ENABLED(GZIP_FAST))
+		return -EAGAIN;
+
+	orig = malloc(FAST_TEST_SIZE);
+	comp = malloc(comp_max);
+	out = malloc(FAST_TEST_SIZE + 1);
+	ref = malloc(FAST_TEST_SIZE);
+	ut_assertnonnull(orig);
+	ut_assertnonnull(comp);
+	ut_assertnonnull(out);
+	ut_assertnonnull(ref);
+	fill_fast_test(orig, FAST_TEST_SIZE);
+
+	for (i = 0; i < ARRAY_SIZE(modes); i++) {
+		comp_size = comp_max;
+		ut_assertok(deflate_raw(orig, FAST_TEST_SIZE, comp, &comp_size,
+					modes[i].level, modes[i].strategy));
+		ref_size = FAST_TEST_SIZE;
+		ut_assertok(inflate_zlib(comp, comp_size, ref, &ref_size));
+		ut_asserteq(FAST_TEST_SIZE, ref_size);
+
+		crc = 0;
+		ut_assertok(inflate_fast_buf(out, FAST_TEST_SIZE, comp,
+					     comp_size + 16, &out_size,
+					     &in_size, &crc));
+		ut_asserteq(FAST_TEST_SIZE, out_size);
+		ut_asserteq(comp_size, in_size);
+		ut_asserteq_mem(ref, out, FAST_TEST_SIZE);
+		ut_asserteq(crc32(0, orig, FAST_TEST_SIZE), crc);
+	}
+
+	/* Truncated input */
+	ut_asserteq(-EINVAL, inflate_fast_buf(out, FAST_TEST_SIZE, comp,
+					      comp_size / 2, &out_size,
+					      &in_size, NULL));
+
+	/* Too-small output buffer */
+	out[FAST_TEST_SIZE - 1] = 'A';
+	ut_asserteq(-ENOSPC, inflate_fast_buf(out, FAST_TEST_SIZE - 1, comp,
+					      comp_size, &out_size, &in_size,
+					      NULL));
+	ut_asserteq('A', out[FAST_TEST_SIZE - 1]);
+
+	/* Corrupt input may decode to anything, but not past the buffer */
+	out[FAST_TEST_SIZE] = 'A';
+	memset(comp + comp_size / 2, 0x49, 64);
+	ret = inflate_fast_buf(out, FAST_TEST_SIZE, comp, comp_size, &out_size,
+			       &in_size, NULL);
+	ut_assert(ret || out_size <= FAST_TEST_SIZE);
+	ut_asserteq('A', out[FAST_TEST_SIZE]);
+
+	/* gunzip() checks the trailer against the CRC of the output */
+	if (IS_ENABLED(CONFIG_GZIP_FAST_CRC)) {
+		comp_size = comp_max;
+		ut_assertok(gzip(comp, &comp_size, orig, FAST_TEST_SIZE));
+		ref_size = comp_size;
+		ut_assertok(gunzip(out, FAST_TEST_SIZE, comp, &ref_size));
+		comp[comp_size - 8] ^= 1;
+		ref_size = comp_size;
+		ut_asserteq(-1, gunzip(out, FAST_TEST_SIZE, comp, &ref_size));
+	}
+
+	/* Throughput of both engines on the default level, best of a few */
+	comp_size = comp_max;
+	ut_assertok(deflate_raw(orig, FAST_TEST_SIZE, comp, &comp_size, 6,
+				Z_DEFAULT_STRATEGY));
+	fast_us = ~0UL;
+	zlib_us = ~0UL;
+	for (i = 0; i < loops; i++) {
+		start = timer_get_us();
+		ut_assertok(inflate_fast_buf(out, FAST_TEST_SIZE, comp,
+					     comp_size, &out_size, &in_size,
+					     NULL));
+		fast_us = min(fast_us, timer_get_us() - start);
+
+		ref_size = FAST_TEST_SIZE;
+		start = timer_get_us();
+		ut_assertok(inflate_zlib(comp, comp_size, ref, &ref_size));
+		zlib_us = min(zlib_us, timer_get_us() - start);
+	}
+	printf("inflate %lu -> %d bytes: fast %lu MB/s, zlib %lu MB/s\n",
+	       comp_size, FAST_TEST_SIZE, FAST_TEST_SIZE / max(fast_us, 1UL),
+	       FAST_TEST_SIZE / max(zlib_us, 1UL));
+
+	free(ref);
+	free(out);
+	free(comp);
+	free(orig);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_gzip_fast, 0);
+
+/**
+ * bench_run() - time one decompressor
+ *
+ * @uts: Test state
+ * @comp: compression algorithm (IH_COMP_...)
+ * @in: compressed data
+ * @in_size: size of @in
+ * @expect: expected output
+ * @expect_len: size of @expect
+ * @out: output buffer of @expect_len bytes
+ * Return: 0 if OK, 1 on test failure
+ */
+static int bench_run(struct unit_test_state *uts, int comp, const void *in,
+		     ulong in_size, const void *expect, ulong expect_len,
+		     void *out)
+{
+	struct malloc_usage before, after;
+	ulong start_us, us, out_len = in_size;
+	u64 start, ticks;
+	u32 frac;
+	int ret;
+
+	/*
+	 * Decompress once first, so that one-time set-up, such as probing a
+	 * DMA engine for large copies, is not counted
+	 */
+	ret = image_decomp_buf(comp, out, expect_len, (void *)in, &out_len);
+	if (ret == -ENOSYS) {
+		printf("%-6s not enabled\n", genimg_get_comp_short_name(comp));
+		return 0;
+	}
+	ut_assertok(ret);
+
+	memset(out, '\0', expect_len);
+	out_len = in_size;
+	malloc_get_usage(&before);
+	malloc_reset_peak();
+	start_us = timer_get_us();
+	start = get_ticks();
+	ut_assertok(image_decomp_buf(comp, out, expect_len, (void *)in,
+				     &out_len));
+	ticks = get_ticks() - start;
+	us = max(timer_get_us() - start_us, 1UL);
+	malloc_get_usage(&after);
+	ut_asserteq(expect_len, out_len);
+	ut_asserteq_mem(expect, out, expect_len);
+	ut_asserteq(before.in_use, after.in_use);
+
+	/* Avoid 64-bit division, which some 32-bit toolchains lack */
+	ticks = lldiv(ticks * 1000, expect_len);
+	frac = do_div(ticks, 1000);
+	printf("%-6s %8lu %9llu %5llu.%03u %8lu\n",
+	       genimg_get_comp_short_name(comp), in_size,
+	       lldiv((u64)expect_len * 1000000 >> 10, us), ticks, frac,
+	       after.peak - after.in_use);
+
+	return 0;
+}
+
+/**
+ * compression_test_bench_norun() - compare the decompressors
+ *
+ * This needs a FIT at compression_bench_addr (hex) holding the same data once
+ * uncompressed, as the first image, and then compressed with each algorithm,
+ * so that every decompressor works on the same input. test_compression.py
+ * makes one from the start of the U-Boot binary; on a board, load such a FIT
+ * and run 'ut compression -f compression_test_bench_norun'.
+ *
+ * This shows the throughput, the timer ticks per output byte (CPU cycles, if
+ * the timer counts those) and, with SYS_MALLOC_STATS, the largest amount of
+ * heap used by the decompression.
+ */
+static int compression_test_bench_norun(struct unit_test_state *uts)
+{
+	const void *fit, *data, *expect = NULL;
+	size_t size, expect_len = 0;
+	void *out = NULL;
+	int images, node;
+	ulong addr;
+	u8 comp;
+
+	addr = env_get_hex("compression_bench_addr", 0);
+	ut_assert(addr);
+	fit = map_sysmem(addr, 0);
+	ut_assertok(fit_check_format(fit, IMAGE_SIZE_INVAL));
+	images = fdt_path_offset(fit, FIT_IMAGES_PATH);
+	ut_assert(images >= 0);
+
+	fdt_for_each_subnode(node, fit, images) {
+		ut_assertok(fit_image_get_data(fit, node, &data, &size));
+		if (fit_image_get_comp(fit, node, &comp))
+			comp = IH_COMP_NONE;
+		if (!expect) {
+			ut_asserteq(IH_COMP_NONE, comp);
+			expect = data;
+			expect_len = size;
+			out = malloc(size);
+			ut_assertnonnull(out);
+			printf("Decompressing %zu bytes, timer %lu Hz\n", size,
+			       get_tbclk());
+			printf("%-6s %8s %9s %9s %8s\n", "Algo", "Input",
+			       "KiB/s", "Ticks/B", "Heap");
+		}
+		ut_assertok(bench_run(uts, comp, data, size, expect,
+				      expect_len, out));
+	}
+	ut_assertnonnull(expect);
+	free(out);
+	unmap_sysmem(fit);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_bench_norun, UTF_MANUAL);
+
 static int compress_using_none(struct unit_test_state *uts,
 			       void *in, unsigned long in_size,
 			       void *out, unsigned long out_max,
@@ -6,10 +6,15 @@
  * Grygorii Strashko <grygorii.strashko@ti.com>
  */
 
+#include <command.h>
 #include <dm.h>
 #include <malloc.h>
+#include <mapmem.h>
+#include <memalign.h>
+#include <time.h>
 #include <dm/test.h>
 #include <dma.h>
+#include <linux/sizes.h>
 #include <test/test.h>
 #include <test/ut.h>
 
@@ -122,3 +127,155 @@ static int dm_test_dma_rx(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_dma_rx, UTF_SCAN_FDT);
+
+static void dma_test_fill(u8 *buf, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = i * 7 + (i >> 12);
+}
+
+static int dm_test_dma_memcpy_async(struct unit_test_state *uts)
+{
+	const size_t line = ARCH_DMA_MINALIGN;
+	struct dma_memcpy_tx tx[5];
+	size_t len = 3 * SZ_64K + 2 * line;
+	u8 *src, *dst, *small;
+	int i;
+
+	src = memalign(line, len);
+	dst = memalign(line, len);
+	small = memalign(line, 4 * line);
+	ut_assertnonnull(src);
+	ut_assertnonnull(dst);
+	ut_assertnonnull(small);
+	dma_test_fill(src, len);
+	memset(dst, '\0', len);
+	memset(small, '\0', 4 * line);
+
+	/* Areas sharing a cache line with other data are refused */
+	ut_asserteq(-EINVAL, dma_memcpy_submit(&tx[0], dst + 1, src, line));
+	ut_asserteq(-EINVAL, dma_memcpy_submit(&tx[0], dst, src + 1, line));
+	ut_asserteq(-EINVAL, dma_memcpy_submit(&tx[0], dst, src, line + 1));
+	ut_asserteq(0, dst[0]);
+
+	/* The emulated engine copies 64KiB each time it is polled */
+	ut_assertok(dma_memcpy_submit(&tx[0], dst, src, len));
+	ut_asserteq(-EINPROGRESS, dma_memcpy_poll(&tx[0]));
+	ut_asserteq_mem(src, dst, SZ_64K);
+	ut_asserteq(0, dst[SZ_64K]);
+
+	/* Four transfers can be queued, they complete in order */
+	for (i = 1; i < 4; i++)
+		ut_assertok(dma_memcpy_submit(&tx[i], small + i * line,
+					      src + i * line, line));
+	ut_asserteq(-EBUSY, dma_memcpy_submit(&tx[4], small, src, line));
+	ut_assertok(dma_memcpy_wait(&tx[1]));
+	ut_assertok(dma_memcpy_poll(&tx[0]));
+	ut_asserteq_mem(src, dst, len);
+	ut_asserteq(0, small[3 * line]);
+	ut_assertok(dma_memcpy_wait(&tx[3]));
+	ut_assertok(dma_memcpy_poll(&tx[2]));
+	ut_asserteq_mem(src + line, small + line, 3 * line);
+
+	free(small);
+	free(dst);
+	free(src);
+
+	return 0;
+}
+DM_TEST(dm_test_dma_memcpy_async, UTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(DMA_MEMCPY_OFFLOAD)
+/* Get the number of transfers submitted to the DMA engine so far */
+static int dma_test_count(struct unit_test_state *uts, ulong *countp)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(u8, buf, ARCH_DMA_MINALIGN);
+	struct dma_memcpy_tx tx;
+
+	ut_assertok(dma_memcpy_submit(&tx, buf, buf, ARCH_DMA_MINALIGN));
+	ut_assertok(dma_memcpy_wait(&tx));
+	*countp = tx.cookie;
+
+	return 0;
+}
+
+static int dm_test_dma_memcpy_offload(struct unit_test_state *uts)
+{
+	size_t len = CONFIG_DMA_MEMCPY_OFFLOAD_MIN;
+	ulong count, next;
+	u8 *src, *dst;
+
+	src = memalign(ARCH_DMA_MINALIGN, len);
+	dst = memalign(ARCH_DMA_MINALIGN, len + ARCH_DMA_MINALIGN);
+	ut_assertnonnull(src);
+	ut_assertnonnull(dst);
+	dma_test_fill(src, len);
+	memset(dst, '\0', len + ARCH_DMA_MINALIGN);
+
+	/* Small, misaligned and overlapping copies are left to the CPU */
+	ut_assertok(dma_test_count(uts, &count));
+	ut_assert(dma_memcpy_offload(dst, src, len - ARCH_DMA_MINALIGN));
+	ut_assert(dma_memcpy_offload(dst + 1, src, len));
+	ut_assert(dma_memcpy_offload(dst, src + 1, len));
+	ut_assert(dma_memcpy_offload(dst, dst + ARCH_DMA_MINALIGN, len));
+	ut_asserteq(0, dst[0]);
+	ut_assertok(dma_test_count(uts, &next));
+	ut_asserteq(count + 1, next);
+
+	ut_assertok(dma_memcpy_offload(dst, src, len));
+	ut_asserteq_mem(src, dst, len);
+	ut_assertok(dma_test_count(uts, &count));
+	ut_asserteq(next + 2, count);
+
+	/* The cp command uses the DMA engine too */
+	memset(dst, '\0', len);
+	ut_assertok(run_commandf("cp.b %lx %lx %zx", (ulong)map_to_sysmem(src),
+				 (ulong)map_to_sysmem(dst), len));
+	ut_asserteq_mem(src, dst, len);
+	ut_assertok(dma_test_count(uts, &next));
+	ut_asserteq(count + 2, next);
+
+	free(dst);
+	free(src);
+
+	return 0;
+}
+DM_TEST(dm_test_dma_memcpy_offload, UTF_SCAN_FDT);
+#endif
+
+/* Report the CPU and DMA copy rates */
+static int dm_test_dma_memcpy_perf(struct unit_test_state *uts)
+{
+	const size_t len = SZ_16M;
+	struct dma_memcpy_tx tx;
+	ulong start, cpu, dma;
+	u8 *src, *dst;
+
+	src = memalign(ARCH_DMA_MINALIGN, len);
+	dst = memalign(ARCH_DMA_MINALIGN, len);
+	ut_assertnonnull(src);
+	ut_assertnonnull(dst);
+	dma_test_fill(src, len);
+
+	start = timer_get_us();
+	memcpy(dst, src, len);
+	cpu = timer_get_us() - start;
+
+	memset(dst, '\0', len);
+	start = timer_get_us();
+	ut_assertok(dma_memcpy_submit(&tx, dst, src, len));
+	ut_assertok(dma_memcpy_wait(&tx));
+	dma = timer_get_us() - start;
+	ut_asserteq_mem(src, dst, len);
+
+	free(dst);
+	free(src);
+
+	printf("copy of %zu MiB: CPU %lu us (%zu MB/s), DMA %lu us (%zu MB/s)\n",
+	       len / SZ_1M, cpu, len / (cpu ?: 1), dma, len / (dma ?: 1));
+
+	return 0;
+}
+DM_TEST(dm_test_dma_memcpy_perf, UTF_SCAN_FDT);
@@ -3,18 +3,27 @@
  * Copyright (C) 2015 Google, Inc
  */
 
+#include <blk.h>
 #include <dm.h>
 #include <fastboot.h>
 #include <fb_mmc.h>
+#include <image-sparse.h>
+#include <malloc.h>
 #include <mmc.h>
 #include <part.h>
 #include <part_efi.h>
 #include <dm/test.h>
 #include <test/ut.h>
+#include <linux/sizes.h>
 #include <linux/stringify.h>
 
 #define FB_ALIAS_PREFIX "fastboot_partition_alias_"
 
+/* Sparse blocks in the partition used for streaming */
+#define FB_STREAM_BLKS		240
+#define FB_STREAM_BLK_SZ	4096
+#define FB_STREAM_SIZE		(FB_STREAM_BLKS * FB_STREAM_BLK_SZ)
+
 static int dm_test_fastboot_mmc_part(struct unit_test_state *uts)
 {
 	char response[FASTBOOT_RESPONSE_LEN] = {0};
@@ -92,3 +101,172 @@ static int dm_test_fastboot_mmc_part(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_fastboot_mmc_part, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
+/**
+ * fb_sparse_chunk() - Append a chunk to a sparse image
+ *
+ * @p: Where to put the chunk
+ * @type: Chunk type
+ * @blks: Number of sparse blocks covered by the chunk
+ * @data: Chunk data
+ * @len: Number of bytes at @data
+ * Return: Pointer to the end of the chunk
+ */
+static void *fb_sparse_chunk(void *p, u16 type, u32 blks, const void *data,
+			     u32 len)
+{
+	chunk_header_t *chunk = p;
+
+	chunk->chunk_type = cpu_to_le16(type);
+	chunk->reserved1 = 0;
+	chunk->chunk_sz = cpu_to_le32(blks);
+	chunk->total_sz = cpu_to_le32(sizeof(*chunk) + len);
+	memcpy(chunk + 1, data, len);
+
+	return (void *)(chunk + 1) + len;
+}
+
+/**
+ * fb_stream_image() - Stream an image through the fastboot download path
+ *
+ * @uts: Test state
+ * @image: Image to download
+ * @size: Number of bytes to download
+ * @part: Partition to stream to, or NULL to download normally
+ * @response: Pointer to fastboot response buffer, holds the "flash" result
+ * Return: 0 if the download went through, 1 on test failure
+ */
+static int fb_stream_image(struct unit_test_state *uts, const u8 *image,
+			   u32 size, const char *part, char *response)
+{
+	char cmd[FASTBOOT_COMMAND_LEN];
+	u32 pos, n;
+
+	if (part) {
+		snprintf(cmd, sizeof(cmd), "oem stream:%s", part);
+		ut_asserteq(FASTBOOT_COMMAND_OEM_STREAM,
+			    fastboot_handle_command(cmd, response));
+		ut_asserteq_str("OKAY", response);
+	}
+
+	snprintf(cmd, sizeof(cmd), "download:%08x", size);
+	ut_asserteq(FASTBOOT_COMMAND_DOWNLOAD,
+		    fastboot_handle_command(cmd, response));
+	if (strncmp("DATA", response, 4))
+		return 0;
+
+	/* Use an odd packet size so that headers are split */
+	for (pos = 0; pos < size; pos += n) {
+		n = min(size - pos, 509U);
+		fastboot_data_download(image + pos, n, response);
+		ut_asserteq_str("", response);
+	}
+	ut_asserteq(0, fastboot_data_remaining());
+	fastboot_data_complete(response);
+	ut_asserteq_str("OKAY", response);
+
+	snprintf(cmd, sizeof(cmd), "flash:%s", part);
+	ut_asserteq(FASTBOOT_COMMAND_FLASH,
+		    fastboot_handle_command(cmd, response));
+
+	return 0;
+}
+
+/*
+ * Stream a sparse image which is much larger than the download buffer and
+ * check that it is written completely
+ */
+static int dm_test_fastboot_mmc_stream(struct unit_test_state *uts)
+{
+	char response[FASTBOOT_RESPONSE_LEN] = {0};
+	char str_disk_guid[UUID_STR_LEN + 1];
+	struct blk_desc *mmc_dev_desc;
+	struct disk_partition parts[1] = {
+		{
+			.start = 48,
+			.size = FB_STREAM_SIZE / 512,
+			.name = "stream",
+		},
+	};
+	static const u32 fill[2] = { 0x5aa5c33c, 0xffffffff };
+	u8 *image, *expect, *buf, *p;
+	sparse_header_t *header;
+	u32 crc = 0, size, i;
+	ulong blks;
+
+	ut_assertok(blk_get_device_by_str("mmc", "0", &mmc_dev_desc));
+	ut_asserteq(512, mmc_dev_desc->blksz);
+	if (CONFIG_IS_ENABLED(RANDOM_UUID)) {
+		gen_rand_uuid_str(parts[0].uuid, UUID_STR_FORMAT_STD);
+		gen_rand_uuid_str(str_disk_guid, UUID_STR_FORMAT_STD);
+	}
+	ut_assertok(gpt_restore(mmc_dev_desc, str_disk_guid, parts,
+				ARRAY_SIZE(parts)));
+	blks = parts[0].size;
+
+	image = malloc(FB_STREAM_SIZE + SZ_4K);
+	expect = malloc(FB_STREAM_SIZE);
+	buf = malloc(CONFIG_FASTBOOT_BUF_SIZE);
+	ut_assertnonnull(image);
+	ut_assertnonnull(expect);
+	ut_assertnonnull(buf);
+	ut_assert(FB_STREAM_SIZE > 16 * CONFIG_FASTBOOT_BUF_SIZE);
+
+	/* Don't-care areas keep what is on the partition already */
+	memset(expect, 0xee, FB_STREAM_SIZE);
+	ut_asserteq(blks, blk_dwrite(mmc_dev_desc, parts[0].start, blks,
+				     expect));
+	for (i = 0; i < FB_STREAM_SIZE; i++)
+		expect[i] = i * 7 + (i >> 12);
+
+	header = (sparse_header_t *)image;
+	header->magic = cpu_to_le32(SPARSE_HEADER_MAGIC);
+	header->major_version = cpu_to_le16(1);
+	header->minor_version = 0;
+	header->file_hdr_sz = cpu_to_le16(sizeof(*header));
+	header->chunk_hdr_sz = cpu_to_le16(sizeof(chunk_header_t));
+	header->blk_sz = cpu_to_le32(FB_STREAM_BLK_SZ);
+	header->total_blks = cpu_to_le32(232);
+	header->total_chunks = cpu_to_le32(6);
+	header->image_checksum = 0;
+
+	p = (u8 *)(header + 1);
+	p = fb_sparse_chunk(p, CHUNK_TYPE_RAW, 96, expect, 96 * SZ_4K);
+	p = fb_sparse_chunk(p, CHUNK_TYPE_FILL, 32, &fill[0], 4);
+	for (i = 96 * SZ_4K; i < 128 * SZ_4K; i += 4)
+		memcpy(expect + i, &fill[0], 4);
+	p = fb_sparse_chunk(p, CHUNK_TYPE_DONT_CARE, 16, NULL, 0);
+	memset(expect + 128 * SZ_4K, 0xee, 16 * SZ_4K);
+	p = fb_sparse_chunk(p, CHUNK_TYPE_CRC32, 0, &crc, 4);
+	p = fb_sparse_chunk(p, CHUNK_TYPE_RAW, 80, expect + 144 * SZ_4K,
+			    80 * SZ_4K);
+	p = fb_sparse_chunk(p, CHUNK_TYPE_FILL, 8, &fill[1], 4);
+	memset(expect + 224 * SZ_4K, 0xff, 8 * SZ_4K);
+	memset(expect + 232 * SZ_4K, 0xee, 8 * SZ_4K);
+	size = p - image;
+
+	fastboot_init(buf, CONFIG_FASTBOOT_BUF_SIZE);
+
+	/* Without streaming the image does not fit */
+	ut_assertok(fb_stream_image(uts, image, size, NULL, response));
+	ut_asserteq_strn("FAIL", response);
+
+	/* A truncated image is reported by the flash command */
+	ut_assertok(fb_stream_image(uts, image, size - 100, "stream",
+				    response));
+	ut_asserteq_str("FAILsparse image truncated", response);
+
+	/* The image is written while it is downloaded */
+	ut_assertok(fb_stream_image(uts, image, size, "stream", response));
+	ut_asserteq_str("OKAY", response);
+	ut_asserteq(blks, blk_dread(mmc_dev_desc, parts[0].start, blks, image));
+	ut_asserteq_mem(expect, image, FB_STREAM_SIZE);
+
+	fastboot_init(NULL, 0);
+	free(buf);
+	free(expect);
+	free(image);
+
+	return 0;
+}
+DM_TEST(dm_test_fastboot_mmc_stream, UTF_SCAN_PDATA | UTF_SCAN_FDT);
@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for offloading hashes to the hash uclass
+ */
+
+#include <command.h>
+#include <dm.h>
+#include <env.h>
+#include <hash.h>
+#include <image.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <dm/test.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <u-boot/hash.h>
+
+#define HASH_TEST_SIZE	10000
+
+static void hash_test_fill(u8 *buf, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = i * 13 + (i >> 8);
+}
+
+static u64 hash_test_bytes(struct udevice *dev)
+{
+	struct hash_dev_priv *uc_priv = dev_get_uclass_priv(dev);
+
+	return uc_priv->bytes;
+}
+
+static int dm_test_hash_offload(struct unit_test_state *uts)
+{
+	u8 sw[HASH_MAX_DIGEST_SIZE], hw[HASH_MAX_DIGEST_SIZE];
+	struct udevice *dev, *tmp;
+	int len;
+	u8 *buf;
+
+	/* The sandbox engine offloads SHA1 and SHA256 only */
+	ut_assertok(hash_find_device(HASH_ALGO_SHA256, &dev));
+	ut_asserteq_str("hash", dev->name);
+	ut_assertok(hash_find_device(HASH_ALGO_SHA1, &tmp));
+	ut_asserteq_ptr(dev, tmp);
+	ut_asserteq(-ENODEV, hash_find_device(HASH_ALGO_MD5, &tmp));
+	ut_asserteq(-ENODEV, hash_find_device(HASH_ALGO_CRC32, &tmp));
+	ut_asserteq(-ENODEV, hash_find_device(HASH_ALGO_INVALID, &tmp));
+
+	buf = malloc(HASH_TEST_SIZE);
+	ut_assertnonnull(buf);
+	hash_test_fill(buf, HASH_TEST_SIZE);
+
+	/* Chunking must not change the digest */
+	len = sizeof(sw);
+	ut_assertok(hash_block("sha256", buf, HASH_TEST_SIZE, sw, &len));
+	ut_assertok(hash_digest_chunked(dev, HASH_ALGO_SHA256, buf,
+					HASH_TEST_SIZE, hw, 999));
+	ut_asserteq_mem(sw, hw, len);
+	ut_assertok(hash_digest_chunked(dev, HASH_ALGO_SHA256, buf,
+					HASH_TEST_SIZE, hw, 0));
+	ut_asserteq_mem(sw, hw, len);
+	ut_asserteq(2 * HASH_TEST_SIZE, hash_test_bytes(dev));
+
+	ut_asserteq(-ENODEV, hash_offload("md5", buf, HASH_TEST_SIZE, hw, 0));
+	ut_asserteq(2 * HASH_TEST_SIZE, hash_test_bytes(dev));
+	free(buf);
+
+	return 0;
+}
+DM_TEST(dm_test_hash_offload, UTF_SCAN_FDT);
+
+/* FIT hashes and the hash command use the device when they can */
+static int dm_test_hash_users(struct unit_test_state *uts)
+{
+	u8 sw[HASH_MAX_DIGEST_SIZE], hw[HASH_MAX_DIGEST_SIZE];
+	struct udevice *dev;
+	int len, hw_len;
+	ulong addr;
+	u8 *buf;
+
+	ut_assertok(hash_find_device(HASH_ALGO_SHA1, &dev));
+	buf = malloc(HASH_TEST_SIZE);
+	ut_assertnonnull(buf);
+	hash_test_fill(buf, HASH_TEST_SIZE);
+	addr = map_to_sysmem(buf);
+
+	len = sizeof(sw);
+	ut_assertok(hash_block("sha1", buf, HASH_TEST_SIZE, sw, &len));
+	ut_assertok(calculate_hash(buf, HASH_TEST_SIZE, "sha1", hw, &hw_len));
+	ut_asserteq(len, hw_len);
+	ut_asserteq_mem(sw, hw, len);
+	ut_asserteq(HASH_TEST_SIZE, hash_test_bytes(dev));
+
+	/* Algorithms without a device are hashed in software */
+	len = sizeof(sw);
+	ut_assertok(hash_block("crc32", buf, HASH_TEST_SIZE, sw, &len));
+	ut_assertok(calculate_hash(buf, HASH_TEST_SIZE, "crc32", hw, &hw_len));
+	ut_asserteq(len, hw_len);
+	ut_asserteq_mem(sw, hw, len);
+	ut_asserteq(HASH_TEST_SIZE, hash_test_bytes(dev));
+
+	ut_assertok(run_commandf("hash sha256 %lx %x hashval", addr,
+				 HASH_TEST_SIZE));
+	ut_asserteq(2 * HASH_TEST_SIZE, hash_test_bytes(dev));
+	len = sizeof(sw);
+	ut_assertok(hash_block("sha256", buf, HASH_TEST_SIZE, sw, &len));
+	ut_assertok(hash_parse_string("sha256", env_get("hashval"), hw));
+	ut_asserteq_mem(sw, hw, len);
+	env_set("hashval", NULL);
+	ut_assertok(run_commandf("crc32 %lx %x", addr, HASH_TEST_SIZE));
+	ut_asserteq(2 * HASH_TEST_SIZE, hash_test_bytes(dev));
+	unmap_sysmem(buf);
+	free(buf);
+
+	console_record_reset_enable();
+	ut_assertok(run_command("hash stats", 0));
+	ut_assert_nextline("Device                Bytes    Time (ms)       KiB/s");
+	ut_assert_nextlinen("hash                  20000");
+	ut_assert_console_end();
+
+	return 0;
+}
+DM_TEST(dm_test_hash_users, UTF_SCAN_FDT | UTF_CONSOLE);
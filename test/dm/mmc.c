@@ -3,10 +3,12 @@
  * Copyright (C) 2015 Google, Inc
  */
 
+#include <cyclic.h>
 #include <dm.h>
 #include <mmc.h>
 #include <part.h>
 #include <dm/test.h>
+#include <linux/delay.h>
 #include <test/test.h>
 #include <test/ut.h>
 
@@ -51,3 +53,75 @@ static int dm_test_mmc_blk(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_mmc_blk, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(MMC_ASYNC_INIT)
+/* Check whether a cyclic function is registered */
+static bool cyclic_registered(struct cyclic_info *info)
+{
+	struct cyclic_info *cyclic;
+
+	hlist_for_each_entry(cyclic, cyclic_get_list(), list) {
+		if (cyclic == info)
+			return true;
+	}
+
+	return false;
+}
+
+/* Test initialising a device in the background */
+static int dm_test_mmc_async(struct unit_test_state *uts)
+{
+	struct blk_desc *dev_desc;
+	struct udevice *dev;
+	struct mmc *mmc;
+	int i;
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	mmc = mmc_get_mmc_dev(dev);
+
+	/* The card may have been used already, so start again */
+	mmc->has_init = 0;
+	mmc_async_init(mmc);
+	ut_assert(mmc_async_pending(mmc));
+	ut_assert(cyclic_registered(&mmc->async_cyclic));
+
+	/* Delays run cyclic functions, which move things along */
+	for (i = 0; i < 100 && mmc_async_pending(mmc); i++)
+		mdelay(1);
+	ut_assert(!mmc_async_pending(mmc));
+	ut_assert(!cyclic_registered(&mmc->async_cyclic));
+	ut_asserteq(1, mmc->has_init);
+
+	/* Starting again does nothing */
+	mmc_async_init(mmc);
+	ut_assert(!mmc_async_pending(mmc));
+
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+	ut_asserteq(512, dev_desc->blksz);
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_async, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
+/* Test using a device before background initialisation has finished */
+static int dm_test_mmc_async_wait(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+	struct mmc *mmc;
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	mmc = mmc_get_mmc_dev(dev);
+	mmc->has_init = 0;
+	mmc_async_init(mmc);
+	ut_assert(mmc_async_pending(mmc));
+
+	/* Using the device finishes the initialisation */
+	ut_assertok(mmc_init(mmc));
+	ut_assert(!mmc_async_pending(mmc));
+	ut_assert(!cyclic_registered(&mmc->async_cyclic));
+	ut_asserteq(1, mmc->has_init);
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_async_wait, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+#endif
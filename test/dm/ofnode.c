@@ -20,6 +20,7 @@
 #include <dm.h>
 #include <log.h>
 #include <of_live.h>
+#include <time.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <dm/of_extra.h>
@@ -1521,3 +1522,211 @@ static int dm_test_bool(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_bool, UTF_SCAN_FDT);
+
+#if IS_ENABLED(CONFIG_OF_LIVE)
+enum {
+	BIG_NODES	= 1000,
+	BIG_PROPS	= 16,
+};
+
+/**
+ * make_big_tree() - Create a live tree with many nodes and properties
+ *
+ * Each node /node@<n> has a phandle of n + 1 and BIG_PROPS u32 properties
+ * called prop-<j> with the value n * BIG_PROPS + j. The first node has two
+ * 'dup' properties with the values 1 and 2.
+ *
+ * @uts: Test state
+ * @fdtp: Returns the flat tree, to be freed after the live tree
+ * @rootp: Returns the root of the live tree
+ * Return: 0 if OK
+ */
+static int make_big_tree(struct unit_test_state *uts, void **fdtp,
+			 struct device_node **rootp)
+{
+	const int size = SZ_1M;
+	char name[20];
+	void *fdt;
+	int i, j;
+
+	fdt = malloc(size);
+	ut_assertnonnull(fdt);
+	ut_assertok(fdt_create(fdt, size));
+	ut_assertok(fdt_finish_reservemap(fdt));
+	ut_assertok(fdt_begin_node(fdt, ""));
+	for (i = 0; i < BIG_NODES; i++) {
+		snprintf(name, sizeof(name), "node@%x", i);
+		ut_assertok(fdt_begin_node(fdt, name));
+		ut_assertok(fdt_property_u32(fdt, "phandle", i + 1));
+		if (!i) {
+			ut_assertok(fdt_property_u32(fdt, "dup", 1));
+			ut_assertok(fdt_property_u32(fdt, "dup", 2));
+		}
+		for (j = 0; j < BIG_PROPS; j++) {
+			snprintf(name, sizeof(name), "prop-%d", j);
+			ut_assertok(fdt_property_u32(fdt, name,
+						     i * BIG_PROPS + j));
+		}
+		ut_assertok(fdt_end_node(fdt));
+	}
+	ut_assertok(fdt_end_node(fdt));
+	ut_assertok(fdt_finish(fdt));
+
+	ut_assertok(unflatten_device_tree(fdt, rootp));
+	*fdtp = fdt;
+
+	return 0;
+}
+
+/* check property lookup with the per-node property hash */
+static int dm_test_livetree_prop_hash(struct unit_test_state *uts)
+{
+	struct device_node *root, *np;
+	struct property *pp;
+	char name[20];
+	void *fdt;
+	u32 val;
+	int len, i;
+
+	ut_assertok(make_big_tree(uts, &fdt, &root));
+	np = root->child;
+	ut_assertnonnull(np);
+#if IS_ENABLED(CONFIG_OF_LIVE_PROP_HASH)
+	ut_assertnonnull(np->prop_hash);
+#endif
+
+	/* every property must be found, with the first duplicate winning */
+	for (pp = np->properties; pp; pp = pp->next) {
+		struct property *first = np->properties;
+
+		while (strcmp(first->name, pp->name))
+			first = first->next;
+		ut_asserteq_ptr(first, of_find_property(np, pp->name, &len));
+		ut_asserteq(pp->length, len);
+	}
+	ut_assertok(of_read_u32(np, "dup", &val));
+	ut_asserteq(1, val);
+	ut_assertok(of_read_u32(np, "prop-15", &val));
+	ut_asserteq(15, val);
+	ut_assertnull(of_find_property(np, "prop-", &len));
+	ut_asserteq(-FDT_ERR_NOTFOUND, len);
+	ut_assertnull(of_find_property(np, "missing", NULL));
+
+	/* adding and removing properties must keep lookups working */
+	ut_assertok(of_write_prop(np, "new-prop", 4, "abc"));
+	ut_asserteq_str("abc", of_get_property(np, "new-prop", NULL));
+	pp = of_find_property(np, "prop-3", NULL);
+	ut_assertok(of_remove_property(np, pp));
+	ut_assertnull(of_find_property(np, "prop-3", NULL));
+	ut_assertok(of_read_u32(np, "prop-4", &val));
+	ut_asserteq(4, val);
+
+	/* check the other nodes */
+	for (i = 0, np = root->child; np; i++, np = np->sibling) {
+		if (!i)
+			continue;
+		snprintf(name, sizeof(name), "prop-%d", i % BIG_PROPS);
+		ut_assertok(of_read_u32(np, name, &val));
+		ut_asserteq(i * BIG_PROPS + i % BIG_PROPS, val);
+	}
+	ut_asserteq(BIG_NODES, i);
+
+	of_live_free(root);
+	free(fdt);
+
+	return 0;
+}
+DM_TEST(dm_test_livetree_prop_hash, UTF_LIVE_TREE);
+
+/* check phandle lookup with the phandle table */
+static int dm_test_livetree_phandle_table(struct unit_test_state *uts)
+{
+	struct device_node *root, *np;
+	void *fdt;
+	int i;
+
+	ut_assertok(make_big_tree(uts, &fdt, &root));
+	ut_assertok(of_phandle_table_build(root));
+
+	for (i = 0, np = root->child; np; i++, np = np->sibling)
+		ut_asserteq_ptr(np, of_find_node_by_phandle(root, i + 1));
+	ut_assertnull(of_find_node_by_phandle(root, 0));
+	ut_assertnull(of_find_node_by_phandle(root, BIG_NODES + 1));
+	ut_assertnull(of_find_node_by_phandle(root, 0xffffffff));
+
+	/* a removed node must not be found */
+	np = of_find_node_by_phandle(root, 5);
+	ut_assertok(of_remove_node(np));
+	ut_assertnull(of_find_node_by_phandle(root, 5));
+	ut_asserteq_ptr(np->sibling, of_find_node_by_phandle(root, 6));
+
+	of_live_free(root);
+	free(fdt);
+
+	/* put back the table for the control tree */
+	if (IS_ENABLED(CONFIG_OF_LIVE_PHANDLE_TABLE))
+		ut_assertok(of_phandle_table_build(gd_of_root()));
+
+	return 0;
+}
+DM_TEST(dm_test_livetree_phandle_table, UTF_SCAN_FDT | UTF_LIVE_TREE);
+
+#if IS_ENABLED(CONFIG_OF_LIVE_PROP_HASH)
+/* compare lookup times with and without the property hash / phandle table */
+static int dm_test_livetree_lookup_perf(struct unit_test_state *uts)
+{
+	struct device_node *root, *np;
+	ulong start, hashed, listed, table, search;
+	char names[BIG_PROPS][20];
+	struct of_prop_hash *ph;
+	void *fdt;
+	int i, j;
+
+	ut_assertok(make_big_tree(uts, &fdt, &root));
+	for (j = 0; j < BIG_PROPS; j++)
+		snprintf(names[j], sizeof(names[j]), "prop-%d", j);
+
+	start = timer_get_us();
+	for (np = root->child; np; np = np->sibling) {
+		for (j = 0; j < BIG_PROPS; j++)
+			ut_assertnonnull(of_find_property(np, names[j], NULL));
+	}
+	hashed = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (np = root->child; np; np = np->sibling) {
+		ph = np->prop_hash;
+		np->prop_hash = NULL;
+		for (j = 0; j < BIG_PROPS; j++)
+			ut_assertnonnull(of_find_property(np, names[j], NULL));
+		np->prop_hash = ph;
+	}
+	listed = timer_get_us() - start;
+
+	ut_assertok(of_phandle_table_build(root));
+	start = timer_get_us();
+	for (i = 1; i <= BIG_NODES; i++)
+		ut_assertnonnull(of_find_node_by_phandle(root, i));
+	table = timer_get_us() - start;
+
+	of_phandle_table_free(root);
+	start = timer_get_us();
+	for (i = 1; i <= BIG_NODES; i++)
+		ut_assertnonnull(of_find_node_by_phandle(root, i));
+	search = timer_get_us() - start;
+
+	printf("%d property lookups: %lu us hashed, %lu us listed\n",
+	       BIG_NODES * BIG_PROPS, hashed, listed);
+	printf("%d phandle lookups: %lu us with table, %lu us searching\n",
+	       BIG_NODES, table, search);
+
+	of_live_free(root);
+	free(fdt);
+	if (IS_ENABLED(CONFIG_OF_LIVE_PHANDLE_TABLE))
+		ut_assertok(of_phandle_table_build(gd_of_root()));
+
+	return 0;
+}
+DM_TEST(dm_test_livetree_lookup_perf, UTF_SCAN_FDT | UTF_LIVE_TREE);
+#endif /* OF_LIVE_PROP_HASH */
+#endif /* OF_LIVE */
@@ -4,8 +4,10 @@
  */
 
 #include <console.h>
+#include <cyclic.h>
 #include <dm.h>
 #include <part.h>
+#include <time.h>
 #include <usb.h>
 #include <asm/io.h>
 #include <asm/state.h>
@@ -166,6 +168,92 @@ static int dm_test_usb_stop(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_usb_stop, UTF_SCAN_PDATA | UTF_SCAN_FDT);
 
+/* test enumerating devices in the background */
+static int dm_test_usb_async(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+
+	if (!CONFIG_IS_ENABLED(USB_ASYNC_SCAN))
+		return -EAGAIN;
+
+	state_set_skip_delays(true);
+	ut_assertok(usb_init_start());
+	ut_assert(usb_scan_busy());
+	ut_asserteq(-EALREADY, usb_init_start());
+
+	/* Waiting finishes the scan, with the same result as usb_init() */
+	ut_assertok(usb_scan_wait());
+	ut_assert(!usb_scan_busy());
+	ut_assertok(uclass_get_device(UCLASS_MASS_STORAGE, 0, &dev));
+	ut_assertok(uclass_get_device(UCLASS_MASS_STORAGE, 1, &dev));
+	ut_assertok(uclass_get_device(UCLASS_MASS_STORAGE, 2, &dev));
+	ut_asserteq(6, count_usb_devices());
+	ut_assertok(usb_stop());
+
+	/* Stopping part-way through drops the ports not yet scanned */
+	ut_assertok(usb_init_start());
+	ut_assertok(usb_stop());
+	ut_assert(!usb_scan_busy());
+	ut_asserteq(0, count_usb_devices());
+
+	/* Removing a bus part-way through drops the ports of its hubs */
+	ut_assertok(usb_init_start());
+	ut_assertok(uclass_first_device_err(UCLASS_USB, &dev));
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_assertok(usb_scan_wait());
+	ut_assert(!usb_scan_busy());
+	ut_assertok(usb_stop());
+
+	/* Once cancelled, hubs scan their ports straight away again */
+	ut_assertok(usb_init_start());
+	usb_scan_cancel();
+	ut_assert(!usb_scan_busy());
+	ut_assertok(usb_stop());
+	ut_assertok(usb_init());
+	ut_asserteq(6, count_usb_devices());
+	ut_assertok(usb_stop());
+
+	/* usb_init() finishes a scan which is already running */
+	ut_assertok(usb_init_start());
+	ut_assertok(usb_init());
+	ut_assert(!usb_scan_busy());
+	ut_asserteq(6, count_usb_devices());
+	ut_assertok(usb_stop());
+
+	return 0;
+}
+DM_TEST(dm_test_usb_async, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
+/* test that the cyclic function enumerates devices without any waiting */
+static int dm_test_usb_async_cyclic(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+	ulong start;
+
+	if (!CONFIG_IS_ENABLED(USB_ASYNC_SCAN))
+		return -EAGAIN;
+
+	state_set_skip_delays(true);
+	ut_assertok(usb_init_start());
+	start = get_timer(0);
+	dev = NULL;
+	while (!dev && get_timer(start) < 1000) {
+		schedule();
+		uclass_find_device(UCLASS_MASS_STORAGE, 2, &dev);
+	}
+	ut_assertnonnull(dev);
+
+	/* The result is still collected by waiting for the scan */
+	ut_assert(usb_scan_busy());
+	ut_assertok(usb_scan_wait());
+	ut_assert(!usb_scan_busy());
+	ut_asserteq(6, count_usb_devices());
+	ut_assertok(usb_stop());
+
+	return 0;
+}
+DM_TEST(dm_test_usb_async_cyclic, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
 /**
  * dm_test_usb_keyb() - test USB keyboard driver
  *
@@ -15,6 +15,7 @@
 #include <video_console.h>
 #include <asm/test.h>
 #include <asm/sdl.h>
+#include <dm/device-internal.h>
 #include <dm/test.h>
 #include <dm/uclass-internal.h>
 #include <test/test.h>
@@ -603,3 +604,225 @@ static int dm_test_video_truetype_bs(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_video_truetype_bs, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
+/* Test that damage tracking only flushes the regions which were drawn */
+static int dm_test_video_damage(struct unit_test_state *uts)
+{
+	struct video_damage *damage;
+	struct video_priv *priv;
+	struct udevice *dev, *con;
+
+	if (!IS_ENABLED(CONFIG_VIDEO_DAMAGE))
+		return -EAGAIN;
+
+	ut_assertok(select_vidconsole(uts, "vidconsole0"));
+	ut_assertok(video_get_nologo(uts, &dev));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO_CONSOLE, 0, &con));
+	ut_assertok(vidconsole_select_font(con, "8x16", 0));
+	priv = dev_get_uclass_priv(dev);
+	damage = &priv->damage;
+	video_set_flush_dcache(dev, true);
+
+	/* clearing the display damages all of it */
+	damage->flush_bytes = 0;
+	ut_assertok(video_clear(dev));
+	ut_assertok(video_sync(dev, true));
+	ut_asserteq(0, damage->count);
+	ut_asserteq(priv->fb_size, damage->flush_bytes);
+
+	/* a character only damages its own cell */
+	damage->flush_bytes = 0;
+	vidconsole_putc_xy(con, VID_TO_POS(8), 16, 'a');
+	ut_asserteq(1, damage->count);
+	ut_asserteq(8, damage->rect[0].x0);
+	ut_asserteq(16, damage->rect[0].y0);
+	ut_asserteq(16, damage->rect[0].x1);
+	ut_asserteq(32, damage->rect[0].y1);
+	ut_assertok(video_sync(dev, true));
+	ut_assert(damage->flush_bytes >= 8 * 16 * 2);
+	ut_assert(damage->flush_bytes <= 16 * 2 * CONFIG_SYS_CACHELINE_SIZE);
+
+	/* separate areas are tracked separately, adjacent ones are merged */
+	ut_assertok(video_fill_part(dev, 0, 0, 10, 10, 0));
+	ut_assertok(video_fill_part(dev, 100, 100, 110, 110, 0));
+	ut_asserteq(2, damage->count);
+	vidconsole_putc_xy(con, 0, 200, 'b');
+	vidconsole_putc_xy(con, VID_TO_POS(8), 200, 'c');
+	ut_asserteq(3, damage->count);
+	ut_asserteq(0, damage->rect[2].x0);
+	ut_asserteq(16, damage->rect[2].x1);
+
+	/* areas which do not fit are merged with the closest rectangle */
+	ut_assertok(video_fill_part(dev, 500, 500, 510, 510, 0));
+	ut_assertok(video_fill_part(dev, 520, 500, 530, 510, 0));
+	ut_asserteq(VIDEO_DAMAGE_RECTS, damage->count);
+	ut_asserteq(500, damage->rect[3].x0);
+	ut_asserteq(530, damage->rect[3].x1);
+
+	/* damage outside the display is ignored */
+	video_damage(dev, priv->xsize, 0, 10, 10);
+	video_damage(dev, 0, -20, 10, 10);
+	ut_asserteq(VIDEO_DAMAGE_RECTS, damage->count);
+
+	ut_assertok(video_sync(dev, true));
+	ut_asserteq(0, damage->count);
+	ut_assert(compress_frame_buffer(uts, dev) > 0);
+
+	/* a frame buffer shared with e.g. EFI is always flushed in full */
+	damage->shared = true;
+	damage->flush_bytes = 0;
+	ut_assertok(video_sync(dev, true));
+	ut_asserteq(priv->fb_size, damage->flush_bytes);
+	damage->shared = false;
+
+	return 0;
+}
+DM_TEST(dm_test_video_damage, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
+/* Compare the cost of console scrolling with the cost of full-screen syncs */
+static int dm_test_video_damage_scroll(struct unit_test_state *uts)
+{
+	struct video_damage *damage;
+	struct video_priv *priv;
+	struct udevice *dev, *con;
+	ulong start, duration;
+	int i;
+
+	if (!IS_ENABLED(CONFIG_VIDEO_DAMAGE))
+		return -EAGAIN;
+
+	ut_assertok(select_vidconsole(uts, "vidconsole0"));
+	ut_assertok(video_get_nologo(uts, &dev));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO_CONSOLE, 0, &con));
+	ut_assertok(vidconsole_select_font(con, "8x16", 0));
+	priv = dev_get_uclass_priv(dev);
+	damage = &priv->damage;
+	video_set_flush_dcache(dev, true);
+	ut_assertok(video_sync(dev, true));
+
+	damage->flush_bytes = 0;
+	damage->copy_bytes = 0;
+	start = timer_get_us();
+	for (i = 0; i < SCROLL_LINES; i++) {
+		vidconsole_put_string(con, "The quick brown fox\n");
+		ut_assertok(video_sync(dev, true));
+	}
+	duration = timer_get_us() - start;
+
+	/* without damage tracking, each sync flushes the whole display */
+	ut_assert(damage->flush_bytes < (ulong)priv->fb_size * SCROLL_LINES);
+	printf("%d lines in %lu us: flushed %lu bytes, copied %lu bytes, full syncs would flush %lu bytes\n",
+	       SCROLL_LINES, duration, damage->flush_bytes, damage->copy_bytes,
+	       (ulong)priv->fb_size * SCROLL_LINES);
+	ut_assert(compress_frame_buffer(uts, dev) > 0);
+
+	return 0;
+}
+DM_TEST(dm_test_video_damage_scroll, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
+/**
+ * check_copy_frame_buffer() - Sync the display and check the copy frame buffer
+ *
+ * With damage tracking, only the damaged regions are copied, so this fails if
+ * a drawing operation reports a region which is smaller than what it drew
+ *
+ * @uts:	Test state
+ * @dev:	Video device
+ * Return: 0 if OK, 1 if the copy does not match
+ */
+static int check_copy_frame_buffer(struct unit_test_state *uts,
+				   struct udevice *dev)
+{
+	struct video_priv *priv = dev_get_uclass_priv(dev);
+
+	ut_assertok(video_sync(dev, true));
+	ut_assertf(!memcmp(priv->fb, priv->copy_fb, priv->fb_size),
+		   "Copy framebuffer does not match fb");
+
+	return 0;
+}
+
+/* Check that damage keeps the copy frame buffer up to date at each rotation */
+static int dm_test_video_damage_copy(struct unit_test_state *uts)
+{
+	struct sandbox_sdl_plat *plat;
+	struct udevice *dev, *con;
+	int rot, i;
+
+	if (!IS_ENABLED(CONFIG_VIDEO_DAMAGE) || !IS_ENABLED(CONFIG_VIDEO_COPY))
+		return -EAGAIN;
+
+	for (rot = 0; rot < 4; rot++) {
+		ut_assertok(uclass_find_device(UCLASS_VIDEO, 0, &dev));
+		ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+		ut_assertok(device_chld_unbind(dev, NULL));
+		plat = dev_get_plat(dev);
+		plat->rot = rot;
+		plat->vidconsole_drv_name = rot ? NULL : "vidconsole0";
+
+		ut_assertok(video_get_nologo(uts, &dev));
+		ut_assertok(uclass_get_device(UCLASS_VIDEO_CONSOLE, 0, &con));
+		ut_assertok(vidconsole_select_font(con, "8x16", 0));
+		ut_assertok(check_copy_frame_buffer(uts, dev));
+
+		/* characters, with wrapping at the end of the line */
+		for (i = 0; i < 120; i++)
+			vidconsole_put_char(con, 'A' + i % 50);
+		ut_assertok(check_copy_frame_buffer(uts, dev));
+
+		/* backspace and the cursor */
+		vidconsole_put_string(con, "abc\b\b");
+		ut_assertok(vidconsole_set_cursor_visible(con, true, 0, 0, 0));
+		ut_assertok(check_copy_frame_buffer(uts, dev));
+
+		/* clearing a line, then scrolling */
+		vidconsole_put_string(con, "\x1b[2K");
+		for (i = 0; i < SCROLL_LINES; i++) {
+			vidconsole_put_char(con, 'A' + i % 50);
+			vidconsole_put_char(con, '\n');
+		}
+		ut_assertok(check_copy_frame_buffer(uts, dev));
+
+		ut_assertok(vidconsole_clear_and_reset(con));
+		ut_assertok(check_copy_frame_buffer(uts, dev));
+	}
+
+	return 0;
+}
+DM_TEST(dm_test_video_damage_copy, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
+/* Time filling the display with TrueType text, with and without cached glyphs */
+static int dm_test_video_truetype_bench(struct unit_test_state *uts)
+{
+	const char *test_string = "Criticism may not be agreeable, but it is necessary. It fulfils the same function as pain in the human body. It calls attention to an unhealthy state of things.\n";
+	struct vidconsole_priv *vc_priv;
+	struct udevice *dev, *con;
+	ulong start, cold, warm;
+	int i, size;
+
+	ut_assertok(video_get_nologo(uts, &dev));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO_CONSOLE, 0, &con));
+	vc_priv = dev_get_uclass_priv(con);
+
+	/* the first screen has to render every character */
+	ut_assertok(vidconsole_clear_and_reset(con));
+	start = timer_get_us();
+	for (i = 0; i < vc_priv->rows - 1; i++)
+		vidconsole_put_string(con, test_string);
+	cold = timer_get_us() - start;
+	size = compress_frame_buffer(uts, dev);
+
+	/* the second can use the glyph cache, and must look the same */
+	ut_assertok(vidconsole_clear_and_reset(con));
+	start = timer_get_us();
+	for (i = 0; i < vc_priv->rows - 1; i++)
+		vidconsole_put_string(con, test_string);
+	warm = timer_get_us() - start;
+	ut_asserteq(size, compress_frame_buffer(uts, dev));
+
+	printf("%d lines: first %lu us, second %lu us\n", vc_priv->rows - 1,
+	       cold, warm);
+
+	return 0;
+}
+DM_TEST(dm_test_video_truetype_bench, UTF_SCAN_PDATA | UTF_SCAN_FDT);
@@ -0,0 +1,204 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for reading FIT images in the background while loading them
+ */
+
+#include <image.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <spl.h>
+#include <linux/libfdt.h>
+#include <test/spl.h>
+#include <test/ut.h>
+
+#define ASYNC_IMAGES	3
+#define ASYNC_FIT_SIZE	1024
+
+/* Load addresses of the images, which must not overlap the test buffers */
+#define ASYNC_LOAD_ADDR	0x01000000
+#define ASYNC_LOAD_GAP	0x10000
+
+/**
+ * struct async_test - State of the test device
+ *
+ * @img: Contents of the device
+ * @log: Records each read (r), submit (s) and wait (w)
+ * @log_len: Number of characters in @log
+ * @buf: Buffer of the submitted read, which is filled in when waiting, so
+ *	that data cannot be used before the read has finished
+ * @offset: Offset of the submitted read
+ * @count: Size of the submitted read
+ */
+struct async_test {
+	void *img;
+	char log[16];
+	int log_len;
+	void *buf;
+	ulong offset;
+	ulong count;
+};
+
+static void async_log(struct async_test *priv, char ch)
+{
+	if (priv->log_len < sizeof(priv->log) - 1)
+		priv->log[priv->log_len++] = ch;
+}
+
+static ulong async_test_read(struct spl_load_info *load, ulong offset,
+			     ulong count, void *buf)
+{
+	struct async_test *priv = load->priv;
+
+	async_log(priv, priv->buf ? '!' : 'r');
+	memcpy(buf, priv->img + offset, count);
+
+	return count;
+}
+
+static int async_test_submit(struct spl_load_info *load, ulong offset,
+			     ulong count, void *buf)
+{
+	struct async_test *priv = load->priv;
+
+	async_log(priv, priv->buf ? '!' : 's');
+	priv->buf = buf;
+	priv->offset = offset;
+	priv->count = count;
+
+	return 0;
+}
+
+static ulong async_test_wait(struct spl_load_info *load)
+{
+	struct async_test *priv = load->priv;
+
+	async_log(priv, priv->buf ? 'w' : '!');
+	if (!priv->buf)
+		return 0;
+	memcpy(priv->buf, priv->img + priv->offset, priv->count);
+	priv->buf = NULL;
+
+	return priv->count;
+}
+
+/* Create a FIT with a firmware image and two loadables, all external */
+static size_t create_async_fit(void *dst, const ulong *load_addr,
+			       size_t data_size)
+{
+	char name[10];
+	int i;
+
+	if (fdt_create(dst, ASYNC_FIT_SIZE) ||
+	    fdt_finish_reservemap(dst) ||
+	    fdt_begin_node(dst, "") ||
+	    fdt_property_u32(dst, FIT_TIMESTAMP_PROP, 0) ||
+	    fdt_property_string(dst, FIT_DESC_PROP, "async") ||
+	    fdt_begin_node(dst, "images"))
+		return 0;
+
+	for (i = 0; i < ASYNC_IMAGES; i++) {
+		snprintf(name, sizeof(name), "image-%d", i);
+		if (fdt_begin_node(dst, name) ||
+		    fdt_property_string(dst, FIT_DESC_PROP, name) ||
+		    fdt_property_string(dst, FIT_TYPE_PROP, "firmware") ||
+		    fdt_property_string(dst, FIT_COMP_PROP, "none") ||
+		    fdt_property_string(dst, FIT_OS_PROP, "tee") ||
+		    fdt_property_u32(dst, FIT_DATA_OFFSET_PROP,
+				     i * data_size) ||
+		    fdt_property_u32(dst, FIT_DATA_SIZE_PROP, data_size) ||
+		    fdt_property_u32(dst, FIT_LOAD_PROP, load_addr[i]) ||
+		    fdt_property_u32(dst, FIT_ENTRY_PROP, load_addr[i]) ||
+		    fdt_end_node(dst))
+			return 0;
+	}
+
+	if (fdt_end_node(dst) || /* images */
+	    fdt_begin_node(dst, "configurations") ||
+	    fdt_property_string(dst, FIT_DEFAULT_PROP, "config-1") ||
+	    fdt_begin_node(dst, "config-1") ||
+	    fdt_property_string(dst, FIT_DESC_PROP, "async") ||
+	    fdt_property_string(dst, FIT_FIRMWARE_PROP, "image-0"))
+		return 0;
+	if (fdt_property(dst, FIT_LOADABLE_PROP, "image-0\0image-1\0image-2",
+			 sizeof("image-0\0image-1\0image-2")) ||
+	    fdt_end_node(dst) || /* config-1 */
+	    fdt_end_node(dst) || /* configurations */
+	    fdt_end_node(dst) || /* root */
+	    fdt_finish(dst))
+		return 0;
+
+	return ALIGN(fdt_totalsize(dst), 4);
+}
+
+static int do_spl_test_async(struct unit_test_state *uts,
+			     const char *test_name, const ulong *load_addr,
+			     const char *expect)
+{
+	struct spl_image_info image;
+	struct spl_load_info load;
+	struct async_test priv;
+	size_t data_size = SPL_TEST_DATA_SIZE;
+	size_t fit_size;
+	char *data;
+	int i;
+
+	memset(&priv, '\0', sizeof(priv));
+	priv.img = calloc(1, ASYNC_FIT_SIZE + ASYNC_IMAGES * data_size);
+	ut_assertnonnull(priv.img);
+	fit_size = create_async_fit(priv.img, load_addr, data_size);
+	ut_assert(fit_size);
+	data = priv.img + fit_size;
+	generate_data(data, ASYNC_IMAGES * data_size, test_name);
+
+	spl_load_init(&load, async_test_read, &priv, 1);
+	spl_set_async(&load, async_test_submit, async_test_wait);
+	memset(&image, '\0', sizeof(image));
+	ut_assertok(spl_load_simple_fit(&image, &load, 0, priv.img));
+	ut_asserteq_str(expect, priv.log);
+	ut_assertnull(priv.buf);
+
+	/* The last image to be loaded wins, where they overlap */
+	ut_asserteq(load_addr[0], image.load_addr);
+	ut_asserteq(load_addr[0], image.entry_point);
+	for (i = ASYNC_IMAGES - 1; i >= 0; i--) {
+		if (i < ASYNC_IMAGES - 1 &&
+		    load_addr[i] + data_size > load_addr[i + 1])
+			continue;
+		ut_asserteq_mem(data + i * data_size,
+				map_sysmem(load_addr[i], data_size),
+				data_size);
+	}
+	free(priv.img);
+
+	return 0;
+}
+
+/* Each loadable is read while the image before it is processed */
+static int spl_test_load_async(struct unit_test_state *uts)
+{
+	const ulong load_addr[ASYNC_IMAGES] = {
+		ASYNC_LOAD_ADDR,
+		ASYNC_LOAD_ADDR + ASYNC_LOAD_GAP,
+		ASYNC_LOAD_ADDR + 2 * ASYNC_LOAD_GAP,
+	};
+
+	/*
+	 * The FIT and the firmware image are read directly, then the two
+	 * loadables are read in the background
+	 */
+	return do_spl_test_async(uts, __func__, load_addr, "rrswsw");
+}
+SPL_TEST(spl_test_load_async, 0);
+
+/* A loadable which overlaps the image before it is read afterwards */
+static int spl_test_load_async_overlap(struct unit_test_state *uts)
+{
+	const ulong load_addr[ASYNC_IMAGES] = {
+		ASYNC_LOAD_ADDR,
+		ASYNC_LOAD_ADDR + ASYNC_LOAD_GAP,
+		ASYNC_LOAD_ADDR + ASYNC_LOAD_GAP + 0x100,
+	};
+
+	return do_spl_test_async(uts, __func__, load_addr, "rrswr");
+}
+SPL_TEST(spl_test_load_async_overlap, 0);
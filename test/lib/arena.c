@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the arena allocator
+ */
+
+#include <arena.h>
+#include <string.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Test allocating from the heap, with growth and reset */
+static int lib_test_arena_heap(struct unit_test_state *uts)
+{
+	struct arena ar;
+	ulong start;
+	char *str;
+	u8 *ptr;
+	int i;
+
+	start = ut_check_free();
+
+	/* nothing is allocated until needed */
+	arena_init(&ar, 256);
+	ut_assertnull(ar.head);
+	ut_assertok(ut_check_delta(start));
+
+	str = arena_strdup(&ar, "hello");
+	ut_asserteq_str("hello", str);
+	ut_asserteq(1, ar.stats.blocks);
+
+	/* allocations are aligned and do not overlap */
+	ptr = arena_alloc(&ar, 3);
+	ut_assertnonnull(ptr);
+	ut_asserteq(0, (ulong)ptr & 7);
+	ut_assert(ptr >= (u8 *)str + 6);
+	str = arena_strndup(&ar, "world!", 5);
+	ut_asserteq_str("world", str);
+	ut_asserteq(3, ar.stats.allocs);
+	ut_asserteq(1, ar.stats.blocks);
+
+	/* fill up the block so that another is needed */
+	for (i = 0; i < 20; i++)
+		ut_assertnonnull(arena_zalloc(&ar, 16));
+	ut_asserteq(2, ar.stats.blocks);
+
+	/* a large allocation gets a block of its own */
+	ptr = arena_zalloc(&ar, 1000);
+	ut_assertnonnull(ptr);
+	ut_asserteq(0, ptr[999]);
+	ut_asserteq(3, ar.stats.blocks);
+	ut_assert(ar.stats.used >= 1000 + 20 * 16);
+	ut_asserteq(ar.stats.used, ar.stats.peak);
+
+	/* reset keeps only the first block */
+	arena_reset(&ar);
+	ut_asserteq(0, ar.stats.used);
+	ut_assertnonnull(arena_alloc(&ar, 100));
+	ut_asserteq(3, ar.stats.blocks);
+	ut_assert(ar.stats.peak > ar.stats.used);
+	ut_assert(ut_check_delta(start) > 0);
+
+	arena_uninit(&ar);
+	ut_assertok(ut_check_delta(start));
+
+	/* the arena can be used again */
+	ut_assertnonnull(arena_alloc(&ar, 10));
+	ut_asserteq(1, ar.stats.blocks);
+	arena_uninit(&ar);
+	ut_assertok(ut_check_delta(start));
+
+	return 0;
+}
+LIB_TEST(lib_test_arena_heap, 0);
+
+/* Test allocating from a buffer provided by the caller */
+static int lib_test_arena_buf(struct unit_test_state *uts)
+{
+	struct arena ar;
+	u64 buf[16];
+	ulong start;
+	void *first;
+	int i;
+
+	start = ut_check_free();
+
+	/* without growth, allocation fails when the buffer is full */
+	arena_init_buf(&ar, buf, sizeof(buf), 0);
+	first = arena_alloc(&ar, 8);
+	ut_assert(first > (void *)buf && first < (void *)(buf + 4));
+	for (i = 1; arena_alloc(&ar, 8); i++)
+		;
+	ut_asserteq(((void *)(buf + 16) - first) / 8, i);
+	ut_assertnull(arena_alloc(&ar, sizeof(buf)));
+	ut_asserteq(0, ar.stats.blocks);
+	ut_assertok(ut_check_delta(start));
+
+	/* reset makes the buffer available again */
+	arena_reset(&ar);
+	ut_asserteq_ptr(first, arena_alloc(&ar, 8));
+	arena_uninit(&ar);
+	ut_assertok(ut_check_delta(start));
+
+	/* with growth, the heap is used once the buffer is full */
+	arena_init_buf(&ar, buf, sizeof(buf), 64);
+	for (i = 0; i < 16; i++)
+		ut_assertnonnull(arena_alloc(&ar, 8));
+	ut_asserteq(1, ar.stats.blocks);
+	ut_assert(ut_check_delta(start) > 0);
+
+	/* reset goes back to the buffer */
+	arena_reset(&ar);
+	ut_assertok(ut_check_delta(start));
+	ut_asserteq_ptr(first, arena_alloc(&ar, 8));
+	arena_uninit(&ar);
+	ut_assertok(ut_check_delta(start));
+
+	return 0;
+}
+LIB_TEST(lib_test_arena_buf, 0);
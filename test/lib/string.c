@@ -11,6 +11,8 @@
 
 #include <command.h>
 #include <log.h>
+#include <malloc.h>
+#include <time.h>
 #include <test/lib.h>
 #include <test/test.h>
 #include <test/ut.h>
@@ -221,3 +223,340 @@ static int lib_memdup(struct unit_test_state *uts)
 	return 0;
 }
 LIB_TEST(lib_memdup, 0);
+
+/* Size of the buffers for the string tests, two (small) pages */
+#define STR_PAGE	4096
+/* Longest string checked at each alignment */
+#define STR_MAXLEN	40
+
+/* Reference implementations handling a byte at a time */
+static noinline size_t ref_strnlen(const char *s, size_t count)
+{
+	size_t len;
+
+	for (len = 0; len < count && s[len]; len++)
+		;
+	return len;
+}
+
+static noinline int ref_strncmp(const char *cs, const char *ct, size_t count)
+{
+	for (; count; cs++, ct++, count--) {
+		if (*cs != *ct)
+			return (unsigned char)*cs - (unsigned char)*ct;
+		if (!*cs)
+			break;
+	}
+	return 0;
+}
+
+static noinline int ref_memcmp(const void *cs, const void *ct, size_t count)
+{
+	const unsigned char *su1 = cs, *su2 = ct;
+
+	for (; count; su1++, su2++, count--) {
+		if (*su1 != *su2)
+			return *su1 - *su2;
+	}
+	return 0;
+}
+
+static noinline void *ref_memchr(const void *s, int c, size_t n)
+{
+	const unsigned char *p = s;
+
+	for (; n; p++, n--) {
+		if (*p == (unsigned char)c)
+			return (void *)p;
+	}
+	return NULL;
+}
+
+static int sign(int val)
+{
+	return val < 0 ? -1 : val > 0;
+}
+
+/**
+ * fill_str() - fill a buffer with a string of non-zero bytes
+ *
+ * Bytes with the top bit set are included to check that comparisons are
+ * unsigned.
+ *
+ * @s:		buffer
+ * @len:	length of the string, a terminator is added after it
+ */
+static void fill_str(char *s, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		s[i] = 0x70 + (i * 7) % 0x20;
+	s[len] = '\0';
+}
+
+/**
+ * check_strlen() - check strlen() and strnlen() on one string
+ *
+ * @uts:	unit test state
+ * @s:		string
+ * @len:	expected length
+ * Return:	0 = success, 1 = failure
+ */
+static int check_strlen(struct unit_test_state *uts, const char *s, int len)
+{
+	int count;
+
+	ut_asserteq(len, strlen(s));
+	for (count = 0; count < len + 2 * (int)sizeof(long); count++)
+		ut_asserteq(ref_strnlen(s, count), strnlen(s, count));
+
+	return 0;
+}
+
+/**
+ * lib_strlen() - unit test for strlen() and strnlen()
+ *
+ * Test with varied alignment and length, including strings which cross a page
+ * boundary.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_strlen(struct unit_test_state *uts)
+{
+	int offset, len;
+	char *buf, *s;
+
+	buf = memalign(STR_PAGE, 2 * STR_PAGE);
+	ut_assertnonnull(buf);
+	memset(buf, 0x55, 2 * STR_PAGE);
+
+	for (offset = 0; offset <= SWEEP; offset++) {
+		for (len = 0; len <= STR_MAXLEN; len++) {
+			fill_str(buf + offset, len);
+			ut_assertok(check_strlen(uts, buf + offset, len));
+		}
+	}
+	for (offset = 1; offset <= SWEEP; offset++) {
+		s = buf + STR_PAGE - offset;
+		for (len = 0; len <= STR_MAXLEN; len++) {
+			fill_str(s, len);
+			ut_assertok(check_strlen(uts, s, len));
+		}
+	}
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_strlen, 0);
+
+/**
+ * check_cmp() - check strcmp(), strncmp() and memcmp() on two strings
+ *
+ * @uts:	unit test state
+ * @cs:		first string
+ * @ct:		second string
+ * @len:	length of the longer string
+ * Return:	0 = success, 1 = failure
+ */
+static int check_cmp(struct unit_test_state *uts, const char *cs,
+		     const char *ct, int len)
+{
+	int count;
+
+	ut_asserteq(sign(ref_strncmp(cs, ct, len + 1)), sign(strcmp(cs, ct)));
+	for (count = 0; count <= len + 1; count++) {
+		ut_asserteq(sign(ref_strncmp(cs, ct, count)),
+			    sign(strncmp(cs, ct, count)));
+		ut_asserteq(sign(ref_memcmp(cs, ct, count)),
+			    sign(memcmp(cs, ct, count)));
+	}
+
+	return 0;
+}
+
+/**
+ * lib_strcmp() - unit test for strcmp(), strncmp() and memcmp()
+ *
+ * Test with varied alignment of both strings, varied length and varied
+ * position of the first difference, including strings which cross a page
+ * boundary.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_strcmp(struct unit_test_state *uts)
+{
+	int offset1, offset2, len, diff;
+	char *buf1, *buf2, *cs, *ct;
+
+	buf1 = memalign(STR_PAGE, 2 * STR_PAGE);
+	ut_assertnonnull(buf1);
+	buf2 = memalign(STR_PAGE, 2 * STR_PAGE);
+	ut_assertnonnull(buf2);
+
+	for (offset1 = 0; offset1 <= SWEEP; offset1++) {
+		for (offset2 = 0; offset2 <= SWEEP; offset2++) {
+			/* strings which may cross into the second page */
+			cs = buf1 + STR_PAGE - STR_MAXLEN / 2 + offset1;
+			ct = buf2 + STR_PAGE - STR_MAXLEN / 2 + offset2;
+			for (len = 0; len <= STR_MAXLEN / 2; len++) {
+				fill_str(cs, len);
+				fill_str(ct, len);
+				ut_assertok(check_cmp(uts, cs, ct, len));
+				for (diff = 0; diff < len; diff++) {
+					ct[diff]++;
+					ut_assertok(check_cmp(uts, cs, ct,
+							      len));
+					ct[diff] ^= 0x80;
+					ut_assertok(check_cmp(uts, cs, ct,
+							      len));
+					ct[diff] = cs[diff];
+				}
+				/* make the second string shorter */
+				if (len) {
+					ct[len - 1] = '\0';
+					ut_assertok(check_cmp(uts, cs, ct,
+							      len));
+				}
+			}
+		}
+	}
+	free(buf2);
+	free(buf1);
+
+	return 0;
+}
+LIB_TEST(lib_strcmp, 0);
+
+/**
+ * lib_memchr() - unit test for memchr()
+ *
+ * Test with varied alignment, length and position of the byte found,
+ * including areas which cross a page boundary.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_memchr(struct unit_test_state *uts)
+{
+	int offset, len, pos, count;
+	char *buf, *s;
+
+	buf = memalign(STR_PAGE, 2 * STR_PAGE);
+	ut_assertnonnull(buf);
+
+	for (offset = 0; offset <= 2 * SWEEP; offset++) {
+		s = buf + STR_PAGE - SWEEP + offset;
+		for (len = 0; len <= STR_MAXLEN; len++) {
+			fill_str(s, len);
+			ut_assertnull(memchr(s, 'a', len));
+			for (pos = 0; pos < len; pos++) {
+				/* only the low byte of the value matters */
+				s[pos] = 'a';
+				for (count = 0; count <= len; count++) {
+					ut_asserteq_ptr(ref_memchr(s, 'a',
+								   count),
+							memchr(s, 0x100 | 'a',
+							       count));
+				}
+				s[pos] = 0x70;
+			}
+		}
+	}
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_memchr, 0);
+
+/**
+ * lib_string_perf() - compare string functions with byte-at-a-time versions
+ *
+ * This prints the time taken to process a long string with the library
+ * functions and with the reference implementations in this file. The barrier
+ * stops the compiler from hoisting the calls out of the loops.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_string_perf(struct unit_test_state *uts)
+{
+	const int loops = 1000;
+	ulong start, lib[4], ref[4];
+	char *cs, *ct;
+	int i;
+
+	cs = malloc(STR_PAGE);
+	ut_assertnonnull(cs);
+	ct = malloc(STR_PAGE);
+	ut_assertnonnull(ct);
+	fill_str(cs, STR_PAGE - 1);
+	fill_str(ct, STR_PAGE - 1);
+
+	start = timer_get_us();
+	for (i = 0; i < loops; i++) {
+		barrier();
+		ut_asserteq(STR_PAGE - 1, strnlen(cs, STR_PAGE));
+	}
+	lib[0] = timer_get_us() - start;
+	start = timer_get_us();
+	for (i = 0; i < loops; i++) {
+		barrier();
+		ut_asserteq(STR_PAGE - 1, ref_strnlen(cs, STR_PAGE));
+	}
+	ref[0] = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < loops; i++) {
+		barrier();
+		ut_asserteq(0, strncmp(cs, ct, STR_PAGE));
+	}
+	lib[1] = timer_get_us() - start;
+	start = timer_get_us();
+	for (i = 0; i < loops; i++) {
+		barrier();
+		ut_asserteq(0, ref_strncmp(cs, ct, STR_PAGE));
+	}
+	ref[1] = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < loops; i++) {
+		barrier();
+		ut_asserteq(0, memcmp(cs, ct, STR_PAGE));
+	}
+	lib[2] = timer_get_us() - start;
+	start = timer_get_us();
+	for (i = 0; i < loops; i++) {
+		barrier();
+		ut_asserteq(0, ref_memcmp(cs, ct, STR_PAGE));
+	}
+	ref[2] = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < loops; i++) {
+		barrier();
+		ut_assertnull(memchr(cs, 'a', STR_PAGE));
+	}
+	lib[3] = timer_get_us() - start;
+	start = timer_get_us();
+	for (i = 0; i < loops; i++) {
+		barrier();
+		ut_assertnull(ref_memchr(cs, 'a', STR_PAGE));
+	}
+	ref[3] = timer_get_us() - start;
+
+	printf("%d x %d bytes (us): library / byte-at-a-time\n", loops,
+	       STR_PAGE);
+	printf("strnlen %lu / %lu, strncmp %lu / %lu\n", lib[0], ref[0],
+	       lib[1], ref[1]);
+	printf("memcmp %lu / %lu, memchr %lu / %lu\n", lib[2], ref[2], lib[3],
+	       ref[3]);
+
+	free(ct);
+	free(cs);
+
+	return 0;
+}
+LIB_TEST(lib_string_perf, 0);
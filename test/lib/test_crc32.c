@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for crc32 and crc32c
+ *
+ * The table-driven and instruction-based implementations are checked against
+ * a bitwise reference for all alignments and short lengths, so that the
+ * prologue, the word loop and the tail are each exercised.
+ */
+
+#include <malloc.h>
+#include <time.h>
+#include <linux/compiler.h>
+#include <linux/sizes.h>
+#include <test/lib.h>
+#include <test/ut.h>
+#include <u-boot/crc.h>
+
+#define CRC32_POLY	0xedb88320
+#define CRC32C_POLY	0x82f63b78
+#define CRC_BUF_SIZE	4096
+#define CRC_PERF_SIZE	SZ_1M
+
+/**
+ * ref_crc() - bitwise reflected CRC without one's complement
+ *
+ * @poly:	bit-reflected polynomial
+ * @crc:	previous crc
+ * @buf:	data to checksum
+ * @len:	number of bytes
+ * Return:	checksum value
+ */
+static u32 noinline ref_crc(u32 poly, u32 crc, const u8 *buf, size_t len)
+{
+	int i;
+
+	while (len--) {
+		crc ^= *buf++;
+		for (i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ ((crc & 1) ? poly : 0);
+	}
+
+	return crc;
+}
+
+static void fill_buf(u8 *buf, size_t len)
+{
+	u32 x = 0x12345678;
+
+	while (len--) {
+		x = x * 1103515245 + 12345;
+		*buf++ = x >> 16;
+	}
+}
+
+static int lib_crc32(struct unit_test_state *uts)
+{
+	static const char check[] = "123456789";
+	size_t off, len;
+	u8 *buf;
+
+	/* Standard check values of both algorithms */
+	ut_asserteq(0xcbf43926, crc32(0, (u8 *)check, 9));
+	ut_asserteq(0, crc32(0, NULL, 0));
+
+	buf = malloc(CRC_BUF_SIZE);
+	ut_assertnonnull(buf);
+	fill_buf(buf, CRC_BUF_SIZE);
+
+	for (off = 0; off < 8; off++) {
+		for (len = 0; len < 80; len++)
+			ut_asserteq(ref_crc(CRC32_POLY, ~0U, buf + off, len),
+				    crc32_no_comp(~0U, buf + off, len));
+		len = CRC_BUF_SIZE - off;
+		ut_asserteq(ref_crc(CRC32_POLY, 0, buf + off, len),
+			    crc32_no_comp(0, buf + off, len));
+
+		/* The EFI runtime version only uses the bytewise table */
+		ut_asserteq(crc32(0, buf + off, len),
+			    crc32_runtime(0, buf + off, len));
+	}
+
+	/* Chaining must give the same result as a single call */
+	ut_asserteq(crc32(0, buf, CRC_BUF_SIZE),
+		    crc32(crc32(0, buf, 1001), buf + 1001,
+			  CRC_BUF_SIZE - 1001));
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_crc32, 0);
+
+static int lib_crc32c(struct unit_test_state *uts)
+{
+	static const char check[] = "123456789";
+	size_t off, len;
+	u8 *buf;
+
+	if (!IS_ENABLED(CONFIG_CRC32C))
+		return -EAGAIN;
+
+	ut_asserteq(0xe3069283, ~crc32c(~0U, check, 9));
+
+	buf = malloc(CRC_BUF_SIZE);
+	ut_assertnonnull(buf);
+	fill_buf(buf, CRC_BUF_SIZE);
+
+	for (off = 0; off < 8; off++) {
+		for (len = 0; len < 80; len++)
+			ut_asserteq(ref_crc(CRC32C_POLY, ~0U, buf + off, len),
+				    crc32c(~0U, buf + off, len));
+		len = CRC_BUF_SIZE - off;
+		ut_asserteq(ref_crc(CRC32C_POLY, 0, buf + off, len),
+			    crc32c(0, buf + off, len));
+	}
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_crc32c, 0);
+
+/**
+ * lib_crc32_perf() - report the crc32 and crc32c throughput
+ *
+ * The bytewise reference uses a 256-entry table, i.e. the algorithm which was
+ * used before slicing-by-8 and the CRC32 instructions.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_crc32_perf(struct unit_test_state *uts)
+{
+	const int loops = 16;
+	ulong start, lib, ref, lib_c = 0;
+	u32 tab[256], crc, crc_ref;
+	u8 *buf;
+	int i;
+	size_t j;
+
+	buf = malloc(CRC_PERF_SIZE);
+	ut_assertnonnull(buf);
+	fill_buf(buf, CRC_PERF_SIZE);
+	for (i = 0; i < 256; i++)
+		tab[i] = ref_crc(CRC32_POLY, 0, (u8 *)&i, 1);
+
+	start = timer_get_us();
+	for (i = 0; i < loops; i++) {
+		barrier();
+		crc = crc32(0, buf, CRC_PERF_SIZE);
+	}
+	lib = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < loops; i++) {
+		barrier();
+		crc_ref = ~0U;
+		for (j = 0; j < CRC_PERF_SIZE; j++)
+			crc_ref = tab[(crc_ref ^ buf[j]) & 255] ^ (crc_ref >> 8);
+		crc_ref = ~crc_ref;
+	}
+	ref = timer_get_us() - start;
+	ut_asserteq(crc_ref, crc);
+
+	if (IS_ENABLED(CONFIG_CRC32C)) {
+		start = timer_get_us();
+		for (i = 0; i < loops; i++) {
+			barrier();
+			crc32c(~0U, buf, CRC_PERF_SIZE);
+		}
+		lib_c = timer_get_us() - start;
+	}
+	free(buf);
+
+	printf("crc32 of %d MiB: %lu us, bytewise %lu us, crc32c %lu us\n",
+	       loops * CRC_PERF_SIZE / SZ_1M, lib, ref, lib_c);
+
+	return 0;
+}
+LIB_TEST(lib_crc32_perf, 0);
@@ -0,0 +1,88 @@
+# SPDX-License-Identifier: GPL-2.0+
+
+"""Benchmark the decompressors on the same image
+
+This compresses the start of the U-Boot binary with each host tool which is
+available, puts the results in a FIT along with the original and runs
+compression_test_bench_norun on it, so that all algorithms decompress the
+same data.
+"""
+
+import os
+import shutil
+
+import pytest
+
+import fit_util
+import u_boot_utils as util
+
+# Compressed images, each with the host command which makes it from the
+# original (IN) to the file with the given extension (OUT)
+COMPRESSORS = (
+    ('gzip', 'gz', ['gzip', '-9', '-n', '-k', '-f', 'IN']),
+    ('bzip2', 'bz2', ['bzip2', '-k', '-f', 'IN']),
+    ('lzma', 'lzma', ['xz', '--format=lzma', '-k', '-f', 'IN']),
+    ('lzo', 'lzo', ['lzop', '-f', '-o', 'OUT', 'IN']),
+    ('lz4', 'lz4', ['lz4', '-f', '-q', '--no-frame-crc', 'IN', 'OUT']),
+    ('zstd', 'zst', ['zstd', '-19', '-k', '-f', '-q', 'IN']),
+)
+
+IMAGE_ITS = '''
+        %(name)s {
+            data = /incbin/("%(fname)s");
+            type = "kernel";
+            arch = "sandbox";
+            os = "linux";
+            compression = "%(comp)s";
+        };
+'''
+
+BASE_ITS = '''
+/dts-v1/;
+
+/ {
+    description = "Decompression benchmark";
+    #address-cells = <1>;
+
+    images {
+%(images)s
+    };
+};
+'''
+
+# Amount of the U-Boot binary to use
+BENCH_SIZE = 2 << 20
+
+FIT_ADDR = 0x1000000
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('fit')
+@pytest.mark.buildconfigspec('ut_compression')
+def test_compression_bench(u_boot_console):
+    """Decompress the same image with each algorithm"""
+    cons = u_boot_console
+    mkimage = os.path.join(cons.config.build_dir, 'tools', 'mkimage')
+
+    with open(os.path.join(cons.config.build_dir, 'u-boot'), 'rb') as inf:
+        data = inf.read(BENCH_SIZE)
+    orig = fit_util.make_fname(cons, 'bench.bin')
+    with open(orig, 'wb') as outf:
+        outf.write(data)
+
+    images = [IMAGE_ITS % {'name': 'none', 'fname': orig, 'comp': 'none'}]
+    for comp, ext, cmd in COMPRESSORS:
+        if not shutil.which(cmd[0]):
+            continue
+        fname = orig + '.' + ext
+        util.run_and_log(cons, [{'IN': orig, 'OUT': fname}.get(arg, arg)
+                                for arg in cmd])
+        images.append(IMAGE_ITS % {'name': comp, 'fname': fname,
+                                   'comp': comp})
+    fit = fit_util.make_fit(cons, mkimage, BASE_ITS,
+                            {'images': ''.join(images)}, 'bench.fit')
+
+    output = cons.run_command_list([
+        'host load hostfs 0 %x %s' % (FIT_ADDR, fit),
+        'setenv compression_bench_addr %x' % FIT_ADDR,
+        'ut compression -f compression_test_bench_norun'])
+    assert 'Failures: 0' in output[-1]
@@ -24,6 +24,7 @@ base_its = '''
                         arch = "sandbox";
                         os = "linux";
                         compression = "%(compression)s";
+                        %(kernel_blocks)s
                         load = <0x40000>;
                         entry = <0x8>;
                 };
@@ -280,6 +281,7 @@ def test_fit(u_boot_console):
             'kernel_out' : kernel_out,
             'kernel_addr' : 0x40000,
             'kernel_size' : filesize(kernel),
+            'kernel_blocks' : '',
 
             'fdt' : fdt,
             'fdt_out' : fdt_out,
@@ -396,6 +398,38 @@ def test_fit(u_boot_console):
             check_not_equal(ramdisk, ramdisk_out, 'Ramdisk got decompressed?')
             check_equal(ramdisk + '.gz', ramdisk_out, 'Ramdist not loaded')
 
+        # Kernel compressed by mkimage in independent blocks
+        with cons.log.section('Kernel compressed in blocks'):
+            params['kernel'] = kernel
+            params['kernel_blocks'] = 'compression-block-size = <0x400>;'
+            fit = fit_util.make_fit(cons, mkimage, base_its, params)
+            cons.restart_uboot()
+            output = cons.run_command_list(cmd.splitlines())
+            check_equal(kernel, kernel_out, 'Kernel not loaded')
+            blocks = (filesize(kernel) + 0x3ff) // 0x400
+            assert 'Uncompressing Kernel Image to 40000 (%d blocks)' % (
+                blocks) in ''.join(output)
+
+            # Extract a range which covers the end of the first block and
+            # the start of the second, so only those are decompressed
+            range_out = make_fname('range-out.bin')
+            output = cons.run_command_list([
+                'host load hostfs 0 %x %s' % (params['fit_addr'], fit),
+                'imxtract %x kernel-1 %x 300 200' % (params['fit_addr'],
+                                                     params['kernel_addr']),
+                'host save hostfs 0 %x %s 200' % (params['kernel_addr'],
+                                                  range_out)])
+            assert '2 blocks decompressed' in ''.join(output)
+            expected = make_fname('range.bin')
+            with open(expected, 'wb') as fd:
+                fd.write(read_file(kernel)[0x300:0x500])
+            check_equal(expected, range_out, 'Kernel range not extracted')
+
+            # An offset without a size is rejected
+            output = cons.run_command('imxtract %x kernel-1 %x 300' % (
+                params['fit_addr'], params['kernel_addr']))
+            assert 'Usage:' in output
+
 
     cons = u_boot_console
     # We need to use our own device tree file. Remember to restore it
@@ -732,6 +732,271 @@ err:
 	return ret;
 }
 
+/**
+ * fit_compress_block() - compress a block using an external tool
+ *
+ * @params: mkimage parameters
+ * @comp: compression type (IH_COMP_...)
+ * @data: data to compress
+ * @len: length of @data
+ * @fname: FIT file name, used to name temporary files
+ * @outp: returns the compressed data, which must be freed by the caller
+ * @out_lenp: returns the length of the compressed data
+ * Return: 0 if OK, -ve on error
+ */
+static int fit_compress_block(struct image_tool_params *params, int comp,
+			      const void *data, int len, const char *fname,
+			      void **outp, int *out_lenp)
+{
+	static const struct {
+		int comp;
+		const char *cmd;
+	} tools[] = {
+		{ IH_COMP_GZIP, "gzip -9 -n -c" },
+		{ IH_COMP_BZIP2, "bzip2 -9 -c" },
+		{ IH_COMP_LZMA, "lzma -9 -c" },
+		{ IH_COMP_LZO, "lzop -9 -c" },
+		{ IH_COMP_LZ4, "lz4 -9 -c" },
+		{ IH_COMP_ZSTD, "zstd -19 -q -c" },
+	};
+	char in[MKIMAGE_MAX_TMPFILE_LEN + 8], out[MKIMAGE_MAX_TMPFILE_LEN + 8];
+	char cmd[MKIMAGE_MAX_DTC_CMDLINE_LEN];
+	struct stat sbuf;
+	void *buf = NULL;
+	int fd, i, ret;
+
+	for (i = 0; i < ARRAY_SIZE(tools); i++) {
+		if (tools[i].comp == comp)
+			break;
+	}
+	if (i == ARRAY_SIZE(tools)) {
+		fprintf(stderr, "%s: Cannot compress blocks with %s\n",
+			params->cmdname, genimg_get_comp_name(comp));
+		return -EINVAL;
+	}
+
+	snprintf(in, sizeof(in), "%s.blk", fname);
+	snprintf(out, sizeof(out), "%s.blk.out", fname);
+	fd = open(in, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666);
+	if (fd < 0 || write(fd, data, len) != len) {
+		fprintf(stderr, "%s: Can't write %s: %s\n", params->cmdname,
+			in, strerror(errno));
+		ret = -EIO;
+		goto err;
+	}
+	close(fd);
+
+	snprintf(cmd, sizeof(cmd), "%s < \"%s\" > \"%s\"", tools[i].cmd, in,
+		 out);
+	debug("Trying to execute \"%s\"\n", cmd);
+	if (system(cmd)) {
+		fprintf(stderr, "%s: Failed to run '%s'\n", params->cmdname,
+			cmd);
+		fd = -1;
+		ret = -EIO;
+		goto err;
+	}
+
+	fd = open(out, O_RDONLY | O_BINARY);
+	if (fd < 0 || fstat(fd, &sbuf) < 0) {
+		ret = -EIO;
+		goto err;
+	}
+	buf = malloc(sbuf.st_size);
+	if (!buf) {
+		ret = -ENOMEM;
+		goto err;
+	}
+	if (read(fd, buf, sbuf.st_size) != sbuf.st_size) {
+		ret = -EIO;
+		goto err;
+	}
+	*outp = buf;
+	*out_lenp = sbuf.st_size;
+	buf = NULL;
+	ret = 0;
+
+err:
+	free(buf);
+	if (fd >= 0)
+		close(fd);
+	unlink(in);
+	unlink(out);
+
+	return ret;
+}
+
+/**
+ * fit_setprop_grow() - set a property, expanding the FDT if needed
+ *
+ * @fdtp: pointer to the FDT, updated if it is moved
+ * @sizep: pointer to the size of the FDT buffer, updated if it grows
+ * @node: node offset
+ * @name: property name
+ * @val: property value
+ * @len: length of @val
+ * Return: 0 if OK, -ve on error
+ */
+static int fit_setprop_grow(void **fdtp, int *sizep, int node,
+			    const char *name, const void *val, int len)
+{
+	void *fdt;
+	int ret;
+
+	ret = fdt_setprop(*fdtp, node, name, val, len);
+	if (ret != -FDT_ERR_NOSPACE)
+		return ret ? -EINVAL : 0;
+
+	fdt = realloc(*fdtp, *sizep + len + 1024);
+	if (!fdt)
+		return -ENOMEM;
+	*fdtp = fdt;
+	*sizep += len + 1024;
+	ret = fdt_open_into(fdt, fdt, *sizep);
+	if (!ret)
+		ret = fdt_setprop(fdt, node, name, val, len);
+
+	return ret ? -EINVAL : 0;
+}
+
+/**
+ * fit_compress_blocks() - compress images in independent blocks
+ *
+ * The data of each image with a 'compression-block-size' property but no
+ * 'compression-block-offsets' property is split into blocks of that size,
+ * which are compressed separately using the algorithm in the 'compression'
+ * property. The 'compression-block-offsets' property is added to say where
+ * each block starts.
+ *
+ * This must be done before hashes are added, since they cover the
+ * compressed data.
+ */
+static int fit_compress_blocks(struct image_tool_params *params,
+			       const char *fname)
+{
+	void *fdt = NULL, *old_fdt, *data = NULL, *out = NULL, *blk;
+	fdt32_t *offsets = NULL;
+	int count, size, len, out_len, blk_len, block_size, new_size;
+	int fd, images, node, i, ret;
+	const fdt32_t *val;
+	struct stat sbuf;
+	bool changed = false;
+	uint8_t comp;
+
+	fd = mmap_fdt(params->cmdname, fname, 0, &old_fdt, &sbuf, false, false);
+	if (fd < 0)
+		return -EIO;
+
+	size = fdt_totalsize(old_fdt) + 1024;
+	ret = -ENOMEM;
+	fdt = malloc(size);
+	if (fdt)
+		ret = fdt_open_into(old_fdt, fdt, size) ? -EINVAL : 0;
+	munmap(old_fdt, sbuf.st_size);
+	close(fd);
+	fd = -1;
+	if (ret)
+		goto err;
+
+	images = fdt_path_offset(fdt, FIT_IMAGES_PATH);
+	for (node = images < 0 ? images : fdt_first_subnode(fdt, images);
+	     node >= 0;
+	     node = fdt_next_subnode(fdt, node)) {
+		val = fdt_getprop(fdt, node, FIT_COMP_BLOCK_SIZE_PROP, &len);
+		if (!val ||
+		    fdt_getprop(fdt, node, FIT_COMP_BLOCK_OFFSETS_PROP, NULL))
+			continue;
+		block_size = len == sizeof(*val) ? fdt32_to_cpu(*val) : 0;
+		if (fit_image_get_comp(fdt, node, &comp))
+			comp = IH_COMP_NONE;
+		if (block_size <= 0 || comp == IH_COMP_NONE) {
+			fprintf(stderr,
+				"%s: Invalid %s or no compression in '%s'\n",
+				params->cmdname, FIT_COMP_BLOCK_SIZE_PROP,
+				fit_get_name(fdt, node, NULL));
+			ret = -EINVAL;
+			goto err;
+		}
+
+		blk = (void *)fdt_getprop(fdt, node, FIT_DATA_PROP, &len);
+		if (!blk || !len)
+			continue;
+		data = malloc(len);
+		count = (len + block_size - 1) / block_size;
+		offsets = calloc(count + 1, sizeof(*offsets));
+		if (!data || !offsets) {
+			ret = -ENOMEM;
+			goto err;
+		}
+		memcpy(data, blk, len);
+
+		for (i = 0, out_len = 0; i < count; i++) {
+			blk_len = len - i * block_size;
+			if (blk_len > block_size)
+				blk_len = block_size;
+			ret = fit_compress_block(params, comp,
+						 data + i * block_size,
+						 blk_len, fname, &blk,
+						 &blk_len);
+			if (ret)
+				goto err;
+			out = realloc(out, out_len + blk_len);
+			if (!out) {
+				free(blk);
+				ret = -ENOMEM;
+				goto err;
+			}
+			memcpy(out + out_len, blk, blk_len);
+			free(blk);
+			offsets[i] = cpu_to_fdt32(out_len);
+			out_len += blk_len;
+		}
+		offsets[count] = cpu_to_fdt32(out_len);
+		debug("Compressed %x bytes to %x in %d blocks\n", len, out_len,
+		      count);
+
+		ret = fit_setprop_grow(&fdt, &size, node, FIT_DATA_PROP, out,
+				       out_len);
+		if (!ret)
+			ret = fit_setprop_grow(&fdt, &size, node,
+					       FIT_COMP_BLOCK_OFFSETS_PROP,
+					       offsets,
+					       (count + 1) * sizeof(*offsets));
+		if (ret)
+			goto err;
+		free(data);
+		free(offsets);
+		free(out);
+		data = NULL;
+		offsets = NULL;
+		out = NULL;
+		changed = true;
+	}
+
+	if (changed) {
+		fdt_pack(fdt);
+		new_size = fdt_totalsize(fdt);
+		fd = open(fname, O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0666);
+		if (fd < 0 || write(fd, fdt, new_size) != new_size) {
+			fprintf(stderr, "%s: Can't write %s: %s\n",
+				params->cmdname, fname, strerror(errno));
+			ret = -EIO;
+			goto err;
+		}
+	}
+	ret = 0;
+
+err:
+	free(out);
+	free(offsets);
+	free(data);
+	free(fdt);
+	if (fd >= 0)
+		close(fd);
+
+	return ret;
+}
+
 /**
  * fit_handle_file - main FIT file processing function
  *
@@ -797,6 +1062,11 @@ static int fit_handle_file(struct image_tool_params *params)
 	if (ret)
 		goto err_system;
 
+	/* Compress images which are to be split into blocks */
+	ret = fit_compress_blocks(params, tmpfile);
+	if (ret)
+		goto err_system;
+
 	/*
 	 * Copy the tmpfile to bakfile, then in the following loop
 	 * we copy bakfile to tmpfile. So we always start from the
@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0+
+
+"""
+Add function names to the output of the 'malloc dump' command
+
+The command shows the address which each caller of malloc() returns to. This
+looks up those addresses in the linker map (u-boot.map) and shows the function
+and offset instead, e.g.:
+
+    $ tools/malloc_sym.py -m u-boot.map dump.txt
+    Caller                              Count       Live       Peak
+    dm_alloc+0x2a                         512      49152      49152
+    ...
+
+The map must come from the same build as the U-Boot which produced the dump.
+"""
+
+import argparse
+import bisect
+import re
+import sys
+
+# Input section for a function, e.g.
+#  .text.malloc   0x00000000000a2d05       0x16 common/dlmalloc.o
+# Long names put the address and size on the next line
+RE_SECTION = re.compile(r'^ \.text\.(\S+)(\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s)?')
+RE_ADDR_SIZE = re.compile(r'^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s')
+
+# Global symbol, e.g.
+#                 0x0000000000066d36                do_bootm
+RE_SYMBOL = re.compile(r'^\s+0x([0-9a-f]+)\s+([A-Za-z_]\w*)$')
+
+# Line of 'malloc dump' output, starting with the caller's address
+RE_DUMP = re.compile(r'^([0-9a-f]+)\s')
+
+# Width of the caller column in 'malloc dump' output, and in ours
+ADDR_WIDTH = 16
+NAME_WIDTH = 32
+
+
+class SymbolTable:
+    """Functions in a U-Boot image, ordered by address"""
+    def __init__(self):
+        self.addrs = []
+        self.syms = []
+
+    def read_map(self, fname):
+        """Read the functions from a linker map
+
+        Args:
+            fname (str): Filename of the map
+        """
+        found = {}
+        pending = None
+        with open(fname, 'r', encoding='utf-8') as inf:
+            for line in inf:
+                line = line.rstrip('\n')
+                if pending:
+                    m_addr = RE_ADDR_SIZE.match(line)
+                    if m_addr:
+                        self.add(found, pending, int(m_addr.group(1), 16),
+                                 int(m_addr.group(2), 16))
+                    pending = None
+                    continue
+                m_sect = RE_SECTION.match(line)
+                if m_sect:
+                    if m_sect.group(2):
+                        self.add(found, m_sect.group(1),
+                                 int(m_sect.group(3), 16),
+                                 int(m_sect.group(4), 16))
+                    else:
+                        pending = m_sect.group(1)
+                    continue
+                m_sym = RE_SYMBOL.match(line)
+                if m_sym:
+                    self.add(found, m_sym.group(2), int(m_sym.group(1), 16),
+                             None)
+        for addr in sorted(found):
+            self.addrs.append(addr)
+            self.syms.append(found[addr])
+
+    @staticmethod
+    def add(found, name, addr, size):
+        """Add a function, ignoring those discarded by the linker
+
+        Args:
+            found (dict): Functions found so far:
+                key (int): Address
+                value (tuple): (name, size or None if not known)
+            name (str): Function name
+            addr (int): Address of the function
+            size (int): Size of the function in bytes, or None
+        """
+        if not addr:
+            return
+        if addr not in found or found[addr][1] is None:
+            found[addr] = (name, size)
+
+    def lookup(self, addr):
+        """Find the function containing an address
+
+        Args:
+            addr (int): Address to look up
+
+        Returns:
+            str: function name and offset, or None if not found
+        """
+        pos = bisect.bisect_right(self.addrs, addr) - 1
+        if pos < 0:
+            return None
+        name, size = self.syms[pos]
+        ofs = addr - self.addrs[pos]
+        if size is not None and ofs >= size:
+            return None
+        return f'{name}+{ofs:#x}'
+
+
+def symbolise(syms, inf, outf):
+    """Replace the addresses in 'malloc dump' output with function names
+
+    Args:
+        syms (SymbolTable): Functions to use
+        inf (file): Output of 'malloc dump'
+        outf (file): File to write the result to
+    """
+    for line in inf:
+        m_dump = RE_DUMP.match(line)
+        if m_dump:
+            caller = m_dump.group(1)
+            name = syms.lookup(int(caller, 16)) or caller
+            line = f'{name:<{NAME_WIDTH}}{line[ADDR_WIDTH:]}'
+        elif line.startswith(('Caller ', '(other) ')):
+            first = line.split()[0]
+            line = f'{first:<{NAME_WIDTH}}{line[ADDR_WIDTH:]}'
+        outf.write(line)
+
+
+def main(argv):
+    """Main program"""
+    parser = argparse.ArgumentParser(
+        description="Add function names to 'malloc dump' output")
+    parser.add_argument('-m', '--map', default='u-boot.map',
+                        help='Linker map of the U-Boot build (u-boot.map)')
+    parser.add_argument('dump', nargs='?',
+                        help="File containing 'malloc dump' output (default: stdin)")
+    args = parser.parse_args(argv)
+
+    syms = SymbolTable()
+    syms.read_map(args.map)
+    if args.dump:
+        with open(args.dump, 'r', encoding='utf-8') as inf:
+            symbolise(syms, inf, sys.stdout)
+    else:
+        symbolise(syms, sys.stdin, sys.stdout)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))